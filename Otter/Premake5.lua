@@ -283,6 +283,90 @@ for k, v in pairs(modules) do
 end
 
 
+-- This function creates a console app that runs a project's tests, for projects that have a tests folder
+-- The tests are built against all of the project's source files except for it's entry point, so that
+-- they link exactly like the project does
+-- @param name    The name of the project being tested
+-- @param relpath The relative path to the project's folder
+function AddTestProject(name, relpath)
+
+	premake.info("  Adding tests for: " .. name)
+
+	-- Gets the location of the project's source code and tests
+	local srcdir = path.join(relpath, "src")
+	local testdir = path.join(relpath, "tests")
+
+	project(name .. " Tests")
+		-- The tests live alongside the project they are testing
+		location(relpath)
+		kind "ConsoleApp"
+		language "C++"
+		cppdialect "C++17"
+		staticruntime "on"
+
+		targetdir ("%{wks.location}\\bin\\" .. outputdir .. "\\%{prj.name}")
+		objdir ("%{wks.location}\\obj\\" .. outputdir .. "\\%{prj.name}")
+		debugdir ("%{wks.location}bin\\%{outputdir}\\%{prj.name}")
+
+		absdir = "%{wks.location}bin\\%{outputdir}\\%{prj.name}"
+
+		-- The tests don't load any resources, but they still need the DLLs that the project links against
+		postbuildcommands {
+			"(xcopy /Q /E /Y /I /C \"%{wks.location}shared_assets\\dll\" \"%{absdir}\")",
+			"(xcopy /Q /E /Y /I /C \"%{wks.location}dependencies\\dll\" \"%{absdir}\")"
+		}
+
+		files {
+			"%{prj.location}\\tests\\**.h",
+			"%{prj.location}\\tests\\**.cpp",
+			"%{prj.location}\\src\\**.h",
+			"%{prj.location}\\src\\**.cpp",
+			"%{prj.location}\\src\\**.c",
+			"%{prj.location}\\src\\**.hpp"
+		}
+
+		-- The tests have their own main
+		removefiles {
+			"%{prj.location}\\src\\entry_point.cpp"
+		}
+
+		defines {
+			"_CRT_SECURE_NO_WARNINGS"
+		}
+
+		-- Tests include the project's headers the same way the project does
+		ProjIncludes[1] = srcdir
+		includedirs(ProjIncludes)
+		includedirs { testdir }
+
+		links(ProjLinks)
+
+		buildoptions { "/bigobj" }
+
+		filter "system:windows"
+			systemversion "latest"
+
+			defines {
+				"GLFW_INCLUDE_NONE",
+				"WINDOWS"
+			}
+
+		filter "configurations:Debug"
+			runtime "Debug"
+			symbols "on"
+
+			links(ProjLinksDebug)
+
+		filter "configurations:Release"
+			runtime "Release"
+			optimize "on"
+
+			links(ProjLinksRelease)
+
+		-- Clear the filter so it doesn't carry over to the next project
+		filter {}
+end
+
 -- This function will create projects for all the paths in a table, and set the group name to the given value
 -- @param groupName The name to group the projects under in the workspace
 -- @param folders   The table of folders that contain the projects to add
@@ -391,6 +475,14 @@ function AddProjects(groupName, folders)
 				optimize "on"
 
 				links(ProjLinksRelease)
+
+			-- Clear the filter so it doesn't carry over to the next project
+			filter {}
+
+		-- Projects with a tests folder get a console app for running their tests
+		if os.isdir(path.join(proj, "tests")) then
+			AddTestProject(name, relpath)
+		end
 	end
 
 end
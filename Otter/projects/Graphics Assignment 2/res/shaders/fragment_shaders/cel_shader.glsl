@@ -2,12 +2,14 @@
 
 #include "../fragments/fs_common_inputs.glsl"
 #include "../fragments/frame_uniforms.glsl"
+#include "../fragments/gbuffer_packing.glsl"
+#include "../fragments/motion_vectors.glsl"
 
 // We output a single color to the color buffer
 layout(location = 0) out vec4 albedo_specPower;
-layout(location = 1) out vec4 normal_metallic;
-layout(location = 2) out vec4 emissive;
-layout(location = 3) out vec3 view_pos;
+layout(location = 1) out vec2 normal_packed;
+layout(location = 2) out vec4 emissive_metallic;
+layout(location = 3) out vec2 motion_vector;
 
 // Represents a collection of attributes that would define a material
 // For instance, you can think of this like material settings in 
@@ -53,12 +55,12 @@ void main() {
     // Here we apply the TBN matrix to transform the normal from tangent space to view space
     normal = normalize(inTBN * normal);
 	
-	// Map [-1, 1] to [0, 1]
-	normal = clamp((normal + 1) / 2.0, 0, 1);
-	normal_metallic = vec4(normal, lightingParams.y);
+	// Pack the normal into octahedral coordinates
+	normal_packed = EncodeNormal(normal);
 
-	// Extract emissive from the material
-	emissive = texture(u_Material.EmissiveMap, inUV);
-	
-	view_pos = inViewPos;
+	// Extract emissive from the material, pre-multiplied by it's strength so metallic can use the alpha channel
+	vec4 emissive = texture(u_Material.EmissiveMap, inUV);
+	emissive_metallic = vec4(emissive.rgb * emissive.a, lightingParams.y);
+
+	motion_vector = GetMotionVector(inPrevClipPos);
 }
\ No newline at end of file
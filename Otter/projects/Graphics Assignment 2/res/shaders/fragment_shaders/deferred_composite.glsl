@@ -4,20 +4,25 @@ layout(location = 0) in vec2 inUV;
 layout(location = 0) out vec4 outColor;
 
 uniform layout(binding = 0) sampler2D s_Albedo;
-uniform layout(binding = 1) sampler2D s_NormalsMetallic;
+uniform layout(binding = 1) sampler2D s_Normals;
 uniform layout(binding = 2) sampler2D s_DiffuseAccumulation;
 uniform layout(binding = 3) sampler2D s_SpecularAccumulation;
-uniform layout(binding = 4) sampler2D s_Emissive;
+uniform layout(binding = 4) sampler2D s_EmissiveMetallic;
 
 #include "../fragments/frame_uniforms.glsl"
 #include "../fragments/color_correction.glsl"
 #include "../fragments/multiple_point_lights.glsl"
 
 void main() {
-    vec3 albedo = texture(s_Albedo, inUV).rgb;
-    vec3 diffuse = texture(s_DiffuseAccumulation, inUV).rgb;
-    vec3 specular = texture(s_SpecularAccumulation, inUV).rgb;
-    vec4 emissive = texture(s_Emissive, inUV);
+    // The scene may have been rendered into only part of the G-Buffer and lighting buffer, this pass
+    // covers the whole output, so the bilinear samples upscale it back to the output's resolution
+    vec2 uv = SceneUV(inUV);
 
-	outColor = vec4(albedo * (diffuse + specular + (emissive.rgb * emissive.a)), 1.0);
+    vec3 albedo = texture(s_Albedo, uv).rgb;
+    vec3 diffuse = texture(s_DiffuseAccumulation, uv).rgb;
+    vec3 specular = texture(s_SpecularAccumulation, uv).rgb;
+    // Emissive is already multiplied by it's strength, since alpha stores metallic
+    vec3 emissive = texture(s_EmissiveMetallic, uv).rgb;
+
+	outColor = vec4(albedo * (diffuse + specular + emissive), 1.0);
 }
\ No newline at end of file
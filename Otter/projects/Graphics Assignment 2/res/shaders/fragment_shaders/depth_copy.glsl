@@ -0,0 +1,10 @@
+#version 450
+
+layout(location = 0) in vec2 inUV;
+
+uniform layout(binding=0) sampler2D s_Depth;
+
+// Copies the G-Buffer's depth into the bound depth buffer, which must be the same size
+void main() {
+    gl_FragDepth = texelFetch(s_Depth, ivec2(gl_FragCoord.xy), 0).r;
+}
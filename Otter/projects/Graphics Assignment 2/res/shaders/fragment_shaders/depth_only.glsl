@@ -0,0 +1,5 @@
+#version 450
+
+// Used when we only care about depth and stencil, color writes should be disabled
+void main() {
+}
@@ -0,0 +1,20 @@
+#version 430
+
+#include "../fragments/fs_common_inputs.glsl"
+
+// Only the parts of the material that affect coverage, the rest of the material's uniforms are
+// matched by name and will be skipped, see Material::ApplyTo. Shaders that don't have both of these
+// uniforms never get a pre-pass variant, see RenderLayer::_GetPrePassShader
+struct Material {
+	sampler2D AlbedoMap;
+	float     DiscardThreshold;
+};
+uniform Material u_Material;
+
+// Used for the depth pre-pass, where color writes are disabled. We still need to discard the same
+// pixels as the G-Buffer pass, otherwise cut out materials would fill in their holes with depth
+void main() {
+	if (texture(u_Material.AlbedoMap, inUV).a < u_Material.DiscardThreshold) {
+		discard;
+	}
+}
@@ -9,6 +9,8 @@ layout(location = 7) in vec4 inTextureWeights;
 ////////////////////////////////////////////////////////////////
 
 #include "../fragments/frame_uniforms.glsl"
+#include "../fragments/gbuffer_packing.glsl"
+#include "../fragments/motion_vectors.glsl"
 
 ////////////////////////////////////////////////////////////////
 /////////////// Instance Level Uniforms ////////////////////////
@@ -36,9 +38,9 @@ uniform Material u_Material;
 
 // We output a single color to the color buffer
 layout(location = 0) out vec4 albedo_specPower;
-layout(location = 1) out vec4 normal_metallic;
-layout(location = 2) out vec4 emissive;
-layout(location = 3) out vec3 view_pos;
+layout(location = 1) out vec2 normal_packed;
+layout(location = 2) out vec4 emissive_metallic;
+layout(location = 3) out vec2 motion_vector;
 
 // https://learnopengl.com/Advanced-Lighting/Advanced-Lighting
 void main() {
@@ -66,14 +68,14 @@ void main() {
     // Here we apply the TBN matrix to transform the normal from tangent space to view space
     normal = normalize(inTBN * normal);
 	
-	// Map [-1, 1] to [0, 1]
-	normal = clamp((normal + 1) / 2.0, 0, 1);
-	normal_metallic = vec4(normal, 0.0f);
+	// Pack the normal into octahedral coordinates
+	normal_packed = EncodeNormal(normal);
 
-	// Extract emissive from the material
-	emissive = 
+	// Extract emissive from the material, pre-multiplied by it's strength so metallic can use the alpha channel
+	vec4 emissive = 
 		texture(u_Material.EmissiveA, inUV).rgba * inTextureWeights.x +
 		texture(u_Material.EmissiveB, inUV).rgba * inTextureWeights.y;
-		
-	view_pos = inViewPos;
+	emissive_metallic = vec4(emissive.rgb * emissive.a, 0.0f);
+
+	motion_vector = GetMotionVector(inPrevClipPos);
 }
\ No newline at end of file
@@ -0,0 +1,29 @@
+#version 450
+
+layout(location = 0) in vec2 inUV;
+layout(location = 0) out float outDepth;
+
+// The depth texture, or the previous level of the pyramid, see HiZBuffer::SOURCE_SLOT
+uniform layout(binding=4) sampler2D s_Source;
+// The fraction of the source that each level covers, this is only under 1 for the first level when the
+// scene was rendered into part of the depth texture, and the last texel of the source that can be read
+uniform vec2  u_SourceScale;
+uniform ivec2 u_SourceMax;
+
+// Each texel keeps the furthest of the source texels below it, which is 2x2 texels between levels, but
+// may be up to 3x3 when the first level is stretched over part of the depth texture. Levels are rounded
+// up in size, so the last row and column of an odd sized source are clamped rather than read past the edge
+void main() {
+    ivec2 base = ivec2(gl_FragCoord.xy) * 2;
+    ivec2 first = min(ivec2(floor(vec2(base) * u_SourceScale)), u_SourceMax);
+    ivec2 last = ivec2(ceil(vec2(base + 2) * u_SourceScale)) - 1;
+    last = clamp(last, first, min(first + 2, u_SourceMax));
+
+    float depth = 0.0;
+    for (int y = 0; y < 3; y++) {
+        for (int x = 0; x < 3; x++) {
+            depth = max(depth, texelFetch(s_Source, min(first + ivec2(x, y), last), 0).r);
+        }
+    }
+    outDepth = depth;
+}
@@ -1,37 +1,43 @@
-#version 440
+#version 450
 
 layout(location = 0) in vec2 inUV;
 layout(location = 0) out vec4 outDiffuse;
 layout(location = 1) out vec4 outSpecular;
 
-// The maximum number of lights the shader supports, increasing this will lower performance!
-#define MAX_LIGHTS 8
-
 // Represents a single light source
 struct Light {
 	vec4  PositionIntensity;
 	// Stores color in RBG and attenuation in w
 	vec4  ColorAttenuation;
+	// The distance that the light is cut off at in x, yzw are unused
+	vec4  Range;
 };
 
-// Our uniform buffer that will store all our lighting data
-// so that it can be shared between shaders
-layout (std140, binding = 2) uniform b_LightBlock {
-    // Stores ambient light color in rgb, and number
-	// of lights in w, allowing for easier struct packing
-	// on the C++ side
-    vec4  AmbientColAndNumLights;
-
-    // Our array of all lights
-    Light Lights[MAX_LIGHTS];
+// The lights are binned into clusters on the CPU, a cluster is a screen tile
+// that is split up into slices by depth (see LightClusters.h)
 
-    // The rotation of the skybox/environment map
-	mat3  EnvironmentRotation;
+// All the lights in view space
+layout (std430, binding = 0) readonly buffer b_ClusterLights {
+    Light Lights[];
+};
+// The offset and number of lights in LightIndices for each cluster
+layout (std430, binding = 1) readonly buffer b_ClusterGrid {
+    uvec2 Clusters[];
+};
+// The lights touching each cluster, sorted by cluster
+layout (std430, binding = 2) readonly buffer b_ClusterIndices {
+    uint LightIndices[];
 };
 
-#include "../fragments/deferred_post_common.glsl"
+// The number of tiles across, tiles down, and depth slices
+uniform uvec3 u_ClusterSize;
+// The slice a depth falls in is floor(log(depth) * x + y)
+uniform vec2  u_ClusterSliceParams;
+// When drawing light volumes, the single light to shade, otherwise -1 to use the clusters
+uniform int   u_LightIndex = -1;
 
 #include "../fragments/frame_uniforms.glsl"
+#include "../fragments/deferred_post_common.glsl"
 
 // Calculates the contribution the given point light has 
 // for the current fragment
@@ -49,6 +55,9 @@ void CalcPointLightContribution(vec3 viewPos, vec3 normal, Light light, float sh
         // We'll use a modified distance squared attenuation factor to keep it simple
         // We add the one to prevent divide by zero errors
         float attenuation = clamp(1.0 / (1.0 + light.ColorAttenuation.w * pow(dist, 2)), 0, 256);
+        // Fade the light out as it reaches its cut off, so we don't see where the clusters end
+        float falloff = clamp(1.0 - pow(dist / light.Range.x, 4), 0.0, 1.0);
+        attenuation *= falloff * falloff;
 
         // Dot product between normal and light
         float NdotL = max(dot(normal, lightDir), 0.0);
@@ -61,7 +70,11 @@ void CalcPointLightContribution(vec3 viewPos, vec3 normal, Light light, float sh
 }
 
 void main() {
-    vec3 normal = GetNormal(inUV);
+    // This shader is also used for light volumes, so we find our UVs from the pixel instead of inUV. The
+    // scene only covers u_RenderScale of the G-Buffer, so this is scaled up to a UV across the output
+    vec2 uv = gl_FragCoord.xy / (vec2(textureSize(s_Normals, 0)) * u_RenderScale.xy);
+
+    vec3 normal = GetNormal(uv);
     
     if (length(normal) < 0.1) {
         discard;
@@ -69,15 +82,31 @@ void main() {
 
     normal = normalize(normal);
 
-    vec3 albedo = GetAlbedo(inUV);
-    vec3 viewPos = GetViewPosition(inUV);
+    vec3 albedo = GetAlbedo(uv);
+    vec3 viewPos = GetViewPosition(uv);
     
-    float specularPow = texture(s_AlbedoSpec, inUV).a;
+    float specularPow = texture(s_AlbedoSpec, SceneUV(uv)).a;
 
     vec3 diffuse = vec3(0);
     vec3 specular = vec3(0);
-    for (int ix = 0; ix < AmbientColAndNumLights.w && ix < MAX_LIGHTS; ix++) {
-        CalcPointLightContribution(viewPos, normal, Lights[ix], specularPow, diffuse, specular);
+
+    // Light volumes only shade a single light
+    if (u_LightIndex >= 0) {
+        CalcPointLightContribution(viewPos, normal, Lights[u_LightIndex], specularPow, diffuse, specular);
+        outDiffuse = vec4(diffuse, 1);
+        outSpecular = vec4(specular, 1);
+        return;
+    }
+
+    // Find the cluster that this pixel falls in
+    uvec2 tile = min(uvec2(uv * vec2(u_ClusterSize.xy)), u_ClusterSize.xy - 1);
+    float sliceF = log(max(-viewPos.z, 0.0001)) * u_ClusterSliceParams.x + u_ClusterSliceParams.y;
+    uint slice = uint(clamp(sliceF, 0.0, float(u_ClusterSize.z - 1)));
+    uvec2 cluster = Clusters[(slice * u_ClusterSize.y + tile.y) * u_ClusterSize.x + tile.x];
+
+    // Only shade the lights that can reach this cluster
+    for (uint ix = 0; ix < cluster.y; ix++) {
+        CalcPointLightContribution(viewPos, normal, Lights[LightIndices[cluster.x + ix]], specularPow, diffuse, specular);
     }
 
     outDiffuse = vec4(diffuse, 1);
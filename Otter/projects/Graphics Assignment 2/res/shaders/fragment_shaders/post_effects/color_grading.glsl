@@ -0,0 +1,45 @@
+#version 430
+
+layout(location = 0) in vec2 inUV;
+
+layout(location = 0) out vec3 outColor;
+
+// Must match ColorGradingEffect::MAX_LUTS
+#define MAX_LUTS 4
+
+uniform layout(binding = 0) sampler2D s_Image;
+// Takes up texture slots 1 to MAX_LUTS
+uniform layout(binding = 1) sampler3D s_Luts[MAX_LUTS];
+
+// The number of LUTs that are bound, and how strongly each one is applied
+uniform int   u_LutCount;
+uniform float u_LutStrengths[MAX_LUTS];
+
+uniform float u_GrainAmount;
+// Strength, radius and softness of the vignette
+uniform vec3  u_Vignette;
+
+#include "../../fragments/frame_uniforms.glsl"
+
+void main() {
+    vec3 color = texture(s_Image, inUV).rgb;
+
+    // Each LUT grades the result of the one before it, the same as running them as separate passes
+    for (int ix = 0; ix < MAX_LUTS; ix++) {
+        if (ix >= u_LutCount) {
+            break;
+        }
+        color = mix(color, texture(s_Luts[ix], color).rgb, u_LutStrengths[ix]);
+    }
+
+    // Darken towards the corners of the screen
+    float dist = length(inUV - vec2(0.5));
+    float vignette = smoothstep(u_Vignette.y, u_Vignette.y - u_Vignette.z, dist);
+    color *= mix(1.0, vignette, u_Vignette.x);
+
+    // Film grain, offset by time so that it doesn't sit still on the screen
+    float noise = fract(sin(dot(inUV + fract(u_Time), vec2(12.9898, 78.233) * 2.0)) * 43758.5453);
+    color -= noise * u_GrainAmount;
+
+    outColor = color;
+}
@@ -0,0 +1,23 @@
+#version 440
+
+// First depth of field pass, shrinks the image to half resolution and stores each
+// pixel's circle of confusion alongside it, so the gather pass only reads one texture
+
+layout(location = 0) in vec2 inUV;
+
+layout(location = 0) out vec4 outColor;
+
+// Our color buffer to sample from
+layout(binding = 0) uniform sampler2D a_Sampler;
+// The depth buffer to use (non-linearized)
+layout(binding = 1) uniform sampler2D a_Depth;
+
+#include "../../fragments/frame_uniforms.glsl"
+#include "../../fragments/depth_of_field_common.glsl"
+
+void main() {
+    // The bilinear sample lands between 4 full resolution pixels and averages them
+    vec3 color = texture(a_Sampler, inUV).rgb;
+    // Store the CoC in half resolution texels
+    outColor = vec4(color, GetCoC(a_Depth, inUV) * 0.5);
+}
@@ -0,0 +1,47 @@
+#version 440
+
+// Last depth of field pass, brings the half resolution blur back up to full resolution
+
+layout(location = 0) in vec2 inUV;
+
+layout(location = 0) out vec4 outColor;
+
+// Our full resolution color buffer
+layout(binding = 0) uniform sampler2D a_Sampler;
+// The depth buffer to use (non-linearized)
+layout(binding = 1) uniform sampler2D a_Depth;
+// The half resolution blur, with the circle of confusion in half resolution texels in alpha
+layout(binding = 3) uniform sampler2D a_Blurred;
+
+#include "../../fragments/frame_uniforms.glsl"
+#include "../../fragments/depth_of_field_common.glsl"
+
+void main() {
+    float coc = GetCoC(a_Depth, inUV);
+    vec3 sharp = texture(a_Sampler, inUV).rgb;
+
+    // Bilateral upsample, the 4 nearest half resolution texels are weighted by how similar their
+    // CoC is to ours as well as by distance, so blur doesn't leak across the edges of in focus objects
+    ivec2 halfSize = textureSize(a_Blurred, 0);
+    vec2 pos = inUV * halfSize - 0.5;
+    ivec2 base = ivec2(floor(pos));
+    vec2 f = fract(pos);
+
+    vec3 blurred = vec3(0);
+    float total = 0.0;
+    for (int ix = 0; ix < 4; ix++) {
+        ivec2 offset = ivec2(ix & 1, ix >> 1);
+        vec4 texel = texelFetch(a_Blurred, clamp(base + offset, ivec2(0), halfSize - 1), 0);
+
+        float bilinear = (offset.x == 1 ? f.x : 1.0 - f.x) * (offset.y == 1 ? f.y : 1.0 - f.y);
+        float similarity = 1.0 / (1.0 + abs(texel.a * 2.0 - coc));
+        float weight = bilinear * similarity + 0.0001;
+
+        blurred += texel.rgb * weight;
+        total += weight;
+    }
+    blurred /= total;
+
+    // Pixels with a CoC under a pixel are in focus, and keep their full resolution color
+    outColor = vec4(mix(sharp, blurred, smoothstep(0.5, 1.5, coc)), 1.0);
+}
@@ -0,0 +1,27 @@
+#version 430
+
+layout(location = 0) in vec2 inUV;
+layout(location = 0) out vec3 outColor;
+
+// Must match BlurKernel::MAX_TAPS
+#define MAX_TAPS 16
+
+uniform layout(binding = 0) sampler2D s_Image;
+
+// The step between texels along the direction of this pass, ex (1/width, 0) for a horizontal pass
+uniform vec2  u_Direction;
+// The taps to sample, offsets are in texels and may fall between two texels
+uniform int   u_TapCount;
+uniform float u_Offsets[MAX_TAPS];
+uniform float u_Weights[MAX_TAPS];
+
+void main() {
+    vec3 accumulator = vec3(0);
+    for (int ix = 0; ix < MAX_TAPS; ix++) {
+        if (ix >= u_TapCount) {
+            break;
+        }
+        accumulator += texture(s_Image, inUV + u_Direction * u_Offsets[ix]).rgb * u_Weights[ix];
+    }
+    outColor = accumulator;
+}
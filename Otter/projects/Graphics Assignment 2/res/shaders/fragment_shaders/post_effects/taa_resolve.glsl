@@ -0,0 +1,96 @@
+#version 440
+
+// Temporal anti-aliasing resolve, blends this frame into the history from the frames before it
+
+layout(location = 0) in vec2 inUV;
+
+layout(location = 0) out vec4 outColor;
+
+// This frame's image, already scaled up to the size of the output
+layout(binding = 0) uniform sampler2D s_Current;
+// The depth buffer (non-linearized)
+layout(binding = 1) uniform sampler2D s_Depth;
+// The motion since the last frame, see motion_vectors.glsl
+layout(binding = 2) uniform sampler2D s_Motion;
+// The resolved image from the last frame
+layout(binding = 3) uniform sampler2D s_History;
+
+// How much of this frame is blended into the history
+uniform float u_CurrentWeight;
+// 0 when the history has been thrown out, and this frame should be used as is
+uniform int u_HistoryValid;
+
+#include "../../fragments/frame_uniforms.glsl"
+
+// How many standard deviations away from the average of the neighbourhood the history may be
+const float VARIANCE_CLIP_GAMMA = 1.25;
+
+float Luma(vec3 color) {
+    return dot(color, vec3(0.299, 0.587, 0.114));
+}
+
+void main() {
+    // The neighbourhood is sampled a rendered pixel apart, which is more than an output pixel when the
+    // scene was rendered at a lower resolution
+    vec2 pixelSize = 1.0 / u_Viewport.zw;
+    ivec2 gBufferSize = textureSize(s_Depth, 0);
+
+    vec3 current = texture(s_Current, inUV).rgb;
+
+    // Motion is only stored for the surface that ends up in each pixel, so pixels just outside of a moving
+    // object would leave their edge behind. Taking the motion from the closest pixel around us moves the
+    // edges along with the object
+    float closestDepth = 1.0;
+    ivec2 closestTexel = ivec2(SceneUV(inUV) * gBufferSize);
+
+    // Gather the average and variance of the colors around us, to decide which history colors are still believable
+    vec3 m1 = vec3(0);
+    vec3 m2 = vec3(0);
+    vec3 minColor = current;
+    vec3 maxColor = current;
+    for (int y = -1; y <= 1; y++) {
+        for (int x = -1; x <= 1; x++) {
+            vec2 uv = inUV + vec2(x, y) * pixelSize;
+
+            ivec2 texel = ivec2(SceneUV(uv) * gBufferSize);
+            float depth = texelFetch(s_Depth, texel, 0).r;
+            if (depth < closestDepth) {
+                closestDepth = depth;
+                closestTexel = texel;
+            }
+
+            vec3 color = texture(s_Current, uv).rgb;
+            m1 += color;
+            m2 += color * color;
+            minColor = min(minColor, color);
+            maxColor = max(maxColor, color);
+        }
+    }
+    m1 /= 9.0;
+    m2 /= 9.0;
+
+    // Motion is in UV units across the scene, which lines up with the output
+    vec2 motion = texelFetch(s_Motion, closestTexel, 0).rg;
+    vec2 prevUV = inUV - motion;
+
+    // Anything that was off the screen last frame has no history to use
+    if (u_HistoryValid == 0 || any(lessThan(prevUV, vec2(0))) || any(greaterThan(prevUV, vec2(1)))) {
+        outColor = vec4(current, 1.0);
+        return;
+    }
+
+    // Clamp the history to the box around the average that the variance covers, kept within the
+    // actual range of colors, so that history from a different surface is pulled back towards ours
+    vec3 sigma = sqrt(max(m2 - m1 * m1, vec3(0)));
+    vec3 boxMin = max(minColor, m1 - sigma * VARIANCE_CLIP_GAMMA);
+    vec3 boxMax = min(maxColor, m1 + sigma * VARIANCE_CLIP_GAMMA);
+    vec3 history = clamp(texture(s_History, prevUV).rgb, boxMin, boxMax);
+
+    // Weighting by the inverse of the brightness keeps single bright pixels from flickering as the
+    // jitter moves across them
+    float currentWeight = u_CurrentWeight / (1.0 + Luma(current));
+    float historyWeight = (1.0 - u_CurrentWeight) / (1.0 + Luma(history));
+    vec3 result = (current * currentWeight + history * historyWeight) / max(currentWeight + historyWeight, 0.0001);
+
+    outColor = vec4(result, 1.0);
+}
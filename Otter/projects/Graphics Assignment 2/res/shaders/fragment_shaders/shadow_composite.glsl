@@ -5,42 +5,61 @@ layout(location = 0) in vec2 inUV;
 layout(location = 0) out vec4 outDiffuse;
 layout(location = 1) out vec4 outSpecular;
 
-// Note the use of sampler2DShadow here! This lets us perform
-// linear sampling on a depth buffer (more or less)
-layout (binding = 5) uniform sampler2DShadow s_ShadowDepth;
-
-// Image to project
-layout (binding = 6) uniform sampler2D s_ProjectionMask;
+// The maximum number of shadow casting lights we can draw in a single pass
+#define MAX_SHADOW_LIGHTS 16
+// The maximum number of projection masks that can be bound for a single pass
+#define MAX_PROJECTION_MASKS 4
 
-// Matrix to go from view space to shadow clip space
-uniform mat4  u_ViewToShadow;
-// Light's direction in view space
-uniform vec3  u_LightDirViewspace;
-// Light's position in view space
-uniform vec3  u_LightPosViewspace;
-
-// Shadow settings
-uniform float u_ShadowBias;
-uniform float u_NormalBias;
-uniform uint  u_ShadowFlags;
+// Note the use of sampler2DShadow here! This lets us perform
+// linear sampling on a depth buffer (more or less). All of the
+// lights' shadow maps are packed into this one atlas
+layout (binding = 5) uniform sampler2DShadow s_ShadowAtlas;
+
+// Images to project, lights refer to these by index
+layout (binding = 6) uniform sampler2D s_ProjectionMasks[MAX_PROJECTION_MASKS];
+
+// Represents a single shadow casting light
+struct ShadowLight {
+	// Matrix to go from view space to shadow clip space
+	mat4  ViewToShadow;
+	// The region of the atlas holding the light's shadow map, as (offset, scale) in UVs
+	vec4  AtlasRect;
+	// Light's position in view space in xyz, and intensity in w
+	vec4  PositionIntensity;
+	// Light's direction in view space in xyz, and the constant shadow bias in w
+	vec4  DirectionBias;
+	// Stores color in RBG and attenuation in w
+	vec4  ColorAttenuation;
+	float NormalBias;
+	uint  Flags;
+	// The index of the light's projection mask in s_ProjectionMasks
+	int   MaskIndex;
+	float Padding;
+	// For cascades, the view depths that the cascade fades in and out over, as
+	// (fade in start, fade in end, fade out start, fade out end)
+	vec4  CascadeRange;
+};
 
-// Light settings
-uniform float u_Attenuation;
-uniform float u_Intensity;
-uniform vec3  u_LightColor;
+layout (std140, binding = 3) uniform b_ShadowBlock {
+	uint        NumShadowLights;
+	ShadowLight ShadowLights[MAX_SHADOW_LIGHTS];
+};
 
 // Flags
 #define FLAG_PROJECTION_ENABLED (1 << 0)
 #define FLAG_ENABLE_PCF (1 << 1)
 #define FLAG_ENABLE_ATTENUATION (1 << 2)
 #define FLAG_ENABLE_WIDE_PCF (1 << 3)
+// Set by the renderer for the cascades of directional lights
+#define FLAG_CASCADE (1 << 4)
+#define FLAG_LAST_CASCADE (1 << 5)
 
 /*
  * Determines if one of the shadow option flags is set,
  * if multiple flags are provided, checks all of them
  */
-bool ShadowFlagSet(uint flag) {
-    return (u_ShadowFlags & flag) == flag;
+bool ShadowFlagSet(ShadowLight light, uint flag) {
+    return (light.Flags & flag) == flag;
 }
 
 // Represents a single light source
@@ -50,39 +69,28 @@ struct Light {
 	vec4  ColorAttenuation;
 };
 
-#include "../fragments/deferred_post_common.glsl"
 #include "../fragments/frame_uniforms.glsl"
-
-// Showing off another way to extract view pos from depth
-vec4 GetViewPos(vec2 uv) {
-	// Get the depth buffer value at this pixel, map from [0,1] to [-1,1]    
-	float zOverW = GetDepth(uv) * 2 - 1;
-	// We convert the range [0,1] to [-1,1], create a point to inverse project    
-	vec4 currentPos = vec4(uv.xy * 2 - 1, zOverW, 1);
-	// Transform by the view-projection inverse    
-	vec4 D = inverse(u_Projection) * currentPos;
-	// Divide by w for perspective divide    
-	vec4 viewPos = D / D.w;
-	return viewPos;
-}
+#include "../fragments/deferred_post_common.glsl"
 
 // Calculates the contribution the given point light has 
 // for the current fragment
 // @param viewPos   The fragment's position in view space
 // @param normal    The fragment's normal (normalized)
 // @param Light     The light to caluclate the contribution for
+// @param lightDir  The direction the light is facing, in view space
+// @param flags     The light's shadow flags
 // @param shininess The specular power for the fragment, between 0 and 1
-void CalcDirectionalLightContribution(vec3 viewPos, vec3 normal, Light light, float shininess, inout vec3 diffuse, inout vec3 specular) {
+void CalcDirectionalLightContribution(vec3 viewPos, vec3 normal, Light light, vec3 lightDirViewspace, uint flags, float shininess, inout vec3 diffuse, inout vec3 specular) {
 
         vec3 lightViewPos = light.PositionIntensity.xyz;
         vec3 lightVec = lightViewPos - viewPos;
         float dist = length(lightVec);
-        vec3 lightDir = -u_LightDirViewspace;
+        vec3 lightDir = -lightDirViewspace;
 
         float attenuation = 1.0;
         // We'll use a modified distance squared attenuation factor to keep it simple
         // We add the one to prevent divide by zero errors
-        if (ShadowFlagSet(FLAG_ENABLE_ATTENUATION)) {
+        if ((flags & FLAG_ENABLE_ATTENUATION) != 0) {
             attenuation = clamp(1.0 / (1.0 + light.ColorAttenuation.w * pow(dist, 2)), 0, 256);
         }
 
@@ -98,17 +106,23 @@ void CalcDirectionalLightContribution(vec3 viewPos, vec3 normal, Light light, fl
 
 // This function will sample multiple points around our sample, and average the results
 // This gives a slight blur to the edges of the shadows, and helps to soften them up
+// @param light The light whose shadow map we are sampling
 // @param fragPos The position in the shadow's normalized clip space to sample
 // @param bias The shadow bias factor to use
-float PCF(vec3 fragPos, float bias) {
+float PCF(ShadowLight light, vec3 fragPos, float bias) {
+    vec2 texelSize = 1.0 / textureSize(s_ShadowAtlas, 0); // Determine the texel size of the shadow sampler
+
+    // Move the sample into the light's region of the atlas, and keep samples from reading the neighbouring lights
+    fragPos.xy = light.AtlasRect.xy + fragPos.xy * light.AtlasRect.zw;
+    vec2 rectMin = light.AtlasRect.xy + texelSize * 0.5;
+    vec2 rectMax = light.AtlasRect.xy + light.AtlasRect.zw - texelSize * 0.5;
 
     // If we're doing PCF, we want to take multiple samples
-    if (ShadowFlagSet(FLAG_ENABLE_PCF)) {
+    if (ShadowFlagSet(light, FLAG_ENABLE_PCF)) {
         float result = 0.0; // accumulator
-        vec2 texelSize = 1.0 / textureSize(s_ShadowDepth, 0); // Determine the texel size of the shadow sampler
         
         // 5x5 kernel
-        if (ShadowFlagSet(FLAG_ENABLE_WIDE_PCF)) {
+        if (ShadowFlagSet(light, FLAG_ENABLE_WIDE_PCF)) {
             // Normalized 5x5 gaussian kernel
             const float kernel[5][5] = {
                 { 1.0/273,  4.0/273,  7.0/273,  4.0/273, 1.0/273 },
@@ -127,8 +141,8 @@ float PCF(vec3 fragPos, float bias) {
                     // applied.
                     float contrib =
                         texture(
-                            s_ShadowDepth, 
-                            vec3(fragPos.xy + vec2(x,y) * texelSize, fragPos.z - bias)
+                            s_ShadowAtlas, 
+                            vec3(clamp(fragPos.xy + vec2(x,y) * texelSize, rectMin, rectMax), fragPos.z - bias)
                         );
                     // Apply kernel weights to the result
                     result += contrib * kernel[x+2][y+2];
@@ -148,7 +162,7 @@ float PCF(vec3 fragPos, float bias) {
             for(int x = -1; x <= 1; ++x) { 
                 for(int y = -1; y <= 1; ++y) {
                     // See above notes about texture
-                    float contrib = texture(s_ShadowDepth, vec3(fragPos.xy + vec2(x,y) * texelSize, fragPos.z - bias));
+                    float contrib = texture(s_ShadowAtlas, vec3(clamp(fragPos.xy + vec2(x,y) * texelSize, rectMin, rectMax), fragPos.z - bias));
                     result += contrib * kernel[x+1][y+1];
                 }    
             }
@@ -159,82 +173,124 @@ float PCF(vec3 fragPos, float bias) {
     // PCF is not enabled, take 1 sample
     else {
         // See above notes about texture
-        float contrib = texture(s_ShadowDepth, vec3(fragPos.xy, fragPos.z - bias));
+        float contrib = texture(s_ShadowAtlas, vec3(fragPos.xy, fragPos.z - bias));
         return contrib; // Perform the depth test, and return the result
     }
 }
 
-void main() {
-    // Normal of sample in view space
-    vec3 normal = GetNormal(inUV);
-    
-    // Ignore things we can't calculate light for
-    if (length(normal) < 0.1) {
-        discard;
-    }
-
-    // Make sure the normal is in fact, a normal
-    normal = normalize(normal);
-
-    // Get values from the g-buffer
-    vec3 albedo = GetAlbedo(inUV);
-
-    // Get viewspace from depth re-construction method (just to show how it works!)
-    vec3 viewPos = GetViewPos(inUV).xyz;
+// Calculates how much a cascade contributes at a given view depth, cascades fade in over the
+// end of the previous cascade and fade out over the start of the next one
+// @param light The cascade to calculate the weight for
+// @param depth The fragment's distance along the camera's view direction
+float CascadeFadeIn(ShadowLight light, float depth) {
+    return clamp((depth - light.CascadeRange.x) / max(light.CascadeRange.y - light.CascadeRange.x, 0.0001), 0.0, 1.0);
+}
+float CascadeFadeOut(ShadowLight light, float depth) {
+    return 1.0 - clamp((depth - light.CascadeRange.z) / max(light.CascadeRange.w - light.CascadeRange.z, 0.0001), 0.0, 1.0);
+}
 
+// Calculates the contribution of a single shadow casting light for the current fragment
+// @param light    The light to calculate the contribution for
+// @param viewPos  The fragment's position in view space
+// @param normal   The fragment's normal (normalized)
+// @param specularPow The specular power for the fragment, between 0 and 1
+void CalcShadowLightContribution(ShadowLight light, vec3 viewPos, vec3 normal, float specularPow, inout vec3 diffuse, inout vec3 specular) {
     // Determine the position in light clip space
-	vec4 shadowPos = u_ViewToShadow * vec4(viewPos, 1.0);  
+	vec4 shadowPos = light.ViewToShadow * vec4(viewPos, 1.0);  
 	shadowPos /= shadowPos.w;                // Perspective divide
 	shadowPos = shadowPos * 0.5 + 0.5;       // Normalize from clip space to [0,1]
-    
-    // If pixel on screen is outside the bounds of the light, skip it
-    if (shadowPos.x < 0 || shadowPos.x > 1 || 
+
+    bool outOfBounds = 
+        shadowPos.x < 0 || shadowPos.x > 1 || 
         shadowPos.y < 0 || shadowPos.y > 1 || 
-        shadowPos.z < 0 || shadowPos.z > 1) {
-        //outDiffuse  = vec4(1, 0, 0, 1);
-        //outSpecular = vec4(1, 0, 0, 1);
-        //return;
-        discard;
+        shadowPos.z < 0 || shadowPos.z > 1;
+
+    // Cascades split up the light by distance from the camera, the weights of overlapping cascades add up to 1
+    float weight = 1.0;
+    float shadowFade = 0.0;
+    if (ShadowFlagSet(light, FLAG_CASCADE)) {
+        float depth = -viewPos.z;
+        weight = CascadeFadeIn(light, depth);
+        // The last cascade keeps lighting the scene past the shadow distance, but the shadows fade away
+        if (ShadowFlagSet(light, FLAG_LAST_CASCADE)) {
+            shadowFade = 1.0 - CascadeFadeOut(light, depth);
+        } else {
+            weight *= CascadeFadeOut(light, depth);
+        }
+        if (weight <= 0) {
+            return;
+        }
+    }
+    // If pixel on screen is outside the bounds of the light, skip it
+    else if (outOfBounds) {
+        return;
     }
 
     // Calculate a bias based on the dot product between surface normal and light direction
-    float bias = max(u_NormalBias * (1.0 - dot(normal, u_LightDirViewspace)), u_ShadowBias);
+    vec3 lightDir = light.DirectionBias.xyz;
+    float bias = max(light.NormalBias * (1.0 - dot(normal, lightDir)), light.DirectionBias.w);
 
-    // Determine how much of the pixel on the screen is in shadow
-    float lightContrib = PCF(shadowPos.xyz, bias);
-
-    vec3 diffuse = vec3(0);
-    vec3 specular = vec3(0);
+    // Determine how much of the pixel on the screen is in shadow, anything outside of a cascade is lit
+    float lightContrib = outOfBounds ? 1.0 : PCF(light, shadowPos.xyz, bias);
+    lightContrib = mix(lightContrib, 1.0, shadowFade) * weight;
 
     // We can skip lighting calculation if the pixel is fully in shadow!
     if (lightContrib > 0) {
+        vec3 lightDiffuse = vec3(0);
+        vec3 lightSpecular = vec3(0);
 
         // Create a light structure we can pass to the CalcDirectionalLightContribution function
         Light l;
-        l.PositionIntensity = vec4(u_LightPosViewspace, u_Intensity);
+        l.PositionIntensity = light.PositionIntensity;
 
         // If we want to use the projection mask, we sample it and multiply by light color
-        if (ShadowFlagSet(FLAG_PROJECTION_ENABLED)) {
-            vec3 color = texture(s_ProjectionMask, shadowPos.xy).rgb * u_LightColor;
-            l.ColorAttenuation = vec4(color, u_Attenuation);
+        if (ShadowFlagSet(light, FLAG_PROJECTION_ENABLED) && light.MaskIndex >= 0) {
+            vec3 color = texture(s_ProjectionMasks[light.MaskIndex], shadowPos.xy).rgb * light.ColorAttenuation.rgb;
+            l.ColorAttenuation = vec4(color, light.ColorAttenuation.w);
         }
         // We do not want to use the projection mask, just use the light color
         else {
-            l.ColorAttenuation = vec4(u_LightColor, u_Attenuation);
+            l.ColorAttenuation = light.ColorAttenuation;
         }
 
-        // We'll also grab specular power from the G-Buffer
-        float specularPow = texture(s_AlbedoSpec, inUV).a;
-
         // Use the structure to calculate a directional light's contribution
-        CalcDirectionalLightContribution(viewPos, normal, l, specularPow, diffuse, specular);
+        // Directional lights are infinitely far away, so they are never attenuated
+        uint flags = ShadowFlagSet(light, FLAG_CASCADE) ? (light.Flags & ~uint(FLAG_ENABLE_ATTENUATION)) : light.Flags;
+        CalcDirectionalLightContribution(viewPos, normal, l, lightDir, flags, specularPow, lightDiffuse, lightSpecular);
 
         // We multiply the final light contribution by the inverse of the shadow
-        diffuse  *= lightContrib;
-        specular *= lightContrib;
+        diffuse  += lightDiffuse * lightContrib;
+        specular += lightSpecular * lightContrib;
+    }
+}
+
+void main() {
+    // Normal of sample in view space
+    vec3 normal = GetNormal(inUV);
+    
+    // Ignore things we can't calculate light for
+    if (length(normal) < 0.1) {
+        discard;
+    }
+
+    // Make sure the normal is in fact, a normal
+    normal = normalize(normal);
+
+    // Get viewspace from depth re-construction method (just to show how it works!)
+    vec3 viewPos = GetViewPosition(inUV);
+
+    // We'll also grab specular power from the G-Buffer
+    float specularPow = texture(s_AlbedoSpec, SceneUV(inUV)).a;
+
+    vec3 diffuse = vec3(0);
+    vec3 specular = vec3(0);
+
+    // Accumulate all the shadow casting lights in one go, reading their shadows from the atlas
+    for (uint ix = 0; ix < NumShadowLights; ix++) {
+        CalcShadowLightContribution(ShadowLights[ix], viewPos, normal, specularPow, diffuse, specular);
     }
 
     // Return our results
     outDiffuse = vec4(diffuse, 1);
     outSpecular = vec4(specular, 1);
-}
\ No newline at end of file
+}
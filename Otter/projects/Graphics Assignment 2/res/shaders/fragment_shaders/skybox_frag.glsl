@@ -1,20 +1,25 @@
 #version 440
 
 layout(location = 0) in vec3 inNormal;
+layout(location = 1) in vec4 inPrevClipPos;
 
 uniform layout (binding=15) samplerCube s_Environment;
 
+#include "../fragments/frame_uniforms.glsl"
+#include "../fragments/gbuffer_packing.glsl"
+#include "../fragments/motion_vectors.glsl"
+
 // We output a single color to the color buffer
 layout(location = 0) out vec4 albedo_specPower;
-layout(location = 1) out vec4 normal_metallic;
-layout(location = 2) out vec4 emissive;
-layout(location = 3) out vec3 view_pos;
+layout(location = 1) out vec2 normal_packed;
+layout(location = 2) out vec4 emissive_metallic;
+layout(location = 3) out vec2 motion_vector;
 
 void main() {
     vec3 norm = normalize(inNormal);
 
     albedo_specPower = vec4(texture(s_Environment, norm).rgb, 0.0);
-    normal_metallic = vec4(0.5, 0.5, 1, 0);
-    emissive = vec4(0);
-    view_pos = vec3(0);
+    normal_packed = EncodeNormal(vec3(0, 0, 1));
+    emissive_metallic = vec4(0);
+    motion_vector = GetMotionVector(inPrevClipPos);
 }
\ No newline at end of file
@@ -1,23 +1,31 @@
-
 uniform layout(binding=0) sampler2D s_Depth;
 uniform layout(binding=1) sampler2D s_AlbedoSpec;
-uniform layout(binding=2) sampler2D s_NormalsMetallic;
-uniform layout(binding=3) sampler2D s_Emissive;
-uniform layout(binding=4) sampler2D s_Position;
+uniform layout(binding=2) sampler2D s_Normals;
+uniform layout(binding=3) sampler2D s_EmissiveMetallic;
 
+// Note: frame_uniforms.glsl must be included before this file, for u_InvProjection and SceneUV
+// The UVs passed in are across the output, the scene may only cover part of the G-Buffer
+#include "gbuffer_packing.glsl"
 
 vec3 GetNormal(vec2 uv) {
-    return ((texture(s_NormalsMetallic, uv).xyz) * 2) - 1;
+    return DecodeNormal(texture(s_Normals, SceneUV(uv)).rg);
 }
 
 vec3 GetAlbedo(vec2 uv) {
-    return texture(s_AlbedoSpec, uv).rgb;
+    return texture(s_AlbedoSpec, SceneUV(uv)).rgb;
 }
 
-vec3 GetViewPosition(vec2 uv) {
-    return texture(s_Position, uv).rgb;
+float GetMetallic(vec2 uv) {
+    return texture(s_EmissiveMetallic, SceneUV(uv)).a;
 }
 
 float GetDepth(vec2 uv) {
-    return texelFetch(s_Depth, ivec2(uv * textureSize(s_Depth, 0)), 0).r;
+    return texelFetch(s_Depth, ivec2(SceneUV(uv) * textureSize(s_Depth, 0)), 0).r;
+}
+
+// Reconstructs the view space position of a pixel from the depth buffer, instead of storing it in the G-Buffer
+vec3 GetViewPosition(vec2 uv) {
+    vec4 clipPos = vec4(uv * 2.0 - 1.0, GetDepth(uv) * 2.0 - 1.0, 1.0);
+    vec4 viewPos = u_InvProjection * clipPos;
+    return viewPos.xyz / viewPos.w;
 }
\ No newline at end of file
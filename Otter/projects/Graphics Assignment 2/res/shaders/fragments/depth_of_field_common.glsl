@@ -0,0 +1,50 @@
+// Shared helpers for the depth of field passes, frame_uniforms.glsl must be included first
+//
+// Modified from:
+// http://tuxedolabs.blogspot.com/2018/05/bokeh-depth-of-field-in-single-pass.html
+
+const float GOLDEN_ANGLE = 2.39996323;
+const float MAX_BLUR_RADIUS = 20; // We impose a hard limit on blurring to avoid killing the GPU
+const float RAD_SCALE = 0.5;
+
+// Converts a screen space coord and a raw depth value into a world-space distance
+// @param screen The screen-space coordinate to convert
+// @param rawValue The raw, non-linear depth value to convert
+// @returns A distance to the camera in world units
+float DepthToDist(vec2 screen, float rawValue) {
+	vec4 screenPos = vec4(screen.x, screen.y, rawValue, 1.0) * 2.0 - 1.0;
+	vec4 viewPosition = u_InvProjection * screenPos;
+
+	return -(viewPosition.z / viewPosition.w);
+}
+
+/*
+* Calculates the Circle of Confusion for a given depth value
+* @param depth The depth of the fragment to caluculate for (in world units)
+* @param focalPlane The distance from the lense to the focal plane (in world units)
+* @param focalLength The focal length parameter (calculated as 1/F = 1/focalPlane + 1/distToSensor)
+* @see http://fileadmin.cs.lth.se/cs/Education/EDAN35/lectures/12DOF.pdf
+*/
+float getBlurSize(float depth, float focalPlane, float focalLength) {
+	float coc = clamp(
+        (focalLength * (focalPlane - depth)) / 
+        (depth * (focalPlane - focalLength)), 
+        -1.0, 1.0);
+	return abs(coc) * u_Aperture;
+}
+
+// Calculates our focal length (1/F = 1/focalPlane + 1/distToSensor)
+float GetFocalLength() {
+    return 1.0f / (1.0 / u_FocalDepth + 1.0 / u_LensDepth);
+}
+
+// Reads the raw depth under a UV across the output, the scene may only cover part of the depth buffer
+float SampleSceneDepth(sampler2D depthBuffer, vec2 uv) {
+    return texelFetch(depthBuffer, ivec2(SceneUV(uv) * textureSize(depthBuffer, 0)), 0).r;
+}
+
+// Gets the circle of confusion (in full resolution pixels) for a pixel in the depth buffer
+float GetCoC(sampler2D depthBuffer, vec2 uv) {
+    float depth = DepthToDist(uv, SampleSceneDepth(depthBuffer, uv));
+    return getBlurSize(depth, u_FocalDepth, GetFocalLength());
+}
@@ -33,18 +33,15 @@ layout (std140, binding = 0) uniform b_FrameLevelUniforms {
     // New for fun, the viewport rectangle on the output (x, y, w, h)
     uniform vec4 u_Viewport;
 
-};
+    // The fraction of the G-Buffer that the scene was rendered into in xy, and the largest UV that
+    // can be sampled without reading outside of it in zw, see RenderLayer::SetDynamicResolution
+    uniform vec4 u_RenderScale;
+
+    // The main camera's view projection from the previous frame, without any jitter
+    uniform mat4 u_PrevViewProjection;
+    // The main camera's jitter in NDC for this frame in xy, and for the previous frame in zw
+    uniform vec4 u_Jitter;
 
-// Stores uniforms that change every object/instance
-layout (std140, binding = 1) uniform b_InstanceLevelUniforms {
-    // Complete MVP
-    uniform mat4 u_ModelViewProjection;
-    // Just the model transform, we'll do worldspace lighting
-    uniform mat4 u_Model;
-    // Just the model * view, for converting to view space
-    uniform mat4 u_ModelView;
-    // Normal Matrix for transforming normals
-    uniform mat4 u_NormalMatrix;
 };
 
 #define FLAG_ENABLE_COLOR_CORRECTION (1 << 0)
@@ -57,6 +54,11 @@ bool IsMultipleFlagSet(uint flags) {
     return (u_Flags & flags) == flags;
 }
 
+// Maps a UV across the output to the region of the G-Buffer that the scene was rendered into
+vec2 SceneUV(vec2 uv) {
+    return min(uv * u_RenderScale.xy, u_RenderScale.zw);
+}
+
 float linearize(float depth) {
     return (2 * u_ZNear) / (u_ZFar + u_ZNear - depth * (u_ZFar - u_ZNear));
 }
\ No newline at end of file
@@ -2,4 +2,5 @@ layout(location = 0) in vec3 inViewPos;
 layout(location = 1) in vec3 inColor;
 layout(location = 2) in vec3 inNormal;
 layout(location = 3) in vec2 inUV;
-layout(location = 4) in mat3 inTBN;
\ No newline at end of file
+layout(location = 4) in mat3 inTBN;
+layout(location = 8) in vec4 inPrevClipPos;
\ No newline at end of file
@@ -0,0 +1,30 @@
+// Helpers for packing and unpacking the G-Buffer
+//
+// Normals are stored as octahedral coordinates in a 2 channel target, which maps the unit sphere onto
+// a square by projecting it onto an octahedron and folding the bottom half over the top. The cleared
+// value of (0, 0) is reserved to mean "no normal", so that the lighting passes can skip empty pixels
+
+// Gets the sign of each component, treating 0 as positive so that the fold stays on the right side
+vec2 OctSign(vec2 v) {
+    return vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+
+// Packs a unit length normal into the [0,1] range for storage in the G-Buffer
+vec2 EncodeNormal(vec3 n) {
+    n /= (abs(n.x) + abs(n.y) + abs(n.z));
+    vec2 result = n.z >= 0.0 ? n.xy : (1.0 - abs(n.yx)) * OctSign(n.xy);
+    // Keep clear of the reserved (0, 0) value, this is less than a texel in a 16 bit target
+    return max(result * 0.5 + 0.5, vec2(1.0 / 65535.0));
+}
+
+// Unpacks a normal stored with EncodeNormal, returns a zero vector for pixels that have no normal
+vec3 DecodeNormal(vec2 encoded) {
+    if (encoded.x == 0.0 && encoded.y == 0.0) {
+        return vec3(0.0);
+    }
+    vec2 f = encoded * 2.0 - 1.0;
+    vec3 n = vec3(f, 1.0 - abs(f.x) - abs(f.y));
+    float t = clamp(-n.z, 0.0, 1.0);
+    n.xy -= t * OctSign(n.xy);
+    return normalize(n);
+}
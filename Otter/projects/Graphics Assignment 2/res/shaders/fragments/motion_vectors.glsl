@@ -0,0 +1,12 @@
+// Motion vectors for the G-Buffer, frame_uniforms.glsl must be included before this file
+//
+// Motion is stored as the distance a pixel has moved across the screen since the previous frame in UV
+// units, so the previous position of a pixel is it's UV minus the motion. The camera's jitter is taken
+// out, so that a scene that is standing still has no motion even though the image is moving
+
+// Gets the motion for this fragment, from it's position on the previous frame (see GetPrevClipPos in vs_common.glsl)
+vec2 GetMotionVector(vec4 prevClipPos) {
+    vec2 ndc = (gl_FragCoord.xy - u_Viewport.xy) / u_Viewport.zw * 2.0 - 1.0;
+    vec2 prevNdc = prevClipPos.xy / prevClipPos.w;
+    return ((ndc - u_Jitter.xy) - prevNdc) * 0.5;
+}
@@ -8,12 +8,48 @@ layout(location = 3) in vec2 inUV;
 layout(location = 4) in vec3 inTangent;
 layout(location = 5) in vec3 inBiTangent;
 
+// Per-instance inputs, these come from an instanced vertex buffer so that many copies of
+// a mesh can be drawn in a single call
+// This will consume 4 slots, since it's essentially 4 vec4s in memory
+layout(location = 8) in mat4 inModelTransform;
+// The transform this instance was drawn with on the previous frame, for motion vectors, also 4 slots
+layout(location = 12) in mat4 inPrevModelTransform;
+
 // Standard vertex shader outputs
 layout(location = 0) out vec3 outViewPos;
 layout(location = 1) out vec3 outColor;
 layout(location = 2) out vec3 outNormal;
 layout(location = 3) out vec2 outUV;
 layout(location = 4) out mat3 outTBN;
+// Where the vertex was on the previous frame, see GetPrevClipPos
+layout(location = 8) out vec4 outPrevClipPos;
+
+// The depth pre-pass draws with a different fragment shader, positions need to come out exactly the
+// same in both programs for the G-Buffer pass's equal depth test to pass
+invariant gl_Position;
 
 // Include the matrices and frame level parameters
 #include "frame_uniforms.glsl"
+
+// The normal matrix is the inverse transpose of the model's upper 3x3, which is it's cofactor matrix over it's
+// determinant. This is cheap enough to build per vertex that it's not worth sending as another instanced attribute
+mat3 GetNormalMatrix() {
+    mat3 m = mat3(inModelTransform);
+    vec3 c0 = cross(m[1], m[2]);
+    vec3 c1 = cross(m[2], m[0]);
+    vec3 c2 = cross(m[0], m[1]);
+    return mat3(c0, c1, c2) / dot(m[0], c0);
+}
+
+// Projects a position in object space with the transform and camera from the previous frame, every shader
+// that writes to the G-Buffer should write this to outPrevClipPos for motion vectors
+vec4 GetPrevClipPos(vec3 position) {
+    return u_PrevViewProjection * (inPrevModelTransform * vec4(position, 1.0));
+}
+
+// Our object level matrices used to be uniforms, these let our shaders keep using the same names
+#define inNormalMatrix        GetNormalMatrix()
+#define u_Model               inModelTransform
+#define u_NormalMatrix        inNormalMatrix
+#define u_ModelView           (u_View * inModelTransform)
+#define u_ModelViewProjection (u_ViewProjection * inModelTransform)
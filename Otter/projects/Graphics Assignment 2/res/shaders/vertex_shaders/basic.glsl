@@ -6,6 +6,7 @@
 void main() {
 
 	gl_Position = u_ModelViewProjection * vec4(inPosition, 1.0);
+	outPrevClipPos = GetPrevClipPos(inPosition);
 
 	// Lecture 5
 	// Pass vertex pos in world space to frag shader
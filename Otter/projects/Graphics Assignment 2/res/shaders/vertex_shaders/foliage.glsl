@@ -15,6 +15,8 @@ void main() {
 	outViewPos = (u_ModelView * vec4(inPosition, 1.0)).xyz + windFactor;
     // Project the world position to determine the screenspace position
 	gl_Position = u_Projection * vec4(outViewPos, 1);
+    // The wind is left out, it only moves the leaves a little between frames
+    outPrevClipPos = GetPrevClipPos(inPosition);
 
 	// Normals
 	outNormal = mat3(u_NormalMatrix) * normalize(inNormal);
@@ -0,0 +1,14 @@
+#version 450
+
+layout (location = 0) in vec3 inPosition;
+
+layout (location = 0) out vec2 outUV;
+
+// Transforms the unit sphere to the light's range, in clip space
+uniform mat4 u_LightVolume;
+
+void main() {
+    gl_Position = u_LightVolume * vec4(inPosition, 1.0);
+    // The lighting shader looks up the G-Buffer with gl_FragCoord, this is just to match the fullscreen quad
+    outUV = (gl_Position.xy / gl_Position.w + 1) / 2;
+}
@@ -3,6 +3,9 @@
 layout(location = 0) in vec3 inPosition;
 
 layout(location = 0) out vec3 outNormal;
+layout(location = 1) out vec4 outPrevClipPos;
+
+#include "../fragments/frame_uniforms.glsl"
 
 uniform mat4 u_ClippedView;
 uniform mat3 u_EnvironmentRotation;
@@ -13,4 +16,9 @@ void main() {
 
     // Normals
     outNormal = normalize(u_EnvironmentRotation * inPosition);
+
+    // The skybox is drawn around the camera in view space, and is infinitely far away, so only the
+    // camera's rotation moves it
+    vec3 worldDir = transpose(mat3(u_View)) * inPosition;
+    outPrevClipPos = u_PrevViewProjection * vec4(worldDir, 0.0);
 }
\ No newline at end of file
@@ -12,6 +12,7 @@ layout(location = 7) out vec4 outTextureWeights;
 void main() {
 
 	gl_Position = u_ModelViewProjection * vec4(inPosition, 1.0);
+	outPrevClipPos = GetPrevClipPos(inPosition);
 
 	// Pass vertex pos in world space to frag shader
 	outViewPos = (u_ModelView * vec4(inPosition, 1.0)).xyz;
@@ -17,6 +17,7 @@
 #include "Graphics/Buffers/IndexBuffer.h"
 #include "Graphics/Buffers/VertexBuffer.h"
 #include "Graphics/VertexArrayObject.h"
+#include "Graphics/MeshArena.h"
 #include "Graphics/ShaderProgram.h"
 #include "Graphics/Textures/Texture1D.h"
 #include "Graphics/Textures/Texture2D.h"
@@ -234,6 +235,9 @@ void Application::_Run()
 		InputEngine::EndFrame();
 		ImGuiHelper::EndFrame();
 
+		// Everything for this frame has been submitted, streaming buffers can re-use it's region once the GPU is done
+		IBuffer::EndFrame();
+
 		glfwSwapBuffers(_window);
 
 	}
@@ -589,6 +593,9 @@ void Application::_Unload() {
 
 	// Clean up ImGui
 	ImGuiHelper::Cleanup();
+
+	// Release our mesh data while we still have an OpenGL context
+	MeshArena::ReleaseAll();
 }
 
 void Application::_HandleSceneChange() {
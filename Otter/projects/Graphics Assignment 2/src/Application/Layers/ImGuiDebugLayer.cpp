@@ -17,6 +17,7 @@
 #include "../Windows/PostProcessingSettingsWindow.h"
 
 #include "Graphics/DebugDraw.h"
+#include "Graphics/GlState.h"
 
 ImGuiDebugLayer::ImGuiDebugLayer() :
 	ApplicationLayer(),
@@ -253,8 +254,8 @@ void ImGuiDebugLayer::OnPostRender()
 	const glm::uvec4& viewport = app.GetPrimaryViewport();
 	glViewport(viewport.x, viewport.y, viewport.z, viewport.w);
  
-	glEnable(GL_DEPTH_TEST);
-	glDepthMask(true);
+	GlState::Enable(GL_DEPTH_TEST);
+	GlState::DepthMask(true);
 
 	glClear(GL_DEPTH_BUFFER_BIT);
 
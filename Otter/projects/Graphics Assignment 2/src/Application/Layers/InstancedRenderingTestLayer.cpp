@@ -32,9 +32,10 @@ void InstancedRenderingTestLayer::OnSceneLoad() {
 		BufferAttribute(10, 4, AttributeType::Float, sizeof(InstanceInfo), 8 * sizeof(float), AttribUsage::User0),
 		BufferAttribute(11, 4, AttributeType::Float, sizeof(InstanceInfo), 12 * sizeof(float), AttribUsage::User0),
 
-		BufferAttribute(12, 3, AttributeType::Float, sizeof(InstanceInfo), 16 * sizeof(float), AttribUsage::User0),
-		BufferAttribute(13, 3, AttributeType::Float, sizeof(InstanceInfo), 20 * sizeof(float), AttribUsage::User0),
-		BufferAttribute(14, 3, AttributeType::Float, sizeof(InstanceInfo), 24 * sizeof(float), AttribUsage::User0),
+		BufferAttribute(12, 4, AttributeType::Float, sizeof(InstanceInfo), 16 * sizeof(float), AttribUsage::User0),
+		BufferAttribute(13, 4, AttributeType::Float, sizeof(InstanceInfo), 20 * sizeof(float), AttribUsage::User0),
+		BufferAttribute(14, 4, AttributeType::Float, sizeof(InstanceInfo), 24 * sizeof(float), AttribUsage::User0),
+		BufferAttribute(15, 4, AttributeType::Float, sizeof(InstanceInfo), 28 * sizeof(float), AttribUsage::User0),
 	};
 
 	// Load a file to get the base VAO, then add the instanced buffers
@@ -93,8 +94,9 @@ void InstancedRenderingTestLayer::_UpdateInstances() {
 	for (int ix = 0; ix < _instances.size(); ix++) {
 		// For now just update everything regardless of if it's changed or not
 		// A smarter system would only update if the data is old
-		data[ix].ModelMatrix  = _instances[ix]->GetTransform();
-		data[ix].NormalMatrix = glm::mat3(glm::transpose(glm::inverse(_instances[ix]->GetTransform())));
+		// The instances are only uploaded once, so there is no motion to track
+		data[ix].ModelMatrix     = _instances[ix]->GetTransform();
+		data[ix].PrevModelMatrix = data[ix].ModelMatrix;
 	}
 
 	// Unmap the buffer so that the GPU can see it again
@@ -33,7 +33,8 @@ protected:
 
 	struct InstanceInfo {
 		glm::mat4 ModelMatrix;
-		glm::mat4 NormalMatrix;
+		// The model matrix from the previous frame, for motion vectors
+		glm::mat4 PrevModelMatrix;
 	};
 
 	void _UpdateInstances();
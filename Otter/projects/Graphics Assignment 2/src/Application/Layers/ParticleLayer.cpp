@@ -2,6 +2,7 @@
 #include "Gameplay/Components/ParticleSystem.h"
 #include "Application/Application.h"
 #include "RenderLayer.h"
+#include "Graphics/GlState.h"
 
 ParticleLayer::ParticleLayer() :
 	ApplicationLayer()
@@ -17,7 +18,7 @@ void ParticleLayer::OnUpdate()
 {
 	Application& app = Application::Get();
 
-	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	GlState::BindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
 
 	// Only update the particle systems when the game is playing, so we can edit them in
 	// the inspector
@@ -7,7 +7,7 @@
 #include <GLM/glm.hpp>
 
 BoxFilter3x3::BoxFilter3x3() :
-	PostProcessingLayer::Effect()
+	SeparableEffect()
 {
 	Name = "Box Filter";
 	_format = RenderTargetType::ColorRgb8;
@@ -26,6 +26,17 @@ BoxFilter3x3::~BoxFilter3x3() = default;
 
 void BoxFilter3x3::Apply(const Framebuffer::Sptr& gBuffer)
 {
+	// Separable kernels need at most 6 samples per pixel over two passes instead of 9, and fewer once
+	// neighbouring taps are merged into bilinear samples
+	std::vector<float> row, column;
+	if (BlurKernel::Factorize(Filter, 3, row, column)) {
+		std::vector<BlurKernel::Tap> horizontal, vertical;
+		BlurKernel::GetLinearTaps(row, horizontal);
+		BlurKernel::GetLinearTaps(column, vertical);
+		_ApplySeparable(horizontal, vertical);
+		return;
+	}
+
 	_shader->Bind(); 
 	_shader->SetUniform("u_Filter", Filter, 9); 
 	_shader->SetUniform("u_PixelSize", glm::vec2(1.0f) / (glm::vec2)gBuffer->GetSize()); 
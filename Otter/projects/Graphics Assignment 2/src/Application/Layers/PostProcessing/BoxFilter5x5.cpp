@@ -7,7 +7,7 @@
 #include <GLM/glm.hpp>
 
 BoxFilter5x5::BoxFilter5x5() :
-	PostProcessingLayer::Effect()
+	SeparableEffect()
 {
 	Name = "Box Filter";
 	_format = RenderTargetType::ColorRgb8;
@@ -25,6 +25,17 @@ BoxFilter5x5::~BoxFilter5x5() = default;
 
 void BoxFilter5x5::Apply(const Framebuffer::Sptr& gBuffer)
 {
+	// Separable kernels need at most 10 samples per pixel over two passes instead of 25, and fewer once
+	// neighbouring taps are merged into bilinear samples
+	std::vector<float> row, column;
+	if (BlurKernel::Factorize(Filter, 5, row, column)) {
+		std::vector<BlurKernel::Tap> horizontal, vertical;
+		BlurKernel::GetLinearTaps(row, horizontal);
+		BlurKernel::GetLinearTaps(column, vertical);
+		_ApplySeparable(horizontal, vertical);
+		return;
+	}
+
 	_shader->Bind();
 	_shader->SetUniform("u_Filter", Filter, 25);
 	_shader->SetUniform("u_PixelSize", glm::vec2(1.0f) / (glm::vec2)gBuffer->GetSize()); 
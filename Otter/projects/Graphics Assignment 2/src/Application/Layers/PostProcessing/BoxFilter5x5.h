@@ -1,10 +1,15 @@
 #pragma once
-#include "Application/Layers/PostProcessingLayer.h"
+#include "SeparableEffect.h"
 #include "Graphics/ShaderProgram.h"
 #include "Graphics/Textures/Texture3D.h"
 #include "Graphics/Framebuffer.h"
 
-class BoxFilter5x5 : public PostProcessingLayer::Effect {
+/**
+ * Applies a user defined 5x5 kernel to the image. Kernels that can be split into a row and
+ * a column (such as box and gaussian blurs) are run as two 1D passes, anything else falls
+ * back to sampling the full 2D kernel
+ */
+class BoxFilter5x5 : public SeparableEffect {
 public:
 	MAKE_PTRS(BoxFilter5x5);
 	float Filter[25];
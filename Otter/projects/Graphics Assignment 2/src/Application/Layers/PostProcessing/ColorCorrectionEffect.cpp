@@ -27,7 +27,7 @@ ColorCorrectionEffect::ColorCorrectionEffect(bool defaultLut) :
 
 ColorCorrectionEffect::~ColorCorrectionEffect() = default;
 
-void ColorCorrectionEffect::Apply(const Framebuffer::Sptr& gBuffer)
+void ColorCorrectionEffect::Apply(const Framebuffer::Sptr& /*gBuffer*/)
 {
 	_shader->Bind();
 	Lut->Bind(1);
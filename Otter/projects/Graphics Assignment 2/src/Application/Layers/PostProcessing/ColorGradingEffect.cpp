@@ -0,0 +1,124 @@
+#include "ColorGradingEffect.h"
+#include "Utils/ResourceManager/ResourceManager.h"
+#include "Utils/JsonGlmHelpers.h"
+#include "Utils/ImGuiHelper.h"
+
+ColorGradingEffect::ColorGradingEffect() :
+	ColorGradingEffect(true) { }
+
+ColorGradingEffect::ColorGradingEffect(bool defaultLuts) :
+	PostProcessingLayer::Effect(),
+	Luts(std::vector<LutLayer>()),
+	GrainAmount(0.1f),
+	VignetteStrength(0.0f),
+	VignetteRadius(0.75f),
+	VignetteSoftness(0.45f),
+	_shader(nullptr)
+{
+	Name = "Color Grading";
+	_format = RenderTargetType::ColorRgb8;
+
+	_shader = ResourceManager::CreateAsset<ShaderProgram>(std::unordered_map<ShaderPartType, std::string>{
+		{ ShaderPartType::Vertex, "shaders/vertex_shaders/fullscreen_quad.glsl" },
+		{ ShaderPartType::Fragment, "shaders/fragment_shaders/post_effects/color_grading.glsl" }
+	});
+
+	if (defaultLuts) {
+		Luts.push_back({ ResourceManager::CreateAsset<Texture3D>("luts/cool.cube"), 0.4f, true });
+		Luts.push_back({ ResourceManager::CreateAsset<Texture3D>("luts/noir.cube"), 0.4f, true });
+		Luts.push_back({ ResourceManager::CreateAsset<Texture3D>("luts/warm.cube"), 0.4f, true });
+	}
+}
+
+ColorGradingEffect::~ColorGradingEffect() = default;
+
+void ColorGradingEffect::Apply(const Framebuffer::Sptr& /*gBuffer*/)
+{
+	_shader->Bind();
+
+	// Pack the enabled LUTs down to the front, so the shader only has to loop over the ones in use
+	float strengths[MAX_LUTS];
+	int lutCount = 0;
+	for (const LutLayer& layer : Luts) {
+		if (lutCount < MAX_LUTS && layer.Enabled && layer.Lut != nullptr && layer.Strength > 0.0f) {
+			layer.Lut->Bind(1 + lutCount);
+			strengths[lutCount] = glm::clamp(layer.Strength, 0.0f, 1.0f);
+			lutCount++;
+		}
+	}
+	_shader->SetUniform("u_LutCount", lutCount);
+	if (lutCount > 0) {
+		_shader->SetUniform("u_LutStrengths", strengths, lutCount);
+	}
+
+	_shader->SetUniform("u_GrainAmount", GrainAmount);
+	_shader->SetUniform("u_Vignette", glm::vec3(VignetteStrength, VignetteRadius, VignetteSoftness));
+}
+
+void ColorGradingEffect::RenderImGui()
+{
+	ImGui::PushID(this);
+
+	for (size_t ix = 0; ix < Luts.size(); ix++) {
+		ImGui::PushID(static_cast<int>(ix));
+		LutLayer& layer = Luts[ix];
+		ImGui::Checkbox("", &layer.Enabled);
+		ImGui::SameLine();
+		ImGui::TextUnformatted(layer.Lut ? layer.Lut->GetDebugName().c_str() : "none");
+		ImGui::SameLine();
+		ImGui::SliderFloat("##strength", &layer.Strength, 0, 1);
+		ImGui::PopID();
+	}
+	if (Luts.size() > MAX_LUTS) {
+		ImGui::TextColored(ImVec4(1.0f, 0.5f, 0.0f, 1.0f), "Only the first %d enabled LUTs are applied", MAX_LUTS);
+	}
+	ImGui::Separator();
+
+	LABEL_LEFT(ImGui::SliderFloat, "Grain", &GrainAmount, 0, 1);
+	LABEL_LEFT(ImGui::SliderFloat, "Vignette", &VignetteStrength, 0, 1);
+	LABEL_LEFT(ImGui::SliderFloat, "Vignette Radius", &VignetteRadius, 0, 1);
+	LABEL_LEFT(ImGui::SliderFloat, "Vignette Softness", &VignetteSoftness, 0.01f, 1);
+
+	ImGui::PopID();
+}
+
+ColorGradingEffect::Sptr ColorGradingEffect::FromJson(const nlohmann::json& data)
+{
+	ColorGradingEffect::Sptr result = std::make_shared<ColorGradingEffect>(false);
+	result->Enabled = JsonGet(data, "enabled", true);
+	if (data.contains("luts") && data["luts"].is_array()) {
+		for (const auto& blob : data["luts"]) {
+			LutLayer layer;
+			layer.Lut = ResourceManager::Get<Texture3D>(Guid(blob["lut"].get<std::string>()));
+			layer.Strength = JsonGet(blob, "strength", 1.0f);
+			layer.Enabled = JsonGet(blob, "enabled", true);
+			result->Luts.push_back(layer);
+		}
+	}
+	result->GrainAmount = JsonGet(data, "grain", result->GrainAmount);
+	result->VignetteStrength = JsonGet(data, "vignette", result->VignetteStrength);
+	result->VignetteRadius = JsonGet(data, "vignette_radius", result->VignetteRadius);
+	result->VignetteSoftness = JsonGet(data, "vignette_softness", result->VignetteSoftness);
+	return result;
+}
+
+nlohmann::json ColorGradingEffect::ToJson() const
+{
+	nlohmann::json luts = nlohmann::json::array();
+	for (const LutLayer& layer : Luts) {
+		luts.push_back({
+			{ "lut", layer.Lut != nullptr ? layer.Lut->GetGUID().str() : "null" },
+			{ "strength", layer.Strength },
+			{ "enabled", layer.Enabled }
+		});
+	}
+
+	return {
+		{ "enabled", Enabled },
+		{ "luts", luts },
+		{ "grain", GrainAmount },
+		{ "vignette", VignetteStrength },
+		{ "vignette_radius", VignetteRadius },
+		{ "vignette_softness", VignetteSoftness }
+	};
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include "Application/Layers/PostProcessingLayer.h"
+#include "Graphics/ShaderProgram.h"
+#include "Graphics/Textures/Texture3D.h"
+
+/**
+ * Applies all of our per-pixel effects (LUT grading, film grain and vignette) in a single
+ * fullscreen pass, instead of running a pass for each of them
+ *
+ * LUTs are applied one after the other in the shader, so stacking grades only costs
+ * another 3D texture lookup rather than another fullscreen pass
+ */
+class ColorGradingEffect : public PostProcessingLayer::Effect {
+public:
+	MAKE_PTRS(ColorGradingEffect);
+
+	// The most LUTs that can be stacked, must match MAX_LUTS in color_grading.glsl
+	static const int MAX_LUTS = 4;
+
+	/**
+	 * A single LUT in the grading stack
+	 */
+	struct LutLayer {
+		Texture3D::Sptr Lut;
+		float           Strength;
+		bool            Enabled;
+	};
+
+	// The LUTs to apply, in order
+	std::vector<LutLayer> Luts;
+
+	// How much noise to add to the image
+	float GrainAmount;
+	// How much the corners of the screen are darkened, 0 to disable
+	float VignetteStrength;
+	// The distance from the center of the screen that darkening starts at
+	float VignetteRadius;
+	// The distance over which the vignette fades in
+	float VignetteSoftness;
+
+	ColorGradingEffect();
+	ColorGradingEffect(bool defaultLuts);
+	virtual ~ColorGradingEffect();
+
+	virtual void Apply(const Framebuffer::Sptr& gBuffer) override;
+	virtual void RenderImGui() override;
+
+	// Inherited from IResource
+
+	ColorGradingEffect::Sptr FromJson(const nlohmann::json& data);
+	virtual nlohmann::json ToJson() const override;
+
+protected:
+	ShaderProgram::Sptr _shader;
+};
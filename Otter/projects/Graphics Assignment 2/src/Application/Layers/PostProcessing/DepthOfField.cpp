@@ -7,23 +7,74 @@
 
 DepthOfField::DepthOfField() :
 	PostProcessingLayer::Effect(),
-	_shader(nullptr)
+	_downsampleShader(nullptr),
+	_shader(nullptr),
+	_upsampleShader(nullptr),
+	_halfColor(RenderGraph::INVALID),
+	_halfBlurred(RenderGraph::INVALID)
 {
 	Name = "Depth of Field";
 	_format = RenderTargetType::ColorRgb8;
 
+	_downsampleShader = ResourceManager::CreateAsset<ShaderProgram>(std::unordered_map<ShaderPartType, std::string>{
+		{ ShaderPartType::Vertex, "shaders/vertex_shaders/fullscreen_quad.glsl" },
+		{ ShaderPartType::Fragment, "shaders/fragment_shaders/post_effects/depth_of_field_downsample.glsl" }
+	});
 	_shader = ResourceManager::CreateAsset<ShaderProgram>(std::unordered_map<ShaderPartType, std::string>{
 		{ ShaderPartType::Vertex, "shaders/vertex_shaders/fullscreen_quad.glsl" },
 		{ ShaderPartType::Fragment, "shaders/fragment_shaders/post_effects/depth_of_field.glsl" }
 	});
+	_upsampleShader = ResourceManager::CreateAsset<ShaderProgram>(std::unordered_map<ShaderPartType, std::string>{
+		{ ShaderPartType::Vertex, "shaders/vertex_shaders/fullscreen_quad.glsl" },
+		{ ShaderPartType::Fragment, "shaders/fragment_shaders/post_effects/depth_of_field_upsample.glsl" }
+	});
 }
 
 DepthOfField::~DepthOfField() = default;
 
+void DepthOfField::DeclareTargets(RenderGraph& graph, RenderGraph::PassId pass, RenderGraph::ResourceId output)
+{
+	const RenderGraph::TextureDesc& outputDesc = graph.GetDesc(output);
+
+	// The circle of confusion needs more precision than 8 bits, and the blur goes through two passes
+	RenderGraph::TextureDesc halfDesc((outputDesc.Width + 1) / 2, (outputDesc.Height + 1) / 2, RenderTargetType::ColorRgba16F);
+	_halfColor = graph.CreateTexture(Name + " Half Color", halfDesc);
+	_halfBlurred = graph.CreateTexture(Name + " Half Blurred", halfDesc);
+	graph.Write(pass, _halfColor);
+	graph.Read(pass, _halfColor);
+	graph.Write(pass, _halfBlurred);
+	graph.Read(pass, _halfBlurred);
+}
+
 void DepthOfField::Apply(const Framebuffer::Sptr& gBuffer)
 {
-	_shader->Bind();
+	const Framebuffer::Sptr& halfColor = _GetTarget(_halfColor);
+	const Framebuffer::Sptr& halfBlurred = _GetTarget(_halfBlurred);
+	glm::ivec2 halfSize = halfColor->GetSize();
+
+	// The previous effect's output stays in slot 0 for the upsample, so the half
+	// resolution buffers are bound to slots 2 and 3
 	gBuffer->BindAttachment(RenderTargetAttachment::Depth, 1);
+
+	// Shrink the image and find the circle of confusion for each pixel
+	_downsampleShader->Bind();
+	halfColor->Bind();
+	glViewport(0, 0, halfSize.x, halfSize.y);
+	DrawFullscreen();
+	halfColor->Unbind();
+
+	// Gather the blur at half resolution, this takes about a quarter of the samples of a full resolution gather
+	_shader->Bind();
+	halfBlurred->Bind();
+	halfColor->BindAttachment(RenderTargetAttachment::Color0, 2);
+	DrawFullscreen();
+	halfBlurred->Unbind();
+
+	// The layer draws the upsample into our output
+	_upsampleShader->Bind();
+	_output->Bind();
+	glViewport(0, 0, _output->GetWidth(), _output->GetHeight());
+	halfBlurred->BindAttachment(RenderTargetAttachment::Color0, 3);
 }
 
 void DepthOfField::RenderImGui()
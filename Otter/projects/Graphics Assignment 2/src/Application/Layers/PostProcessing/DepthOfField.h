@@ -5,6 +5,10 @@
 #include "Graphics/Textures/Texture3D.h"
 #include "Graphics/Framebuffer.h"
 
+/**
+ * Depth of field that gathers the blur at half resolution, then does a bilateral upsample
+ * that uses the circle of confusion to keep blur from leaking over objects that are in focus
+ */
 class DepthOfField : public PostProcessingLayer::Effect {
 public:
 	MAKE_PTRS(DepthOfField);
@@ -13,6 +17,7 @@ public:
 	virtual ~DepthOfField();
 
 	virtual void Apply(const Framebuffer::Sptr& gBuffer) override;
+	virtual void DeclareTargets(RenderGraph& graph, RenderGraph::PassId pass, RenderGraph::ResourceId output) override;
 	virtual void RenderImGui() override;
 
 	// Inherited from IResource
@@ -21,5 +26,12 @@ public:
 	virtual nlohmann::json ToJson() const override;
 
 protected:
+	ShaderProgram::Sptr _downsampleShader;
 	ShaderProgram::Sptr _shader;
+	ShaderProgram::Sptr _upsampleShader;
+
+	// Half resolution color with the circle of confusion in alpha
+	RenderGraph::ResourceId _halfColor;
+	// Half resolution result of the gather pass
+	RenderGraph::ResourceId _halfBlurred;
 };
\ No newline at end of file
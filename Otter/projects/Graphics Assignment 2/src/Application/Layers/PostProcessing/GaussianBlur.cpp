@@ -0,0 +1,57 @@
+#include "GaussianBlur.h"
+#include "Utils/JsonGlmHelpers.h"
+#include "Utils/ImGuiHelper.h"
+
+GaussianBlur::GaussianBlur() :
+	SeparableEffect(),
+	Radius(MAX_RADIUS),
+	Sigma(4.0f),
+	_taps(std::vector<BlurKernel::Tap>()),
+	_tapsRadius(-1),
+	_tapsSigma(0.0f)
+{
+	Name = "Gaussian Blur";
+	Enabled = false;
+	_format = RenderTargetType::ColorRgb8;
+}
+
+GaussianBlur::~GaussianBlur() = default;
+
+void GaussianBlur::Apply(const Framebuffer::Sptr& /*gBuffer*/)
+{
+	Radius = glm::clamp(Radius, 0, MAX_RADIUS);
+	if (Radius != _tapsRadius || Sigma != _tapsSigma) {
+		std::vector<float> weights;
+		BlurKernel::GetGaussianWeights(Radius, Sigma, weights);
+		BlurKernel::GetLinearTaps(weights, _taps);
+		_tapsRadius = Radius;
+		_tapsSigma = Sigma;
+	}
+
+	_ApplySeparable(_taps, _taps);
+}
+
+void GaussianBlur::RenderImGui()
+{
+	LABEL_LEFT(ImGui::SliderInt, "Radius", &Radius, 0, MAX_RADIUS);
+	LABEL_LEFT(ImGui::SliderFloat, "Sigma", &Sigma, 0.1f, 10.0f);
+	ImGui::Text("%d taps per pass", static_cast<int>(_taps.size()));
+}
+
+GaussianBlur::Sptr GaussianBlur::FromJson(const nlohmann::json& data)
+{
+	GaussianBlur::Sptr result = std::make_shared<GaussianBlur>();
+	result->Enabled = JsonGet(data, "enabled", false);
+	result->Radius = JsonGet(data, "radius", result->Radius);
+	result->Sigma = JsonGet(data, "sigma", result->Sigma);
+	return result;
+}
+
+nlohmann::json GaussianBlur::ToJson() const
+{
+	return {
+		{ "enabled", Enabled },
+		{ "radius", Radius },
+		{ "sigma", Sigma }
+	};
+}
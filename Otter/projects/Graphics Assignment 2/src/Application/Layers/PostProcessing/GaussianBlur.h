@@ -0,0 +1,36 @@
+#pragma once
+#include "SeparableEffect.h"
+
+/**
+ * A separable gaussian blur, using bilinear taps so that a kernel with a radius of
+ * 12 texels (25 texels wide) only takes 13 samples per pass
+ */
+class GaussianBlur : public SeparableEffect {
+public:
+	MAKE_PTRS(GaussianBlur);
+
+	// The largest radius we allow, keeps the number of taps within BlurKernel::MAX_TAPS
+	static const int MAX_RADIUS = 12;
+
+	// The number of texels on either side of the center to blur
+	int   Radius;
+	// The standard deviation of the gaussian, in texels
+	float Sigma;
+
+	GaussianBlur();
+	virtual ~GaussianBlur();
+
+	virtual void Apply(const Framebuffer::Sptr& gBuffer) override;
+	virtual void RenderImGui() override;
+
+	// Inherited from IResource
+
+	GaussianBlur::Sptr FromJson(const nlohmann::json& data);
+	virtual nlohmann::json ToJson() const override;
+
+protected:
+	// The taps are only rebuilt when the settings change
+	std::vector<BlurKernel::Tap> _taps;
+	int   _tapsRadius;
+	float _tapsSigma;
+};
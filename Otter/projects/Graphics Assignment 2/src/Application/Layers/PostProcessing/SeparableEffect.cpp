@@ -0,0 +1,66 @@
+#include "SeparableEffect.h"
+#include "Utils/ResourceManager/ResourceManager.h"
+#include "Logging.h"
+
+SeparableEffect::SeparableEffect() :
+	PostProcessingLayer::Effect(),
+	_separableShader(nullptr),
+	_intermediate(RenderGraph::INVALID)
+{
+	_separableShader = ResourceManager::CreateAsset<ShaderProgram>(std::unordered_map<ShaderPartType, std::string>{
+		{ ShaderPartType::Vertex, "shaders/vertex_shaders/fullscreen_quad.glsl" },
+		{ ShaderPartType::Fragment, "shaders/fragment_shaders/post_effects/separable_blur.glsl" }
+	});
+}
+
+SeparableEffect::~SeparableEffect() = default;
+
+void SeparableEffect::DeclareTargets(RenderGraph& graph, RenderGraph::PassId pass, RenderGraph::ResourceId output)
+{
+	// The intermediate follows the size of our output, and is shared with other effects' scratch targets
+	const RenderGraph::TextureDesc& outputDesc = graph.GetDesc(output);
+	_intermediate = graph.CreateTexture(Name + " Intermediate", RenderGraph::TextureDesc(outputDesc.Width, outputDesc.Height, RenderTargetType::ColorRgb16F));
+	graph.Write(pass, _intermediate);
+	graph.Read(pass, _intermediate);
+}
+
+void SeparableEffect::_ApplySeparable(const std::vector<BlurKernel::Tap>& horizontal, const std::vector<BlurKernel::Tap>& vertical)
+{
+	glm::ivec2 size = _output->GetSize();
+	const Framebuffer::Sptr& intermediate = _GetTarget(_intermediate);
+
+	_separableShader->Bind();
+
+	// Horizontal pass, reading from the previous effect's output in slot 0
+	intermediate->Bind();
+	glViewport(0, 0, size.x, size.y);
+	_SetTaps(horizontal, glm::vec2(1.0f / size.x, 0.0f));
+	DrawFullscreen();
+	intermediate->Unbind();
+
+	// Vertical pass, the layer will draw this one into our output
+	_output->Bind();
+	glViewport(0, 0, size.x, size.y);
+	intermediate->BindAttachment(RenderTargetAttachment::Color0, 0);
+	_SetTaps(vertical, glm::vec2(0.0f, 1.0f / size.y));
+}
+
+void SeparableEffect::_SetTaps(const std::vector<BlurKernel::Tap>& taps, const glm::vec2& direction)
+{
+	LOG_ASSERT(taps.size() <= BlurKernel::MAX_TAPS, "Too many taps for a single blur pass!");
+
+	float offsets[BlurKernel::MAX_TAPS];
+	float weights[BlurKernel::MAX_TAPS];
+	int count = glm::min(static_cast<int>(taps.size()), BlurKernel::MAX_TAPS);
+	for (int ix = 0; ix < count; ix++) {
+		offsets[ix] = taps[ix].Offset;
+		weights[ix] = taps[ix].Weight;
+	}
+
+	_separableShader->SetUniform("u_Direction", direction);
+	_separableShader->SetUniform("u_TapCount", count);
+	if (count > 0) {
+		_separableShader->SetUniform("u_Offsets", offsets, count);
+		_separableShader->SetUniform("u_Weights", weights, count);
+	}
+}
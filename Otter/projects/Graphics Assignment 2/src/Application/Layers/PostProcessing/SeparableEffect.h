@@ -0,0 +1,39 @@
+#pragma once
+#include "Application/Layers/PostProcessingLayer.h"
+#include "Graphics/ShaderProgram.h"
+#include "Graphics/Framebuffer.h"
+#include "Graphics/BlurKernel.h"
+
+/**
+ * Base class for effects that can be applied as a horizontal pass followed by a vertical
+ * pass. The horizontal pass renders into a scratch target from the layer's render graph,
+ * and the vertical pass is left bound for the post processing layer to draw into the
+ * effect's output
+ */
+class SeparableEffect : public PostProcessingLayer::Effect {
+public:
+	MAKE_PTRS(SeparableEffect);
+
+	virtual ~SeparableEffect();
+
+	virtual void DeclareTargets(RenderGraph& graph, RenderGraph::PassId pass, RenderGraph::ResourceId output) override;
+
+protected:
+	ShaderProgram::Sptr _separableShader;
+	// Holds the result of the horizontal pass, kept at a higher precision since
+	// the vertical pass is not finished with it yet
+	RenderGraph::ResourceId _intermediate;
+
+	SeparableEffect();
+
+	/**
+	 * Runs the horizontal pass, and binds the vertical pass for the post processing
+	 * layer to draw. Must be called from within Apply
+	 * @param horizontal The taps to sample along the X axis
+	 * @param vertical The taps to sample along the Y axis
+	 */
+	void _ApplySeparable(const std::vector<BlurKernel::Tap>& horizontal, const std::vector<BlurKernel::Tap>& vertical);
+
+	// Uploads a list of taps to the separable shader
+	void _SetTaps(const std::vector<BlurKernel::Tap>& taps, const glm::vec2& direction);
+};
@@ -0,0 +1,116 @@
+#include "TemporalAntiAliasing.h"
+
+#include "Utils/ResourceManager/ResourceManager.h"
+#include "Utils/JsonGlmHelpers.h"
+#include "Utils/ImGuiHelper.h"
+
+TemporalAntiAliasing::TemporalAntiAliasing() :
+	PostProcessingLayer::Effect(),
+	CurrentWeight(0.1f),
+	_resolveShader(nullptr),
+	_copyShader(nullptr),
+	_history{ nullptr, nullptr },
+	_current(0),
+	_historyValid(false)
+{
+	Name = "Temporal Anti-Aliasing";
+	Enabled = false;
+	_format = RenderTargetType::ColorRgb8;
+	_jitterProjection = true;
+	_renderScale = 0.67f;
+
+	_resolveShader = ResourceManager::CreateAsset<ShaderProgram>(std::unordered_map<ShaderPartType, std::string>{
+		{ ShaderPartType::Vertex, "shaders/vertex_shaders/fullscreen_quad.glsl" },
+		{ ShaderPartType::Fragment, "shaders/fragment_shaders/post_effects/taa_resolve.glsl" }
+	});
+	_copyShader = ResourceManager::CreateAsset<ShaderProgram>(std::unordered_map<ShaderPartType, std::string>{
+		{ ShaderPartType::Vertex, "shaders/vertex_shaders/fullscreen_quad.glsl" },
+		{ ShaderPartType::Fragment, "shaders/fragment_shaders/texture_passthrough.glsl" }
+	});
+}
+
+TemporalAntiAliasing::~TemporalAntiAliasing() = default;
+
+void TemporalAntiAliasing::ResetHistory()
+{
+	_historyValid = false;
+}
+
+void TemporalAntiAliasing::Apply(const Framebuffer::Sptr& gBuffer)
+{
+	// The history matches our output, and is only re-created when the output changes size
+	glm::ivec2 size = _output->GetSize();
+	for (int ix = 0; ix < 2; ix++) {
+		if (_history[ix] == nullptr) {
+			// The history is kept at 16 bits so that small blend weights don't get lost to rounding
+			FramebufferDescriptor desc = FramebufferDescriptor();
+			desc.Width  = size.x;
+			desc.Height = size.y;
+			desc.RenderTargets[RenderTargetAttachment::Color0] = RenderTargetDescriptor(RenderTargetType::ColorRgba16F);
+			_history[ix] = std::make_shared<Framebuffer>(desc);
+			_historyValid = false;
+		} else if (_history[ix]->GetSize() != size) {
+			_history[ix]->Resize(size);
+			_historyValid = false;
+		}
+	}
+
+	const Framebuffer::Sptr& previous = _history[_current];
+	_current = 1 - _current;
+	const Framebuffer::Sptr& resolved = _history[_current];
+
+	// Blend this frame into the history, the previous effect's output is still in slot 0
+	_resolveShader->Bind();
+	_resolveShader->SetUniform("u_CurrentWeight", CurrentWeight);
+	_resolveShader->SetUniform("u_HistoryValid", _historyValid ? 1 : 0);
+	gBuffer->BindAttachment(RenderTargetAttachment::Depth, 1);
+	gBuffer->BindAttachment(RenderTargetAttachment::Color3, 2); // Motion vectors
+	previous->BindAttachment(RenderTargetAttachment::Color0, 3);
+	resolved->Bind();
+	DrawFullscreen();
+	resolved->Unbind();
+	_historyValid = true;
+
+	// The layer copies the new history into our output
+	_copyShader->Bind();
+	_copyShader->SetUniform("IgnoreAlpha", 1);
+	resolved->BindAttachment(RenderTargetAttachment::Color0, 0);
+	_output->Bind();
+}
+
+void TemporalAntiAliasing::OnSceneLoad()
+{
+	ResetHistory();
+}
+
+void TemporalAntiAliasing::OnWindowResize(const glm::ivec2& /*oldSize*/, const glm::ivec2& /*newSize*/)
+{
+	ResetHistory();
+}
+
+void TemporalAntiAliasing::RenderImGui()
+{
+	LABEL_LEFT(ImGui::SliderFloat, "Current Weight", &CurrentWeight, 0.02f, 1.0f);
+	LABEL_LEFT(ImGui::SliderFloat, "Render Scale", &_renderScale, 0.5f, 1.0f);
+	if (ImGui::Button("Reset History")) {
+		ResetHistory();
+	}
+}
+
+TemporalAntiAliasing::Sptr TemporalAntiAliasing::FromJson(const nlohmann::json& data)
+{
+	TemporalAntiAliasing::Sptr result = std::make_shared<TemporalAntiAliasing>();
+	result->Enabled = JsonGet(data, "enabled", false);
+	result->CurrentWeight = JsonGet(data, "current_weight", result->CurrentWeight);
+	result->_renderScale = JsonGet(data, "render_scale", result->_renderScale);
+	return result;
+}
+
+nlohmann::json TemporalAntiAliasing::ToJson() const
+{
+	return {
+		{ "enabled", Enabled },
+		{ "current_weight", CurrentWeight },
+		{ "render_scale", _renderScale }
+	};
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "Application/Layers/PostProcessingLayer.h"
+#include "Graphics/ShaderProgram.h"
+#include "Graphics/Framebuffer.h"
+
+/**
+ * Temporal anti-aliasing, the camera is jittered by a different sub-pixel offset every frame, and
+ * each frame is blended into a history that is moved along with the G-Buffer's motion vectors. The
+ * history is clamped to the colors around each pixel in the new frame, so that anything that was
+ * uncovered or changed doesn't leave a trail behind it
+ *
+ * Since the history gathers samples from many frames, the scene can be rendered at a lower resolution
+ * while this is enabled, and scaled back up to close to the quality of the full resolution
+ */
+class TemporalAntiAliasing : public PostProcessingLayer::Effect {
+public:
+	MAKE_PTRS(TemporalAntiAliasing);
+
+	// How much of each new frame is blended into the history, lower values smooth out more
+	// jitter but take longer to catch up with changes
+	float CurrentWeight;
+
+	TemporalAntiAliasing();
+	virtual ~TemporalAntiAliasing();
+
+	/**
+	 * Throws away the history, the next frame will be used as is
+	 */
+	void ResetHistory();
+
+	virtual void Apply(const Framebuffer::Sptr& gBuffer) override;
+	virtual void OnSceneLoad() override;
+	virtual void OnWindowResize(const glm::ivec2& oldSize, const glm::ivec2& newSize) override;
+	virtual void RenderImGui() override;
+
+	// Inherited from IResource
+
+	TemporalAntiAliasing::Sptr FromJson(const nlohmann::json& data);
+	virtual nlohmann::json ToJson() const override;
+
+protected:
+	ShaderProgram::Sptr _resolveShader;
+	ShaderProgram::Sptr _copyShader;
+
+	// The history has to outlive the frame, so it is kept out of the render graph. We resolve into
+	// one while reading the other, and swap them each frame
+	Framebuffer::Sptr _history[2];
+	int               _current;
+	bool              _historyValid;
+};
@@ -2,19 +2,21 @@
 
 #include "Application/Application.h"
 #include "RenderLayer.h"
+#include "Graphics/GlState.h"
 
 #include "PostProcessing/ColorCorrectionEffect.h"
-#include "PostProcessing/ColorCorrectionEffectcool.h"
-#include "PostProcessing/ColorCorrectionEffectnoir.h"
-#include "PostProcessing/ColorCorrectionEffectwarm.h"
+#include "PostProcessing/ColorGradingEffect.h"
 #include "PostProcessing/BoxFilter3x3.h"
 #include "PostProcessing/BoxFilter5x5.h"
+#include "PostProcessing/GaussianBlur.h"
 #include "PostProcessing/OutlineEffect.h"
 #include "PostProcessing/DepthOfField.h"
-#include "PostProcessing/FilmGrainEffect.h"
+#include "PostProcessing/TemporalAntiAliasing.h"
 
 PostProcessingLayer::PostProcessingLayer() :
-	ApplicationLayer()
+	ApplicationLayer(),
+	_graph(std::make_shared<RenderGraph>()),
+	_targetPool(std::make_shared<RenderTargetPool>())
 {
 	Name = "Post Processing";
 	Overrides =
@@ -27,6 +29,7 @@ PostProcessingLayer::PostProcessingLayer() :
 PostProcessingLayer::~PostProcessingLayer() = default;
 
 void PostProcessingLayer::AddEffect(const Effect::Sptr& effect) {
+	effect->_targetPool = _targetPool.get();
 	_effects.push_back(effect);
 }
 
@@ -34,26 +37,19 @@ void PostProcessingLayer::OnAppLoad(const nlohmann::json& config)
 {
 	// Loads some effects in
 	//_effects.push_back(std::make_shared<ColorCorrectionEffect>());
-	_effects.push_back(std::make_shared<ColorCorrectionEffectcool>());
-	_effects.push_back(std::make_shared<ColorCorrectionEffectnoir>());
-	_effects.push_back(std::make_shared<ColorCorrectionEffectwarm>());
+	// Anti-aliasing runs first, so the effects after it see a stable image
+	_effects.push_back(std::make_shared<TemporalAntiAliasing>());
 	_effects.push_back(std::make_shared<BoxFilter3x3>());
 	_effects.push_back(std::make_shared<BoxFilter5x5>());
+	_effects.push_back(std::make_shared<GaussianBlur>());
 	_effects.push_back(std::make_shared<OutlineEffect>());
 	_effects.push_back(std::make_shared<DepthOfField>());
-	_effects.push_back(std::make_shared<FilmGrainEffect>()); //filmgrain
+	// LUTs, film grain and vignette all run in this one pass
+	_effects.push_back(std::make_shared<ColorGradingEffect>());
 
-	Application& app = Application::Get();
-	const glm::uvec4& viewport = app.GetPrimaryViewport();
-
-	// Initialize all the effect's output FBOs (inefficient) 
+	// Effects don't own their outputs, they render into targets from our pool
 	for (const auto& effect : _effects) {
-		FramebufferDescriptor fboDesc = FramebufferDescriptor();
-		fboDesc.Width  = viewport.z * effect->_outputScale.x;
-		fboDesc.Height = viewport.w * effect->_outputScale.y;
-		fboDesc.RenderTargets[RenderTargetAttachment::Color0] = RenderTargetDescriptor(effect->_format);
-
-		effect->_output = std::make_shared<Framebuffer>(fboDesc);
+		effect->_targetPool = _targetPool.get();
 	}
 
 	// We need a mesh for drawing fullscreen quads
@@ -81,55 +77,99 @@ void PostProcessingLayer::OnPostRender()
 	const Framebuffer::Sptr& output = renderer->GetRenderOutput();
 	const Framebuffer::Sptr& gBuffer = renderer->GetGBuffer();
 
-	// Stores the input FBO to the effect, we start with the renderlayer's output 
-	Framebuffer::Sptr current = output;
-
-	// Disable depth testing and depth writing, as well as blending
-	glDisable(GL_DEPTH_TEST);
-	glDepthMask(false);
-	glDisable(GL_BLEND);
+	// Let the render layer know how the next frames should be rendered for the effects that are enabled
+	bool jitterProjection = false;
+	float renderScale = 1.0f;
+	for (const auto& effect : _effects) {
+		if (effect->Enabled) {
+			jitterProjection |= effect->_jitterProjection;
+			renderScale = glm::min(renderScale, effect->_renderScale);
+		}
+	}
+	renderer->SetTemporalJitter(jitterProjection);
+	renderer->SetFixedRenderScale(renderScale);
 
-	// Bind the quad VAO so our effects can use it
-	_quadVAO->Bind();
+	// Build the graph for this frame, each effect reads the output of the one before it, starting
+	// with the render layer's output
+	_graph->Clear();
+	RenderGraph::ResourceId sceneColor = _graph->ImportTexture("Scene Color", RenderGraph::TextureDesc(output->GetWidth(), output->GetHeight(), RenderTargetType::ColorRgba8));
+	RenderGraph::ResourceId current = sceneColor;
 
-	// Iterate over all the effects in the queue
 	for (const auto& effect : _effects) {
 		// Only render if it's enabled
-		if (effect->Enabled) {
+		if (!effect->Enabled) {
+			continue;
+		}
+
+		RenderGraph::ResourceId input = current;
+		RenderGraph::ResourceId result = _graph->CreateTexture(effect->Name, RenderGraph::TextureDesc(
+			static_cast<uint32_t>(viewport.z * effect->_outputScale.x),
+			static_cast<uint32_t>(viewport.w * effect->_outputScale.y),
+			effect->_format
+		));
+
+		RenderGraph::PassId pass = _graph->AddPass(effect->Name, [this, effect, input, result, &gBuffer]() {
+			effect->_output = _targetPool->Get(result);
+
 			// Bind the FBO and make sure we're rendering to the whole thing
 			effect->_output->Bind();
 			glViewport(0, 0, effect->_output->GetWidth(), effect->_output->GetHeight());
 
 			// Bind color 0 from previous pass to texture slot 0 so our effects can access
-			current->BindAttachment(RenderTargetAttachment::Color0, 0);
+			_targetPool->Get(input)->BindAttachment(RenderTargetAttachment::Color0, 0);
 
 			// Apply the effect and render the fullscreen quad
 			effect->Apply(gBuffer);
 			_quadVAO->Draw();
 
-			// Unbind output and set it as input for next pass
 			effect->_output->Unbind();
-			current = effect->_output;
-		}
+		});
+		_graph->Read(pass, input);
+		_graph->Write(pass, result);
+		effect->DeclareTargets(*_graph, pass, result);
+
+		current = result;
 	}
-	_quadVAO->Unbind();
 
-	// Restore viewport to game viewport
-	glViewport(viewport.x, viewport.y, viewport.z, viewport.w);
+	// Copying the result to the screen is the only pass that the rest of the graph has to feed into
+	RenderGraph::PassId present = _graph->AddPass("Present", [this, current, &viewport]() {
+		const Framebuffer::Sptr& result = _targetPool->Get(current);
 
-	// Bind the output of our post processing as the source for the blit
-	current->Bind(FramebufferBinding::Read);
-	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+		// Restore viewport to game viewport
+		glViewport(viewport.x, viewport.y, viewport.z, viewport.w);
 
-	// Blit the color buffer to our game window
-	current->Blit(
-		{ 0, 0, current->GetWidth(), current->GetHeight() },
-		{ viewport.x, viewport.y, viewport.x + viewport.z, viewport.y + viewport.w },
-		BufferFlags::Color,
-		MagFilter::Linear
-	);
+		// Bind the output of our post processing as the source for the blit
+		result->Bind(FramebufferBinding::Read);
+		GlState::BindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
 
-	current->Unbind();
+		// Blit the color buffer to our game window
+		result->Blit(
+			{ 0, 0, result->GetWidth(), result->GetHeight() },
+			{ viewport.x, viewport.y, viewport.x + viewport.z, viewport.y + viewport.w },
+			BufferFlags::Color,
+			MagFilter::Linear
+		);
+
+		result->Unbind();
+	});
+	_graph->Read(present, current);
+	_graph->SetSideEffect(present);
+
+	if (!_graph->Compile()) {
+		return;
+	}
+	_targetPool->Realize(*_graph);
+	_targetPool->Import(sceneColor, output);
+
+	// Disable depth testing and depth writing, as well as blending
+	GlState::Disable(GL_DEPTH_TEST);
+	GlState::DepthMask(false);
+	GlState::Disable(GL_BLEND);
+
+	// Bind the quad VAO so our effects can use it
+	_quadVAO->Bind();
+	_graph->Execute();
+	_quadVAO->Unbind();
 }
 
 void PostProcessingLayer::OnSceneLoad()
@@ -148,9 +188,9 @@ void PostProcessingLayer::OnSceneUnload()
 
 void PostProcessingLayer::OnWindowResize(const glm::ivec2& oldSize, const glm::ivec2& newSize)
 {
+	// The graph picks up the new size on the next frame, and the pool re-creates any targets that changed
 	for (const auto& effect : _effects) {
 		effect->OnWindowResize(oldSize, newSize);
-		effect->_output->Resize(newSize.x, newSize.y);
 	}
 }
 
@@ -159,6 +199,21 @@ const std::vector<PostProcessingLayer::Effect::Sptr>& PostProcessingLayer::GetEf
 	return _effects;
 }
 
+const RenderGraph::Sptr& PostProcessingLayer::GetRenderGraph() const
+{
+	return _graph;
+}
+
+const RenderTargetPool::Sptr& PostProcessingLayer::GetTargetPool() const
+{
+	return _targetPool;
+}
+
+const Framebuffer::Sptr& PostProcessingLayer::Effect::_GetTarget(RenderGraph::ResourceId target) const
+{
+	return _targetPool->Get(target);
+}
+
 void PostProcessingLayer::Effect::DrawFullscreen()
 {
 	glDrawArrays(GL_TRIANGLES, 0, 6);
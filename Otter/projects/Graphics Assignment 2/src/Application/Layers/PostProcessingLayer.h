@@ -3,10 +3,17 @@
 #include "Application/ApplicationLayer.h"
 #include "Utils/Macros.h"
 #include "Graphics/VertexArrayObject.h"
+#include "Graphics/RenderGraph.h"
+#include "Graphics/RenderTargetPool.h"
 
 /**
  * The post processing layer will handle rendering effects after the primary
  * deffered pipeline has composited an output image
+ * 
+ * Each frame the enabled effects are built into a render graph, where every effect
+ * is a pass that reads the previous effect's output and writes a new one. Outputs and
+ * scratch targets only live as long as the passes using them, so the graph can share
+ * their memory between effects
  */
 class PostProcessingLayer final : public ApplicationLayer {
 public:
@@ -33,6 +40,15 @@ public:
 		 * @param gBuffer The G-Buffer from the deferred rendering pipeline
 		 */
 		virtual void Apply(const Framebuffer::Sptr& gBuffer) = 0;
+		/**
+		 * Overload this in derived classes that need scratch render targets while they are
+		 * applied. Targets should be created and written by the effect's pass, and can then
+		 * be fetched with _GetTarget from within Apply
+		 * @param graph The graph that the layer is building for this frame
+		 * @param pass The effect's pass within the graph
+		 * @param output The texture that the effect will render into
+		 */
+		virtual void DeclareTargets(RenderGraph& /*graph*/, RenderGraph::PassId /*pass*/, RenderGraph::ResourceId /*output*/) {}
 		/**
 		 * Allows this effect to perform logic when a new scene is loaded
 		 */
@@ -61,14 +77,28 @@ public:
 	protected:
 		friend class PostProcessingLayer;
 
-		// The output that this effect will render into
+		// The output that this effect will render into, assigned by the layer from it's
+		// render targets before the effect is applied
 		Framebuffer::Sptr _output = nullptr;
 		// The scaling between this effect's output and the screen size, default 1
 		glm::vec2 _outputScale = glm::vec2(1);
 		// The render target format for the effect's buffer
 		RenderTargetType _format = RenderTargetType::ColorRgba8;
+		// The pool that the layer creates the graph's render targets in, set by the layer
+		RenderTargetPool* _targetPool = nullptr;
+		// True if the render layer should jitter the camera's projection while this effect is enabled
+		bool _jitterProjection = false;
+		// The fraction of the window that the scene can be rendered at while this effect is enabled, the
+		// smallest scale of all the enabled effects is used
+		float _renderScale = 1.0f;
 		
 		Effect() = default;
+
+		/**
+		 * Gets the framebuffer for a target that was declared in DeclareTargets, only
+		 * valid from within Apply
+		 */
+		const Framebuffer::Sptr& _GetTarget(RenderGraph::ResourceId target) const;
 	};
 
 	PostProcessingLayer();
@@ -94,6 +124,15 @@ public:
 	 */
 	const std::vector<Effect::Sptr>& GetEffects() const;
 
+	/**
+	 * Gets the render graph that the effects were drawn with on the last frame
+	 */
+	const RenderGraph::Sptr& GetRenderGraph() const;
+	/**
+	 * Gets the pool that holds the render targets that the effects draw into
+	 */
+	const RenderTargetPool::Sptr& GetTargetPool() const;
+
 	/**
 	 * Adds a new effect to the end of the processing stack
 	 */
@@ -112,4 +151,9 @@ protected:
 
 	std::vector<Effect::Sptr> _effects;
 	VertexArrayObject::Sptr _quadVAO;
+
+	// Rebuilt from the enabled effects every frame
+	RenderGraph::Sptr _graph;
+	// Holds on to the graph's render targets between frames
+	RenderTargetPool::Sptr _targetPool;
 };
\ No newline at end of file
@@ -3,29 +3,95 @@
 #include "Graphics/GuiBatcher.h"
 #include "Gameplay/Components/Camera.h"
 #include "Graphics/DebugDraw.h"
+#include "Graphics/MeshArena.h"
+#include "Graphics/GlState.h"
+#include "Utils/Frustum.h"
 #include "Graphics/Textures/TextureCube.h"
 #include "../Timing.h"
 #include "Gameplay/Components/ComponentManager.h"
 #include "Gameplay/Components/RenderComponent.h"
 #include "Gameplay/Components/Light.h"
+#include "Utils/MeshFactory.h"
 
 // GLM math library
 #include <GLM/glm.hpp>
 #include <GLM/gtc/matrix_transform.hpp>
 #include <GLM/gtc/type_ptr.hpp>
+#include <cstring>
+#include <algorithm>
 #define GLM_ENABLE_EXPERIMENTAL
 #include <GLM/gtx/common.hpp> // for fmod (floating modulus)
 #include "Gameplay/Components/ShadowCamera.h"
 
+// The number of draws each thread should have before it's worth starting another one to prepare them
+const size_t PREPARE_MIN_DRAWS_PER_THREAD = 256;
+
+const VertexArrayObject::VertexDeclaration RenderLayer::InstanceData::V_DECL = {
+	BufferAttribute(8,  4, AttributeType::Float, sizeof(InstanceData), 0,                  AttribUsage::User0),
+	BufferAttribute(9,  4, AttributeType::Float, sizeof(InstanceData), 4 * sizeof(float),  AttribUsage::User0),
+	BufferAttribute(10, 4, AttributeType::Float, sizeof(InstanceData), 8 * sizeof(float),  AttribUsage::User0),
+	BufferAttribute(11, 4, AttributeType::Float, sizeof(InstanceData), 12 * sizeof(float), AttribUsage::User0),
+
+	BufferAttribute(12, 4, AttributeType::Float, sizeof(InstanceData), 16 * sizeof(float), AttribUsage::User0),
+	BufferAttribute(13, 4, AttributeType::Float, sizeof(InstanceData), 20 * sizeof(float), AttribUsage::User0),
+	BufferAttribute(14, 4, AttributeType::Float, sizeof(InstanceData), 24 * sizeof(float), AttribUsage::User0),
+	BufferAttribute(15, 4, AttributeType::Float, sizeof(InstanceData), 28 * sizeof(float), AttribUsage::User0),
+};
+
+// The number of instances we reserve space for in the instance buffer when we start up
+const uint32_t INITIAL_INSTANCE_CAPACITY = 4096;
 
 RenderLayer::RenderLayer() :
 	ApplicationLayer(),
 	_primaryFBO(nullptr),
 	_blitFbo(true),
-	_frameUniforms(nullptr),
-	_instanceUniforms(nullptr),
+	_clearColor({ 0.1f, 0.1f, 0.1f, 1.0f }),
 	_renderFlags(RenderFlags::None),
-	_clearColor({ 0.1f, 0.1f, 0.1f, 1.0f })
+	_lodPixelError(1.0f),
+	_frameUniforms(nullptr),
+	_instanceBuffer(nullptr),
+	_instanceData(std::vector<InstanceData>()),
+	_lightClusters(nullptr),
+	_clusterLights(std::vector<ClusterLight>()),
+	_clusterLightSpheres(std::vector<glm::vec4>()),
+	_clusterLightBuffer(nullptr),
+	_clusterGridBuffer(nullptr),
+	_clusterIndexBuffer(nullptr),
+	_lightPassMode(LightPassMode::Clustered),
+	_lightVolume(nullptr),
+	_lightVolumeScale(1.0f),
+	_lightVolumeShader(nullptr),
+	_lightStencilShader(nullptr),
+	_depthCopyShader(nullptr),
+	_shadowAtlas(nullptr),
+	_shadowViews(std::vector<ShadowView>()),
+	_shadowUbo(nullptr),
+	_renderQueue(RenderQueue()),
+	_drawList(std::vector<RenderComponent*>()),
+	_cullSpheres(std::vector<glm::vec4>()),
+	_visibleDraws(std::vector<uint32_t>()),
+	_prepareDraws(std::vector<ScenePrepare::Draw>()),
+	_workerPool(WorkerPool::GetShared()),
+	_prepareBuffers(std::vector<ScenePrepare::Buffer>(_workerPool->GetThreadCount())),
+	_occlusionCulling(false),
+	_occlusionBuffer(std::make_shared<OcclusionBuffer>()),
+	_hiZCulling(false),
+	_hiZBuffer(nullptr),
+	_dynamicResolution(false),
+	_gpuTimer(nullptr),
+	_resolutionController(std::make_shared<ResolutionController>()),
+	_renderSize(glm::ivec2(0)),
+	_fixedRenderScale(1.0f),
+	_temporalJitter(false),
+	_jitterIndex(0),
+	_prevViewProjection(glm::mat4(1.0f)),
+	_prevJitter(glm::vec2(0.0f)),
+	_hasPrevFrame(false),
+	_depthPrePass(false),
+	_prePassShaders(std::unordered_map<Guid, PrePassShader>()),
+	_prePassStates(std::unordered_map<Guid, PrePassState>()),
+	_currentStats(RenderStats()),
+	_frameStats(RenderStats())
 {
 	Name = "Rendering";
 	Overrides = 
@@ -34,7 +100,24 @@ RenderLayer::RenderLayer() :
 		AppLayerFunctions::OnWindowResize;
 }
 
-RenderLayer::~RenderLayer() = default;
+RenderLayer::~RenderLayer() {
+	for (auto& [material, state] : _prePassStates) {
+		glDeleteQueries(2, state.Queries);
+	}
+}
+
+// Gets the index'th number in the Halton sequence with the given base, these are spread evenly over [0, 1)
+// without any pattern that would show up as the camera jitters between them
+static float Halton(int index, int base) {
+	float result = 0.0f;
+	float fraction = 1.0f;
+	while (index > 0) {
+		fraction /= base;
+		result += fraction * (index % base);
+		index /= base;
+	}
+	return result;
+}
 
 void RenderLayer::OnPreRender()
 {
@@ -42,10 +125,24 @@ void RenderLayer::OnPreRender()
 
 	Application& app = Application::Get();
 
+	// Keep the stats from the last frame around for display, and start counting the new frame
+	const GlState::Stats& stateStats = GlState::GetStats();
+	_currentStats.StateChanges = stateStats.Issued;
+	_currentStats.StateChangesSkipped = stateStats.Skipped;
+	_currentStats.StateMismatches = stateStats.Mismatches;
+	GlState::ResetStats();
+	_frameStats = _currentStats;
+	_currentStats = RenderStats();
+
+	// Start timing the frame on the GPU, and pick this frame's resolution from the frames that have finished
+	_gpuTimer->Begin();
+	_UpdateRenderSize();
+
 	// Clear the color and depth buffers
+	// Note that a packed normal of (0, 0) marks pixels with nothing in them for the lighting passes
 	const glm::vec4 colors[4] = {
 		glm::vec4(0.0f),
-		glm::vec4(0.5f, 0.5f, 0.5f, 0.0f),
+		glm::vec4(0.0f),
 		glm::vec4(0.0f),
 		glm::vec4(0.0f)
 	};
@@ -58,6 +155,16 @@ void RenderLayer::OnPreRender()
 	// Grab shorthands to the camera and shader from the scene
 	Camera::Sptr camera = app.CurrentScene()->MainCamera;
 
+	// Offset the projection by up to half a pixel, the scene is rendered at _renderSize so the offset
+	// is worked out from that rather than the size of the G-Buffer
+	if (_temporalJitter) {
+		_jitterIndex = (_jitterIndex + 1) % JITTER_SEQUENCE_LENGTH;
+		glm::vec2 offset = glm::vec2(Halton(_jitterIndex + 1, 2), Halton(_jitterIndex + 1, 3)) - 0.5f;
+		camera->SetJitter(offset * 2.0f / glm::vec2(_renderSize));
+	} else {
+		camera->SetJitter(glm::vec2(0.0f));
+	}
+
 	// Cache the camera's viewprojection
 	glm::mat4 viewProj = camera->GetViewProjection();
 	DebugDrawer::Get().SetViewProjection(viewProj);
@@ -81,12 +188,20 @@ void RenderLayer::OnPreRender()
 
 	// Here we'll bind all the UBOs to their corresponding slots
 	_frameUniforms->Bind(FRAME_UBO_BINDING);
-	_instanceUniforms->Bind(INSTANCE_UBO_BINDING);
 	_lightingUbo->Bind(LIGHTING_UBO_BINDING);
+	_shadowUbo->Bind(SHADOW_UBO_BINDING);
 
 	// Draw physics debug
 	app.CurrentScene()->DrawPhysicsDebug();
 
+	// Compact any mesh arenas that have been left with too many gaps by unloaded meshes
+	MeshArena::DefragmentAll();
+
+	// Track which objects have stopped moving, so that they can be drawn into cached shadow maps
+	app.CurrentScene()->Components().Each<RenderComponent>([](const RenderComponent::Sptr& renderable) {
+		renderable->UpdateStaticState();
+	});
+
 	_InitFrameUniforms();
 }
 
@@ -97,18 +212,22 @@ void RenderLayer::OnRender(const Framebuffer::Sptr& prevLayer)
 	Application& app = Application::Get();
 	
 	// Make sure depth testing and culling are re-enabled
-	glEnable(GL_DEPTH_TEST);
-	glEnable(GL_CULL_FACE); 
-	glDepthMask(true); 
+	GlState::Enable(GL_DEPTH_TEST);
+	GlState::Enable(GL_CULL_FACE);
+	GlState::DepthMask(true);
 
 	// Disable blending, we want to override any existing colors
-	glDisable(GL_BLEND);
+	GlState::Disable(GL_BLEND);
 
 	// Grab shorthands to the camera and shader from the scene
 	Camera::Sptr camera = app.CurrentScene()->MainCamera;
 
-	// We can now render all our scene elements via the helper function
-	_RenderScene(camera->GetView(), camera->GetProjection(), _primaryFBO->GetSize());
+	// The scene is drawn into the bottom left of the G-Buffer, which may be smaller than the window
+	glViewport(0, 0, _renderSize.x, _renderSize.y);
+
+	// We can now render all our scene elements via the helper function, the main camera
+	// is the one that decides which level of detail each object renders at
+	_RenderScene(camera->GetView(), camera->GetProjection(), _renderSize, true, DrawFilter::All, true);
 
 	// Use our cubemap to draw our skybox
 	app.CurrentScene()->DrawSkybox();
@@ -125,6 +244,12 @@ void RenderLayer::OnPostRender() {
 	// Composite our lighting 
 	_Composite();
 
+	// Reduce this frame's depth for the next frames to cull against, now that nothing else will draw into it
+	if (_hiZCulling) {
+		Camera::Sptr camera = Application::Get().CurrentScene()->MainCamera;
+		_hiZBuffer->Update(_primaryFBO->GetTextureAttachment(RenderTargetAttachment::Depth), camera->GetViewProjection(), camera->GetGameObject()->GetPosition(), glm::uvec2(_renderSize));
+	}
+
 	Application& app = Application::Get();
 	const glm::uvec4& viewport = app.GetPrimaryViewport();
 
@@ -134,7 +259,7 @@ void RenderLayer::OnPostRender() {
 	// Blit our depth to the primary framebuffer so that other rendering can use it
 	glBlitNamedFramebuffer(
 		_primaryFBO->GetHandle(), 0,
-		0, 0, _primaryFBO->GetWidth(), _primaryFBO->GetHeight(),
+		0, 0, _renderSize.x, _renderSize.y,
 		viewport.x, viewport.y, viewport.x + viewport.z, viewport.y + viewport.w,
 		GL_DEPTH_BUFFER_BIT,
 		GL_NEAREST
@@ -151,6 +276,31 @@ void RenderLayer::OnPostRender() {
 	);
 
 	_outputBuffer->Unbind();
+
+	// Keep this frame's camera around for the next frame's motion vectors
+	Camera::Sptr camera = app.CurrentScene()->MainCamera;
+	_prevViewProjection = camera->GetUnjitteredProjection() * camera->GetView();
+	_prevJitter = camera->GetJitter();
+	_hasPrevFrame = true;
+
+	_gpuTimer->End();
+
+	// Make sure that nothing has changed the state behind the state cache's back while we were rendering
+	if (GlState::IsValidationEnabled()) {
+		GlState::Validate();
+	}
+}
+
+// Our point lights fall off by 1 / (1 + a * d^2), which never reaches zero, so we cut them off at the distance where
+// they drop below 1/256th of their brightness, which is too dark to show up in an 8 bit image. The light
+// accumulation shader fades lights out towards this distance so there is no visible edge
+static float GetLightRange(float intensity, const glm::vec3& color, float attenuation) {
+	const float CUTOFF = 1.0f / 256.0f;
+	float brightness = intensity * glm::max(color.r, glm::max(color.g, color.b));
+	if (brightness <= CUTOFF) {
+		return 0.0f;
+	}
+	return glm::sqrt((brightness / CUTOFF - 1.0f) / glm::max(attenuation, 0.00001f));
 }
 
 void RenderLayer::_AccumulateLighting()
@@ -164,9 +314,8 @@ void RenderLayer::_AccumulateLighting()
 	const glm::mat4& view = camera->GetView();
 
 	// Update our lighting UBO for any shaders that need it
-	LightingUboStruct& data = _lightingUbo->GetData();
-	data.AmbientCol = scene->GetAmbientLight();
-	data.EnvironmentRotation = scene->GetSkyboxRotation() * glm::inverse(glm::mat3(scene->MainCamera->GetView()));
+	_lightingUbo->Set(&LightingUboStruct::AmbientCol, scene->GetAmbientLight());
+	_lightingUbo->Set(&LightingUboStruct::EnvironmentRotation, scene->GetSkyboxRotation() * glm::inverse(glm::mat3(scene->MainCamera->GetView())));
 
 	const glm::vec3& ambient = scene->GetAmbientLight();
 	const glm::vec4 colors[2] = {
@@ -175,9 +324,11 @@ void RenderLayer::_AccumulateLighting()
 	};
 	_lightingFBO->Bind();
 	_ClearFramebuffer(_lightingFBO, colors, 2);
+	// Lights only need to cover the region of the G-Buffer that the scene was rendered into
+	glViewport(0, 0, _renderSize.x, _renderSize.y);
 
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE); 
+	GlState::Enable(GL_BLEND);
+	GlState::BlendFunc(GL_SRC_ALPHA, GL_ONE);
 
 	// Bind our shader for processing lighting 
 	_lightAccumulationShader->Bind(); 
@@ -185,123 +336,251 @@ void RenderLayer::_AccumulateLighting()
 	// Bind our G-Buffer textures so that they're readable
 	_primaryFBO->GetTextureAttachment(RenderTargetAttachment::Depth)->Bind(0);  // depth
 	_primaryFBO->GetTextureAttachment(RenderTargetAttachment::Color0)->Bind(1); // albedo + spec
-	_primaryFBO->GetTextureAttachment(RenderTargetAttachment::Color1)->Bind(2); // normals + metallic
-	_primaryFBO->GetTextureAttachment(RenderTargetAttachment::Color2)->Bind(3); // emissive
-	_primaryFBO->GetTextureAttachment(RenderTargetAttachment::Color3)->Bind(4); // view pos
+	_primaryFBO->GetTextureAttachment(RenderTargetAttachment::Color1)->Bind(2); // packed normals
+	_primaryFBO->GetTextureAttachment(RenderTargetAttachment::Color2)->Bind(3); // emissive + metallic
 
 
-	// Send in how many active lights we have and the global lighting settings
-	data.AmbientCol = glm::vec3(0.1f);
-	int ix = 0;
+	// Gather all of our lights in view space, since we're doing view space lighting
+	_lightingUbo->Set(&LightingUboStruct::AmbientCol, glm::vec3(0.1f));
+	_clusterLights.clear();
+	_clusterLightSpheres.clear();
 	app.CurrentScene()->Components().Each<Light>([&](const Light::Sptr& light) {
-		// Get the light's position in view space, since we're doing view space lighting
 		glm::vec4 pos = glm::vec4(light->GetGameObject()->GetWorldPosition(), 1.0f);
 		pos = view * pos;
 
-		// Copy to the ubo data
-		data.Lights[ix].Position = (glm::vec3)(pos) / pos.w;
-		data.Lights[ix].Intensity = light->GetIntensity();
-		data.Lights[ix].Color = light->GetColor();
-		data.Lights[ix].Attenuation = 1.0f / (1.0f + light->GetRadius());  
-
-		ix++;
-
-		// If we've reached the max # of lights the shader supports, draw to the screen and start the next batch
-		if (ix == MAX_LIGHTS) {
-			data.NumLights = MAX_LIGHTS;
-
-			// Send updated data to OpenGL
-			_lightingUbo->Update();
-
-			// Draw the fullscreen quad to accumulate the lights
-			_fullscreenQuad->Draw();
-
-			ix = 0;
-		}
+		ClusterLight result;
+		result.Position = (glm::vec3)(pos) / pos.w;
+		result.Intensity = light->GetIntensity();
+		result.Color = light->GetColor();
+		result.Attenuation = 1.0f / (1.0f + light->GetRadius());
+		result.Range = GetLightRange(result.Intensity, result.Color, result.Attenuation);
+		_clusterLights.push_back(result);
+		_clusterLightSpheres.push_back(glm::vec4(result.Position, result.Range));
 	});
+	uint32_t pointLightCount = static_cast<uint32_t>(_clusterLights.size());
+	_currentStats.Lights += pointLightCount;
+
+	// Forward shaders still read the first few lights from the lighting UBO
+	uint32_t uboLights = glm::min(pointLightCount, static_cast<uint32_t>(MAX_LIGHTS));
+	// Only the lights that have changed since last frame get uploaded
+	for (uint32_t ix = 0; ix < uboLights; ix++) {
+		LightingUboStruct::Light light;
+		light.Position    = _clusterLights[ix].Position;
+		light.Intensity   = _clusterLights[ix].Intensity;
+		light.Color       = _clusterLights[ix].Color;
+		light.Attenuation = _clusterLights[ix].Attenuation;
+		_lightingUbo->SetElement(&LightingUboStruct::Lights, ix, light);
+	}
+	_lightingUbo->Set(&LightingUboStruct::NumLights, uboLights);
+	_lightingUbo->Update();
+
+	// Bin the lights into clusters, so each pixel only has to shade the lights that can reach it
+	_lightClusters->SetProjection(camera->GetUnjitteredProjection(), camera->GetNearPlane(), camera->GetFarPlane());
+	_lightClusters->Build(_clusterLightSpheres.data(), _lightPassMode == LightPassMode::Clustered ? pointLightCount : 0);
+	const std::vector<uint32_t>& lightIndices = _lightClusters->GetLightIndices();
+	_currentStats.ClusterLightRefs += static_cast<uint32_t>(lightIndices.size());
+
+	// Lights are additively blended on top of each other, and don't need to touch the depth buffer
+	GlState::Disable(GL_DEPTH_TEST);
+	GlState::DepthMask(false);
+
+	if (pointLightCount > 0) {
+		_clusterLightBuffer->UpdateData(_clusterLights.data(), sizeof(ClusterLight), pointLightCount);
+		_clusterLightBuffer->Bind(CLUSTER_LIGHTS_SSBO_BINDING);
+	}
 
-	// If we have lights left over that haven't been drawn, draw them now
-	if (ix > 0) {
-		data.NumLights = ix;
-
-		// Send updated data to OpenGL
-		_lightingUbo->Update();
+	if (_lightPassMode == LightPassMode::StencilVolumes) {
+		_RenderLightVolumes(camera->GetProjection());
+	}
+	// Shade every pixel once, with all of the lights in it's cluster
+	else if (!lightIndices.empty()) {
+		_clusterGridBuffer->UpdateData(_lightClusters->GetClusters().data(), sizeof(LightClusters::Cluster), LightClusters::CLUSTER_COUNT);
+		_clusterIndexBuffer->UpdateData(lightIndices.data(), sizeof(uint32_t), static_cast<uint32_t>(lightIndices.size()));
+		_clusterGridBuffer->Bind(CLUSTER_GRID_SSBO_BINDING);
+		_clusterIndexBuffer->Bind(CLUSTER_INDICES_SSBO_BINDING);
+
+		_lightAccumulationShader->Bind();
+		_lightAccumulationShader->SetUniform("u_ClusterSize", glm::uvec3(LightClusters::TILES_X, LightClusters::TILES_Y, LightClusters::SLICES));
+		_lightAccumulationShader->SetUniform("u_ClusterSliceParams", _lightClusters->GetSliceParams());
+		_lightAccumulationShader->SetUniform("u_LightIndex", -1);
 
-		// Draw the fullscreen quad to accumulate the lights
 		_fullscreenQuad->Draw();
 	}
 
-	// Re-render the scene for shadows
-	app.CurrentScene()->Components().Each<ShadowCamera>([&](const ShadowCamera::Sptr& shadowCam) {
-		// Bind the shadow camera's depth buffer and clear it
-		shadowCam->GetDepthBuffer()->Bind();
-		glClear(GL_DEPTH_BUFFER_BIT);
-		glViewport(0, 0, shadowCam->GetBufferResolution().x, shadowCam->GetBufferResolution().y);
-
-		_RenderScene(shadowCam->GetGameObject()->GetInverseTransform(), shadowCam->GetProjection(), shadowCam->GetDepthBuffer()->GetSize());
+	// Shadow maps need depth testing and depth writes
+	GlState::Enable(GL_DEPTH_TEST);
+	GlState::DepthMask(true);
 
-		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
-	});
+	// Pack the shadow maps for all our lights into the atlas, and re-render the scene for shadows
+	_AllocateShadowAtlas(camera->GetView(), camera->GetUnjitteredProjection(), camera->GetNearPlane(), camera->GetFarPlane());
+	for (const ShadowView& shadowView : _shadowViews) {
+		_RenderShadowMap(shadowView);
+	}
 
 	// Restore frame level uniforms
 	_InitFrameUniforms();
 
 	_lightingFBO->Bind();
-	glViewport(0, 0, _lightingFBO->GetWidth(), _lightingFBO->GetHeight());
+	glViewport(0, 0, _renderSize.x, _renderSize.y);
 
 	// Bind our G-Buffer textures so that they're readable
 	_primaryFBO->GetTextureAttachment(RenderTargetAttachment::Depth)->Bind(0);  // depth
 	_primaryFBO->GetTextureAttachment(RenderTargetAttachment::Color0)->Bind(1); // albedo + spec
-	_primaryFBO->GetTextureAttachment(RenderTargetAttachment::Color1)->Bind(2); // normals + metallic
-	_primaryFBO->GetTextureAttachment(RenderTargetAttachment::Color2)->Bind(3); // emissive
-	_primaryFBO->GetTextureAttachment(RenderTargetAttachment::Color3)->Bind(4); // view pos
-
-	// Bind shadow composite shader
-	_shadowShader->Bind();
+	_primaryFBO->GetTextureAttachment(RenderTargetAttachment::Color1)->Bind(2); // packed normals
+	_primaryFBO->GetTextureAttachment(RenderTargetAttachment::Color2)->Bind(3); // emissive + metallic
 
-	// Add each shadow casting light to the lighting buffers
-	app.CurrentScene()->Components().Each<ShadowCamera>([&](const ShadowCamera::Sptr& shadowCam) {
+	// The shadow composite is a fullscreen pass, so we don't want the lighting buffer's depth to get in the way
+	GlState::Disable(GL_DEPTH_TEST);
 
-		// This gets us the light -> view space matrix, which we'll inverse to go from view space to light space
-		glm::mat4 lightSpaceMatrix = camera->GetView() * shadowCam->GetGameObject()->GetTransform();
+	// Bind shadow composite shader, and the atlas that holds all of our shadow maps
+	_shadowShader->Bind();
+	_shadowAtlas->GetFramebuffer()->BindAttachment(RenderTargetAttachment::Depth, 5);
 
-		// Or we have a matrix to go from view space to shadow space
-		glm::mat4 viewToShadow = shadowCam->GetProjection() * glm::inverse(lightSpaceMatrix);
+	const Texture2D* masks[MAX_PROJECTION_MASKS];
+	uint32_t maskCount = 0;
+	uint32_t lightCount = 0;
+	float atlasScale = 1.0f / _shadowAtlas->GetSize();
 
-		// Calculate light's position and direction in view space
-		glm::vec3 lightDirViewSpace = glm::mat3(lightSpaceMatrix) * glm::vec3(0, 0, -1.0f); 
-		glm::vec3 lightPosViewSpace = lightSpaceMatrix * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+	// Composites the lights that have been added to the buffer in a single pass
+	auto flushShadows = [&]() {
+		if (lightCount == 0) {
+			return;
+		}
+		_shadowUbo->Set(&ShadowUboStruct::NumShadowLights, lightCount);
+		_shadowUbo->Update();
+		_fullscreenQuad->Draw();
+		_currentStats.ShadowPasses++;
+		lightCount = 0;
+		maskCount = 0;
+	};
 
-		// Bind depth and projection mask for reading, making sure not to stomp G-Buffer bindings
-		shadowCam->GetDepthBuffer()->BindAttachment(RenderTargetAttachment::Depth, 5);
-		if (shadowCam->GetProjectionMask() != nullptr) {
-			shadowCam->GetProjectionMask()->Bind(6);
+	// Add each shadow map to the shadow buffer, cascades are composited as separate lights that blend together
+	for (const ShadowView& shadowView : _shadowViews) {
+		ShadowCamera* shadowCam = shadowView.Light;
+
+		// Projection masks need their own texture slot, if we've run out we need to draw what we have first
+		const Texture2D::Sptr& mask = (*(shadowCam->Flags & ShadowFlags::ProjectionEnabled)) ? shadowCam->GetProjectionMask() : nullptr;
+		int32_t maskIndex = -1;
+		if (mask != nullptr) {
+			for (uint32_t ix = 0; ix < maskCount; ix++) {
+				if (masks[ix] == mask.get()) {
+					maskIndex = ix;
+				}
+			}
+			if (maskIndex < 0) {
+				if (maskCount == MAX_PROJECTION_MASKS) {
+					flushShadows();
+				}
+				mask->Bind(6 + maskCount);
+				masks[maskCount] = mask.get();
+				maskIndex = maskCount++;
+			}
 		}
 
-		//_shadowShader->SetUniformMatrix("u_ClipToShadow", clipToShadow); 
-		_shadowShader->SetUniformMatrix("u_ViewToShadow", viewToShadow); 
+		// This gets us the light -> view space matrix, which we'll inverse to go from view space to light space
+		glm::mat4 lightSpaceMatrix = camera->GetView() * shadowCam->GetGameObject()->GetTransform();
 
 		// Get color and normalize it (strip the alpha)
 		glm::vec4 color = shadowCam->GetColor();
 		color *= color.w;
 
-		_shadowShader->SetUniform("u_LightDirViewspace", lightDirViewSpace);
-		_shadowShader->SetUniform("u_ShadowBias", shadowCam->Bias);
-		_shadowShader->SetUniform("u_NormalBias", shadowCam->NormalBias);
-		_shadowShader->SetUniform("u_Attenuation", 1/shadowCam->Range);
-		_shadowShader->SetUniform("u_Intensity", shadowCam->Intensity);
-		_shadowShader->SetUniform("u_LightColor", (glm::vec3)color);
-		_shadowShader->SetUniform("u_LightPosViewspace", lightPosViewSpace);
-		_shadowShader->SetUniform("u_ShadowFlags", *shadowCam->Flags);
+		const glm::ivec4& rect = shadowCam->GetAtlasRect(shadowView.Cascade);
+		ShadowUboStruct::ShadowLight light = {};
+		// Or we have a matrix to go from view space to shadow space
+		light.ViewToShadow = shadowView.Projection * shadowView.View * glm::inverse(camera->GetView());
+		light.AtlasRect    = glm::vec4(rect) * atlasScale;
+		// Calculate light's position and direction in view space
+		light.Position     = glm::vec3(lightSpaceMatrix * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+		light.Intensity    = shadowCam->Intensity;
+		light.Direction    = glm::mat3(lightSpaceMatrix) * glm::vec3(0, 0, -1.0f);
+		light.Bias         = shadowCam->Bias;
+		light.Color        = glm::vec3(color);
+		light.Attenuation  = 1 / shadowCam->Range;
+		light.NormalBias   = shadowCam->NormalBias;
+		light.Flags        = *shadowCam->Flags;
+		light.MaskIndex    = maskIndex;
+		light.CascadeRange = shadowView.CascadeRange;
+		if (shadowCam->Type == ShadowCameraType::Directional) {
+			light.Flags |= ShadowUboStruct::FLAG_CASCADE;
+			if (shadowView.Cascade == shadowCam->GetShadowMapCount() - 1) {
+				light.Flags |= ShadowUboStruct::FLAG_LAST_CASCADE;
+			}
+		}
+		// Lights that haven't moved since the last pass that used this slot won't be uploaded again
+		_shadowUbo->SetElement(&ShadowUboStruct::Lights, lightCount++, light);
 
-		// Draw the fullscreen quad to accumulate the lights
-		_fullscreenQuad->Draw();
-	});
+		if (lightCount == MAX_SHADOW_LIGHTS) {
+			flushShadows();
+		}
+	}
+
+	// Composite any lights that are left over
+	flushShadows();
+
+	GlState::Enable(GL_DEPTH_TEST);
 
 	// Unbind the lighting FBO so we can read its textures
 	_lightingFBO->Unbind();
 }
 
+void RenderLayer::_RenderLightVolumes(const glm::mat4& projection) {
+	// Copy the G-Buffer's depth into the lighting buffer, so that the light volumes can be depth tested against the scene
+	GlState::Enable(GL_DEPTH_TEST);
+	GlState::DepthFunc(GL_ALWAYS);
+	GlState::DepthMask(true);
+	glColorMask(false, false, false, false);
+	_depthCopyShader->Bind();
+	_fullscreenQuad->Draw();
+	GlState::DepthFunc(GL_LESS);
+	GlState::DepthMask(false);
+	glColorMask(true, true, true, true);
+
+	glClear(GL_STENCIL_BUFFER_BIT);
+	GlState::Enable(GL_STENCIL_TEST);
+	glStencilMask(0xFF);
+
+	Frustum frustum = Frustum::FromViewProjection(projection);
+	for (uint32_t ix = 0; ix < static_cast<uint32_t>(_clusterLights.size()); ix++) {
+		const ClusterLight& light = _clusterLights[ix];
+		if (light.Range <= 0.0f || !frustum.Intersects(BoundingSphere{ light.Position, light.Range })) {
+			continue;
+		}
+		glm::mat4 volume = projection * glm::translate(glm::mat4(1.0f), light.Position) * glm::scale(glm::mat4(1.0f), glm::vec3(light.Range * _lightVolumeScale));
+
+		// Mark the pixels where the scene is inside the volume. The back faces count up when they are behind the scene
+		// and the front faces count down, so only pixels with the scene between the front and back faces are left non-zero
+		GlState::Enable(GL_DEPTH_TEST);
+		GlState::Disable(GL_CULL_FACE);
+		glColorMask(false, false, false, false);
+		glStencilFunc(GL_ALWAYS, 0, 0xFF);
+		glStencilOpSeparate(GL_BACK,  GL_KEEP, GL_INCR_WRAP, GL_KEEP);
+		glStencilOpSeparate(GL_FRONT, GL_KEEP, GL_DECR_WRAP, GL_KEEP);
+
+		_lightStencilShader->Bind();
+		_lightStencilShader->SetUniformMatrix("u_LightVolume", volume);
+		_lightVolume->Draw();
+
+		// Light the marked pixels. We draw the back faces so the light still works when the camera is inside of it,
+		// and reset the stencil as we go so it's ready for the next light
+		GlState::Disable(GL_DEPTH_TEST);
+		GlState::Enable(GL_CULL_FACE);
+		GlState::CullFace(GL_FRONT);
+		glColorMask(true, true, true, true);
+		glStencilFunc(GL_NOTEQUAL, 0, 0xFF);
+		glStencilOp(GL_KEEP, GL_KEEP, GL_ZERO);
+
+		_lightVolumeShader->Bind();
+		_lightVolumeShader->SetUniformMatrix("u_LightVolume", volume);
+		_lightVolumeShader->SetUniform("u_LightIndex", static_cast<int>(ix));
+		_lightVolume->Draw();
+
+		_currentStats.LightVolumes++;
+	}
+
+	GlState::Disable(GL_STENCIL_TEST);
+	GlState::CullFace(GL_BACK);
+}
+
 void RenderLayer::_Composite()
 {
 	using namespace Gameplay;
@@ -321,9 +600,10 @@ void RenderLayer::_Composite()
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 	// Disable blending, we want to override any existing colors
-	glDisable(GL_BLEND);
+	GlState::Disable(GL_BLEND);
 
-	// Bind our albedo and lighting buffers so we can composite a final scene
+	// Bind our albedo and lighting buffers so we can composite a final scene, this covers the whole output
+	// so the scene is scaled up from the region of the buffers that it was rendered into
 	_primaryFBO->GetTextureAttachment(RenderTargetAttachment::Color0)->Bind(0);
 	_primaryFBO->GetTextureAttachment(RenderTargetAttachment::Color1)->Bind(1);
 	_lightingFBO->GetTextureAttachment(RenderTargetAttachment::Color0)->Bind(2); 
@@ -332,12 +612,12 @@ void RenderLayer::_Composite()
 	_fullscreenQuad->Draw(); 
 
 	// Re-enable depth testing
-	glEnable(GL_DEPTH_TEST);
+	GlState::Enable(GL_DEPTH_TEST);
 
-	// Blit our depth from primary FBO to our output depth buffer
+	// Blit our depth from primary FBO to our output depth buffer, scaling it up along with the color
 	glBlitNamedFramebuffer(
 		_primaryFBO->GetHandle(), _outputBuffer->GetHandle(),
-		0, 0, _primaryFBO->GetWidth(), _primaryFBO->GetHeight(),
+		0, 0, _renderSize.x, _renderSize.y,
 		0, 0, _outputBuffer->GetWidth(), _outputBuffer->GetHeight(),
 		GL_DEPTH_BUFFER_BIT,
 		GL_NEAREST
@@ -353,13 +633,13 @@ void RenderLayer::_ClearFramebuffer(Framebuffer::Sptr& buffer, const glm::vec4*
 	// Make the entire buffer visible
 	glViewport(0, 0, buffer->GetWidth(), buffer->GetHeight());
 	// Disable depth testing
-	glEnable(GL_DEPTH_TEST); 
+	GlState::Enable(GL_DEPTH_TEST);
 	// Enable depth writing
-	glDepthMask(true);
+	GlState::DepthMask(true);
 	// Disable blending, we want to override the colors
-	glDisable(GL_BLEND);
+	GlState::Disable(GL_BLEND);
 	// Ignore existing depth
-	glDepthFunc(GL_ALWAYS);
+	GlState::DepthFunc(GL_ALWAYS);
 
 	// Bind the buffer so we're writing to it
 	buffer->Bind();
@@ -370,7 +650,7 @@ void RenderLayer::_ClearFramebuffer(Framebuffer::Sptr& buffer, const glm::vec4*
 	_fullscreenQuad->Draw();
 
 	// Reset depth test function to default
-	glDepthFunc(GL_LESS);
+	GlState::DepthFunc(GL_LESS);
 }
 
 void RenderLayer::OnWindowResize(const glm::ivec2& oldSize, const glm::ivec2& newSize)
@@ -392,9 +672,9 @@ void RenderLayer::OnAppLoad(const nlohmann::json& config)
 	Application& app = Application::Get();
 
 	// GL states, we'll enable depth testing and backface fulling
-	glEnable(GL_DEPTH_TEST);
-	glEnable(GL_CULL_FACE);
-	glCullFace(GL_BACK);
+	GlState::Enable(GL_DEPTH_TEST);
+	GlState::Enable(GL_CULL_FACE);
+	GlState::CullFace(GL_BACK);
 
 	// Create a new descriptor for our FBO
 	FramebufferDescriptor fboDescriptor;
@@ -405,12 +685,13 @@ void RenderLayer::OnAppLoad(const nlohmann::json& config)
 	fboDescriptor.RenderTargets[RenderTargetAttachment::Depth] = RenderTargetDescriptor(RenderTargetType::Depth32);
 	// Color layer 0 (albedo, specular)
 	fboDescriptor.RenderTargets[RenderTargetAttachment::Color0] = RenderTargetDescriptor(RenderTargetType::ColorRgba8);
-	// Color layer 1 (normals, metallic)
-	fboDescriptor.RenderTargets[RenderTargetAttachment::Color1] = RenderTargetDescriptor(RenderTargetType::ColorRgba8);
-	// Color layer 2 (emissive)  
+	// Color layer 1 (normals, packed into octahedral coordinates)
+	fboDescriptor.RenderTargets[RenderTargetAttachment::Color1] = RenderTargetDescriptor(RenderTargetType::ColorRG16);
+	// Color layer 2 (emissive pre-multiplied by it's strength, metallic)  
 	fboDescriptor.RenderTargets[RenderTargetAttachment::Color2] = RenderTargetDescriptor(RenderTargetType::ColorRgba8);
-	// Color layer 3 (view space position)  
-	fboDescriptor.RenderTargets[RenderTargetAttachment::Color3] = RenderTargetDescriptor(RenderTargetType::ColorRgba16F);
+	// Color layer 3 (screen space motion since the last frame, in NDC)
+	fboDescriptor.RenderTargets[RenderTargetAttachment::Color3] = RenderTargetDescriptor(RenderTargetType::ColorRG16F);
+	// Note that view space position is not stored, the lighting passes rebuild it from depth
 	 
 	// Create the primary FBO
 	_primaryFBO = std::make_shared<Framebuffer>(fboDescriptor);
@@ -418,6 +699,8 @@ void RenderLayer::OnAppLoad(const nlohmann::json& config)
 	fboDescriptor.RenderTargets.clear();
 	fboDescriptor.RenderTargets[RenderTargetAttachment::Color0] = RenderTargetDescriptor(RenderTargetType::ColorRgba8); // Diffuse
 	fboDescriptor.RenderTargets[RenderTargetAttachment::Color1] = RenderTargetDescriptor(RenderTargetType::ColorRgba8); // Specular
+	// A copy of the G-Buffer's depth and a stencil buffer, for stencil tested light volumes
+	fboDescriptor.RenderTargets[RenderTargetAttachment::DepthStencil] = RenderTargetDescriptor(RenderTargetType::DepthStencil, false);
 
 	_lightingFBO = std::make_shared<Framebuffer>(fboDescriptor);
 
@@ -434,6 +717,22 @@ void RenderLayer::OnAppLoad(const nlohmann::json& config)
 	_lightAccumulationShader->LoadShaderPartFromFile("shaders/fragment_shaders/light_accumulation.glsl", ShaderPartType::Fragment);
 	_lightAccumulationShader->Link();
 
+	// Light volumes use the same lighting shader, but only cover the pixels that a light can reach
+	_lightVolumeShader = ShaderProgram::Create();
+	_lightVolumeShader->LoadShaderPartFromFile("shaders/vertex_shaders/light_volume.glsl", ShaderPartType::Vertex);
+	_lightVolumeShader->LoadShaderPartFromFile("shaders/fragment_shaders/light_accumulation.glsl", ShaderPartType::Fragment);
+	_lightVolumeShader->Link();
+
+	_lightStencilShader = ShaderProgram::Create();
+	_lightStencilShader->LoadShaderPartFromFile("shaders/vertex_shaders/light_volume.glsl", ShaderPartType::Vertex);
+	_lightStencilShader->LoadShaderPartFromFile("shaders/fragment_shaders/depth_only.glsl", ShaderPartType::Fragment);
+	_lightStencilShader->Link();
+
+	_depthCopyShader = ShaderProgram::Create();
+	_depthCopyShader->LoadShaderPartFromFile("shaders/vertex_shaders/fullscreen_quad.glsl", ShaderPartType::Vertex);
+	_depthCopyShader->LoadShaderPartFromFile("shaders/fragment_shaders/depth_copy.glsl", ShaderPartType::Fragment);
+	_depthCopyShader->Link();
+
 	_compositingShader = ShaderProgram::Create();
 	_compositingShader->LoadShaderPartFromFile("shaders/vertex_shaders/fullscreen_quad.glsl", ShaderPartType::Vertex);
 	_compositingShader->LoadShaderPartFromFile("shaders/fragment_shaders/deferred_composite.glsl", ShaderPartType::Fragment);
@@ -466,8 +765,37 @@ void RenderLayer::OnAppLoad(const nlohmann::json& config)
 
 	// Create our common uniform buffers
 	_frameUniforms = std::make_shared<UniformBuffer<FrameLevelUniforms>>(BufferUsage::DynamicDraw);
-	_instanceUniforms = std::make_shared<UniformBuffer<InstanceLevelUniforms>>(BufferUsage::DynamicDraw);
+	_instanceBuffer = VertexBuffer::Create(BufferUsage::Streaming);
+	_instanceBuffer->LoadData<InstanceData>(nullptr, INITIAL_INSTANCE_CAPACITY);
 	_lightingUbo = std::make_shared<UniformBuffer<LightingUboStruct>>(BufferUsage::DynamicDraw);
+	_shadowUbo = std::make_shared<UniformBuffer<ShadowUboStruct>>(BufferUsage::DynamicDraw);
+
+	_lightClusters = std::make_shared<LightClusters>();
+
+	// The icosphere's vertices sit on the sphere, so it's faces cut inside of it. We scale it up by the
+	// distance to the closest face so that the volume always covers the light's whole range
+	MeshBuilder<VertexPosNormTexCol> sphere;
+	MeshFactory::AddIcoSphere(sphere, glm::vec3(0.0f), 1.0f, 1);
+	float inradius = 1.0f;
+	const VertexPosNormTexCol* verts = sphere.GetVertexDataPtr();
+	const uint32_t* indices = sphere.GetIndexDataPtr();
+	for (size_t ix = 0; ix + 2 < sphere.GetIndexCount(); ix += 3) {
+		const glm::vec3& a = verts[indices[ix]].Position;
+		glm::vec3 normal = glm::normalize(glm::cross(verts[indices[ix + 1]].Position - a, verts[indices[ix + 2]].Position - a));
+		inradius = glm::min(inradius, glm::abs(glm::dot(normal, a)));
+	}
+	_lightVolumeScale = 1.0f / inradius;
+	_lightVolume = sphere.Bake();
+	_clusterLightBuffer = ShaderStorageBuffer::Create(BufferUsage::Streaming);
+	_clusterGridBuffer = ShaderStorageBuffer::Create(BufferUsage::Streaming);
+	_clusterIndexBuffer = ShaderStorageBuffer::Create(BufferUsage::Streaming);
+
+	_shadowAtlas = std::make_shared<ShadowAtlas>(SHADOW_ATLAS_SIZE);
+
+	_hiZBuffer = std::make_shared<HiZBuffer>(_fullscreenQuad);
+
+	_gpuTimer = std::make_shared<GpuTimer>();
+	_renderSize = _primaryFBO->GetSize();
 }
 
 const Framebuffer::Sptr& RenderLayer::GetPrimaryFBO() const {
@@ -502,6 +830,110 @@ RenderFlags RenderLayer::GetRenderFlags() const {
 	return _renderFlags;
 }
 
+void RenderLayer::SetLodPixelError(float value) {
+	_lodPixelError = value;
+}
+
+float RenderLayer::GetLodPixelError() const {
+	return _lodPixelError;
+}
+
+void RenderLayer::SetLightPassMode(LightPassMode value) {
+	_lightPassMode = value;
+}
+
+LightPassMode RenderLayer::GetLightPassMode() const {
+	return _lightPassMode;
+}
+
+void RenderLayer::SetOcclusionCulling(bool value) {
+	_occlusionCulling = value;
+}
+
+bool RenderLayer::IsOcclusionCullingEnabled() const {
+	return _occlusionCulling;
+}
+
+const OcclusionBuffer::Sptr& RenderLayer::GetOcclusionBuffer() const {
+	return _occlusionBuffer;
+}
+
+void RenderLayer::SetHiZCulling(bool value) {
+	// Whatever was read back before culling was turned off no longer matches the scene
+	if (value && !_hiZCulling && _hiZBuffer != nullptr) {
+		_hiZBuffer->Reset();
+	}
+	_hiZCulling = value;
+}
+
+bool RenderLayer::IsHiZCullingEnabled() const {
+	return _hiZCulling;
+}
+
+const HiZBuffer::Sptr& RenderLayer::GetHiZBuffer() const {
+	return _hiZBuffer;
+}
+
+void RenderLayer::SetDepthPrePass(bool value) {
+	_depthPrePass = value;
+}
+
+bool RenderLayer::IsDepthPrePassEnabled() const {
+	return _depthPrePass;
+}
+
+void RenderLayer::SetDynamicResolution(bool value) {
+	// Start back at full resolution, rather than where the controller was left when it was last used
+	if (value != _dynamicResolution) {
+		_resolutionController->Reset();
+	}
+	_dynamicResolution = value;
+}
+
+bool RenderLayer::IsDynamicResolutionEnabled() const {
+	return _dynamicResolution;
+}
+
+void RenderLayer::SetGpuBudget(float milliseconds) {
+	_resolutionController->SetBudget(milliseconds);
+}
+
+float RenderLayer::GetGpuBudget() const {
+	return _resolutionController->GetBudget();
+}
+
+const ResolutionController::Sptr& RenderLayer::GetResolutionController() const {
+	return _resolutionController;
+}
+
+void RenderLayer::SetFixedRenderScale(float value) {
+	_fixedRenderScale = glm::clamp(value, 0.1f, 1.0f);
+}
+
+float RenderLayer::GetFixedRenderScale() const {
+	return _fixedRenderScale;
+}
+
+float RenderLayer::GetRenderScale() const {
+	return _dynamicResolution ? _resolutionController->GetScale() : _fixedRenderScale;
+}
+
+const glm::ivec2& RenderLayer::GetRenderSize() const {
+	return _renderSize;
+}
+
+float RenderLayer::GetGpuTime() const {
+	return _gpuTimer->GetMilliseconds();
+}
+
+void RenderLayer::SetTemporalJitter(bool value) {
+	_temporalJitter = value;
+}
+
+bool RenderLayer::IsTemporalJitterEnabled() const {
+	return _temporalJitter;
+}
+
 const Framebuffer::Sptr& RenderLayer::GetLightingBuffer() const {
 	return _lightingFBO;
 }
@@ -524,27 +956,311 @@ void RenderLayer::_InitFrameUniforms()
 	glm::mat4 viewProj = camera->GetViewProjection();
 	glm::mat4 view = camera->GetView();
 
-	// Upload frame level uniforms
-	auto& frameData = _frameUniforms->GetData();
-	frameData.u_Projection = camera->GetProjection();
-	frameData.u_InvProjection = glm::inverse(camera->GetProjection());
-	frameData.u_View = camera->GetView();
-	frameData.u_ViewProjection = camera->GetViewProjection();
-	frameData.u_CameraPos = glm::vec4(camera->GetGameObject()->GetPosition(), 1.0f);
-	frameData.u_Time = static_cast<float>(Timing::Current().TimeSinceSceneLoad());
-	frameData.u_DeltaTime = Timing::Current().DeltaTime();
-	frameData.u_RenderFlags = _renderFlags;
-	frameData.u_ZNear = camera->GetNearPlane();
-	frameData.u_ZFar = camera->GetFarPlane();
-	frameData.u_Viewport = { 0.0f, 0.0f, _primaryFBO->GetWidth(), _primaryFBO->GetHeight() };
-
-	frameData.u_Aperture   = camera->Aperture;
-	frameData.u_LensDepth  = camera->LensDepth;
-	frameData.u_FocalDepth = camera->FocalDepth;
+	// Upload frame level uniforms, only the fields that have changed are sent to OpenGL
+	_frameUniforms->Set(&FrameLevelUniforms::u_Projection, camera->GetProjection());
+	_frameUniforms->Set(&FrameLevelUniforms::u_InvProjection, glm::inverse(camera->GetProjection()));
+	_frameUniforms->Set(&FrameLevelUniforms::u_View, camera->GetView());
+	_frameUniforms->Set(&FrameLevelUniforms::u_ViewProjection, camera->GetViewProjection());
+	_frameUniforms->Set(&FrameLevelUniforms::u_CameraPos, glm::vec4(camera->GetGameObject()->GetPosition(), 1.0f));
+	_frameUniforms->Set(&FrameLevelUniforms::u_Time, Timing::Current().TimeSinceSceneLoad());
+	_frameUniforms->Set(&FrameLevelUniforms::u_DeltaTime, Timing::Current().DeltaTime());
+	_frameUniforms->Set(&FrameLevelUniforms::u_RenderFlags, _renderFlags);
+	_frameUniforms->Set(&FrameLevelUniforms::u_ZNear, camera->GetNearPlane());
+	_frameUniforms->Set(&FrameLevelUniforms::u_ZFar, camera->GetFarPlane());
+	_frameUniforms->Set(&FrameLevelUniforms::u_Viewport, glm::vec4(0.0f, 0.0f, _renderSize.x, _renderSize.y));
+	// Bilinear samples are kept half a texel inside of the region, so they never blend in what's outside of it
+	glm::vec2 targetSize = glm::vec2(_primaryFBO->GetSize());
+	_frameUniforms->Set(&FrameLevelUniforms::u_RenderScale, glm::vec4(glm::vec2(_renderSize) / targetSize, (glm::vec2(_renderSize) - 0.5f) / targetSize));
+	// Without a previous frame nothing has moved yet
+	if (_hasPrevFrame) {
+		_frameUniforms->Set(&FrameLevelUniforms::u_PrevViewProjection, _prevViewProjection);
+		_frameUniforms->Set(&FrameLevelUniforms::u_Jitter, glm::vec4(camera->GetJitter(), _prevJitter));
+	} else {
+		_frameUniforms->Set(&FrameLevelUniforms::u_PrevViewProjection, camera->GetUnjitteredProjection() * view);
+		_frameUniforms->Set(&FrameLevelUniforms::u_Jitter, glm::vec4(camera->GetJitter(), camera->GetJitter()));
+	}
+
+	_frameUniforms->Set(&FrameLevelUniforms::u_Aperture, camera->Aperture);
+	_frameUniforms->Set(&FrameLevelUniforms::u_LensDepth, camera->LensDepth);
+	_frameUniforms->Set(&FrameLevelUniforms::u_FocalDepth, camera->FocalDepth);
 	_frameUniforms->Update();
 }
 
-void RenderLayer::_RenderScene(const glm::mat4& view, const glm::mat4& projection, const glm::ivec2& screenSize)
+void RenderLayer::_UpdateRenderSize() {
+	if (_dynamicResolution && _gpuTimer->HasNewResult()) {
+		_resolutionController->Update(_gpuTimer->GetMilliseconds());
+	}
+
+	// The targets always match the window, so a window resize is picked up here as well
+	glm::ivec2 targetSize = _primaryFBO->GetSize();
+	float scale = GetRenderScale();
+	_renderSize = glm::clamp(glm::ivec2(glm::round(glm::vec2(targetSize) * scale)), glm::ivec2(1), targetSize);
+}
+
+// Mixes a value into an FNV-1a style hash
+static void HashCombine(uint64_t& hash, uint64_t value) {
+	for (int ix = 0; ix < 8; ix++) {
+		hash ^= (value >> (ix * 8)) & 0xFF;
+		hash *= 0x100000001B3ull;
+	}
+}
+
+// Estimates the fraction of the screen that a light's frustum covers, by projecting the corners of
+// the light's frustum onto the screen. Returns zero if the light's frustum can't be seen at all
+static float GetScreenCoverage(const glm::mat4& cameraViewProjection, const glm::mat4& lightViewProjection) {
+	glm::mat4 lightToWorld = glm::inverse(lightViewProjection);
+
+	glm::vec3 corners[8];
+	BoundingBox bounds;
+	for (int ix = 0; ix < 8; ix++) {
+		glm::vec4 corner = lightToWorld * glm::vec4((ix & 1) ? 1.0f : -1.0f, (ix & 2) ? 1.0f : -1.0f, (ix & 4) ? 1.0f : -1.0f, 1.0f);
+		corners[ix] = glm::vec3(corner) / corner.w;
+		bounds.Min = ix == 0 ? corners[ix] : glm::min(bounds.Min, corners[ix]);
+		bounds.Max = ix == 0 ? corners[ix] : glm::max(bounds.Max, corners[ix]);
+	}
+	if (!Frustum::FromViewProjection(cameraViewProjection).Intersects(bounds)) {
+		return 0.0f;
+	}
+
+	glm::vec2 minNdc = glm::vec2(1.0f), maxNdc = glm::vec2(-1.0f);
+	for (const glm::vec3& corner : corners) {
+		glm::vec4 clip = cameraViewProjection * glm::vec4(corner, 1.0f);
+		// If the light's frustum reaches behind the camera, we can't project it, so assume it covers the screen
+		if (clip.w <= 0.0f) {
+			return 1.0f;
+		}
+		glm::vec2 ndc = glm::vec2(clip) / clip.w;
+		minNdc = glm::min(minNdc, ndc);
+		maxNdc = glm::max(maxNdc, ndc);
+	}
+	glm::vec2 extents = glm::clamp(maxNdc, -1.0f, 1.0f) - glm::clamp(minNdc, -1.0f, 1.0f);
+	return glm::max(extents.x, 0.0f) * glm::max(extents.y, 0.0f) * 0.25f;
+}
+
+void RenderLayer::_AllocateShadowAtlas(const glm::mat4& cameraView, const glm::mat4& cameraProjection, float nearPlane, float farPlane) {
+	Application& app = Application::Get();
+	glm::mat4 cameraViewProjection = cameraProjection * cameraView;
+
+	struct ShadowRequest {
+		ShadowCamera* Light;
+		int           Cascade;
+		uint32_t      Size;
+		float         Score;
+	};
+	std::vector<ShadowRequest> requests;
+
+	app.CurrentScene()->Components().Each<ShadowCamera>([&](const ShadowCamera::Sptr& shadowCam) {
+		for (int ix = 0; ix < ShadowCascades::MAX_CASCADES; ix++) {
+			shadowCam->SetAtlasRect(glm::ivec4(0), ix);
+		}
+		uint32_t maxSize = static_cast<uint32_t>(glm::max(shadowCam->GetBufferResolution().x, shadowCam->GetBufferResolution().y));
+
+		// Cascades are fit to the camera, so they always cover the screen. Since each cascade covers a larger
+		// area than the last, they all get the same resolution
+		if (shadowCam->Type == ShadowCameraType::Directional) {
+			if (shadowCam->Priority <= 0.0f) {
+				return;
+			}
+			for (int ix = 0; ix < shadowCam->GetShadowMapCount(); ix++) {
+				requests.push_back({ shadowCam.get(), ix, _shadowAtlas->GetLargestTileSize(maxSize), shadowCam->Priority });
+			}
+			return;
+		}
+
+		// Resolution scales with the light's linear size on screen, so the texel density stays about the same
+		float coverage = GetScreenCoverage(cameraViewProjection, shadowCam->GetViewProjection());
+		float score = glm::sqrt(coverage) * shadowCam->Priority;
+		if (score <= 0.0f) {
+			return;
+		}
+		uint32_t size = _shadowAtlas->GetTileSize(static_cast<uint32_t>(maxSize * glm::min(score, 1.0f)));
+		// The cap is rounded down, so a light never gets a tile with more texels than it's buffer resolution
+		requests.push_back({ shadowCam.get(), 0, glm::min(size, _shadowAtlas->GetLargestTileSize(maxSize)), score });
+	});
+
+	// Place the largest tiles first so the quadtree stays packed, with the most important lights first among equals
+	std::sort(requests.begin(), requests.end(), [](const ShadowRequest& a, const ShadowRequest& b) {
+		return a.Size != b.Size ? a.Size > b.Size : a.Score > b.Score;
+	});
+
+	_shadowAtlas->Clear();
+	_shadowViews.clear();
+	for (const ShadowRequest& request : requests) {
+		// If the atlas is getting full, lower priority lights get smaller tiles
+		glm::ivec4 rect;
+		for (uint32_t size = request.Size; size >= ShadowAtlas::MIN_TILE_SIZE; size /= 2) {
+			if (_shadowAtlas->Allocate(size, rect)) {
+				request.Light->SetAtlasRect(rect, request.Cascade);
+				break;
+			}
+		}
+		if (request.Light->GetAtlasRect(request.Cascade).z == 0) {
+			continue;
+		}
+
+		ShadowView view;
+		view.Light = request.Light;
+		view.Cascade = request.Cascade;
+		view.CascadeRange = glm::vec4(0.0f);
+
+		if (request.Light->Type == ShadowCameraType::Directional) {
+			ShadowCamera* light = request.Light;
+			int count = light->GetShadowMapCount();
+			float splits[ShadowCascades::MAX_CASCADES + 1];
+			ShadowCascades::CalculateSplits(nearPlane, glm::min(farPlane, light->ShadowDistance), count, light->CascadeLambda, splits);
+
+			// Each cascade fades out over the end of it's slice, and the next cascade is extended back to cover
+			// the same band so that the two can be blended together
+			int ix = request.Cascade;
+			float blend = glm::clamp(light->CascadeBlend, 0.0f, 1.0f);
+			float fadeOut = blend * (splits[ix + 1] - splits[ix]);
+			float fadeIn = ix > 0 ? blend * (splits[ix] - splits[ix - 1]) : 0.0f;
+			view.CascadeRange = glm::vec4(
+				ix > 0 ? splits[ix] - fadeIn : 0.0f, ix > 0 ? splits[ix] : 0.0f,
+				splits[ix + 1] - fadeOut, splits[ix + 1]);
+
+			// Strip any scale from the light's transform, the cascades only care about it's rotation
+			glm::mat3 rotation = glm::mat3(light->GetGameObject()->GetTransform());
+			rotation[0] = glm::normalize(rotation[0]);
+			rotation[1] = glm::normalize(rotation[1]);
+			rotation[2] = glm::normalize(rotation[2]);
+
+			ShadowCascades::Cascade cascade = ShadowCascades::FitCascade(
+				cameraView, cameraProjection, splits[ix] - fadeIn, splits[ix + 1],
+				rotation, light->GetAtlasRect(ix).z, light->CasterDistance);
+			view.View = cascade.View;
+			view.Projection = cascade.Projection;
+		} else {
+			view.View = request.Light->GetGameObject()->GetInverseTransform();
+			view.Projection = request.Light->GetProjection();
+		}
+
+		_shadowViews.push_back(view);
+	}
+	_currentStats.ShadowLights += static_cast<uint32_t>(_shadowViews.size());
+}
+
+void RenderLayer::_RenderShadowMap(const ShadowView& shadowView) {
+	ShadowCamera* shadowCam = shadowView.Light;
+	const glm::mat4& view = shadowView.View;
+	const glm::mat4& projection = shadowView.Projection;
+	const Framebuffer::Sptr& atlas = _shadowAtlas->GetFramebuffer();
+	const glm::ivec4& rect = shadowCam->GetAtlasRect(shadowView.Cascade);
+	glm::ivec2 size = glm::ivec2(rect.z, rect.w);
+
+	if (!shadowCam->CacheStaticShadows) {
+		// Bind the atlas and clear our region of it
+		atlas->Bind();
+		GlState::Enable(GL_SCISSOR_TEST);
+		glScissor(rect.x, rect.y, rect.z, rect.w);
+		glClear(GL_DEPTH_BUFFER_BIT);
+		GlState::Disable(GL_SCISSOR_TEST);
+		glViewport(rect.x, rect.y, rect.z, rect.w);
+
+		_RenderScene(view, projection, size);
+
+		GlState::BindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+		return;
+	}
+
+	// Only re-render the static casters when the light or one of the static casters that it can see has changed
+	const Framebuffer::Sptr& staticBuffer = shadowCam->GetStaticDepthBuffer(shadowView.Cascade);
+	uint64_t key = _GetStaticShadowKey(shadowView);
+	if (!shadowCam->IsStaticCacheValid(key, shadowView.Cascade)) {
+		staticBuffer->Bind();
+		glClear(GL_DEPTH_BUFFER_BIT);
+		glViewport(0, 0, size.x, size.y);
+
+		_RenderScene(view, projection, size, false, DrawFilter::StaticOnly);
+
+		shadowCam->SetStaticCacheKey(key, shadowView.Cascade);
+		_currentStats.StaticShadowUpdates++;
+	}
+
+	// Start from a copy of the static casters, and draw the dynamic casters on top
+	glBlitNamedFramebuffer(
+		staticBuffer->GetHandle(), atlas->GetHandle(),
+		0, 0, size.x, size.y,
+		rect.x, rect.y, rect.x + rect.z, rect.y + rect.w,
+		GL_DEPTH_BUFFER_BIT, GL_NEAREST
+	);
+
+	atlas->Bind();
+	glViewport(rect.x, rect.y, rect.z, rect.w);
+
+	_RenderScene(view, projection, size, false, DrawFilter::DynamicOnly);
+
+	GlState::BindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+}
+
+uint64_t RenderLayer::_GetStaticShadowKey(const ShadowView& shadowView) {
+	using namespace Gameplay;
+
+	uint64_t hash = 0xCBF29CE484222325ull;
+
+	// Any change to the light's position, orientation, projection or resolution changes the matrix or size. Cascades
+	// only move in whole texel steps (in depth as well), so they will keep their cache while the camera moves within a texel
+	glm::mat4 viewProjection = shadowView.Projection * shadowView.View;
+	const float* matrix = glm::value_ptr(viewProjection);
+	for (int ix = 0; ix < 16; ix++) {
+		uint32_t bits;
+		memcpy(&bits, &matrix[ix], sizeof(uint32_t));
+		HashCombine(hash, bits);
+	}
+	const glm::ivec4& rect = shadowView.Light->GetAtlasRect(shadowView.Cascade);
+	HashCombine(hash, (static_cast<uint64_t>(rect.z) << 32) | static_cast<uint32_t>(rect.w));
+
+	// Static casters only change by becoming dynamic, leaving or entering the frustum, or changing their
+	// mesh or level of detail, so the set of visible static casters is enough to tell if the cache is stale
+	Frustum frustum = Frustum::FromViewProjection(viewProjection);
+	Application::Get().CurrentScene()->Components().Each<RenderComponent>([&](const RenderComponent::Sptr& renderable) {
+		if (!renderable->IsStatic() || renderable->GetMeshResource() == nullptr) {
+			return;
+		}
+		if (!frustum.Intersects(renderable->GetWorldSphere()) || !frustum.Intersects(renderable->GetWorldBox())) {
+			return;
+		}
+		HashCombine(hash, reinterpret_cast<uintptr_t>(renderable.get()));
+		HashCombine(hash, reinterpret_cast<uintptr_t>(renderable->GetMeshResource().get()));
+		HashCombine(hash, static_cast<uint64_t>(renderable->GetLodIndex()));
+	});
+
+	return hash;
+}
+
+// Gets a small, densely packed ID for an object so that it can be stored in a sort key
+static uint32_t GetSortId(std::unordered_map<const void*, uint32_t>& ids, const void* object) {
+	auto it = ids.find(object);
+	if (it != ids.end()) {
+		return it->second;
+	}
+	uint32_t result = static_cast<uint32_t>(ids.size());
+	ids[object] = result;
+	return result;
+}
+
+void RenderLayer::_RenderScene(const glm::mat4& view, const glm::mat4& projection, const glm::ivec2& screenSize, bool selectLods, DrawFilter filter, bool mainView)
+{
+	glm::mat4 viewProj = projection * view;
+
+	_frameUniforms->Set(&FrameLevelUniforms::u_Projection, projection);
+	_frameUniforms->Set(&FrameLevelUniforms::u_View, view);
+	_frameUniforms->Set(&FrameLevelUniforms::u_ViewProjection, viewProj);
+	_frameUniforms->Set(&FrameLevelUniforms::u_CameraPos, view * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+	_frameUniforms->Set(&FrameLevelUniforms::u_Viewport, glm::vec4(0.0f, 0.0f, screenSize.x, screenSize.y));
+	_frameUniforms->Update();
+
+	// Shadow maps have no fragment shading to save, so only the main view uses the depth pre-pass
+	bool depthPrePass = mainView && _depthPrePass;
+	if (depthPrePass) {
+		_CollectPrePassResults();
+	}
+
+	_PrepareScene(view, projection, screenSize, selectLods, filter, mainView);
+	_SubmitScene();
+}
+
+void RenderLayer::_PrepareScene(const glm::mat4& view, const glm::mat4& projection, const glm::ivec2& screenSize, bool selectLods, DrawFilter filter, bool mainView)
 {
 	using namespace Gameplay;
 
@@ -552,24 +1268,28 @@ void RenderLayer::_RenderScene(const glm::mat4& view, const glm::mat4& projectio
 
 	glm::mat4 viewProj = projection * view;
 
-	// The current material that is bound for rendering
-	Material::Sptr currentMat = nullptr;
-	ShaderProgram::Sptr shader = nullptr;
-
 	Material::Sptr defaultMat = app.CurrentScene()->DefaultMaterial;
 
-	auto& frameData = _frameUniforms->GetData();
-	frameData.u_Projection = projection;
-	frameData.u_View = view;
-	frameData.u_ViewProjection = viewProj;
-	frameData.u_CameraPos = view * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
-	frameData.u_Viewport = { 0.0f, 0.0f, screenSize.x, screenSize.y };
-	_frameUniforms->Update();
-
-	// Render all our objects
+	_renderQueue.Clear();
+	_drawList.clear();
+	_shaderSortIds.clear();
+	_materialSortIds.clear();
+	_arenaSortIds.clear();
+	_meshSortIds.clear();
+
+	// The state we would have had bound if we drew in component order, so we can see how much sorting saves us
+	const void* unsortedShader = nullptr;
+	const void* unsortedMaterial = nullptr;
+	const void* unsortedArena = nullptr;
+
+	// Collect all the objects that we could draw, along with their bounds and transforms. Fetching these can
+	// recalculate the object's cached transforms, so it's done here, and the threads below only read the copies
+	_cullSpheres.clear();
+	_prepareDraws.clear();
 	app.CurrentScene()->Components().Each<RenderComponent>([&](const RenderComponent::Sptr& renderable) {
 		// Early bail if mesh not set
-		if (renderable->GetMesh() == nullptr) {
+		const MeshResource::Sptr& meshResource = renderable->GetMeshResource();
+		if (meshResource == nullptr || !meshResource->IsLoaded()) {
 			return;
 		}
 
@@ -584,32 +1304,440 @@ void RenderLayer::_RenderScene(const glm::mat4& view, const glm::mat4& projectio
 			}
 		}
 
-		// If the material has changed, we need to bind the new shader and set up our material and frame data
-		// Note: This is a good reason why we should be sorting the render components in ComponentManager
-		if (renderable->GetMaterial() != currentMat) {
-			currentMat = renderable->GetMaterial();
-			shader = currentMat->GetShader();
+		if ((filter == DrawFilter::StaticOnly && !renderable->IsStatic()) ||
+			(filter == DrawFilter::DynamicOnly && renderable->IsStatic())) {
+			return;
+		}
 
-			shader->Bind();
-			currentMat->Apply();
+		// World bounds are cached by the component, and only recalculated when the object moves
+		const BoundingSphere& sphere = renderable->GetWorldSphere();
+		_cullSpheres.push_back(glm::vec4(sphere.Center, sphere.Radius));
+		_prepareDraws.push_back({
+			renderable->GetWorldBox(), sphere, renderable->IsOccluder(), meshResource->Lods.size() > 1,
+			renderable->GetGameObject()->GetTransform(), renderable->GetPreviousTransform()
+		});
+		_drawList.push_back(renderable.get());
+	});
+
+	// Test all of the spheres against the frustum in one batch, then refine the survivors with their
+	// boxes, which are a much tighter fit for long thin objects like level geometry
+	Frustum frustum = Frustum::FromViewProjection(viewProj);
+	_visibleDraws.resize(_drawList.size());
+	uint32_t visibleCount = frustum.CullSpheres(_cullSpheres.data(), static_cast<uint32_t>(_cullSpheres.size()), _visibleDraws.data());
+	_currentStats.Culled += static_cast<uint32_t>(_drawList.size()) - visibleCount;
+
+	// Occlusion culling only applies to the main camera's view, which is the one the Hi-Z buffer is built from
+	bool softwareOcclusion = mainView && _occlusionCulling;
+	bool hiZOcclusion = mainView && _hiZCulling && _hiZBuffer->GetPyramid()->HasData();
+	// The Hi-Z depth is a few frames old, grow the boxes by how far the camera has moved since then
+	float hiZMargin = hiZOcclusion ? _hiZBuffer->GetPyramid()->GetCameraDistance(glm::vec3(glm::inverse(view)[3])) : 0.0f;
+	bool depthPrePass = mainView && _depthPrePass;
+
+	// Draw the visible occluders into the occlusion buffer, so we can test everything else against them
+	if (softwareOcclusion) {
+		_occlusionBuffer->Begin(viewProj);
+		for (uint32_t visibleIx = 0; visibleIx < visibleCount; visibleIx++) {
+			RenderComponent* renderable = _drawList[_visibleDraws[visibleIx]];
+			const MeshResource::Sptr& meshResource = renderable->GetMeshResource();
+			if (renderable->IsOccluder() && !meshResource->OccluderIndices.empty()) {
+				_occlusionBuffer->AddOccluder(_prepareDraws[_visibleDraws[visibleIx]].Transform,
+					meshResource->OccluderVertices.data(), meshResource->OccluderIndices.data(), meshResource->OccluderIndices.size());
+			}
 		}
+		_occlusionBuffer->Rasterize(*_workerPool);
+		_currentStats.OccluderTriangles += _occlusionBuffer->GetTriangleCount();
+	}
+
+	// Refine the culling and pick the level of detail for the visible objects. Each thread takes a contiguous
+	// range of the draws and writes the survivors into it's own buffer, so they stay in component order
+	ScenePrepare::Settings settings;
+	settings.View = view;
+	settings.Projection = projection;
+	settings.ScreenSize = screenSize;
+	settings.ViewFrustum = frustum;
+	settings.Occlusion = softwareOcclusion ? _occlusionBuffer.get() : nullptr;
+	settings.HiZ = hiZOcclusion ? _hiZBuffer->GetPyramid().get() : nullptr;
+	settings.HiZMargin = hiZMargin;
+	settings.LodPixelError = _lodPixelError;
+	if (selectLods) {
+		settings.SelectLod = [&](uint32_t drawIx, float screenDiameter) {
+			RenderComponent* renderable = _drawList[drawIx];
+			return renderable->GetMeshResource()->SelectLod(screenDiameter, renderable->GetLodIndex(), _lodPixelError);
+		};
+	}
+	size_t threadCount = ScenePrepare::Prepare(*_workerPool, _prepareDraws, _visibleDraws.data(), visibleCount,
+		PREPARE_MIN_DRAWS_PER_THREAD, settings, _prepareBuffers);
+
+	// Build the sort keys for the survivors. The IDs in the keys are handed out in the order that objects
+	// are first seen, so this is done in component order on the calling thread
+	for (size_t thread = 0; thread < threadCount; thread++) {
+		const ScenePrepare::Buffer& buffer = _prepareBuffers[thread];
+		_currentStats.Culled += buffer.Culled;
+		_currentStats.OcclusionCulled += buffer.OcclusionCulled;
+		_currentStats.HiZCulled += buffer.HiZCulled;
+
+		for (const ScenePrepare::PreparedDraw& draw : buffer.Draws) {
+			RenderComponent* renderable = _drawList[draw.DrawIndex];
+			if (draw.Lod >= 0) {
+				renderable->SetLodIndex(draw.Lod);
+			}
+			const MeshResource::Sptr& meshResource = renderable->GetMeshResource();
+			const Material::Sptr& material = renderable->GetMaterial();
+			const ShaderProgram* shader = material->GetShader().get();
+			MeshArena* arena = meshResource->GetArena().get();
+
+			// Count the binds that drawing in component order would have cost
+			if (shader != unsortedShader) {
+				unsortedShader = shader;
+				_currentStats.UnsortedShaderBinds++;
+			}
+			if (material.get() != unsortedMaterial) {
+				unsortedMaterial = material.get();
+				_currentStats.UnsortedMaterialBinds++;
+			}
+			if (arena == nullptr || arena != unsortedArena) {
+				unsortedArena = arena;
+				_currentStats.UnsortedVaoBinds++;
+			}
 
-		// Grab the game object so we can do some stuff with it
-		GameObject* object = renderable->GetGameObject();
+			// Meshes are grouped by arena first, since switching arenas is what costs us a VAO bind. The level
+			// of detail goes in the lowest bits, so that objects that can be instanced together end up together
+			uint32_t meshId = (GetSortId(_arenaSortIds, arena) << 13) | (((GetSortId(_meshSortIds, meshResource.get()) << 2) | (renderable->GetLodIndex() & 0x3)) & 0x1FFF);
 
-		// Use our uniform buffer for our instance level uniforms
-		auto& instanceData = _instanceUniforms->GetData();
-		instanceData.u_Model = object->GetTransform();
-		instanceData.u_ModelViewProjection = viewProj * object->GetTransform();
-		instanceData.u_ModelView = view * object->GetTransform();
-		instanceData.u_NormalMatrix = glm::mat3(glm::transpose(glm::inverse(object->GetTransform())));
-		_instanceUniforms->Update();
+			// All of our geometry currently goes through a single opaque pass on a single layer, materials
+			// using the depth pre-pass are moved to the end of it
+			uint32_t pass = depthPrePass && _UsesDepthPrePass(material) ? PREPASS_RENDER_PASS : 0;
+			uint64_t key = RenderQueue::MakeKey(pass, 0, GetSortId(_shaderSortIds, shader), GetSortId(_materialSortIds, material.get()), meshId, draw.Depth);
+			_renderQueue.Push(key, draw.DrawIndex);
+		}
+	}
 
-		// Draw the object
-		renderable->GetMesh()->Draw();
+	_renderQueue.Sort();
+
+	// Merge runs of draws with the same mesh, level of detail and material into instanced batches. Our
+	// sort key already puts these next to each other, and keeps them front to back within the run
+	const std::vector<RenderQueue::Entry>& entries = _renderQueue.GetEntries();
+	_drawBatches.clear();
+	for (uint32_t ix = 0; ix < entries.size(); ix++) {
+		RenderComponent* renderable = _drawList[entries[ix].Index];
+
+		bool merged = false;
+		if (!_drawBatches.empty()) {
+			RenderComponent* first = _drawList[entries[_drawBatches.back().FirstEntry].Index];
+			// Standalone meshes can't offset into the instance buffer, so they are always drawn alone
+			merged =
+				renderable->GetMeshResource() == first->GetMeshResource() &&
+				renderable->GetMaterial() == first->GetMaterial() &&
+				renderable->GetLodIndex() == first->GetLodIndex() &&
+				renderable->GetMeshResource()->GetArena() != nullptr;
+		}
+		if (merged) {
+			_drawBatches.back().Count++;
+		} else {
+			_drawBatches.push_back({ ix, 1 });
+		}
+	}
 
+	// Pack the instance data in sorted order from the transforms we copied out above, every instance has
+	// it's own slot so the threads never overlap
+	_instanceData.resize(entries.size());
+	_workerPool->RunRanges(entries.size(), PREPARE_MIN_DRAWS_PER_THREAD, [&](size_t /*thread*/, size_t begin, size_t end) {
+		for (size_t ix = begin; ix < end; ix++) {
+			const ScenePrepare::Draw& draw = _prepareDraws[entries[ix].Index];
+			InstanceData& instance = _instanceData[ix];
+			instance.Model = draw.Transform;
+			instance.PrevModel = draw.PrevTransform;
+		}
 	});
+}
+
+void RenderLayer::_SubmitScene()
+{
+	using namespace Gameplay;
+
+	const std::vector<RenderQueue::Entry>& entries = _renderQueue.GetEntries();
 
+	// Send all of the instance data over in one go, rather than updating a uniform buffer per draw
+	_UploadInstances();
+
+	// Pre-pass materials sort after everything else, so they are all in the batches at the end
+	size_t firstPrePassBatch = _drawBatches.size();
+	for (size_t ix = 0; ix < _drawBatches.size(); ix++) {
+		if (RenderQueue::GetPass(entries[_drawBatches[ix].FirstEntry].Key) == PREPASS_RENDER_PASS) {
+			firstPrePassBatch = ix;
+			break;
+		}
+	}
+
+	// The state that is currently bound, so we can skip redundant binds
+	const Material* currentMat = nullptr;
+	const ShaderProgram* currentShader = nullptr;
+	MeshArena* currentArena = nullptr;
+	PrePassState* measuring = nullptr;
+
+	// Submit our batches in key order
+	for (size_t batchIx = 0; batchIx < _drawBatches.size(); batchIx++) {
+		// Once everything else is drawn, the pre-pass materials fill in their depth, and are then shaded
+		// only where their depth is the one that was kept
+		if (batchIx == firstPrePassBatch) {
+			_RenderDepthPrePass(firstPrePassBatch);
+			GlState::DepthFunc(GL_EQUAL);
+			GlState::DepthMask(false);
+			currentMat = nullptr;
+			currentShader = nullptr;
+			currentArena = nullptr;
+		}
+
+		const DrawBatch& batch = _drawBatches[batchIx];
+		RenderComponent* renderable = _drawList[entries[batch.FirstEntry].Index];
+		const Material::Sptr& material = renderable->GetMaterial();
+
+		// Materials that share a shader only need to update their uniforms
+		if (material->GetShader().get() != currentShader) {
+			currentShader = material->GetShader().get();
+			material->GetShader()->Bind();
+			_currentStats.ShaderBinds++;
+		}
+		if (material.get() != currentMat) {
+			currentMat = material.get();
+			material->Apply();
+			_currentStats.MaterialBinds++;
+			if (batchIx >= firstPrePassBatch) {
+				_SwitchPrePassQuery(measuring, material.get(), 1);
+			}
+		}
+
+		_DrawBatch(batch, currentArena);
+		_currentStats.Instances += batch.Count;
+	}
+
+	// Put the depth state back, and wait for the results of anything that was measured this frame
+	if (firstPrePassBatch < _drawBatches.size()) {
+		_SwitchPrePassQuery(measuring, nullptr, 1);
+		GlState::DepthFunc(GL_LESS);
+		GlState::DepthMask(true);
+		for (auto& [key, state] : _prePassStates) {
+			if (state.Measuring) {
+				state.Measuring = false;
+				state.Pending = true;
+			}
+		}
+	}
+
+	VertexArrayObject::Unbind();
+}
+
+void RenderLayer::_DrawBatch(const DrawBatch& batch, MeshArena*& currentArena) {
+	using namespace Gameplay;
+
+	RenderComponent* renderable = _drawList[_renderQueue.GetEntries()[batch.FirstEntry].Index];
+	const MeshResource::Sptr& meshResource = renderable->GetMeshResource();
+
+	// Draw the objects, we only need to switch VAOs when we move to a mesh in a different arena
+	MeshArena::Sptr arena = meshResource->GetArena();
+	if (arena != nullptr) {
+		if (arena.get() != currentArena) {
+			// Arenas may have been created or resized since we last drew from them
+			if (arena->GetInstanceBuffer() != _instanceBuffer) {
+				arena->SetInstanceBuffer(_instanceBuffer, InstanceData::V_DECL);
+			}
+			arena->Bind();
+			currentArena = arena.get();
+			_currentStats.VaoBinds++;
+		}
+		arena->DrawInstanced(*meshResource->Vertices, *meshResource->GetLod(renderable->GetLodIndex()).Indices, batch.Count, batch.FirstEntry);
+	} else {
+		// Standalone meshes don't have our instance buffer attached, so we feed the instance through the
+		// generic vertex attributes instead. Note that these meshes unbind their VAO after drawing
+		const InstanceData& instance = _instanceData[batch.FirstEntry];
+		for (int ix = 0; ix < 4; ix++) {
+			glVertexAttrib4fv(8 + ix, glm::value_ptr(instance.Model[ix]));
+			glVertexAttrib4fv(12 + ix, glm::value_ptr(instance.PrevModel[ix]));
+		}
+		meshResource->Mesh->Draw();
+		currentArena = nullptr;
+		_currentStats.VaoBinds++;
+	}
+	_currentStats.DrawCalls++;
+}
+
+void RenderLayer::_RenderDepthPrePass(size_t firstBatch) {
+	using namespace Gameplay;
+
+	const std::vector<RenderQueue::Entry>& entries = _renderQueue.GetEntries();
+
+	// Only depth is written, the G-Buffer pass will fill in the colors
+	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+
+	const Material* currentMat = nullptr;
+	const ShaderProgram* currentShader = nullptr;
+	MeshArena* currentArena = nullptr;
+	PrePassState* measuring = nullptr;
+
+	for (size_t batchIx = firstBatch; batchIx < _drawBatches.size(); batchIx++) {
+		const DrawBatch& batch = _drawBatches[batchIx];
+		const Material::Sptr& material = _drawList[entries[batch.FirstEntry].Index]->GetMaterial();
+
+		if (material.get() != currentMat) {
+			currentMat = material.get();
+
+			// Materials only end up in this pass if their shader has a variant, see _UsesDepthPrePass
+			const ShaderProgram::Sptr& shader = _GetPrePassShader(material->GetShader());
+			if (shader.get() != currentShader) {
+				currentShader = shader.get();
+				shader->Bind();
+				_currentStats.ShaderBinds++;
+			}
+			material->ApplyTo(shader);
+			_currentStats.MaterialBinds++;
+			_currentStats.PrePassMaterials++;
+			_SwitchPrePassQuery(measuring, material.get(), 0);
+		}
+
+		_DrawBatch(batch, currentArena);
+		_currentStats.PrePassDraws++;
+	}
+	_SwitchPrePassQuery(measuring, nullptr, 0);
+
+	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+}
+
+bool RenderLayer::_UsesDepthPrePass(const Gameplay::Material::Sptr& material) {
+	using namespace Gameplay;
+
+	if (material->DepthPrePass == DepthPrePassMode::Never || _GetPrePassShader(material->GetShader()) == nullptr) {
+		return false;
+	}
+	if (material->DepthPrePass == DepthPrePassMode::Always) {
+		return true;
+	}
+
+	auto it = _prePassStates.find(material->GetGUID());
+	if (it == _prePassStates.end()) {
+		PrePassState state;
+		state.Source = material;
+		state.Enabled = false;
+		state.Measuring = false;
+		state.Pending = false;
+		state.FramesUntilRetest = 0;
+		state.Overdraw = 0.0f;
+		glGenQueries(2, state.Queries);
+		it = _prePassStates.emplace(material->GetGUID(), state).first;
+	}
+
+	// Disabled materials are given a trial run with the pre-pass when it's time to measure them again,
+	// and keep it until that measurement comes back
+	PrePassState& state = it->second;
+	bool result = state.Enabled || state.FramesUntilRetest <= 0;
+	if (result && !state.Pending) {
+		state.Measuring = true;
+	}
+	return result;
+}
+
+const ShaderProgram::Sptr& RenderLayer::_GetPrePassShader(const ShaderProgram::Sptr& shader) {
+	auto it = _prePassShaders.find(shader->GetGUID());
+	if (it != _prePassShaders.end()) {
+		return it->second.Variant;
+	}
+
+	// The pre-pass fragment shader only knows how to run the alpha test of shaders that use these two
+	// uniforms, anything else (different names, blended textures, no alpha test) has to skip the pre-pass
+	// rather than being cut out with the wrong texture
+	const std::unordered_map<std::string, ShaderProgram::UniformInfo>& uniforms = shader->GetUniforms();
+	auto albedo = uniforms.find("u_Material.AlbedoMap");
+	auto threshold = uniforms.find("u_Material.DiscardThreshold");
+	if (albedo == uniforms.end() || albedo->second.Type != ShaderDataType::Tex2D ||
+		threshold == uniforms.end() || threshold->second.Type != ShaderDataType::Float) {
+		LOG_INFO("\"{}\" does not alpha test with u_Material.AlbedoMap and u_Material.DiscardThreshold, it's materials will skip the pre-pass", shader->GetDebugName());
+		PrePassShader& entry = _prePassShaders[shader->GetGUID()];
+		entry.Source = shader;
+		entry.Variant = nullptr;
+		return entry.Variant;
+	}
+
+	// The vertex stage and anything after it can move the positions, so those all have to be kept
+	ShaderProgram::Sptr result = ShaderProgram::Create();
+	bool loaded = result->LoadShaderPartFrom(*shader, ShaderPartType::Vertex);
+	result->LoadShaderPartFrom(*shader, ShaderPartType::TessControl);
+	result->LoadShaderPartFrom(*shader, ShaderPartType::TessEval);
+	result->LoadShaderPartFrom(*shader, ShaderPartType::Geometry);
+	loaded = loaded && result->LoadShaderPartFromFile("shaders/fragment_shaders/depth_prepass.glsl", ShaderPartType::Fragment);
+	loaded = loaded && result->Link();
+
+	if (loaded) {
+		result->SetDebugName(shader->GetDebugName() + " (Depth Pre-Pass)");
+	} else {
+		LOG_WARN("Failed to build a depth pre-pass variant of \"{}\", it's materials will skip the pre-pass", shader->GetDebugName());
+		result = nullptr;
+	}
+	PrePassShader& entry = _prePassShaders[shader->GetGUID()];
+	entry.Source = shader;
+	entry.Variant = result;
+	return entry.Variant;
+}
+
+void RenderLayer::_CollectPrePassResults() {
+	// Materials and shaders that were unloaded with their scene won't be drawn again
+	for (auto it = _prePassStates.begin(); it != _prePassStates.end();) {
+		if (it->second.Source.expired()) {
+			glDeleteQueries(2, it->second.Queries);
+			it = _prePassStates.erase(it);
+		} else {
+			++it;
+		}
+	}
+	for (auto it = _prePassShaders.begin(); it != _prePassShaders.end();) {
+		if (it->second.Source.expired()) {
+			it = _prePassShaders.erase(it);
+		} else {
+			++it;
+		}
+	}
+
+	for (auto& [guid, state] : _prePassStates) {
+		if (!state.Pending) {
+			if (!state.Enabled && state.FramesUntilRetest > 0) {
+				state.FramesUntilRetest--;
+			}
+			continue;
+		}
+
+		// The G-Buffer query is issued last, so once it is done both are. We never wait on the GPU here
+		GLuint available = GL_FALSE;
+		glGetQueryObjectuiv(state.Queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (available == GL_FALSE) {
+			continue;
+		}
+
+		GLuint64 prePassSamples = 0;
+		GLuint64 shadedSamples = 0;
+		glGetQueryObjectui64v(state.Queries[0], GL_QUERY_RESULT, &prePassSamples);
+		glGetQueryObjectui64v(state.Queries[1], GL_QUERY_RESULT, &shadedSamples);
+		state.Pending = false;
+
+		// Use separate thresholds for turning on and off, so materials near the threshold don't flicker between them
+		state.Overdraw = static_cast<float>(prePassSamples) / static_cast<float>(glm::max<GLuint64>(shadedSamples, 1));
+		state.Enabled = state.Overdraw > (state.Enabled ? PREPASS_DISABLE_OVERDRAW : PREPASS_ENABLE_OVERDRAW);
+		if (!state.Enabled) {
+			state.FramesUntilRetest = PREPASS_RETEST_FRAMES;
+		}
+	}
+}
+
+void RenderLayer::_SwitchPrePassQuery(PrePassState*& measuring, const Gameplay::Material* material, int pass) {
+	if (measuring != nullptr) {
+		glEndQuery(GL_SAMPLES_PASSED);
+		measuring = nullptr;
+	}
+	if (material == nullptr) {
+		return;
+	}
+	auto it = _prePassStates.find(material->GetGUID());
+	if (it != _prePassStates.end() && it->second.Measuring) {
+		glBeginQuery(GL_SAMPLES_PASSED, it->second.Queries[pass]);
+		measuring = &it->second;
+	}
 }
 
 const UniformBuffer<RenderLayer::FrameLevelUniforms>::Sptr& RenderLayer::GetFrameUniforms() const
@@ -617,3 +1745,18 @@ const UniformBuffer<RenderLayer::FrameLevelUniforms>::Sptr& RenderLayer::GetFram
 	return _frameUniforms;
 }
 
+void RenderLayer::_UploadInstances() {
+	uint32_t count = static_cast<uint32_t>(_instanceData.size());
+	if (count == 0) {
+		return;
+	}
+
+	// This is written straight into the buffer's mapped memory, after the data from any earlier passes
+	// this frame. The buffer grows if a frame's worth of instances stops fitting
+	_instanceBuffer->UpdateData(_instanceData.data(), sizeof(InstanceData), count);
+}
+
+const RenderLayer::RenderStats& RenderLayer::GetRenderStats() const {
+	return _frameStats;
+}
+
@@ -4,14 +4,46 @@
 #include "Graphics/Buffers/UniformBuffer.h"
 #include "Graphics/ShaderProgram.h"
 #include "Graphics/VertexArrayObject.h"
+#include "Graphics/RenderQueue.h"
+#include "Graphics/ShadowAtlas.h"
+#include "Graphics/LightClusters.h"
+#include "Graphics/OcclusionBuffer.h"
+#include "Graphics/HiZBuffer.h"
+#include "Graphics/ScenePrepare.h"
+#include "Graphics/GpuTimer.h"
+#include "Graphics/ResolutionController.h"
+#include "Graphics/Buffers/ShaderStorageBuffer.h"
+#include "Utils/WorkerPool.h"
+#include <unordered_map>
 
 #define MAX_LIGHTS 8
+// The maximum number of shadow casting lights that are composited in a single pass
+#define MAX_SHADOW_LIGHTS 16
+// The maximum number of projection masks that can be bound for a single shadow pass
+#define MAX_PROJECTION_MASKS 4
+
+class RenderComponent;
+class ShadowCamera;
+class MeshArena;
+namespace Gameplay {
+	class Material;
+}
 
 ENUM_FLAGS(RenderFlags, uint32_t,
 	None = 0,
 	EnableColorCorrection = 1 << 0
 );
 
+/// <summary>
+/// Selects how point lights are accumulated into the lighting buffer
+/// </summary>
+ENUM(LightPassMode, int,
+	// Lights are binned into clusters, and every pixel is shaded once with the lights in it's cluster
+	Clustered = 0,
+	// Each light draws a sphere around it's range, and the stencil buffer limits shading to the scene inside of it
+	StencilVolumes = 1
+);
+
 class RenderLayer final : public ApplicationLayer {
 public:
 	MAKE_PTRS(RenderLayer); 
@@ -49,22 +81,62 @@ public:
 		float u_Aperture = 20.0f;
 
 		glm::vec4 u_Viewport;
+		// The fraction of the G-Buffer that the scene is rendered into in xy, and the largest UV that
+		// can be sampled inside of it in zw
+		glm::vec4 u_RenderScale;
+		// The view projection from the previous frame without jitter, for motion vectors
+		glm::mat4 u_PrevViewProjection;
+		// The projection jitter in NDC for this frame in xy, and the previous frame in zw
+		glm::vec4 u_Jitter;
+
+	};
 
+	// Structure for our per-instance data, matches the instanced attributes
+	// from fragments/vs_common.glsl
+	// For use with an instanced vertex buffer.
+	struct InstanceData {
+		// Just the model transform, the view and projection are added in the shader. The normal matrix
+		// is built from this in the shader
+		glm::mat4 Model;
+		// The model transform from the previous frame, for motion vectors
+		glm::mat4 PrevModel;
 
+		// The instanced attributes for this structure, slots 8 through 15
+		static const VertexArrayObject::VertexDeclaration V_DECL;
 	};
 
-	// Structure for our instance-level uniforms, matches layout from
-	// fragments/frame_uniforms.glsl
-	// For use with a UBO.
-	struct InstanceLevelUniforms {
-		// Complete MVP
-		glm::mat4 u_ModelViewProjection;
-		// Just the model transform, we'll do worldspace lighting
-		glm::mat4 u_Model;
-		// To go from model space to view space
-		glm::mat4 u_ModelView;
-		// Normal Matrix for transforming normals
-		glm::mat4 u_NormalMatrix;
+	/// <summary>
+	/// Represents a c++ struct layout that matches the shadow light
+	/// uniform buffer in shadow_composite.glsl
+	/// </summary>
+	struct ShadowUboStruct {
+		// Flags set by the renderer on top of the light's ShadowFlags, these must match shadow_composite.glsl
+		static const uint32_t FLAG_CASCADE      = 1 << 4;
+		static const uint32_t FLAG_LAST_CASCADE = 1 << 5;
+
+		struct ShadowLight {
+			glm::mat4 ViewToShadow;
+			// Offset in xy and scale in zw, in UV space of the atlas
+			glm::vec4 AtlasRect;
+			glm::vec3 Position;
+			float     Intensity;
+			glm::vec3 Direction;
+			float     Bias;
+			glm::vec3 Color;
+			float     Attenuation;
+			float     NormalBias;
+			uint32_t  Flags;
+			int32_t   MaskIndex;
+			float     Padding;
+			// For cascades, the view depths that the cascade fades in and out over, as
+			// (fade in start, fade in end, fade out start, fade out end)
+			glm::vec4 CascadeRange;
+		};
+
+		uint32_t    NumShadowLights;
+		// Pad out to the alignment of the light structures
+		uint32_t    Padding[3];
+		ShadowLight Lights[MAX_SHADOW_LIGHTS];
 	};
 
 	/// <summary>
@@ -93,6 +165,67 @@ public:
 		glm::mat4 EnvironmentRotation;
 	};
 
+	/// <summary>
+	/// Represents a c++ struct layout that matches a light in the clustered
+	/// light list in light_accumulation.glsl, using the std430 layout
+	/// </summary>
+	struct ClusterLight {
+		glm::vec3 Position;
+		float     Intensity;
+		glm::vec3 Color;
+		float     Attenuation;
+		// The distance at which the light is cut off, see GetLightRange in RenderLayer.cpp
+		float     Range;
+		float     Padding[3];
+	};
+
+	/// <summary>
+	/// Counts of the draws and state changes made while rendering the scene over a frame,
+	/// including shadow passes
+	/// </summary>
+	struct RenderStats {
+		uint32_t DrawCalls;
+		// The number of objects that were drawn, objects may be merged into one instanced draw call
+		uint32_t Instances;
+		// The number of objects that were skipped because they were outside of the view frustum
+		uint32_t Culled;
+		// The number of objects that were hidden behind occluders, and the number of occluder
+		// triangles that were drawn into the occlusion buffer
+		uint32_t OcclusionCulled;
+		uint32_t OccluderTriangles;
+		// The number of objects that were hidden behind the depth of an earlier frame
+		uint32_t HiZCulled;
+		// The number of draw calls made in the depth pre-pass, and the number of materials that were drawn in it
+		uint32_t PrePassDraws;
+		uint32_t PrePassMaterials;
+		// The number of times a shadow camera had to re-render it's cached static casters
+		uint32_t StaticShadowUpdates;
+		// The number of shadow maps that were given space in the shadow atlas, each cascade counts as one
+		uint32_t ShadowLights;
+		// The number of shadow composite passes, lights are composited in batches of MAX_SHADOW_LIGHTS
+		uint32_t ShadowPasses;
+		// The number of point lights, and the total number of lights that were binned into clusters,
+		// a light will be counted once for every cluster that it touches
+		uint32_t Lights;
+		uint32_t ClusterLightRefs;
+		// The number of lights that were drawn as stencil tested volumes
+		uint32_t LightVolumes;
+		// The binds that were actually made, after sorting and skipping redundant binds
+		uint32_t ShaderBinds;
+		uint32_t MaterialBinds;
+		uint32_t VaoBinds;
+		// The binds that would have been made if we had drawn in component order
+		uint32_t UnsortedShaderBinds;
+		uint32_t UnsortedMaterialBinds;
+		uint32_t UnsortedVaoBinds;
+		// The state changes that went through the GL state cache for the whole frame, the ones that
+		// were skipped since they would not have changed anything, and the number of times the cache
+		// was found to be out of date
+		uint32_t StateChanges;
+		uint32_t StateChangesSkipped;
+		uint32_t StateMismatches;
+	};
+
 	RenderLayer();
 	virtual ~RenderLayer();
 
@@ -110,12 +243,100 @@ public:
 	void SetRenderFlags(RenderFlags value);
 	RenderFlags GetRenderFlags() const;
 
+	/// <summary>
+	/// Sets the maximum error in pixels that we will accept when selecting mesh levels of detail,
+	/// set to 0 to always render at full detail
+	/// </summary>
+	void SetLodPixelError(float value);
+	float GetLodPixelError() const;
+
+	/// <summary>
+	/// Sets how point lights are accumulated, see LightPassMode
+	/// </summary>
+	void SetLightPassMode(LightPassMode value);
+	LightPassMode GetLightPassMode() const;
+
+	/// <summary>
+	/// Sets whether objects hidden behind occluders are skipped when drawing the main camera's view,
+	/// see RenderComponent::SetOccluder
+	/// </summary>
+	void SetOcclusionCulling(bool value);
+	bool IsOcclusionCullingEnabled() const;
+	/// <summary>
+	/// Gets the software depth buffer that occluders were drawn into for the last frame
+	/// </summary>
+	const OcclusionBuffer::Sptr& GetOcclusionBuffer() const;
+
+	/// <summary>
+	/// Sets whether objects hidden behind the depth buffer of an earlier frame are skipped when drawing
+	/// the main camera's view, see HiZBuffer
+	/// </summary>
+	void SetHiZCulling(bool value);
+	bool IsHiZCullingEnabled() const;
+	const HiZBuffer::Sptr& GetHiZBuffer() const;
+
+	/// <summary>
+	/// Sets whether materials are allowed to use the depth pre-pass when drawing the main camera's view,
+	/// where they are drawn into the depth buffer first so that the G-Buffer pass only shades visible
+	/// pixels. See Material::DepthPrePass for selecting which materials use it. Only materials whose shader
+	/// alpha tests with u_Material.AlbedoMap and u_Material.DiscardThreshold can use it, any others are
+	/// drawn as if their mode was DepthPrePassMode::Never
+	/// </summary>
+	void SetDepthPrePass(bool value);
+	bool IsDepthPrePassEnabled() const;
+
+	/// <summary>
+	/// Sets whether the scene is rendered into a smaller part of the G-Buffer when the GPU goes over it's
+	/// time budget. The render targets stay at the window size, and the composite pass scales the scene
+	/// back up to fill the output, so post processing still runs at the window's resolution
+	/// </summary>
+	void SetDynamicResolution(bool value);
+	bool IsDynamicResolutionEnabled() const;
+	/// <summary>
+	/// Sets the time in milliseconds that the GPU should take to render the scene, see SetDynamicResolution
+	/// </summary>
+	void SetGpuBudget(float milliseconds);
+	float GetGpuBudget() const;
+	const ResolutionController::Sptr& GetResolutionController() const;
+	/// <summary>
+	/// Sets the fraction of the window's width and height that the scene is rendered at while dynamic resolution
+	/// is disabled, this is used by the post processing layer to render at a lower resolution when an effect
+	/// can scale the image back up
+	/// </summary>
+	void SetFixedRenderScale(float value);
+	float GetFixedRenderScale() const;
+	/// <summary>
+	/// Gets the fraction of the window's width and height that the scene is being rendered at
+	/// </summary>
+	float GetRenderScale() const;
+	/// <summary>
+	/// Gets the size in pixels of the region in the bottom left of the G-Buffer that the scene is rendered into
+	/// </summary>
+	const glm::ivec2& GetRenderSize() const;
+	/// <summary>
+	/// Gets the most recent GPU time for rendering the scene in milliseconds, this lags a few frames behind
+	/// </summary>
+	float GetGpuTime() const;
+
+	/// <summary>
+	/// Sets whether the main camera's projection is offset by a different sub-pixel amount each frame, so that
+	/// temporal effects can gather more than one sample per pixel over several frames. The post processing
+	/// layer turns this on while an effect that needs it is enabled
+	/// </summary>
+	void SetTemporalJitter(bool value);
+	bool IsTemporalJitterEnabled() const;
+
 	const Framebuffer::Sptr& GetLightingBuffer() const;
 	const Framebuffer::Sptr& GetRenderOutput() const;
 	const Framebuffer::Sptr& GetGBuffer() const;
 
 	const UniformBuffer<FrameLevelUniforms>::Sptr& GetFrameUniforms() const;
 
+	/// <summary>
+	/// Gets the draw and bind counts for the last frame that was rendered
+	/// </summary>
+	const RenderStats& GetRenderStats() const;
+
 	// Inherited from ApplicationLayer
 
 	virtual void OnAppLoad(const nlohmann::json& config) override;
@@ -139,20 +360,196 @@ protected:
 	bool              _blitFbo;
 	glm::vec4         _clearColor;
 	RenderFlags       _renderFlags;
+	float             _lodPixelError;
 
 	const int FRAME_UBO_BINDING = 0;
 	UniformBuffer<FrameLevelUniforms>::Sptr _frameUniforms;
 
-	const int INSTANCE_UBO_BINDING = 1;
-	UniformBuffer<InstanceLevelUniforms>::Sptr _instanceUniforms;
+	// Stores InstanceData for all our draws, this is a streaming buffer so every upload goes to a new
+	// spot in it's region for this frame, and we never overwrite data that the GPU may still be using
+	VertexBuffer::Sptr _instanceBuffer;
+	std::vector<InstanceData> _instanceData;
 
 	const int LIGHTING_UBO_BINDING = 2;
 	UniformBuffer<LightingUboStruct>::Sptr _lightingUbo;
 
+	// Point lights are binned into clusters on the CPU, and the light accumulation shader reads the
+	// lights for each pixel's cluster from these storage buffers
+	LightClusters::Sptr            _lightClusters;
+	std::vector<ClusterLight>      _clusterLights;
+	// The view space bounding spheres of _clusterLights
+	std::vector<glm::vec4>         _clusterLightSpheres;
+	const int CLUSTER_LIGHTS_SSBO_BINDING  = 0;
+	const int CLUSTER_GRID_SSBO_BINDING    = 1;
+	const int CLUSTER_INDICES_SSBO_BINDING = 2;
+	ShaderStorageBuffer::Sptr      _clusterLightBuffer;
+	ShaderStorageBuffer::Sptr      _clusterGridBuffer;
+	ShaderStorageBuffer::Sptr      _clusterIndexBuffer;
+
+	LightPassMode                  _lightPassMode;
+	// A unit icosphere that is scaled to each light's range, _lightVolumeScale makes it cover the unit sphere
+	VertexArrayObject::Sptr        _lightVolume;
+	float                          _lightVolumeScale;
+	ShaderProgram::Sptr            _lightVolumeShader;
+	ShaderProgram::Sptr            _lightStencilShader;
+	// Copies the G-Buffer depth into the lighting buffer for light volumes to test against
+	ShaderProgram::Sptr            _depthCopyShader;
+
+	// All the shadow maps are packed into this atlas each frame
+	const uint32_t SHADOW_ATLAS_SIZE = 4096;
+	ShadowAtlas::Sptr              _shadowAtlas;
+	// A single shadow map in the atlas, directional lights will have one of these per cascade
+	struct ShadowView {
+		ShadowCamera* Light;
+		int           Cascade;
+		glm::mat4     View;
+		glm::mat4     Projection;
+		// See ShadowUboStruct::ShadowLight::CascadeRange
+		glm::vec4     CascadeRange;
+	};
+	// The shadow maps that were given space in the atlas this frame, largest first
+	std::vector<ShadowView>        _shadowViews;
+	const int SHADOW_UBO_BINDING = 3;
+	UniformBuffer<ShadowUboStruct>::Sptr _shadowUbo;
+
+	// Sorts the draws in _RenderScene, stores indices into _drawList
+	RenderQueue                    _renderQueue;
+	std::vector<RenderComponent*>  _drawList;
+	// The world space bounding spheres of the objects in _drawList, and the indices of the ones
+	// that passed frustum culling
+	std::vector<glm::vec4>         _cullSpheres;
+	std::vector<uint32_t>          _visibleDraws;
+	// The bounds, flags and transforms of the objects in _drawList, copied out of the components so that
+	// the prepare threads never touch them, see ScenePrepare
+	std::vector<ScenePrepare::Draw> _prepareDraws;
+	// Scene preparation runs several times a frame (once per shadow view and once for the main view), and the
+	// occlusion buffer is rasterized on the same threads. This is the engine's shared pool, so mesh loading
+	// and rendering don't each start a thread per core
+	WorkerPool::Sptr               _workerPool;
+	// One buffer per core for the threads preparing the scene, these are kept between frames
+	std::vector<ScenePrepare::Buffer> _prepareBuffers;
+	// Occluders are drawn into this on the CPU, and the objects behind them are skipped
+	bool                           _occlusionCulling;
+	OcclusionBuffer::Sptr          _occlusionBuffer;
+	// The G-Buffer's depth is reduced into a Hi-Z pyramid at the end of each frame, and read back for
+	// culling the frames after it
+	bool                           _hiZCulling;
+	HiZBuffer::Sptr                _hiZBuffer;
+	// The GPU time from the start of OnPreRender to the end of OnPostRender is measured, and the controller
+	// picks the resolution that the scene is rendered at from it when dynamic resolution is enabled
+	bool                           _dynamicResolution;
+	GpuTimer::Sptr                 _gpuTimer;
+	ResolutionController::Sptr     _resolutionController;
+	glm::ivec2                     _renderSize;
+	float                          _fixedRenderScale;
+	// The camera's jitter walks through a Halton sequence, and the previous frame's unjittered view projection
+	// is kept around so that the G-Buffer can store how far each pixel has moved
+	static const int JITTER_SEQUENCE_LENGTH = 8;
+	bool                           _temporalJitter;
+	int                            _jitterIndex;
+	glm::mat4                      _prevViewProjection;
+	glm::vec2                      _prevJitter;
+	bool                           _hasPrevFrame;
+	// Materials that use the depth pre-pass are given this pass in their sort keys, so that they are drawn
+	// after everything else, and can be tested against the depth of everything else in the pre-pass
+	static const uint32_t PREPASS_RENDER_PASS = 1;
+	// Auto materials switch to the pre-pass when they are shading more than this many fragments for every
+	// visible pixel, and back when they drop under PREPASS_DISABLE_OVERDRAW
+	static constexpr float PREPASS_ENABLE_OVERDRAW  = 1.5f;
+	static constexpr float PREPASS_DISABLE_OVERDRAW = 1.25f;
+	// The number of frames an Auto material waits before it is measured again after it was turned off
+	static const int PREPASS_RETEST_FRAMES = 120;
+	bool                           _depthPrePass;
+	// The variants of each material shader that are drawn in the pre-pass, these keep the shader's vertex
+	// stage so that positions match, but only run the alpha test in the fragment shader. Keyed by the
+	// shader's GUID, and dropped once the shader they were built from is gone
+	struct PrePassShader {
+		ShaderProgram::Wptr Source;
+		ShaderProgram::Sptr Variant;
+	};
+	std::unordered_map<Guid, PrePassShader> _prePassShaders;
+	// Tracks the overdraw of materials using DepthPrePassMode::Auto. The samples drawn in the pre-pass and
+	// in the G-Buffer pass are counted with queries, the pre-pass count is what the material would have
+	// shaded without the pre-pass, and the G-Buffer count is what it shades with it
+	struct PrePassState {
+		// The material being measured, the state is dropped once this expires
+		std::weak_ptr<Gameplay::Material> Source;
+		bool     Enabled;
+		// True if the material's samples are being counted this frame
+		bool     Measuring;
+		// True if the queries have been issued, but the results have not been read yet
+		bool     Pending;
+		int      FramesUntilRetest;
+		float    Overdraw;
+		GLuint   Queries[2];
+	};
+	std::unordered_map<Guid, PrePassState> _prePassStates;
+	// Runs of sorted draws that share a mesh, level of detail and material, which are merged into 
+	// a single instanced draw call
+	struct DrawBatch {
+		uint32_t FirstEntry;
+		uint32_t Count;
+	};
+	std::vector<DrawBatch>         _drawBatches;
+	// Maps shaders, materials, arenas and meshes to the small IDs that we pack into sort keys,
+	// these are rebuilt each time we render the scene
+	std::unordered_map<const void*, uint32_t> _shaderSortIds;
+	std::unordered_map<const void*, uint32_t> _materialSortIds;
+	std::unordered_map<const void*, uint32_t> _arenaSortIds;
+	std::unordered_map<const void*, uint32_t> _meshSortIds;
+
+	// The stats for the frame being rendered, and the last complete frame
+	RenderStats       _currentStats;
+	RenderStats       _frameStats;
+
+	// Selects which objects _RenderScene will draw, so that static and dynamic shadow casters can be drawn separately
+	enum class DrawFilter {
+		All,
+		StaticOnly,
+		DynamicOnly
+	};
+
 	void _InitFrameUniforms();
-	void _RenderScene(const glm::mat4& view, const glm::mat4&Projection, const glm::ivec2& screenSize);
+	// Picks the size of the region that the scene is rendered into this frame, see SetDynamicResolution
+	void _UpdateRenderSize();
+	// Uploads _instanceData to the instance buffer, arenas point their instance attributes at the new
+	// data when they are next bound, so the first instance is always 0
+	void _UploadInstances();
+	// The main view is the only one that uses occlusion culling and the depth pre-pass
+	void _RenderScene(const glm::mat4& view, const glm::mat4&Projection, const glm::ivec2& screenSize, bool selectLods = false, DrawFilter filter = DrawFilter::All, bool mainView = false);
+	// Culls the scene, picks levels of detail and builds the sorted batches and instance data for _SubmitScene.
+	// The per-object work is split across threads, and apart from creating the pre-pass resources for a
+	// material the first time it is seen, this makes no OpenGL calls
+	void _PrepareScene(const glm::mat4& view, const glm::mat4& projection, const glm::ivec2& screenSize, bool selectLods, DrawFilter filter, bool mainView);
+	// Uploads the instance data and draws the batches built by _PrepareScene
+	void _SubmitScene();
+	// Draws a batch from _drawBatches, switching arenas if needed
+	void _DrawBatch(const DrawBatch& batch, MeshArena*& currentArena);
+	// Draws the batches from firstBatch onwards into the depth buffer only, with their pre-pass shaders
+	void _RenderDepthPrePass(size_t firstBatch);
+	// Returns true if a material should be drawn in the depth pre-pass this frame
+	bool _UsesDepthPrePass(const std::shared_ptr<Gameplay::Material>& material);
+	// Gets or builds the pre-pass variant of a material shader, returns nullptr if it could not be built, or
+	// if the shader does not alpha test with u_Material.AlbedoMap and u_Material.DiscardThreshold
+	const ShaderProgram::Sptr& _GetPrePassShader(const ShaderProgram::Sptr& shader);
+	// Reads the overdraw queries that have finished, and decides which Auto materials use the pre-pass.
+	// Also drops the states and shader variants of any materials and shaders that have been unloaded
+	void _CollectPrePassResults();
+	// Ends the running overdraw query, and starts one for the material if it is being measured
+	void _SwitchPrePassQuery(PrePassState*& measuring, const Gameplay::Material* material, int pass);
+	// Picks a resolution for each shadow casting light based on how much of the screen it covers, and
+	// packs them into the shadow atlas, filling _shadowViews. Directional lights are split into cascades
+	// that are fit to the camera's frustum
+	void _AllocateShadowAtlas(const glm::mat4& cameraView, const glm::mat4& cameraProjection, float nearPlane, float farPlane);
+	// Renders a shadow map's region of the shadow atlas, re-using the cached static casters where possible
+	void _RenderShadowMap(const ShadowView& shadowView);
+	// Builds a hash of a shadow map and the static casters that it can see, which changes whenever the
+	// cached static depth buffer needs to be re-rendered
+	uint64_t _GetStaticShadowKey(const ShadowView& shadowView);
 
 	void _AccumulateLighting();
+	// Draws each of _clusterLights as a stencil tested volume, used with LightPassMode::StencilVolumes
+	void _RenderLightVolumes(const glm::mat4& projection);
 	void _Composite();
 	void _ClearFramebuffer(Framebuffer::Sptr& buffer, const glm::vec4* colors, int layers);
 };
\ No newline at end of file
@@ -2,6 +2,8 @@
 #include "Application/Application.h"
 #include "Application/ApplicationLayer.h"
 #include "Application/Layers/RenderLayer.h"
+#include "Graphics/GlState.h"
+#include "Utils/ImGuiHelper.h"
 
 DebugWindow::DebugWindow() :
 	IEditorWindow()
@@ -37,4 +39,52 @@ void DebugWindow::RenderMenuBar()
 	if (changed) {
 		renderLayer->SetRenderFlags(flags);
 	}
+
+	LightPassMode lightPass = renderLayer->GetLightPassMode();
+	if (ImGuiHelper::DrawEnumCombo("Light Pass", &lightPass, GET_ENUM_MAP(LightPassMode))) {
+		renderLayer->SetLightPassMode(lightPass);
+	}
+
+	bool occlusionCulling = renderLayer->IsOcclusionCullingEnabled();
+	if (ImGui::Checkbox("Occlusion Culling", &occlusionCulling)) {
+		renderLayer->SetOcclusionCulling(occlusionCulling);
+	}
+	bool hiZCulling = renderLayer->IsHiZCullingEnabled();
+	if (ImGui::Checkbox("Hi-Z Culling", &hiZCulling)) {
+		renderLayer->SetHiZCulling(hiZCulling);
+	}
+	bool depthPrePass = renderLayer->IsDepthPrePassEnabled();
+	if (ImGui::Checkbox("Depth Pre-Pass", &depthPrePass)) {
+		renderLayer->SetDepthPrePass(depthPrePass);
+	}
+	bool dynamicResolution = renderLayer->IsDynamicResolutionEnabled();
+	if (ImGui::Checkbox("Dynamic Resolution", &dynamicResolution)) {
+		renderLayer->SetDynamicResolution(dynamicResolution);
+	}
+	float gpuBudget = renderLayer->GetGpuBudget();
+	if (ImGui::DragFloat("GPU Budget (ms)", &gpuBudget, 0.1f, 1.0f, 100.0f)) {
+		renderLayer->SetGpuBudget(gpuBudget);
+	}
+	bool validateState = GlState::IsValidationEnabled();
+	if (ImGui::Checkbox("Validate GL State", &validateState)) {
+		GlState::SetValidationEnabled(validateState);
+	}
+
+	ImGui::Separator();
+
+	// Show how many binds sorting the draws is saving us, unsorted counts are in brackets
+	const RenderLayer::RenderStats& stats = renderLayer->GetRenderStats();
+	ImGui::Text("Draws: %u (%u objects, %u culled)  Shaders: %u (%u)  Materials: %u (%u)  VAOs: %u (%u)",
+		stats.DrawCalls, stats.Instances, stats.Culled,
+		stats.ShaderBinds, stats.UnsortedShaderBinds,
+		stats.MaterialBinds, stats.UnsortedMaterialBinds,
+		stats.VaoBinds, stats.UnsortedVaoBinds);
+	ImGui::Text("Shadow lights: %u (%u passes)  Static shadow redraws: %u", stats.ShadowLights, stats.ShadowPasses, stats.StaticShadowUpdates);
+	ImGui::Text("Lights: %u  Clustered light refs: %u  Light volumes: %u", stats.Lights, stats.ClusterLightRefs, stats.LightVolumes);
+	ImGui::Text("Occlusion culled: %u  Occluder triangles: %u", stats.OcclusionCulled, stats.OccluderTriangles);
+	ImGui::Text("Hi-Z culled: %u (%u frames behind)", stats.HiZCulled, renderLayer->GetHiZBuffer()->GetLatency());
+	ImGui::Text("Depth pre-pass draws: %u  Materials: %u", stats.PrePassDraws, stats.PrePassMaterials);
+	const glm::ivec2& renderSize = renderLayer->GetRenderSize();
+	ImGui::Text("GL state changes: %u  Skipped: %u  Mismatches: %u", stats.StateChanges, stats.StateChangesSkipped, stats.StateMismatches);
+	ImGui::Text("GPU time: %.2f ms  Render scale: %.2f (%d x %d)", renderLayer->GetGpuTime(), renderLayer->GetRenderScale(), renderSize.x, renderSize.y);
 }
@@ -2,6 +2,7 @@
 #include "Application/Application.h"
 #include "../Layers/RenderLayer.h"
 #include "Utils/ImGuiHelper.h"
+#include "Graphics/GlState.h"
 
 GBufferPreviews::GBufferPreviews()
 	: IEditorWindow()
@@ -27,7 +28,7 @@ void GBufferPreviews::Render()
 	Texture2D::Sptr& color = framebuffer->GetTextureAttachment(RenderTargetAttachment::Color0);
 	Texture2D::Sptr& normals = framebuffer->GetTextureAttachment(RenderTargetAttachment::Color1);
 	Texture2D::Sptr& emissive = framebuffer->GetTextureAttachment(RenderTargetAttachment::Color2);
-	Texture2D::Sptr& viewspace = framebuffer->GetTextureAttachment(RenderTargetAttachment::Color3);
+	Texture2D::Sptr& motion = framebuffer->GetTextureAttachment(RenderTargetAttachment::Color3);
 
 	Texture2D::Sptr& diffuse = lightBuffer->GetTextureAttachment(RenderTargetAttachment::Color0);
 	Texture2D::Sptr& specular = lightBuffer->GetTextureAttachment(RenderTargetAttachment::Color1);
@@ -49,13 +50,13 @@ void GBufferPreviews::Render()
 	_RenderTexture2D(color, size, "color");
 	ImGui::NextColumn();
 
-	_RenderTexture2D(normals, size, "normals");
+	_RenderTexture2D(normals, size, "normals (octahedral)");
 	ImGui::NextColumn();
 
 	_RenderTexture2D(emissive, size, "emissive"); 
 	ImGui::NextColumn();  
 
-	_RenderTexture2D(viewspace, size, "position (viewspace)");
+	_RenderTexture2D(motion, size, "motion vectors");
 	ImGui::NextColumn();
 
 	_RenderTexture2D(diffuse, size, "Diffuse Lighting");
@@ -73,11 +74,11 @@ void GBufferPreviews::_RenderTexture2D(const Texture2D::Sptr & value, const ImVe
 	ImDrawList* drawList = ImGui::GetWindowDrawList();
 
 	drawList->AddCallback([](const ImDrawList* parent_list, const ImDrawCmd* cmd) {
-		glDisable(GL_BLEND);
+		GlState::Disable(GL_BLEND);
 	}, nullptr);
 	ImGui::Image((ImTextureID)value->GetHandle(), size, ImVec2(0, 1), ImVec2(1, 0));
 	drawList->AddCallback([](const ImDrawList* parent_list, const ImDrawCmd* cmd) {
-		glEnable(GL_BLEND);
+		GlState::Enable(GL_BLEND);
 	}, nullptr);
 
 	ImGui::Text(name);
@@ -22,6 +22,15 @@ void PostProcessingSettingsWindow::Render()
 
 	PostProcessingLayer::Sptr layer = app.GetLayer<PostProcessingLayer>();
 
+	// Effects' outputs and scratch targets share memory wherever their lifetimes don't overlap
+	const RenderGraph::Sptr& graph = layer->GetRenderGraph();
+	int transientCount = 0;
+	for (RenderGraph::ResourceId resource = 0; resource < graph->GetResourceCount(); resource++) {
+		transientCount += graph->IsImported(resource) ? 0 : 1;
+	}
+	ImGui::Text("Render targets: %d (for %d textures)", layer->GetTargetPool()->GetTargetCount(), transientCount);
+	ImGui::Separator();
+
 	std::set<PostProcessingLayer::Effect::Sptr> unique (layer->GetEffects().begin(), layer->GetEffects().end());
 
 	for (const auto& effect : unique) {
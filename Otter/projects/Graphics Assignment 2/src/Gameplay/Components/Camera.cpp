@@ -64,6 +64,8 @@ namespace Gameplay {
 		_isOrtho(false),
 		_view(glm::mat4(1.0f)),
 		_projection(glm::mat4(1.0f)),
+		_unjitteredProjection(glm::mat4(1.0f)),
+		_jitter(glm::vec2(0.0f)),
 		_viewProjection(glm::mat4(1.0f)),
 		_isDirty(true)
 	{
@@ -110,6 +112,18 @@ namespace Gameplay {
 		return _viewProjection;
 	}
 
+	void Camera::SetJitter(const glm::vec2& ndcOffset) {
+		if (ndcOffset != _jitter) {
+			_jitter = ndcOffset;
+			_isProjectionDirty = true;
+		}
+	}
+
+	const glm::mat4& Camera::GetUnjitteredProjection() const {
+		__CalculateProjection();
+		return _unjitteredProjection;
+	}
+
 	const glm::vec4& Camera::GetClearColor() const
 	{
 		return _clearColor;
@@ -147,10 +161,12 @@ namespace Gameplay {
 			if (_isOrtho) {
 				float w = (_orthoVerticalScale * _aspectRatio) / 2.0f;
 				float h = (_orthoVerticalScale / 2.0f);
-				_projection = glm::ortho(-w, w, -h, h, _nearPlane, _farPlane);
+				_unjitteredProjection = glm::ortho(-w, w, -h, h, _nearPlane, _farPlane);
 			} else {
-				_projection = glm::perspective(_fovRadians, _aspectRatio, _nearPlane, _farPlane);
+				_unjitteredProjection = glm::perspective(_fovRadians, _aspectRatio, _nearPlane, _farPlane);
 			}
+			// Translating after the projection moves the image in NDC, the same amount for every depth
+			_projection = glm::translate(glm::mat4(1.0f), glm::vec3(_jitter, 0.0f)) * _unjitteredProjection;
 			_isProjectionDirty = false;
 		}
 		return _projection;
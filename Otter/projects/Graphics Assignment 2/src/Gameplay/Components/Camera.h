@@ -85,6 +85,18 @@ namespace Gameplay {
 		/// </summary>
 		const glm::mat4& GetViewProjection() const;
 
+		/// <summary>
+		/// Sets an offset that is applied to the projection after everything else, used to move the image by
+		/// a fraction of a pixel each frame for temporal anti-aliasing
+		/// </summary>
+		/// <param name="ndcOffset">The offset in normalized device coordinates, so a pixel is 2 / the render size</param>
+		void SetJitter(const glm::vec2& ndcOffset);
+		const glm::vec2& GetJitter() const { return _jitter; }
+		/// <summary>
+		/// Gets the projection matrix for this camera without the jitter applied
+		/// </summary>
+		const glm::mat4& GetUnjitteredProjection() const;
+
 		const glm::vec4& GetClearColor() const;
 		void SetClearColor(const glm::vec4& color);
 
@@ -105,6 +117,9 @@ namespace Gameplay {
 
 		glm::mat4 _view;
 		mutable glm::mat4 _projection;
+		// The projection before _jitter is applied to it
+		mutable glm::mat4 _unjitteredProjection;
+		glm::vec2         _jitter;
 
 		// The view projection, it is mutable so we can re-calculate it during const methods
 		mutable glm::mat4 _viewProjection;
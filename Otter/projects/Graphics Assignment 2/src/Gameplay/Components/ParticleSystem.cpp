@@ -3,6 +3,7 @@
 #include "Application/Timing.h"
 #include "Application/Application.h"
 #include "Utils/ImGuiHelper.h"
+#include "Graphics/GlState.h"
 
 ParticleSystem::ParticleSystem() :
 	IComponent(),
@@ -57,12 +58,13 @@ void ParticleSystem::Update()
 		glCreateVertexArrays(2, _renderVaos);
 
 		for (int ix = 0; ix < 2; ix++) {
-			glBindVertexArray(_updateVaos[ix]);
+			GlState::BindVertexArray(_updateVaos[ix]);
 
 			// Set up our first transform feedback buffer to write to the first buffer
 			glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, _feedbackBuffers[ix]);
+			// The particles are only ever written by the GPU after this, so the storage never needs to change
+			glNamedBufferStorage(_particleBuffers[ix], dataSize, data, 0);
 			glBindBuffer(GL_ARRAY_BUFFER, _particleBuffers[ix]);
-			glBufferData(GL_ARRAY_BUFFER, dataSize, data, GL_DYNAMIC_DRAW);
 			glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, _particleBuffers[ix]);
 
 			// Enable our attributes
@@ -81,7 +83,7 @@ void ParticleSystem::Update()
 			glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(ParticleData), (const GLvoid*)offsetof(ParticleData, Metadata)); // metadata 
 
 
-			glBindVertexArray(_renderVaos[ix]);
+			GlState::BindVertexArray(_renderVaos[ix]);
 			glBindBuffer(GL_ARRAY_BUFFER, _particleBuffers[ix]);
 
 			// Enable type, position and color 
@@ -95,7 +97,7 @@ void ParticleSystem::Update()
 			glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(ParticleData), (const GLvoid*)offsetof(ParticleData, Metadata)); // metadata 
 		}
 
-		glBindVertexArray(0);
+		GlState::BindVertexArray(0);
 
 
 		// We create a query object to track the number of particles we're simulating
@@ -106,7 +108,7 @@ void ParticleSystem::Update()
 	}
 
 	// Disable rasterization, this is update only
-	glEnable(GL_RASTERIZER_DISCARD);
+	GlState::Enable(GL_RASTERIZER_DISCARD);
 
 
 	// Bind the update shader and send our relevant uniforms
@@ -114,7 +116,7 @@ void ParticleSystem::Update()
 	_updateShader->SetUniform("u_Gravity", _gravity); 
 	_updateShader->SetUniformMatrix("u_ModelMatrix", GetGameObject()->GetTransform()); 
 
-	glBindVertexArray(_updateVaos[_currentVertexBuffer]);
+	GlState::BindVertexArray(_updateVaos[_currentVertexBuffer]);
 
 	// Bind the buffer and transform feedback
 	glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, _feedbackBuffers[_currentFeedbackBuffer]);
@@ -147,10 +149,10 @@ void ParticleSystem::Update()
 	// Clean up our state
 	glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, 0);
 
-	glBindVertexArray(0);
+	GlState::BindVertexArray(0);
 
 	// Re-enable rasterization for later OpenGL calls
-	glDisable(GL_RASTERIZER_DISCARD);
+	GlState::Disable(GL_RASTERIZER_DISCARD);
 
 	_hasInit = true;
 
@@ -168,11 +170,11 @@ void ParticleSystem::Render()
 		_renderShader->Bind();
 
 		// Make sure no VAOs are bound
-		glBindVertexArray(_renderVaos[_currentVertexBuffer]);
+		GlState::BindVertexArray(_renderVaos[_currentVertexBuffer]);
 
 		//glDisable(GL_DEPTH_TEST);
 		
-		glDisable(GL_BLEND);
+		GlState::Disable(GL_BLEND);
 		//glEnablei(GL_BLEND, 0);
 		//glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
@@ -182,9 +184,9 @@ void ParticleSystem::Render()
 		// Draw our particles using whatever data we have in transform feedback buffer
 		glDrawTransformFeedback(GL_POINTS, _feedbackBuffers[_currentVertexBuffer]);
 
-		glBindVertexArray(0);
+		GlState::BindVertexArray(0);
 
-		glEnable(GL_DEPTH_TEST);
+		GlState::Enable(GL_DEPTH_TEST);
 	}
 }
 
@@ -1,23 +1,46 @@
 #include "Gameplay/Components/RenderComponent.h"
+#include "Gameplay/GameObject.h"
 
 #include "Utils/ResourceManager/ResourceManager.h"
 #include "Utils/ImGuiHelper.h"
+#include "Utils/JsonGlmHelpers.h"
 
 
 RenderComponent::RenderComponent(const Gameplay::MeshResource::Sptr& mesh, const Gameplay::Material::Sptr& material) :
 	_mesh(mesh), 
 	_material(material), 
-	_meshBuilderParams(std::vector<MeshBuilderParam>()) 
+	_meshBuilderParams(std::vector<MeshBuilderParam>()),
+	_lodIndex(0),
+	_worldBox({ glm::vec3(0.0f), glm::vec3(0.0f) }),
+	_worldSphere({ glm::vec3(0.0f), 0.0f }),
+	_boundsMesh(nullptr),
+	_boundsVersion(0),
+	_staticFrames(0),
+	_isOccluder(false),
+	_frameTransform(glm::mat4(1.0f)),
+	_previousTransform(glm::mat4(1.0f)),
+	_hasFrameTransform(false)
 { }
 
 RenderComponent::RenderComponent() : 
 	_mesh(nullptr), 
 	_material(nullptr), 
-	_meshBuilderParams(std::vector<MeshBuilderParam>())
+	_meshBuilderParams(std::vector<MeshBuilderParam>()),
+	_lodIndex(0),
+	_worldBox({ glm::vec3(0.0f), glm::vec3(0.0f) }),
+	_worldSphere({ glm::vec3(0.0f), 0.0f }),
+	_boundsMesh(nullptr),
+	_boundsVersion(0),
+	_staticFrames(0),
+	_isOccluder(false),
+	_frameTransform(glm::mat4(1.0f)),
+	_previousTransform(glm::mat4(1.0f)),
+	_hasFrameTransform(false)
 { }
 
 RenderComponent* RenderComponent::SetMesh(const Gameplay::MeshResource::Sptr& mesh) {
 	_mesh = mesh;
+	_lodIndex = 0;
 	return this;
 }
 
@@ -25,10 +48,6 @@ const Gameplay::MeshResource::Sptr& RenderComponent::GetMeshResource() const {
 	return _mesh;
 }
 
-VertexArrayObject::Sptr RenderComponent::GetMesh() const {
-	return _mesh ? _mesh->Mesh : nullptr;
-}
-
 RenderComponent* RenderComponent::SetMaterial(const Gameplay::Material::Sptr& mat) {
 	_material = mat;
 	return this;
@@ -38,10 +57,76 @@ const Gameplay::Material::Sptr& RenderComponent::GetMaterial() const {
 	return _material;
 }
 
+int RenderComponent::GetLodIndex() const {
+	return _lodIndex;
+}
+
+void RenderComponent::SetLodIndex(int lod) {
+	_lodIndex = lod;
+}
+
+const BoundingBox& RenderComponent::GetWorldBox() {
+	_UpdateWorldBounds();
+	return _worldBox;
+}
+
+const BoundingSphere& RenderComponent::GetWorldSphere() {
+	_UpdateWorldBounds();
+	return _worldSphere;
+}
+
+bool RenderComponent::IsStatic() const {
+	return _staticFrames >= STATIC_FRAME_THRESHOLD;
+}
+
+void RenderComponent::UpdateStaticState() {
+	if (_UpdateWorldBounds()) {
+		_staticFrames = 0;
+	} else if (_staticFrames < STATIC_FRAME_THRESHOLD) {
+		_staticFrames++;
+	}
+
+	// Objects that have just been added have nothing to move from
+	const glm::mat4& transform = GetGameObject()->GetTransform();
+	_previousTransform = _hasFrameTransform ? _frameTransform : transform;
+	_frameTransform = transform;
+	_hasFrameTransform = true;
+}
+
+const glm::mat4& RenderComponent::GetPreviousTransform() const {
+	return _previousTransform;
+}
+
+bool RenderComponent::IsOccluder() const {
+	return _isOccluder;
+}
+
+RenderComponent* RenderComponent::SetOccluder(bool value) {
+	_isOccluder = value;
+	return this;
+}
+
+bool RenderComponent::_UpdateWorldBounds() {
+	uint32_t version = GetGameObject()->GetTransformVersion();
+	if (_mesh.get() == _boundsMesh && version == _boundsVersion) {
+		return false;
+	}
+	_boundsMesh = _mesh.get();
+	_boundsVersion = version;
+
+	if (_mesh != nullptr) {
+		const glm::mat4& transform = GetGameObject()->GetTransform();
+		_worldBox = _mesh->BoxBounds.Transformed(transform);
+		_worldSphere = _mesh->SphereBounds.Transformed(transform);
+	}
+	return true;
+}
+
 nlohmann::json RenderComponent::ToJson() const {
 	nlohmann::json result;
 	result["mesh"] = _mesh ? _mesh->GetGUID().str() : "null";
 	result["material"] = _material ? _material->GetGUID().str() : "null";
+	result["is_occluder"] = _isOccluder;
 	return result;
 }
 
@@ -49,14 +134,17 @@ RenderComponent::Sptr RenderComponent::FromJson(const nlohmann::json& data) {
 	RenderComponent::Sptr result = std::make_shared<RenderComponent>();
 	result->_mesh = ResourceManager::Get<Gameplay::MeshResource>(Guid(data["mesh"].get<std::string>()));
 	result->_material = ResourceManager::Get<Gameplay::Material>(Guid(data["material"].get<std::string>()));
+	result->_isOccluder = JsonGet(data, "is_occluder", false);
 
 	return result;
 }
 
 void RenderComponent::RenderImGui() {
-	ImGui::Text("Indexed:   %s", GetMesh() != nullptr ? (_mesh->Mesh->GetIndexBuffer() != nullptr ? "true" : "false") : "N/A");
-	ImGui::Text("Triangles: %d", GetMesh() != nullptr ? (_mesh->Mesh->GetElementCount() / 3) : 0);
+	ImGui::Text("Storage:   %s", _mesh != nullptr ? (_mesh->Vertices != nullptr ? "Arena" : "Standalone") : "N/A");
+	ImGui::Text("Triangles: %d", _mesh != nullptr ? _mesh->GetTriangleCount() : 0);
 	ImGui::Text("Source:    %s", (_mesh == nullptr || _mesh->Filename.empty()) ? "Generated" : _mesh->Filename.c_str());
+	ImGui::Text("LOD:       %d / %d (%d triangles)", _lodIndex, _mesh != nullptr ? (int)_mesh->Lods.size() : 0, _mesh != nullptr ? _mesh->GetTriangleCount(_lodIndex) : 0);
+	ImGui::Checkbox("Occluder", &_isOccluder);
 	ImGui::Separator();
 	ImGui::Text("Material:  %s", _material != nullptr ? _material->Name.c_str() : "NULL");
 	ImGuiHelper::ResourceDragTarget<Gameplay::Material>(_material);
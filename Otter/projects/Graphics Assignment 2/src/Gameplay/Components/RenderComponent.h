@@ -13,6 +13,11 @@ class RenderComponent : public Gameplay::IComponent {
 public:
 	typedef std::shared_ptr<RenderComponent> Sptr;
 
+	/// <summary>
+	/// The number of frames an object must stay still for before it is treated as static
+	/// </summary>
+	static const uint32_t STATIC_FRAME_THRESHOLD = 30;
+
 	RenderComponent();
 	RenderComponent(const Gameplay::MeshResource::Sptr& mesh, const Gameplay::Material::Sptr& material);
 
@@ -22,16 +27,12 @@ public:
 	/// </summary>
 	const Gameplay::MeshResource::Sptr& GetMeshResource() const;
 	/// <summary>
-	/// Gets the VAO of the underlying mesh resource
-	/// </summary>
-	VertexArrayObject::Sptr GetMesh() const;
-	/// <summary>
 	/// Gets the material that this renderer is using
 	/// </summary>
 	const Gameplay::Material::Sptr& GetMaterial() const;
 
 	/// <summary>
-	/// Sets this render component's mesh resource, from which the VAO will be retrieved for rendering
+	/// Sets this render component's mesh resource, which will be used for rendering
 	/// </summary>
 	/// <param name="mesh">The mesh resource containing info about the model to be rendered</param>
 	RenderComponent* SetMesh(const Gameplay::MeshResource::Sptr& mesh);
@@ -42,6 +43,55 @@ public:
 	/// <param name="mat">The material for this object</param>
 	RenderComponent* SetMaterial(const Gameplay::Material::Sptr& mat);
 
+	/// <summary>
+	/// Gets the level of detail that this object was last rendered at
+	/// </summary>
+	int GetLodIndex() const;
+	/// <summary>
+	/// Sets the level of detail to render this object at, this is updated by the
+	/// render layer based on the object's size on screen
+	/// </summary>
+	/// <param name="lod">The index of the level of detail in the mesh resource</param>
+	void SetLodIndex(int lod);
+
+	/// <summary>
+	/// Gets the bounding box of this object's mesh in world space. This is cached, and is only
+	/// recalculated when the object's world transform or mesh changes
+	/// </summary>
+	const BoundingBox& GetWorldBox();
+	/// <summary>
+	/// Gets the bounding sphere of this object's mesh in world space. This is cached, and is only
+	/// recalculated when the object's world transform or mesh changes
+	/// </summary>
+	const BoundingSphere& GetWorldSphere();
+
+	/// <summary>
+	/// Returns true if this object has not moved or changed meshes in the last STATIC_FRAME_THRESHOLD
+	/// frames. Static objects can be drawn into cached render targets, such as static shadow maps
+	/// </summary>
+	bool IsStatic() const;
+	/// <summary>
+	/// Updates whether this object is static, and keeps the transform that it was drawn with on the
+	/// last frame. Should be called by the render layer once per frame, before drawing
+	/// </summary>
+	void UpdateStaticState();
+	/// <summary>
+	/// Gets the world transform that this object was drawn with on the previous frame, for motion vectors.
+	/// Objects that were not drawn on the previous frame return their current transform
+	/// </summary>
+	const glm::mat4& GetPreviousTransform() const;
+
+	/// <summary>
+	/// Returns true if this object should be drawn into the occlusion buffer to hide the objects behind it
+	/// </summary>
+	bool IsOccluder() const;
+	/// <summary>
+	/// Sets whether this object should be drawn into the occlusion buffer. Good occluders are large,
+	/// solid objects like walls and terrain, small objects cost more to draw than they will save
+	/// </summary>
+	/// <param name="value">True if the object should be used as an occluder</param>
+	RenderComponent* SetOccluder(bool value);
+
 	// Inherited from IComponent
 
 	virtual void RenderImGui() override;
@@ -57,4 +107,24 @@ protected:
 
 	// If we want to use MeshFactory, we can populate this list
 	std::vector<MeshBuilderParam> _meshBuilderParams;
+
+	// The level of detail we're currently rendering at
+	int                           _lodIndex;
+
+	// The cached world space bounds, along with the mesh and transform version they were calculated from
+	BoundingBox                   _worldBox;
+	BoundingSphere                _worldSphere;
+	const Gameplay::MeshResource* _boundsMesh;
+	uint32_t                      _boundsVersion;
+	// The number of frames since the world bounds last changed, saturates at STATIC_FRAME_THRESHOLD
+	uint32_t                      _staticFrames;
+	// True if this object is drawn into the occlusion buffer
+	bool                          _isOccluder;
+	// The world transform for this frame and the one before it, see UpdateStaticState
+	glm::mat4                     _frameTransform;
+	glm::mat4                     _previousTransform;
+	bool                          _hasFrameTransform;
+
+	// Recalculates the world bounds if needed, returning true if they were recalculated
+	bool _UpdateWorldBounds();
 };
\ No newline at end of file
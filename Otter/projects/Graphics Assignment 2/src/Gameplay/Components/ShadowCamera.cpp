@@ -12,12 +12,26 @@ ShadowCamera::ShadowCamera() :
 	NormalBias(0.0001f),
 	Intensity(1.0f),
 	Range(100.0f),
-	_depthBuffer(nullptr),
+	CacheStaticShadows(true),
+	Priority(1.0f),
+	Type(ShadowCameraType::Perspective),
+	CascadeCount(3),
+	CascadeLambda(0.75f),
+	CascadeBlend(0.1f),
+	ShadowDistance(100.0f),
+	CasterDistance(50.0f),
 	_projectionMask(nullptr),
 	_color(glm::vec4(1.0f)),
 	_bufferResolution(glm::ivec2(512)), 
 	_projectionMatrix(glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 100.0f))
-{ }
+{
+	for (int ix = 0; ix < ShadowCascades::MAX_CASCADES; ix++) {
+		_staticDepthBuffers[ix] = nullptr;
+		_staticCacheKeys[ix] = 0;
+		_isStaticCacheValid[ix] = false;
+		_atlasRects[ix] = glm::ivec4(0);
+	}
+}
 
 ShadowCamera::~ShadowCamera() = default;
 
@@ -32,9 +46,6 @@ const glm::vec4& ShadowCamera::GetColor() const {
 void ShadowCamera::SetBufferResolution(const glm::ivec2& value) {
 	LOG_ASSERT(value.x * value.y > 0, "Buffer size must be > 0");
 	_bufferResolution = value;
-	if (_depthBuffer != nullptr) {
-		_depthBuffer->Resize(value);
-	}
 }
 
 const glm::ivec2& ShadowCamera::GetBufferResolution() const {
@@ -43,6 +54,7 @@ const glm::ivec2& ShadowCamera::GetBufferResolution() const {
 
 void ShadowCamera::SetProjection(const glm::mat4& value) {
 	_projectionMatrix = value;
+	InvalidateStaticCache();
 }
 
 const glm::mat4& ShadowCamera::GetProjection() const {
@@ -69,12 +81,9 @@ void ShadowCamera::OnLoad()
 {
 	LOG_ASSERT(_bufferResolution.x * _bufferResolution.y > 0, "Buffer size must be > 0");
 
-	FramebufferDescriptor desc;
-	desc.Width  = _bufferResolution.x;
-	desc.Height = _bufferResolution.y;
-	desc.RenderTargets[RenderTargetAttachment::Depth] = RenderTargetDescriptor(RenderTargetType::Depth32, true, true);
-
-	_depthBuffer = std::make_shared<Framebuffer>(desc);
+	// Static depth buffers are created when the render layer gives us space in the atlas, since
+	// we won't know how many we need or what size they are until then
+	InvalidateStaticCache();
 }
 
 nlohmann::json ShadowCamera::ToJson() const
@@ -87,6 +96,14 @@ nlohmann::json ShadowCamera::ToJson() const
 		{ "intensity", Intensity },
 		{ "resolution", _bufferResolution },
 		{ "flags", *Flags },
+		{ "cache_static", CacheStaticShadows },
+		{ "priority", Priority },
+		{ "type", ~Type },
+		{ "cascade_count", CascadeCount },
+		{ "cascade_lambda", CascadeLambda },
+		{ "cascade_blend", CascadeBlend },
+		{ "shadow_distance", ShadowDistance },
+		{ "caster_distance", CasterDistance },
 		{ "mask", _projectionMask ? _projectionMask->GetGUID().str() : "null" },
 		{ "projection", _projectionMatrix }
 	};
@@ -101,6 +118,14 @@ ShadowCamera::Sptr ShadowCamera::FromJson(const nlohmann::json& data)
 	result->NormalBias = JsonGet(data, "normal_bias", result->NormalBias);
 	result->Range = JsonGet(data, "range", result->Range);
 	result->Intensity = JsonGet(data, "intensity", result->Intensity);
+	result->CacheStaticShadows = JsonGet(data, "cache_static", result->CacheStaticShadows);
+	result->Priority = JsonGet(data, "priority", result->Priority);
+	result->Type = JsonParseEnum(ShadowCameraType, data, "type", result->Type);
+	result->CascadeCount = JsonGet(data, "cascade_count", result->CascadeCount);
+	result->CascadeLambda = JsonGet(data, "cascade_lambda", result->CascadeLambda);
+	result->CascadeBlend = JsonGet(data, "cascade_blend", result->CascadeBlend);
+	result->ShadowDistance = JsonGet(data, "shadow_distance", result->ShadowDistance);
+	result->CasterDistance = JsonGet(data, "caster_distance", result->CasterDistance);
 	result->_color = JsonGet(data, "color", result->_color);
 	result->_bufferResolution = JsonGet(data, "resolution", result->_bufferResolution);
 	result->_projectionMask = ResourceManager::Get<Texture2D>(Guid(JsonGet<std::string>(data, "mask", "null")));
@@ -108,9 +133,56 @@ ShadowCamera::Sptr ShadowCamera::FromJson(const nlohmann::json& data)
 	return result;
 }
 
-const Framebuffer::Sptr& ShadowCamera::GetDepthBuffer() const
+int ShadowCamera::GetShadowMapCount() const {
+	return Type == ShadowCameraType::Directional ? glm::clamp(CascadeCount, 1, ShadowCascades::MAX_CASCADES) : 1;
+}
+
+const glm::ivec4& ShadowCamera::GetAtlasRect(int cascade) const {
+	LOG_ASSERT(cascade >= 0 && cascade < ShadowCascades::MAX_CASCADES, "Cascade index out of range!");
+	return _atlasRects[cascade];
+}
+
+void ShadowCamera::SetAtlasRect(const glm::ivec4& rect, int cascade) {
+	LOG_ASSERT(cascade >= 0 && cascade < ShadowCascades::MAX_CASCADES, "Cascade index out of range!");
+	Framebuffer::Sptr& buffer = _staticDepthBuffers[cascade];
+
+	// Static casters are cached at the resolution of our atlas region, so they need to be redrawn when it changes
+	if (rect.z > 0 && rect.w > 0) {
+		if (buffer == nullptr) {
+			FramebufferDescriptor desc;
+			desc.Width  = rect.z;
+			desc.Height = rect.w;
+			desc.RenderTargets[RenderTargetAttachment::Depth] = RenderTargetDescriptor(RenderTargetType::Depth32, true, true);
+			buffer = std::make_shared<Framebuffer>(desc);
+			_isStaticCacheValid[cascade] = false;
+		}
+		else if (buffer->GetWidth() != static_cast<uint32_t>(rect.z) || buffer->GetHeight() != static_cast<uint32_t>(rect.w)) {
+			buffer->Resize(rect.z, rect.w);
+			_isStaticCacheValid[cascade] = false;
+		}
+	}
+	_atlasRects[cascade] = rect;
+}
+
+const Framebuffer::Sptr& ShadowCamera::GetStaticDepthBuffer(int cascade) const
 {
-	return _depthBuffer;
+	LOG_ASSERT(cascade >= 0 && cascade < ShadowCascades::MAX_CASCADES, "Cascade index out of range!");
+	return _staticDepthBuffers[cascade];
+}
+
+bool ShadowCamera::IsStaticCacheValid(uint64_t key, int cascade) const {
+	return _isStaticCacheValid[cascade] && _staticCacheKeys[cascade] == key;
+}
+
+void ShadowCamera::SetStaticCacheKey(uint64_t key, int cascade) {
+	_staticCacheKeys[cascade] = key;
+	_isStaticCacheValid[cascade] = true;
+}
+
+void ShadowCamera::InvalidateStaticCache() {
+	for (int ix = 0; ix < ShadowCascades::MAX_CASCADES; ix++) {
+		_isStaticCacheValid[ix] = false;
+	}
 }
 
 void ShadowCamera::RenderImGui()
@@ -121,6 +193,10 @@ void ShadowCamera::RenderImGui()
 	ImGui::Text("Shadow Settings");
 	ImGui::Separator();
 
+	if (ImGuiHelper::DrawEnumCombo("Type", &Type, GET_ENUM_MAP(ShadowCameraType))) {
+		InvalidateStaticCache();
+	}
+
 	if (ImGui::BeginCombo("Flags", (~Flags).c_str())) {
 
 		ImGui::CheckboxFlags("PCF", (uint32_t*)&Flags, *ShadowFlags::PcfEnabled);
@@ -131,9 +207,21 @@ void ShadowCamera::RenderImGui()
 	}
 	ImGui::DragFloat("Bias", &Bias, 0.000001f, 0.0f, 0.1f, "%.9f");
 	ImGui::DragFloat("Normal Bias", &NormalBias, 0.000001f, 0.0f, 0.1f, "%.9f");
-	if (ImGui::DragInt2("Resolution", &_bufferResolution.x, 1.0f, 1, 1024)) {
+	if (ImGui::DragInt2("Max Resolution", &_bufferResolution.x, 1.0f, 1, 4096)) {
 		SetBufferResolution(_bufferResolution);
 	}
+	ImGui::Checkbox("Cache Static Shadows", &CacheStaticShadows);
+	ImGui::DragFloat("Priority", &Priority, 0.01f, 0.0f, 10.0f);
+	if (Type == ShadowCameraType::Directional) {
+		ImGui::SliderInt("Cascades", &CascadeCount, 2, ShadowCascades::MAX_CASCADES);
+		ImGui::SliderFloat("Split Lambda", &CascadeLambda, 0.0f, 1.0f);
+		ImGui::SliderFloat("Cascade Blend", &CascadeBlend, 0.0f, 0.5f);
+		ImGui::DragFloat("Shadow Distance", &ShadowDistance, 0.1f, 1.0f, 1000.0f);
+		ImGui::DragFloat("Caster Distance", &CasterDistance, 0.1f, 0.0f, 1000.0f);
+	}
+	for (int ix = 0; ix < GetShadowMapCount(); ix++) {
+		ImGui::Text("Atlas Region %d: %d x %d", ix, _atlasRects[ix].z, _atlasRects[ix].w);
+	}
 
 	// Projection Mask
 	{
@@ -166,16 +254,19 @@ void ShadowCamera::RenderImGui()
 	// Depth display
 	{
 		bool checked = ImGui::GetStateStorage()->GetBool(ImGui::GetID("show_depth"), false);
-		if (ImGui::Checkbox("Show Depth", &checked)) {
+		if (ImGui::Checkbox("Show Static Depth", &checked)) {
 			ImGui::GetStateStorage()->SetBool(ImGui::GetID("show_depth"), checked);
 		}
-		if (_depthBuffer != nullptr && checked) {
-			Texture2D::Sptr depth = _depthBuffer->GetTextureAttachment(RenderTargetAttachment::Depth);
-
+		if (checked) {
 			int width = ImGui::GetContentRegionAvailWidth();
-
 			ImGui::Columns(1);
-			ImGuiHelper::DrawLinearDepthTexture(depth, glm::ivec2(width, width), 0.1f, 100.0f);
+
+			for (int ix = 0; ix < GetShadowMapCount(); ix++) {
+				if (_staticDepthBuffers[ix] != nullptr) {
+					Texture2D::Sptr depth = _staticDepthBuffers[ix]->GetTextureAttachment(RenderTargetAttachment::Depth);
+					ImGuiHelper::DrawLinearDepthTexture(depth, glm::ivec2(width, width), 0.1f, 100.0f);
+				}
+			}
 		}
 	}
 
@@ -3,6 +3,7 @@
 #include "Graphics/Textures/Texture2D.h"
 #include "Gameplay/Components/IComponent.h"
 #include "Graphics/ShaderProgram.h"
+#include "Graphics/ShadowCascades.h"
 
 ENUM_FLAGS(ShadowFlags, uint32_t,
 	None = 0,
@@ -12,6 +13,13 @@ ENUM_FLAGS(ShadowFlags, uint32_t,
 	WidePcfEnabled     = 1 << 3
 );
 
+ENUM(ShadowCameraType, int,
+	// Uses the camera's projection matrix, for spot lights and projectors
+	Perspective = 0,
+	// A light infinitely far away, such as the sun, using cascades that follow the main camera
+	Directional = 1
+);
+
 /**
  * A camera with a depth buffer that lets us render shadows like a camera
  * Also contains color and projector mask info
@@ -29,6 +37,42 @@ public:
 	float NormalBias;
 	float Intensity;
 	float Range;
+	/// <summary>
+	/// True if static casters should be rendered into a cached depth buffer, which is only re-rendered
+	/// when the light or the static casters it can see change
+	/// </summary>
+	bool  CacheStaticShadows;
+	/// <summary>
+	/// How important this light's shadows are compared to other lights, lights with a higher
+	/// priority get a larger share of the shadow atlas
+	/// </summary>
+	float Priority;
+
+	/// <summary>
+	/// Whether this light uses it's own projection, or is a directional light with cascades
+	/// </summary>
+	ShadowCameraType Type;
+	/// <summary>
+	/// The number of cascades to split a directional light's shadows into, between 2 and MAX_CASCADES
+	/// </summary>
+	int   CascadeCount;
+	/// <summary>
+	/// The blend between uniform (0) and logarithmic (1) cascade splits
+	/// </summary>
+	float CascadeLambda;
+	/// <summary>
+	/// The fraction of each cascade that is blended with the previous cascade, to hide the seams between them
+	/// </summary>
+	float CascadeBlend;
+	/// <summary>
+	/// The distance from the camera that directional shadows are rendered out to
+	/// </summary>
+	float ShadowDistance;
+	/// <summary>
+	/// How far towards the light directional cascades extend past the camera's view, so that casters
+	/// outside of the view still cast shadows into it
+	/// </summary>
+	float CasterDistance;
 
 	ShadowCamera();
 	virtual ~ShadowCamera();
@@ -45,12 +89,13 @@ public:
 	const glm::vec4& GetColor() const;
 
 	/// <summary>
-	/// Resizes this light's depth buffer, both dimensions must be non-zero
+	/// Sets the maximum resolution of this light's shadow map, both dimensions must be non-zero. The
+	/// actual resolution is picked by the render layer based on how much of the screen the light covers
 	/// </summary>
-	/// <param name="value">The new size of the buffer, in pixels</param>
+	/// <param name="value">The new maximum size of the shadow map, in pixels</param>
 	void SetBufferResolution(const glm::ivec2& value);
 	/// <summary>
-	/// Returns the resolution of this light's depth buffer in pixels
+	/// Returns the maximum resolution of this light's shadow map in pixels
 	/// </summary>
 	const glm::ivec2& GetBufferResolution() const;
 
@@ -80,9 +125,49 @@ public:
 	const Texture2D::Sptr& GetProjectionMask() const;
 
 	/// <summary>
-	/// Gets the shadow camera's depth buffer that it renders to
+	/// Gets the number of shadow maps this light renders, this is the number of cascades for
+	/// directional lights, and 1 otherwise
+	/// </summary>
+	int GetShadowMapCount() const;
+
+	/// <summary>
+	/// Gets the region of the shadow atlas that one of this light's shadow maps rendered to this frame, as
+	/// (x, y, width, height) in pixels. The width and height will be zero if it was not given any space in the atlas
+	/// </summary>
+	/// <param name="cascade">The index of the shadow map, see GetShadowMapCount</param>
+	const glm::ivec4& GetAtlasRect(int cascade = 0) const;
+	/// <summary>
+	/// Sets the region of the shadow atlas that one of this light's shadow maps will render to, this is set by
+	/// the render layer. Changing the size of the region will resize and invalidate the cached static casters
+	/// </summary>
+	/// <param name="rect">The region of the atlas, as (x, y, width, height) in pixels</param>
+	/// <param name="cascade">The index of the shadow map, see GetShadowMapCount</param>
+	void SetAtlasRect(const glm::ivec4& rect, int cascade = 0);
+	/// <summary>
+	/// Gets the depth buffer that static casters are cached in, dynamic casters are drawn on top
+	/// of a copy of this buffer each frame. This is the same size as the shadow map's atlas region,
+	/// and will be nullptr until the shadow map has been given a region
+	/// </summary>
+	/// <param name="cascade">The index of the shadow map, see GetShadowMapCount</param>
+	const Framebuffer::Sptr& GetStaticDepthBuffer(int cascade = 0) const;
+
+	/// <summary>
+	/// Returns true if the static depth buffer was rendered with the given state, see RenderLayer
+	/// for how the state key is built
+	/// </summary>
+	/// <param name="key">A hash of the light and the static casters that it can see</param>
+	/// <param name="cascade">The index of the shadow map, see GetShadowMapCount</param>
+	bool IsStaticCacheValid(uint64_t key, int cascade = 0) const;
+	/// <summary>
+	/// Marks the static depth buffer as up to date for the given state
+	/// </summary>
+	/// <param name="key">A hash of the light and the static casters that it can see</param>
+	/// <param name="cascade">The index of the shadow map, see GetShadowMapCount</param>
+	void SetStaticCacheKey(uint64_t key, int cascade = 0);
+	/// <summary>
+	/// Forces all of the static depth buffers to be re-rendered the next time the light is drawn
 	/// </summary>
-	const Framebuffer::Sptr& GetDepthBuffer() const;
+	void InvalidateStaticCache();
 
 	// Inherited from IComponent
 
@@ -93,14 +178,19 @@ public:
 	MAKE_TYPENAME(ShadowCamera);
 
 protected:
-	// Framebuffer we render into to get depth
-	Framebuffer::Sptr _depthBuffer;
+	// Framebuffers containing only the static casters, one per shadow map
+	Framebuffer::Sptr _staticDepthBuffers[ShadowCascades::MAX_CASCADES];
+	// The state that each of _staticDepthBuffers was rendered with
+	uint64_t          _staticCacheKeys[ShadowCascades::MAX_CASCADES];
+	bool              _isStaticCacheValid[ShadowCascades::MAX_CASCADES];
 	// The image to project from this light
 	Texture2D::Sptr   _projectionMask;
 	// The color of the light
 	glm::vec4         _color;
-	// The resolution of _depthBuffer in pixels
+	// The maximum resolution of our shadow map in pixels
 	glm::ivec2        _bufferResolution;
+	// The regions of the shadow atlas that we are rendering to, one per shadow map
+	glm::ivec4        _atlasRects[ShadowCascades::MAX_CASCADES];
 	// The projection matrix of the light
 	glm::mat4         _projectionMatrix;
 };
\ No newline at end of file
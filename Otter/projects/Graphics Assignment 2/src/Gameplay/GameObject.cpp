@@ -29,6 +29,7 @@ namespace Gameplay {
 		_worldTransform(MAT4_IDENTITY),
 		_inverseWorldTransform(MAT4_IDENTITY),
 		_isWorldTransformDirty(true),
+		_transformVersion(0),
 		_parent(WeakRef()),
 		_children(std::vector<WeakRef>())
 	{ }
@@ -52,13 +53,17 @@ namespace Gameplay {
 	}
 
 	void GameObject::_RecalcWorldTransform() const {
+		// Changes further up the hierarchy will dirty our world transform, so make sure our parent is up to date first
+		GameObject::Sptr parent = _parent;
+		if (parent != nullptr) {
+			parent->_RecalcWorldTransform();
+		}
+
 		// Start by determining our local transform if required
 		_RecalcLocalTransform();
 
 		// If our world transform has been marked as dirty, we need to recalculate it!
 		if (_isWorldTransformDirty) {
-			GameObject::Sptr parent = _parent;
-
 			// If out parent exists, we apply our local transformation relative to the parent's world transformation
 			if (parent != nullptr) {
 				_worldTransform = parent->GetTransform() * _localTransform;
@@ -71,6 +76,15 @@ namespace Gameplay {
 				_inverseWorldTransform = _inverseLocalTransform;
 			}
 			_isWorldTransformDirty = false;
+			_transformVersion++;
+
+			// Our children are relative to our world transform, so they need to be updated as well
+			for (const auto& childPtr : _children) {
+				GameObject::Sptr childSptr = childPtr;
+				if (childSptr != nullptr) {
+					childSptr->_isWorldTransformDirty = true;
+				}
+			}
 		}
 	}
 
@@ -161,6 +175,11 @@ namespace Gameplay {
 		return _inverseWorldTransform;
 	}
 
+	uint32_t GameObject::GetTransformVersion() const {
+		_RecalcWorldTransform();
+		return _transformVersion;
+	}
+
 	const glm::mat4& GameObject::GetLocalTransform() const
 	{
 		_RecalcLocalTransform();
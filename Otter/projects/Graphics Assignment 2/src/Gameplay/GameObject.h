@@ -222,6 +222,11 @@ namespace Gameplay {
 		/// This matrix transforms points from world space to local space
 		/// </summary>
 		const glm::mat4& GetInverseTransform() const;
+		/// <summary>
+		/// Gets a counter that changes every time this object's world transform is recalculated,
+		/// allowing other systems to cache data that depends on the world transform
+		/// </summary>
+		uint32_t GetTransformVersion() const;
 
 		const glm::mat4& GetLocalTransform() const;
 		const glm::mat4& GetInverseLocalTransform() const;
@@ -354,6 +359,7 @@ namespace Gameplay {
 		mutable glm::mat4 _worldTransform;
 		mutable glm::mat4 _inverseWorldTransform;
 		mutable bool _isWorldTransformDirty;
+		mutable uint32_t _transformVersion;
 
 		// For the hierarchy
 		WeakRef _parent;
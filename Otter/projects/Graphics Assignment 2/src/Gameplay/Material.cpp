@@ -11,6 +11,7 @@
 namespace Gameplay {
 	Material::Material(const ShaderProgram::Sptr& shader) :
 		IResource(),
+		DepthPrePass(DepthPrePassMode::Never),
 		_shader(shader),
 		_uniforms(std::unordered_map<std::string, UniformData>())
 	{
@@ -19,6 +20,7 @@ namespace Gameplay {
 
 	Material::Material() :
 		IResource(),
+		DepthPrePass(DepthPrePassMode::Never),
 		_shader(nullptr),
 		_uniforms(std::unordered_map<std::string, UniformData>())
 	{ }
@@ -97,6 +99,42 @@ namespace Gameplay {
 		}
 	}
 
+	void Material::ApplyTo(const ShaderProgram::Sptr& shader) {
+		if (shader == _shader) {
+			Apply();
+			return;
+		}
+
+		int textureSlot = 0;
+		for (auto&[name, data] : _uniforms) {
+			if (data.Location < 0) {
+				continue;
+			}
+			// Stages that the variant does not use will have been stripped, so it's fine to not find a uniform
+			ShaderProgram::UniformInfo info;
+			if (!shader->FindUniform(name, &info) || info.Type != data.Type) {
+				continue;
+			}
+
+			if (GetShaderDataTypeCode(data.Type) == ShaderDataTypecode::Texture) {
+				if (textureSlot < MAX_TEXTURE_SLOTS) {
+					ITexture::Sptr texture = data.TextureAsset;
+					if (texture != nullptr) {
+						texture->Bind(textureSlot);
+					}
+					else {
+						ITexture::Unbind(textureSlot);
+					}
+					shader->SetUniform(info.Location, data.Type, &textureSlot);
+					textureSlot++;
+				}
+			}
+			else {
+				shader->SetUniform(info.Location, data.Type, data.ArraySize > 1 ? data.ArrayBlock : data.Value, data.ArraySize);
+			}
+		}
+	}
+
 	void Material::RenderImGui() {
 		ImGui::PushID(this);
 
@@ -106,6 +144,7 @@ namespace Gameplay {
 
 		if (open) {
 			ImGui::Text("Shader: %s", _shader != nullptr ? _shader->GetDebugName().c_str() : "null");
+			ImGuiHelper::DrawEnumCombo("Depth Pre-Pass", &DepthPrePass, GET_ENUM_MAP(DepthPrePassMode));
 			// Draw all of our valid uniforms
 			for (auto&[key, value] : _uniforms) {
 				if (value.Location != -2 && value.Location != -1) {
@@ -132,6 +171,7 @@ namespace Gameplay {
 		result->OverrideGUID(Guid(data["guid"]));
 		result->Name = data["name"].get<std::string>();
 		result->_shader = ResourceManager::Get<ShaderProgram>(Guid(data["shader"]));
+		result->DepthPrePass = JsonParseEnum(DepthPrePassMode, data, "depth_prepass", result->DepthPrePass);
 		result->_PopulateUniforms();
 
 		// material specific parameters'
@@ -153,6 +193,7 @@ namespace Gameplay {
 			{ "guid", GetGUID().str() },
 			{ "name", Name },
 			{ "shader", _shader ? _shader->GetGUID().str() : "null" },
+			{ "depth_prepass", ~DepthPrePass },
 			{ "parameters", nlohmann::json() }
 		};
 
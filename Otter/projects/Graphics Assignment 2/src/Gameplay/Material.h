@@ -3,6 +3,18 @@
 #include "Graphics/ShaderProgram.h"
 #include "Graphics/Textures/ITexture.h"
 
+/// <summary>
+/// Selects whether a material is drawn into the depth buffer before it is shaded, so that the
+/// G-Buffer pass only shades the pixels that end up visible
+/// </summary>
+ENUM(DepthPrePassMode, int,
+	Never  = 0,
+	// Always draws the material in the depth pre-pass
+	Always = 1,
+	// Measures how much the material is overdrawn, and only uses the pre-pass when that is high
+	Auto   = 2
+);
+
 namespace Gameplay {
 	/// <summary>
 	/// Helper structure for material parameters to our shader
@@ -23,6 +35,10 @@ namespace Gameplay {
 		/// A human readable name for the material
 		/// </summary>
 		std::string     Name;
+		/// <summary>
+		/// Whether the material is drawn in the depth pre-pass, see RenderLayer::SetDepthPrePass
+		/// </summary>
+		DepthPrePassMode DepthPrePass;
 
 		/// <summary>
 		/// Default constructor, to be used by Resource manager and smart pointers only
@@ -65,6 +81,12 @@ namespace Gameplay {
 		/// Will bind the shader, update material uniforms, and bind textures
 		/// </summary>
 		virtual void Apply();
+		/// <summary>
+		/// Applies this material's parameters to another shader, matching uniforms by name. Used for
+		/// variants of the material's shader, such as the one used for the depth pre-pass
+		/// </summary>
+		/// <param name="shader">The shader to apply the parameters to, must be bound</param>
+		void ApplyTo(const ShaderProgram::Sptr& shader);
 
 		/// <summary>
 		/// Renders some UI controls for manipulating a material at runtime
@@ -2,24 +2,53 @@
 #include <filesystem>
 
 #include "Utils/ObjLoader.h"
+#include "Utils/OptimizedObjLoader.h"
+#include "Utils/MeshSimplifier.h"
+
+#include <LinearMath/btConvexHull.h>
+#include <BulletCollision/CollisionShapes/btConvexHullShape.h>
 
 namespace Gameplay {
+	// We won't bother generating LODs for meshes with less than this many triangles
+	const size_t MIN_LOD_TRIANGLES = 64;
+	// The maximum error each LOD is allowed to have, relative to the size of the mesh
+	const float LOD_MAX_ERROR[MeshResource::MAX_LODS] = { 0.0f, 0.01f, 0.03f, 0.08f };
+	// The maximum error an occluder is allowed to have, relative to the size of the mesh. This is kept
+	// small since an occluder that bulges out past the mesh can hide things that should be visible
+	const float OCCLUDER_MAX_ERROR = 0.01f;
+
 	MeshResource::MeshResource() :
 		IResource(),
 		Filename(""),
 		MeshBuilderParams(std::vector<MeshBuilderParam>()),
+		Vertices(nullptr),
 		Mesh(nullptr),
-		BulletTriMesh(nullptr)
+		Lods(std::vector<LodLevel>()),
+		MeshData(nullptr),
+		BoxBounds({ glm::vec3(0.0f), glm::vec3(0.0f) }),
+		SphereBounds({ glm::vec3(0.0f), 0.0f }),
+		ConvexHull(nullptr),
+		OccluderVertices(std::vector<glm::vec3>()),
+		OccluderIndices(std::vector<uint32_t>())
 	{ }
 
 	MeshResource::MeshResource(const std::string& filename) :
 		IResource(),
 		Filename(filename),
 		MeshBuilderParams(std::vector<MeshBuilderParam>()),
+		Vertices(nullptr),
 		Mesh(nullptr),
-		BulletTriMesh(nullptr)
+		Lods(std::vector<LodLevel>()),
+		MeshData(nullptr),
+		BoxBounds({ glm::vec3(0.0f), glm::vec3(0.0f) }),
+		SphereBounds({ glm::vec3(0.0f), 0.0f }),
+		ConvexHull(nullptr),
+		OccluderVertices(std::vector<glm::vec3>()),
+		OccluderIndices(std::vector<uint32_t>())
 	{
-		Mesh = ObjLoader::LoadFromFile(filename);
+		MeshData = std::make_shared<MeshBuilder<VertexPosNormTexColTangents>>();
+		ObjLoader::LoadMeshData(filename, *MeshData);
+		_BakeMeshData();
 	}
 
 	MeshResource::~MeshResource() = default;
@@ -44,21 +73,31 @@ namespace Gameplay {
 		MeshResource::Sptr result = std::make_shared<MeshResource>();
 		if (blob.contains("params") && blob["params"].is_array()) {
 			std::vector<nlohmann::json> meshbuilderParams = blob["params"].get<std::vector<nlohmann::json>>();
-			MeshBuilder<VertexPosNormTexColTangents> mesh;
 			for (int ix = 0; ix < meshbuilderParams.size(); ix++) {
-				MeshBuilderParam p = MeshBuilderParam::FromJson(meshbuilderParams[ix]);
-				result->MeshBuilderParams.push_back(p);
-				MeshFactory::AddParameterized(mesh, p);
+				result->MeshBuilderParams.push_back(MeshBuilderParam::FromJson(meshbuilderParams[ix]));
 			}
-			MeshFactory::CalculateTBN(mesh);
-			result->Mesh = mesh.Bake();
+			result->GenerateMesh();
 		} else {
 			result->Filename = JsonGet<std::string>(blob, "filename", "null");
 			if (result->Filename != "null" && std::filesystem::exists(result->Filename)) {
+				result->MeshData = std::make_shared<MeshBuilder<VertexPosNormTexColTangents>>();
 				#ifdef OPTIMIZED_OBJ_LOADER
-				result->Mesh = OptimizedObjLoader::LoadFromFile(result->Filename);
+				// If the binary file has a layout we don't know about, we can still render it, but we
+				// can't do any processing on it
+				if (OptimizedObjLoader::LoadMeshData(result->Filename, *result->MeshData)) {
+					result->_BakeMeshData();
+				} else {
+					result->MeshData = nullptr;
+					result->Mesh = OptimizedObjLoader::LoadFromFile(result->Filename);
+					// Colliders only need the positions, which we can usually still find in the file
+					std::vector<glm::vec3> positions;
+					if (OptimizedObjLoader::LoadPositions(result->Filename, positions)) {
+						result->GenerateConvexHull(positions);
+					}
+				}
 				#else
-				result->Mesh = ObjLoader::LoadFromFile(result->Filename);
+				ObjLoader::LoadMeshData(result->Filename, *result->MeshData);
+				result->_BakeMeshData();
 				#endif
 
 			}
@@ -67,15 +106,223 @@ namespace Gameplay {
 	}
 
 	void MeshResource::GenerateMesh() {
-		MeshBuilder<VertexPosNormTexColTangents> mesh;
+		MeshData = std::make_shared<MeshBuilder<VertexPosNormTexColTangents>>();
 		for (auto& param : MeshBuilderParams) {
-			MeshFactory::AddParameterized(mesh, param);
+			MeshFactory::AddParameterized(*MeshData, param);
 		}
-		MeshFactory::CalculateTBN(mesh);
-		Mesh = mesh.Bake();
+		MeshFactory::CalculateTBN(*MeshData);
+		_BakeMeshData();
 	}
 
 	void MeshResource::AddParam(const MeshBuilderParam & param) {
 		MeshBuilderParams.push_back(param);
 	}
-}
\ No newline at end of file
+
+	void MeshResource::GenerateLods() {
+		Lods.clear();
+		MeshArena::Sptr arena = GetArena();
+		if (arena == nullptr || MeshData == nullptr) {
+			return;
+		}
+		Lods.push_back({ arena->AllocateIndices(MeshData->GetIndexDataPtr(), static_cast<uint32_t>(MeshData->GetIndexCount())), 0.0f });
+
+		// We need enough triangles for simplifying the mesh to be worthwhile
+		if (MeshData->GetIndexCount() < MIN_LOD_TRIANGLES * 3 || SphereBounds.Radius <= 0.0f) {
+			return;
+		}
+
+		// The simplifier reports error relative to the largest extent of the mesh, we want it relative to
+		// the bounding sphere so we can compare it against the projected size of the sphere
+		const VertexPosNormTexColTangents* vertices = MeshData->GetVertexDataPtr();
+		glm::vec3 extents = BoxBounds.Max - BoxBounds.Min;
+		float errorScale = glm::max(extents.x, glm::max(extents.y, extents.z)) / (SphereBounds.Radius * 2.0f);
+
+		std::vector<uint32_t> source(MeshData->GetIndexDataPtr(), MeshData->GetIndexDataPtr() + MeshData->GetIndexCount());
+		std::vector<uint32_t> result;
+		for (int ix = 1; ix < MAX_LODS; ix++) {
+			// Each level aims to halve the triangle count of the previous one
+			size_t targetIndices = (source.size() / 6) * 3;
+			if (targetIndices < MIN_LOD_TRIANGLES * 3) {
+				break;
+			}
+
+			float error = MeshSimplifier::Simplify(
+				vertices, MeshData->GetVertexCount(),
+				source.data(), source.size(),
+				result, targetIndices, LOD_MAX_ERROR[ix]);
+
+			// If we couldn't remove a meaningful number of triangles within the error budget, further
+			// levels won't do any better
+			if (result.size() > (source.size() * 3) / 4) {
+				break;
+			}
+
+			// Each level is simplified from the previous one, so the errors stack up. All levels
+			// share the full detail vertices, so we only need to store the new indices
+			float lodError = error * errorScale + Lods.back().Error;
+			Lods.push_back({ arena->AllocateIndices(result.data(), static_cast<uint32_t>(result.size())), lodError });
+			source.swap(result);
+		}
+
+		LOG_TRACE("Generated {} LODs for mesh \"{}\"", Lods.size(), Filename.empty() ? GetGUID().str() : Filename);
+	}
+
+	void MeshResource::GenerateConvexHull(int maxVertices) {
+		if (MeshData == nullptr) {
+			ConvexHull = nullptr;
+			return;
+		}
+
+		std::vector<glm::vec3> positions;
+		positions.reserve(MeshData->GetVertexCount());
+		const VertexPosNormTexColTangents* vertices = MeshData->GetVertexDataPtr();
+		for (size_t ix = 0; ix < MeshData->GetVertexCount(); ix++) {
+			positions.push_back(vertices[ix].Position);
+		}
+		GenerateConvexHull(positions, maxVertices);
+	}
+
+	void MeshResource::GenerateConvexHull(const std::vector<glm::vec3>& positions, int maxVertices) {
+		// Colliders that are already using the old hull keep their own reference to it
+		ConvexHull = nullptr;
+		if (positions.size() < 4) {
+			return;
+		}
+
+		std::vector<btVector3> points;
+		points.reserve(positions.size());
+		for (const glm::vec3& position : positions) {
+			points.emplace_back(position.x, position.y, position.z);
+		}
+
+		// Bullet's hull library grows the hull by repeatedly adding the furthest point, and
+		// stops once we hit the vertex limit
+		HullDesc desc = HullDesc(QF_TRIANGLES, static_cast<unsigned int>(points.size()), points.data());
+		desc.mMaxVertices = maxVertices;
+
+		HullLibrary library;
+		HullResult hull;
+		if (library.CreateConvexHull(desc, hull) == QE_OK) {
+			// Bullet shapes need their aligned allocator, so we can't use make_shared here
+			ConvexHull = std::shared_ptr<btConvexHullShape>(new btConvexHullShape(&hull.m_OutputVertices[0].x(), static_cast<int>(hull.mNumOutputVertices), sizeof(btVector3)));
+		} else {
+			LOG_WARN("Failed to build convex hull for mesh \"{}\"", Filename.empty() ? GetGUID().str() : Filename);
+		}
+		library.ReleaseResult(hull);
+	}
+
+	void MeshResource::GenerateOccluder(int maxTriangles) {
+		OccluderVertices.clear();
+		OccluderIndices.clear();
+		if (MeshData == nullptr || MeshData->GetIndexCount() < 3) {
+			return;
+		}
+
+		// Only the shape matters for occlusion, so we ignore the vertex attributes while simplifying
+		const VertexPosNormTexColTangents* vertices = MeshData->GetVertexDataPtr();
+		std::vector<uint32_t> indices;
+		if (MeshData->GetIndexCount() > static_cast<size_t>(maxTriangles) * 3) {
+			MeshSimplifier::Simplify(
+				vertices, MeshData->GetVertexCount(),
+				MeshData->GetIndexDataPtr(), MeshData->GetIndexCount(),
+				indices, static_cast<size_t>(maxTriangles) * 3, OCCLUDER_MAX_ERROR, 0.0f);
+		} else {
+			indices.assign(MeshData->GetIndexDataPtr(), MeshData->GetIndexDataPtr() + MeshData->GetIndexCount());
+		}
+
+		// Only keep the positions of the vertices that the simplified triangles still use
+		std::vector<uint32_t> remap(MeshData->GetVertexCount(), UINT32_MAX);
+		OccluderIndices.reserve(indices.size());
+		for (uint32_t index : indices) {
+			if (remap[index] == UINT32_MAX) {
+				remap[index] = static_cast<uint32_t>(OccluderVertices.size());
+				OccluderVertices.push_back(vertices[index].Position);
+			}
+			OccluderIndices.push_back(remap[index]);
+		}
+	}
+
+	bool MeshResource::IsLoaded() const {
+		return (Vertices != nullptr && !Lods.empty() && GetArena() != nullptr) || Mesh != nullptr;
+	}
+
+	MeshArena::Sptr MeshResource::GetArena() const {
+		return Vertices != nullptr ? Vertices->GetArena() : nullptr;
+	}
+
+	const MeshResource::LodLevel& MeshResource::GetLod(int lod) const {
+		return Lods[glm::clamp(lod, 0, static_cast<int>(Lods.size()) - 1)];
+	}
+
+	uint32_t MeshResource::GetTriangleCount(int lod) const {
+		if (!Lods.empty()) {
+			return GetLod(lod).Indices->GetCount() / 3;
+		}
+		return Mesh != nullptr ? Mesh->GetElementCount() / 3 : 0;
+	}
+
+	void MeshResource::Draw(int lod) {
+		MeshArena::Sptr arena = GetArena();
+		if (arena != nullptr && !Lods.empty()) {
+			arena->Bind();
+			arena->Draw(*Vertices, *GetLod(lod).Indices);
+			VertexArrayObject::Unbind();
+		} else if (Mesh != nullptr) {
+			Mesh->Draw();
+		}
+	}
+
+	int MeshResource::SelectLod(float screenSize, int currentLod, float pixelError, float hysteresis) const {
+		if (Lods.size() <= 1) {
+			return 0;
+		}
+		int result = glm::clamp(currentLod, 0, static_cast<int>(Lods.size()) - 1);
+
+		// Move to finer levels while the current level is visibly wrong
+		while (result > 0 && Lods[result].Error * screenSize > pixelError * (1.0f + hysteresis)) {
+			result--;
+		}
+		// Move to coarser levels while the next level would still be acceptable
+		while (result + 1 < static_cast<int>(Lods.size()) && Lods[result + 1].Error * screenSize < pixelError * (1.0f - hysteresis)) {
+			result++;
+		}
+		return result;
+	}
+
+	void MeshResource::_BakeMeshData() {
+		if (MeshData == nullptr || MeshData->GetVertexCount() == 0) {
+			return;
+		}
+
+		// Calculate the bounding box, and a bounding sphere around the center of the box
+		const VertexPosNormTexColTangents* vertices = MeshData->GetVertexDataPtr();
+		BoxBounds.Min = BoxBounds.Max = vertices[0].Position;
+		for (size_t ix = 1; ix < MeshData->GetVertexCount(); ix++) {
+			BoxBounds.Min = glm::min(BoxBounds.Min, vertices[ix].Position);
+			BoxBounds.Max = glm::max(BoxBounds.Max, vertices[ix].Position);
+		}
+		SphereBounds.Center = BoxBounds.GetCenter();
+		float radiusSq = 0.0f;
+		for (size_t ix = 0; ix < MeshData->GetVertexCount(); ix++) {
+			glm::vec3 offset = vertices[ix].Position - SphereBounds.Center;
+			radiusSq = glm::max(radiusSq, glm::dot(offset, offset));
+		}
+		SphereBounds.Radius = glm::sqrt(radiusSq);
+
+		// Meshes in an arena are always drawn with indices, so generate them for un-indexed meshes
+		if (MeshData->GetIndexCount() == 0) {
+			MeshData->ReserveIndexSpace(MeshData->GetVertexCount());
+			for (uint32_t ix = 0; ix < MeshData->GetVertexCount(); ix++) {
+				MeshData->AddIndex(ix);
+			}
+		}
+
+		MeshArena::Sptr arena = MeshArena::Get(VertexPosNormTexColTangents::V_DECL);
+		Vertices = arena->AllocateVertices(MeshData->GetVertexDataPtr(), static_cast<uint32_t>(MeshData->GetVertexCount()));
+		Mesh = nullptr;
+
+		GenerateLods();
+		GenerateConvexHull();
+		GenerateOccluder();
+	}
+}
@@ -1,21 +1,53 @@
 #pragma once
 #include "Utils/ResourceManager/IResource.h"
 #include "Graphics/VertexArrayObject.h"
+#include "Graphics/MeshArena.h"
+#include "Utils/Frustum.h"
 #include "Utils/MeshFactory.h"
+#include "Utils/MeshBuilder.h"
 
-// bullet triangle mesh pre-declaration
-class btTriangleMesh;
+// bullet convex hull pre-declaration
+class btConvexHullShape;
 
 namespace Gameplay {
 	/// <summary>
-	/// A mesh resource contains information on how to generate a VAO at runtime
-	/// It can either load a VAO from a file, or generate one using the mesh 
-	/// factory and MeshBuilderParams
+	/// A mesh resource contains information on how to generate a mesh at runtime
+	/// It can either load a mesh from a file, or generate one using the mesh 
+	/// factory and MeshBuilderParams. The mesh data is stored in the mesh arena
+	/// for it's vertex layout, rather than in it's own VAO
 	/// </summary>
 	class MeshResource : public IResource {
 	public:
 		typedef std::shared_ptr<MeshResource> Sptr;
 
+		/// <summary>
+		/// The maximum number of levels of detail we will generate for a mesh, including the full detail mesh
+		/// </summary>
+		static const int MAX_LODS = 4;
+		/// <summary>
+		/// The maximum number of vertices we will keep in a mesh's convex hull
+		/// </summary>
+		static const int MAX_HULL_VERTICES = 64;
+		/// <summary>
+		/// The number of triangles we try to reduce a mesh's occluder to
+		/// </summary>
+		static const int MAX_OCCLUDER_TRIANGLES = 256;
+
+		/// <summary>
+		/// Represents a single level of detail for a mesh. All levels share the vertices of
+		/// the full detail mesh, and only differ in their indices
+		/// </summary>
+		struct LodLevel {
+			/// <summary>
+			/// The range of indices within the mesh arena to render for this level of detail
+			/// </summary>
+			MeshArena::Block::Sptr  Indices;
+			/// <summary>
+			/// The geometric error of this level, relative to the diameter of the mesh's bounding sphere
+			/// </summary>
+			float                   Error;
+		};
+
 		// Default constructor
 		MeshResource();
 		/// <summary>
@@ -37,9 +69,33 @@ namespace Gameplay {
 		std::vector<MeshBuilderParam>   MeshBuilderParams;
 
 		/// <summary>
-		/// The VAO for rendering this mesh in OpenGL
+		/// The range of vertices within the mesh arena that this mesh is using, or nullptr if
+		/// the mesh has not been loaded into an arena
+		/// </summary>
+		MeshArena::Block::Sptr          Vertices;
+		/// <summary>
+		/// A standalone VAO for this mesh, only used when the mesh's data could not be loaded
+		/// to the CPU, and thus could not be placed in an arena
 		/// </summary>
 		VertexArrayObject::Sptr         Mesh;
+		/// <summary>
+		/// The levels of detail for this mesh, where the first level is always the full detail mesh.
+		/// Will be empty if the mesh is not stored in an arena
+		/// </summary>
+		std::vector<LodLevel>           Lods;
+		/// <summary>
+		/// The CPU side copy of the mesh data, which we use for import time processing
+		/// </summary>
+		std::shared_ptr<MeshBuilder<VertexPosNormTexColTangents>> MeshData;
+
+		/// <summary>
+		/// The mesh's axis aligned bounding box in object space, calculated at import time
+		/// </summary>
+		BoundingBox                     BoxBounds;
+		/// <summary>
+		/// The mesh's bounding sphere in object space, centered on the bounding box
+		/// </summary>
+		BoundingSphere                  SphereBounds;
 
 
 		/// <summary>
@@ -47,9 +103,17 @@ namespace Gameplay {
 		/// </summary>
 		MeshResource::Sptr             ColliderMeshData;
 		/// <summary>
-		/// Allows for bullet to generate a triangle mesh from this mesh and cache it
+		/// The reduced convex hull around this mesh in object space, calculated at import time
+		/// so that convex mesh colliders never need to read mesh data back from OpenGL. This is
+		/// shared by all colliders using the mesh, and is never scaled
+		/// </summary>
+		std::shared_ptr<btConvexHullShape> ConvexHull;
+		/// <summary>
+		/// A simplified copy of the mesh's triangles in object space, calculated at import time, which
+		/// is drawn into the software occlusion buffer when the mesh is used as an occluder
 		/// </summary>
-		std::shared_ptr<btTriangleMesh> BulletTriMesh;
+		std::vector<glm::vec3>          OccluderVertices;
+		std::vector<uint32_t>           OccluderIndices;
 
 		/// <summary>
 		/// Generates a new mesh from the mesh builder parameters
@@ -61,9 +125,74 @@ namespace Gameplay {
 		/// <param name="param">The parameter to add</param>
 		void AddParam(const MeshBuilderParam& param);
 
+		/// <summary>
+		/// Regenerates the levels of detail for this mesh from the CPU side mesh data, using quadric
+		/// error simplification
+		/// </summary>
+		void GenerateLods();
+		/// <summary>
+		/// Regenerates the convex hull for this mesh from the CPU side mesh data
+		/// </summary>
+		/// <param name="maxVertices">The maximum number of vertices to keep in the hull</param>
+		void GenerateConvexHull(int maxVertices = MAX_HULL_VERTICES);
+		/// <summary>
+		/// Regenerates the convex hull for this mesh from a set of object space points, for meshes
+		/// that were loaded without CPU side mesh data
+		/// </summary>
+		/// <param name="positions">The points to build the hull around</param>
+		/// <param name="maxVertices">The maximum number of vertices to keep in the hull</param>
+		void GenerateConvexHull(const std::vector<glm::vec3>& positions, int maxVertices = MAX_HULL_VERTICES);
+		/// <summary>
+		/// Regenerates the occluder geometry for this mesh from the CPU side mesh data. Simplification
+		/// stops early if it can't reach the target without visibly changing the mesh's shape
+		/// </summary>
+		/// <param name="maxTriangles">The number of triangles to try to reduce the occluder to</param>
+		void GenerateOccluder(int maxTriangles = MAX_OCCLUDER_TRIANGLES);
+		/// <summary>
+		/// Returns true if this mesh has data that can be rendered
+		/// </summary>
+		bool IsLoaded() const;
+		/// <summary>
+		/// Gets the mesh arena that this mesh is stored in, or nullptr if the mesh is not in an arena
+		/// </summary>
+		MeshArena::Sptr GetArena() const;
+		/// <summary>
+		/// Gets the given level of detail, clamped to the levels that are available. Note that 
+		/// this should only be called if Lods is not empty
+		/// </summary>
+		/// <param name="lod">The index of the level of detail to get</param>
+		const LodLevel& GetLod(int lod) const;
+		/// <summary>
+		/// Gets the number of triangles that will be rendered at the given level of detail
+		/// </summary>
+		/// <param name="lod">The index of the level of detail to get the triangle count of</param>
+		uint32_t GetTriangleCount(int lod = 0) const;
+		/// <summary>
+		/// Binds and draws this mesh at the given level of detail. When drawing many meshes, prefer
+		/// binding the arena once and using MeshArena::Draw to avoid redundant VAO binds. Note that this
+		/// does not provide any per-instance data to the shader
+		/// </summary>
+		/// <param name="lod">The index of the level of detail to render</param>
+		void Draw(int lod = 0);
+		/// <summary>
+		/// Selects the coarsest level of detail whose error stays below the given number of pixels. 
+		/// Levels will only switch once the error has moved past the threshold by the hysteresis amount,
+		/// to prevent popping back and forth when objects sit on the threshold
+		/// </summary>
+		/// <param name="screenSize">The projected diameter of the mesh's bounding sphere, in pixels</param>
+		/// <param name="currentLod">The level of detail that was used last frame</param>
+		/// <param name="pixelError">The maximum error we're willing to accept, in pixels</param>
+		/// <param name="hysteresis">The fraction of the pixel error to use as a dead zone for switching levels</param>
+		/// <returns>The index of the level of detail to use</returns>
+		int SelectLod(float screenSize, int currentLod, float pixelError = 1.0f, float hysteresis = 0.25f) const;
+
 		// Inherited from IResource
 
 		virtual nlohmann::json ToJson() const override;
 		static MeshResource::Sptr FromJson(const nlohmann::json& blob);
+
+	protected:
+		// Uploads the CPU side mesh data to it's mesh arena and runs our import steps on it
+		void _BakeMeshData();
 	};
 }
\ No newline at end of file
@@ -5,6 +5,10 @@
 namespace Gameplay::Physics {
 	/// <summary>
 	/// A complex collider type that allows us to construct collision hulls from arbitrary convex meshes
+	/// 
+	/// The hull is calculated once per MeshResource when the mesh is imported, and shared by every
+	/// collider using the mesh. Bullet applies scaling to the shape itself, so each collider wraps the
+	/// shared hull's points in it's own point cloud shape, which holds the scale without copying them
 	/// </summary>
 	class ConvexMeshCollider final : public ICollider {
 	public:
@@ -19,7 +23,8 @@ namespace Gameplay::Physics {
 		virtual void FromJson(const nlohmann::json& data) override;
 
 	protected:
-		btTriangleMesh* _triMesh;
+		// Keeps the hull's points alive for our shape, even if the mesh regenerates it's hull
+		std::shared_ptr<btConvexHullShape> _hull;
 		ConvexMeshCollider();
 
 		virtual btCollisionShape* CreateShape() const override;
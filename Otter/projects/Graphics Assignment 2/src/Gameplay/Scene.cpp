@@ -15,6 +15,7 @@
 #include "Graphics/DebugDraw.h"
 #include "Graphics/Textures/TextureCube.h"
 #include "Graphics/VertexArrayObject.h"
+#include "Graphics/GlState.h"
 #include "Application/Application.h"
 
 namespace Gameplay {
@@ -364,23 +365,23 @@ namespace Gameplay {
 	{
 		if (_skyboxShader != nullptr &&
 			_skyboxMesh != nullptr &&
-			_skyboxMesh->Mesh != nullptr &&
+			_skyboxMesh->IsLoaded() &&
 			_skyboxTexture != nullptr &&
 			MainCamera != nullptr) {
 			
-			glDepthMask(false);
-			glDisable(GL_CULL_FACE);
-			glDepthFunc(GL_LEQUAL); 
+			GlState::DepthMask(false);
+			GlState::Disable(GL_CULL_FACE);
+			GlState::DepthFunc(GL_LEQUAL);
 
 			_skyboxShader->Bind();
 			_skyboxShader->SetUniformMatrix("u_ClippedView", MainCamera->GetProjection());
 			_skyboxShader->SetUniformMatrix("u_EnvironmentRotation", _skyboxRotation * glm::inverse(glm::mat3(MainCamera->GetView())));
 			_skyboxTexture->Bind(0);
-			_skyboxMesh->Mesh->Draw();
+			_skyboxMesh->Draw();
 
-			glDepthFunc(GL_LESS);
-			glEnable(GL_CULL_FACE);
-			glDepthMask(true);
+			GlState::DepthFunc(GL_LESS);
+			GlState::Enable(GL_CULL_FACE);
+			GlState::DepthMask(true);
 
 		}
 	}
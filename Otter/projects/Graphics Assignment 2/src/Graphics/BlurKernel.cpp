@@ -0,0 +1,98 @@
+#include "BlurKernel.h"
+#include <cmath>
+
+void BlurKernel::GetGaussianWeights(int radius, float sigma, std::vector<float>& outWeights) {
+	radius = radius < 0 ? 0 : radius;
+	sigma = sigma < 0.0001f ? 0.0001f : sigma;
+
+	outWeights.resize(radius * 2 + 1);
+	float total = 0.0f;
+	for (int ix = -radius; ix <= radius; ix++) {
+		float weight = std::exp(-(ix * ix) / (2.0f * sigma * sigma));
+		outWeights[ix + radius] = weight;
+		total += weight;
+	}
+	for (float& weight : outWeights) {
+		weight /= total;
+	}
+}
+
+void BlurKernel::GetBoxWeights(int radius, std::vector<float>& outWeights) {
+	radius = radius < 0 ? 0 : radius;
+	outWeights.assign(radius * 2 + 1, 1.0f / (radius * 2 + 1));
+}
+
+void BlurKernel::GetLinearTaps(const std::vector<float>& weights, std::vector<Tap>& outTaps) {
+	outTaps.clear();
+	if (weights.empty()) {
+		return;
+	}
+
+	const int center = static_cast<int>(weights.size()) / 2;
+	auto weightAt = [&](int offset) {
+		int ix = center + offset;
+		return (ix >= 0 && ix < static_cast<int>(weights.size())) ? weights[ix] : 0.0f;
+	};
+	auto addTap = [&](float offset, float weight) {
+		if (weight != 0.0f) {
+			outTaps.push_back({ offset, weight });
+		}
+	};
+
+	addTap(0.0f, weights[center]);
+
+	// Walk outwards from the center on each side, pairing up neighbouring texels
+	for (int side = -1; side <= 1; side += 2) {
+		for (int distance = 1; distance <= center; distance += 2) {
+			float a = weightAt(distance * side);
+			float b = weightAt((distance + 1) * side);
+
+			// A bilinear sample at t between the two texels gives a*(1-t) + b*t, so we can only
+			// merge them when the weights have the same sign
+			if ((a > 0.0f && b > 0.0f) || (a < 0.0f && b < 0.0f)) {
+				float weight = a + b;
+				float offset = distance + b / weight;
+				addTap(offset * side, weight);
+			} else {
+				addTap(static_cast<float>(distance * side), a);
+				addTap(static_cast<float>((distance + 1) * side), b);
+			}
+		}
+	}
+}
+
+bool BlurKernel::Factorize(const float* kernel, int size, std::vector<float>& outRow, std::vector<float>& outColumn, float epsilon) {
+	outRow.assign(size, 0.0f);
+	outColumn.assign(size, 0.0f);
+
+	// Find the largest weight, it's row and column are the most numerically stable factors
+	int pivotX = 0, pivotY = 0;
+	for (int iy = 0; iy < size; iy++) {
+		for (int ix = 0; ix < size; ix++) {
+			if (std::abs(kernel[iy * size + ix]) > std::abs(kernel[pivotY * size + pivotX])) {
+				pivotX = ix;
+				pivotY = iy;
+			}
+		}
+	}
+	float pivot = kernel[pivotY * size + pivotX];
+	if (pivot == 0.0f) {
+		// An all zero kernel is trivially separable
+		return true;
+	}
+
+	// kernel = column * row, where row is the pivot row, and column is the pivot column scaled so that column[pivotY] = 1
+	for (int ix = 0; ix < size; ix++) {
+		outRow[ix] = kernel[pivotY * size + ix];
+		outColumn[ix] = kernel[ix * size + pivotX] / pivot;
+	}
+
+	for (int iy = 0; iy < size; iy++) {
+		for (int ix = 0; ix < size; ix++) {
+			if (std::abs(outColumn[iy] * outRow[ix] - kernel[iy * size + ix]) > epsilon) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <vector>
+
+/// <summary>
+/// Helpers for building the taps of separable blur kernels
+///
+/// A separable 2D kernel can be applied as a horizontal pass followed by a vertical pass, so a
+/// kernel that is N pixels wide costs 2N samples per pixel instead of N*N. On top of that, two
+/// neighbouring taps with weights of the same sign can be replaced by one bilinear sample placed
+/// between them, which roughly halves the number of samples again
+/// </summary>
+class BlurKernel
+{
+public:
+	/// <summary>
+	/// The most taps that a single pass can use, must match MAX_TAPS in separable_blur.glsl
+	/// </summary>
+	static const int MAX_TAPS = 16;
+
+	/// <summary>
+	/// A single sample in a blur pass
+	/// </summary>
+	struct Tap {
+		/// <summary>
+		/// The distance from the center pixel in texels, may fall between texels
+		/// </summary>
+		float Offset;
+		/// <summary>
+		/// The weight of the sample
+		/// </summary>
+		float Weight;
+	};
+
+	/// <summary>
+	/// Calculates the weights of a normalized 1D gaussian kernel
+	/// </summary>
+	/// <param name="radius">The number of texels on either side of the center</param>
+	/// <param name="sigma">The standard deviation of the gaussian in texels</param>
+	/// <param name="outWeights">Receives the radius * 2 + 1 weights, starting at -radius</param>
+	static void GetGaussianWeights(int radius, float sigma, std::vector<float>& outWeights);
+	/// <summary>
+	/// Calculates the weights of a normalized 1D box kernel
+	/// </summary>
+	/// <param name="radius">The number of texels on either side of the center</param>
+	/// <param name="outWeights">Receives the radius * 2 + 1 weights, starting at -radius</param>
+	static void GetBoxWeights(int radius, std::vector<float>& outWeights);
+
+	/// <summary>
+	/// Converts a 1D kernel into the taps to sample, merging pairs of neighbouring texels with weights
+	/// of the same sign into a single bilinear tap. The center texel is never merged, so symmetric
+	/// kernels stay symmetric, and texels with a weight of zero are skipped
+	/// </summary>
+	/// <param name="weights">The kernel's weights, the center of the kernel is at weights.size() / 2</param>
+	/// <param name="outTaps">Receives the taps, this will be empty if all the weights are zero</param>
+	static void GetLinearTaps(const std::vector<float>& weights, std::vector<Tap>& outTaps);
+
+	/// <summary>
+	/// Attempts to split a square 2D kernel into a column vector and a row vector, where the kernel is
+	/// equal to column * row. This is only possible for kernels where every row is a multiple of every other row
+	/// </summary>
+	/// <param name="kernel">The kernel's weights, stored row by row</param>
+	/// <param name="size">The width and height of the kernel</param>
+	/// <param name="outRow">Receives the horizontal weights</param>
+	/// <param name="outColumn">Receives the vertical weights</param>
+	/// <param name="epsilon">The largest error allowed between the kernel and the product of it's factors</param>
+	/// <returns>True if the kernel is separable, false if it has to be applied as a full 2D kernel</returns>
+	static bool Factorize(const float* kernel, int size, std::vector<float>& outRow, std::vector<float>& outColumn, float epsilon = 0.0001f);
+
+protected:
+	BlurKernel() = default;
+	~BlurKernel() = default;
+};
@@ -0,0 +1,63 @@
+#include "DirtyRanges.h"
+#include <algorithm>
+
+DirtyRanges::DirtyRanges(uint32_t mergeGap) :
+	_ranges(std::vector<Range>()),
+	_mergeGap(mergeGap),
+	_isCoalesced(true)
+{ }
+
+bool DirtyRanges::_CanMerge(const Range& first, const Range& second) const {
+	// Comparing without adding to the end avoids overflowing for ranges at the end of the address space
+	return second.Offset >= first.Offset && second.Offset - first.Offset <= first.Size + _mergeGap;
+}
+
+void DirtyRanges::Add(uint32_t offset, uint32_t size) {
+	if (size == 0) {
+		return;
+	}
+
+	Range range = { offset, size };
+	if (!_ranges.empty()) {
+		Range& last = _ranges.back();
+		if (_CanMerge(last, range)) {
+			last.Size = std::max(last.End(), range.End()) - last.Offset;
+			return;
+		}
+		// Ranges added in order stay sorted, and too far apart to merge
+		if (range.Offset < last.Offset) {
+			_isCoalesced = false;
+		}
+	}
+	_ranges.push_back(range);
+}
+
+const std::vector<DirtyRanges::Range>& DirtyRanges::Coalesce() {
+	if (_isCoalesced || _ranges.empty()) {
+		return _ranges;
+	}
+
+	std::sort(_ranges.begin(), _ranges.end(), [](const Range& a, const Range& b) {
+		return a.Offset < b.Offset;
+	});
+
+	// Merge each range into the last one we kept, if it's close enough
+	size_t kept = 0;
+	for (size_t ix = 1; ix < _ranges.size(); ix++) {
+		Range& last = _ranges[kept];
+		if (_CanMerge(last, _ranges[ix])) {
+			last.Size = std::max(last.End(), _ranges[ix].End()) - last.Offset;
+		} else {
+			_ranges[++kept] = _ranges[ix];
+		}
+	}
+	_ranges.resize(kept + 1);
+	_isCoalesced = true;
+
+	return _ranges;
+}
+
+void DirtyRanges::Clear() {
+	_ranges.clear();
+	_isCoalesced = true;
+}
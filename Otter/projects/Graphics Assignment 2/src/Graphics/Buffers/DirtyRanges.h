@@ -0,0 +1,58 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+/// <summary>
+/// Tracks the byte ranges of a buffer that have changed since it was last uploaded, and merges them
+/// into as few uploads as possible. Ranges that overlap or touch are always merged, ranges with a
+/// gap of at most the merge gap between them are merged as well, since re-uploading a few unchanged
+/// bytes is cheaper than making another call
+/// </summary>
+class DirtyRanges final {
+public:
+	/// <summary>
+	/// A range of bytes within the buffer
+	/// </summary>
+	struct Range {
+		uint32_t Offset;
+		uint32_t Size;
+
+		uint32_t End() const { return Offset + Size; }
+	};
+
+	/// <summary>
+	/// Creates a new set of dirty ranges
+	/// </summary>
+	/// <param name="mergeGap">The largest gap in bytes between two ranges that will still be merged into one</param>
+	DirtyRanges(uint32_t mergeGap = 0);
+	~DirtyRanges() = default;
+
+	/// <summary>
+	/// Marks a range of bytes as changed, ranges that follow on from the last one that was added are
+	/// merged straight away, since fields tend to be written in order
+	/// </summary>
+	/// <param name="offset">The offset of the range in bytes</param>
+	/// <param name="size">The size of the range in bytes, empty ranges are ignored</param>
+	void Add(uint32_t offset, uint32_t size);
+	/// <summary>
+	/// Sorts and merges the ranges, returning the uploads that cover all of the changes
+	/// </summary>
+	const std::vector<Range>& Coalesce();
+	/// <summary>
+	/// Forgets all of the ranges, should be called once they have been uploaded
+	/// </summary>
+	void Clear();
+
+	bool IsEmpty() const { return _ranges.empty(); }
+	const std::vector<Range>& GetRanges() const { return _ranges; }
+	uint32_t GetMergeGap() const { return _mergeGap; }
+
+private:
+	std::vector<Range> _ranges;
+	uint32_t           _mergeGap;
+	// True if the ranges are known to be sorted and merged
+	bool               _isCoalesced;
+
+	// Returns true if the range starting at second can be merged into first
+	bool _CanMerge(const Range& first, const Range& second) const;
+};
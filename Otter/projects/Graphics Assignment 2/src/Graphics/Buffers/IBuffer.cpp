@@ -1,11 +1,76 @@
 #include "IBuffer.h"
 #include "Logging.h"
+#include "Graphics/GlState.h"
+#include <algorithm>
+#include <cstring>
+
+GLsync   IBuffer::__frameFences[IBuffer::STREAMING_FRAMES] = { nullptr };
+uint64_t IBuffer::__frameIndex = 0;
+
+// How long we wait on a frame's fence at a time, in nanoseconds
+const GLuint64 STREAMING_FENCE_TIMEOUT = 1000000000;
+
+// The storage flags for streaming buffers, and the flags that they are mapped with
+const GLbitfield STREAMING_STORAGE_FLAGS = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+// Immutable buffers can still be updated and mapped, they just can't be re-allocated
+const GLbitfield IMMUTABLE_STORAGE_FLAGS = GL_DYNAMIC_STORAGE_BIT | GL_MAP_READ_BIT | GL_MAP_WRITE_BIT;
+
+namespace {
+	/// <summary>
+	/// Gets the alignment that writes to a streaming buffer of the given type need, uniform and storage
+	/// buffers can only be bound at offsets that OpenGL allows
+	/// </summary>
+	uint32_t GetStreamAlignment(BufferType type) {
+		static GLint uniformAlignment = 0;
+		static GLint storageAlignment = 0;
+		switch (type) {
+			case BufferType::Uniform:
+				if (uniformAlignment == 0) {
+					glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+				}
+				return static_cast<uint32_t>(uniformAlignment);
+			case BufferType::ShaderStorage:
+				if (storageAlignment == 0) {
+					glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storageAlignment);
+				}
+				return static_cast<uint32_t>(storageAlignment);
+			default:
+				return 16;
+		}
+	}
+
+	uint32_t AlignUp(uint32_t value, uint32_t alignment) {
+		return ((value + alignment - 1) / alignment) * alignment;
+	}
+
+	/// <summary>
+	/// Blocks until the GPU has passed the given fence
+	/// </summary>
+	void WaitForFence(GLsync fence) {
+		if (fence == nullptr) {
+			return;
+		}
+		// The first wait flushes, so that the fence is sure to be reached
+		GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+		while (result == GL_TIMEOUT_EXPIRED) {
+			result = glClientWaitSync(fence, 0, STREAMING_FENCE_TIMEOUT);
+		}
+		if (result == GL_WAIT_FAILED) {
+			LOG_WARN("Failed to wait for a streaming buffer's fence");
+		}
+	}
+}
 
 IBuffer::IBuffer(BufferType type, BufferUsage usage) :
 	IGraphicsResource(),
 	_elementCount(0),
 	_elementSize(0),
-	_size(0)
+	_size(0),
+	_dataOffset(0),
+	_mapped(nullptr),
+	_regionSize(0),
+	_streamCursor(0),
+	_streamFrame(0)
 {
 	_type = type;
 	_usage = usage;
@@ -18,22 +83,60 @@ GlResourceType IBuffer::GetResourceClass() const {
 
 IBuffer::~IBuffer() {
 	if (_rendererId != 0) {
+		GlState::OnBufferDeleted(_rendererId);
 		glDeleteBuffers(1, &_rendererId);
 		_rendererId = 0;
 	}
 }
 
 void IBuffer::LoadData(const void* data, uint32_t elementSize, uint32_t elementCount) {
-	// Note, this is part of the bindless state access stuff added in 4.5
-	glNamedBufferData(_rendererId, (GLsizeiptr)elementSize * elementCount, data, (GLenum)_usage);
+	if (_usage == BufferUsage::Streaming) {
+		_Stream(data, elementSize, elementCount, true);
+		return;
+	}
+
+	uint32_t size = elementCount * elementSize;
+	if (_usage == BufferUsage::Immutable) {
+		// Immutable storage can't be re-specified, so we only need a new buffer when the data doesn't fit
+		if (size > _regionSize) {
+			_RecreateStorage(size, data, IMMUTABLE_STORAGE_FLAGS);
+			_regionSize = size;
+		} else if (data != nullptr && size > 0) {
+			glNamedBufferSubData(_rendererId, 0, size, data);
+		}
+	} else {
+		// Note, this is part of the bindless state access stuff added in 4.5
+		glNamedBufferData(_rendererId, (GLsizeiptr)size, data, (GLenum)_usage);
+	}
 
 	_elementCount = elementCount;
 	_elementSize = elementSize;
-	_size = elementCount * elementSize;
+	_size = size;
 }
 
 void IBuffer::UpdateData(const void* data, uint32_t elementSize, uint32_t elementCount, bool allowResize /*= true*/)
 {
+	if (_usage == BufferUsage::Streaming) {
+		_Stream(data, elementSize, elementCount, allowResize);
+		return;
+	}
+	if (_usage == BufferUsage::Immutable) {
+		uint32_t size = elementCount * elementSize;
+		if (size > _regionSize) {
+			LOG_ASSERT(allowResize, "Attempting to write beyond the end of the buffer!");
+			LOG_INFO("Re-creating immutable buffer, expanding from {} bytes to {} bytes", _regionSize, size);
+			LoadData(data, elementSize, elementCount);
+		} else {
+			if (size > 0) {
+				glNamedBufferSubData(_rendererId, 0, size, data);
+			}
+			_elementCount = elementCount;
+			_elementSize = elementSize;
+			_size = size;
+		}
+		return;
+	}
+
 	if (elementSize * elementCount > _size) {
 		if (allowResize) {
 			glNamedBufferData(_rendererId, (GLsizeiptr)elementSize * elementCount, data, (GLenum)_usage);
@@ -60,11 +163,84 @@ void IBuffer::UpdateData(const void* data, uint32_t elementSize, uint32_t elemen
 }
 
 void* IBuffer::Map(BufferMapMode mode) {
+	if (_usage == BufferUsage::Streaming) {
+		return _mapped != nullptr ? _mapped + _dataOffset : nullptr;
+	}
 	return glMapNamedBufferRange(_rendererId, 0, _size, *mode);
 }
 
 void IBuffer::Unmap() {
-	glUnmapNamedBuffer(_rendererId);
+	if (_usage != BufferUsage::Streaming) {
+		glUnmapNamedBuffer(_rendererId);
+	}
+}
+
+void IBuffer::EndFrame() {
+	// The fence we're replacing is from STREAMING_FRAMES frames ago, any writes to it's region have already waited on it
+	GLsync& fence = __frameFences[__frameIndex % STREAMING_FRAMES];
+	if (fence != nullptr) {
+		glDeleteSync(fence);
+	}
+	fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	__frameIndex++;
+}
+
+void IBuffer::_RecreateStorage(uint32_t size, const void* data, GLbitfield flags) {
+	// A buffer without storage yet can be given it directly, otherwise we need a new buffer. Deleting the
+	// old one unmaps it, and the GPU keeps it's storage around for any draws that still need it
+	if (_regionSize > 0) {
+		GlState::OnBufferDeleted(_rendererId);
+		glDeleteBuffers(1, &_rendererId);
+		GLuint handle = 0;
+		glCreateBuffers(1, &handle);
+		_SetRenderId(handle);
+	}
+	glNamedBufferStorage(_rendererId, size, data, flags);
+	_mapped = nullptr;
+}
+
+void IBuffer::_Stream(const void* data, uint32_t elementSize, uint32_t elementCount, bool allowResize) {
+	uint32_t size = elementCount * elementSize;
+	_elementCount = elementCount;
+	_elementSize = elementSize;
+	_size = size;
+	if (size == 0) {
+		return;
+	}
+
+	// The first write in a frame moves us over to that frame's region, once the GPU is done reading it
+	uint32_t region = static_cast<uint32_t>(__frameIndex % STREAMING_FRAMES);
+	if (_streamFrame != __frameIndex) {
+		WaitForFence(__frameFences[region]);
+		_streamFrame = __frameIndex;
+		_streamCursor = region * _regionSize;
+	}
+
+	uint32_t alignment = GetStreamAlignment(_type);
+	uint32_t offset = AlignUp(_streamCursor, alignment);
+	if (_mapped == nullptr || offset + size > (region + 1) * _regionSize) {
+		LOG_ASSERT(_mapped == nullptr || allowResize, "Attempting to write beyond the end of the buffer!");
+
+		// Grow the regions so that everything written this frame would fit, so that we settle on a size
+		// after a frame or two. Anything already written this frame stays in the old buffer
+		uint32_t used = _mapped != nullptr ? offset - region * _regionSize : 0;
+		uint32_t regionSize = AlignUp(std::max(_regionSize * 2, used + size), alignment);
+		if (_mapped != nullptr) {
+			LOG_INFO("Expanding streaming buffer regions from {} bytes to {} bytes", _regionSize, regionSize);
+		}
+
+		_RecreateStorage(regionSize * STREAMING_FRAMES, nullptr, STREAMING_STORAGE_FLAGS);
+		_mapped = static_cast<uint8_t*>(glMapNamedBufferRange(_rendererId, 0, regionSize * STREAMING_FRAMES, STREAMING_STORAGE_FLAGS));
+		_regionSize = regionSize;
+		offset = region * _regionSize;
+	}
+	_dataOffset = offset;
+
+	// Loading nothing only makes sure that we have room for that much data
+	if (data != nullptr) {
+		memcpy(_mapped + offset, data, size);
+		_streamCursor = offset + size;
+	}
 }
 
 void IBuffer::Bind() const {
@@ -73,7 +249,11 @@ void IBuffer::Bind() const {
 
 void IBuffer::Bind(uint32_t slot) const
 {
-	glBindBufferBase((GLenum)_type, slot, _rendererId);
+	if (_usage == BufferUsage::Streaming && _size > 0) {
+		GlState::BindBufferRange((GLenum)_type, slot, _rendererId, _dataOffset, _size);
+	} else {
+		GlState::BindBufferBase((GLenum)_type, slot, _rendererId);
+	}
 }
 
 void IBuffer::UnBind(BufferType type) {
@@ -81,5 +261,5 @@ void IBuffer::UnBind(BufferType type) {
 }
 
 void IBuffer::UnBind(BufferType type, uint32_t slot) {
-	glBindBufferBase((GLenum)type, slot, 0);
+	GlState::BindBufferBase((GLenum)type, slot, 0);
 }
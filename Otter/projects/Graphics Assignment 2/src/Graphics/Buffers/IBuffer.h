@@ -30,13 +30,21 @@ class IBuffer : public IGraphicsResource
 public:
 	DEFINE_RESOURCE(IBuffer);
 
+	/// <summary>
+	/// The number of frames that streaming buffers keep a region of storage for, so that we can write one
+	/// frame while the GPU is still reading the frames before it
+	/// </summary>
+	static const int STREAMING_FRAMES = 3;
+
 	/// <summary>
 	/// Virtual destructor to allow child buffers to overload it when needed
 	/// </summary>
 	virtual ~IBuffer();
 
 	/// <summary>
-	/// Loads data into this buffer, using the bindless method glNamedBufferData
+	/// Loads data into this buffer, using the bindless method glNamedBufferData. Immutable buffers are
+	/// only re-created if the data does not fit, and streaming buffers append the data to this frame's
+	/// region. Loading nullptr into a streaming buffer only reserves space for that much data per frame
 	/// </summary>
 	/// <param name="data">The data that you want to load into the buffer</param>
 	/// <param name="elementSize">The size of a single element, in bytes</param>
@@ -72,10 +80,16 @@ public:
 	/// </summary>
 	uint32_t GetElementSize() const { return _elementSize; }
 	/// <summary>
-	/// Returns the total size in bytes that this buffer occupies
+	/// Returns the total size in bytes that this buffer occupies, for streaming buffers this is the size
+	/// of the data that was last written
 	/// </summary>
 	uint32_t GetTotalSize() const { return _size; }
 	/// <summary>
+	/// Returns the offset in bytes of the data that was last written, this is only ever non-zero for
+	/// streaming buffers. Bind(slot) and VertexArrayObject take care of this offset
+	/// </summary>
+	uint32_t GetDataOffset() const { return _dataOffset; }
+	/// <summary>
 	/// Returns the type of buffer (ex GL_ARRAY_BUFFER, GL_ARRAY_ELEMENT_BUFFER, etc...)
 	/// </summary>
 	BufferType GetType() const { return _type; }
@@ -91,18 +105,26 @@ public:
 	/// <see>https://www.khronos.org/registry/OpenGL-Refpages/gl4/html/glMapBufferRange.xhtml</see>
 	/// <param name="mode">The mode, as a series of bit flags</param>
 	/// <returns>A pointer to the data in the buffer, or nullptr if an error occurs</returns>
+	/// <remarks>Streaming buffers are always mapped, and return the data that was last written</remarks>
 	void* Map(BufferMapMode mode);
 	/// <summary>
 	/// Unmaps the buffers, so that the GPU can take control of the memory
 	/// </summary>
 	void Unmap();
 
+	/// <summary>
+	/// Should be called once all of the frame's commands have been submitted, fences off the frame
+	/// so that streaming buffers know when the GPU is done with the region they wrote to
+	/// </summary>
+	static void EndFrame();
+
 	/// <summary>
 	/// Binds this buffer for use to the slot returned by GetType()
 	/// </summary>
 	virtual void Bind() const;
 	/// <summary>
-	/// Binds this buffer for use to the slot returned by GetType()
+	/// Binds this buffer for use to the slot returned by GetType(), streaming buffers only bind the data
+	/// that was last written
 	/// </summary>
 	/// <param name="slot">The buffer slot to bind to, for the vast majority of cases this should be 0</param>
 	virtual void Bind(uint32_t slot) const;
@@ -128,10 +150,37 @@ protected:
 	/// <param name="type">The type of buffer (EX: GL_ARRAY_BUFFER, GL_ARRAY_ELEMENT_BUFFER)</param>
 	/// <param name="usage">The usage hint for the buffer (EX: GL_STATIC_DRAW, GL_DYNAMIC_DRAW)</param>
 	IBuffer(BufferType type, BufferUsage usage);
+
+	/// <summary>
+	/// Replaces the buffer with a new one with immutable storage, the old buffer stays alive until the
+	/// GPU is done with it
+	/// </summary>
+	/// <param name="size">The size of the storage, in bytes</param>
+	/// <param name="data">The data to fill the storage with, or nullptr</param>
+	/// <param name="flags">The storage flags to pass to glNamedBufferStorage</param>
+	void _RecreateStorage(uint32_t size, const void* data, GLbitfield flags);
+	/// <summary>
+	/// Appends data to this frame's region of a streaming buffer, waiting for the GPU to finish with
+	/// the region if this is the first write to it this frame
+	/// </summary>
+	void _Stream(const void* data, uint32_t elementSize, uint32_t elementCount, bool allowResize);
 	
 	uint32_t _elementSize; // The size or stride of our elements
 	uint32_t _elementCount; // The number of elements in the buffer
 	uint32_t _size; // The size of the buffer in bytes
+	uint32_t _dataOffset; // The offset of the data that was last written, for streaming buffers
 	BufferUsage _usage; // The buffer usage mode (GL_STATIC_DRAW, GL_DYNAMIC_DRAW)
 	BufferType _type; // The buffer type (ex GL_ARRAY_BUFFER, GL_ARRAY_ELEMENT_BUFFER)
+
+	// The persistent mapping of a streaming buffer's storage
+	uint8_t* _mapped;
+	// The size of each frame's region in a streaming buffer, and where the next write in this frame's region goes
+	uint32_t _regionSize;
+	uint32_t _streamCursor;
+	// The frame that the streaming buffer's cursor was last moved to
+	uint64_t _streamFrame;
+
+	// The fences for the last frames in flight, indexed by frame number
+	static GLsync   __frameFences[STREAMING_FRAMES];
+	static uint64_t __frameIndex;
 };
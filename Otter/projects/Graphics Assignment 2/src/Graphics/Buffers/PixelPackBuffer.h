@@ -0,0 +1,29 @@
+#pragma once
+#include "IBuffer.h"
+#include <memory>
+
+/// <summary>
+/// A pixel pack buffer receives pixels read back from textures and framebuffers. While one of these
+/// is bound, reads such as glGetTextureImage write into the buffer instead of CPU memory, and return
+/// straight away instead of waiting for the GPU to finish rendering the pixels
+/// </summary>
+class PixelPackBuffer : public IBuffer
+{
+public:
+	typedef std::shared_ptr<PixelPackBuffer> Sptr;
+
+	static inline Sptr Create(BufferUsage usage = BufferUsage::StreamRead) {
+		return std::make_shared<PixelPackBuffer>(usage);
+	}
+
+	/// <summary>
+	/// Creates a new pixel pack buffer, with the given usage. Space will still need to be allocated with LoadData before it can be used
+	/// </summary>
+	/// <param name="usage">The usage hint for the buffer, default is GL_STREAM_READ</param>
+	PixelPackBuffer(BufferUsage usage = BufferUsage::StreamRead) : IBuffer(BufferType::PixelPack, usage) { }
+
+	/// <summary>
+	/// Unbinds the pixel pack buffer, so that reads go back to writing into CPU memory
+	/// </summary>
+	static void UnBind() { IBuffer::UnBind(BufferType::PixelPack); }
+};
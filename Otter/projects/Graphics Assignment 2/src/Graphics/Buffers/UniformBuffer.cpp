@@ -1,5 +1,10 @@
 #include "UniformBuffer.h"
 #include "Logging.h"
+#include "Graphics/GlState.h"
+
+// Gaps between changed fields smaller than this are uploaded along with them, since a few extra
+// bytes are cheaper than another call into the driver
+static const uint32_t UNIFORM_BUFFER_MERGE_GAP = 64;
 
 AbstractUniformBuffer::~AbstractUniformBuffer() {
 	delete[] _rawData;
@@ -7,8 +12,10 @@ AbstractUniformBuffer::~AbstractUniformBuffer() {
 
 AbstractUniformBuffer::AbstractUniformBuffer(uint32_t sizeInBytes, BufferUsage usage /*= BufferUsage::DynamicDraw*/) :
 	IBuffer(BufferType::Uniform, usage),
-	_rawData(nullptr)
+	_rawData(nullptr),
+	_dirty(UNIFORM_BUFFER_MERGE_GAP)
 {
+	LOG_ASSERT(usage != BufferUsage::Immutable && usage != BufferUsage::Streaming, "Uniform buffers keep their own copy of the data, and need a regular usage hint");
 	_rawData = new uint8_t[sizeInBytes];
 	_size = sizeInBytes;
 	memset(_rawData, 0, sizeInBytes);
@@ -20,16 +27,42 @@ void AbstractUniformBuffer::LoadData(const void* data, uint32_t elementSize, uin
 	LOG_ASSERT(dataSize <= _size, "Data exceeds the bounds of this UBO");
 	// Copy data from the data given to our internal buffer
 	memcpy(_rawData, data, dataSize);
-	// Upload data to the OpenGL buffer
-	glNamedBufferSubData(_rendererId, 0, dataSize, _rawData);
+	// Upload data to the OpenGL buffer, along with anything else that was waiting
+	MarkDirty(0, (uint32_t)dataSize);
+	_UploadDirty();
 }
 
 void AbstractUniformBuffer::Bind() const {
-	glBindBufferBase(GL_UNIFORM_BUFFER, 0, _rendererId);
+	GlState::BindBufferBase(GL_UNIFORM_BUFFER, 0, _rendererId);
 }
 
 void AbstractUniformBuffer::Bind(int slot) const
 {
-	glBindBufferBase(GL_UNIFORM_BUFFER, slot, _rendererId);
+	GlState::BindBufferBase(GL_UNIFORM_BUFFER, slot, _rendererId);
 }
 
+
+void AbstractUniformBuffer::MarkDirty(uint32_t offset, uint32_t size) {
+	LOG_ASSERT(offset <= _size && size <= _size - offset, "Dirty range exceeds the bounds of this UBO");
+	_dirty.Add(offset, size);
+}
+
+void AbstractUniformBuffer::MarkAllDirty() {
+	_dirty.Clear();
+	_dirty.Add(0, _size);
+}
+
+void AbstractUniformBuffer::_Write(uint32_t offset, const void* value, uint32_t size) {
+	uint8_t* dest = _rawData + offset;
+	if (memcmp(dest, value, size) != 0) {
+		memcpy(dest, value, size);
+		MarkDirty(offset, size);
+	}
+}
+
+void AbstractUniformBuffer::_UploadDirty() {
+	for (const DirtyRanges::Range& range : _dirty.Coalesce()) {
+		glNamedBufferSubData(_rendererId, range.Offset, range.Size, _rawData + range.Offset);
+	}
+	_dirty.Clear();
+}
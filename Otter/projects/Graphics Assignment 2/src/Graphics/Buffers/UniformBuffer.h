@@ -1,6 +1,9 @@
 #pragma once
 #include "IBuffer.h"
+#include "DirtyRanges.h"
+#include <Logging.h>
 #include <memory>
+#include <cstring>
 
 /// <summary>
 /// A uniform buffer that operates on raw data
@@ -41,10 +44,35 @@ public :
 	/// <param name="slot">The buffer binding slot to bind to</param>
 	void Bind(int slot) const;
 
+	/// <summary>
+	/// Marks a range of the buffer as changed, so that it is uploaded on the next update
+	/// </summary>
+	/// <param name="offset">The offset of the range in bytes</param>
+	/// <param name="size">The size of the range in bytes</param>
+	void MarkDirty(uint32_t offset, uint32_t size);
+	/// <summary>
+	/// Marks the entire buffer as changed, for when the data has been modified directly
+	/// </summary>
+	void MarkAllDirty();
+
 protected:
 	// Will contain the backing data store for the buffer
 	uint8_t* _rawData;
 	uint32_t _size;
+	// The ranges of _rawData that have changed since the last upload
+	DirtyRanges _dirty;
+
+	/// <summary>
+	/// Copies a value into the backing data, marking it as dirty only if it has actually changed
+	/// </summary>
+	/// <param name="offset">The offset to write to in bytes</param>
+	/// <param name="value">The value to copy</param>
+	/// <param name="size">The size of the value in bytes</param>
+	void _Write(uint32_t offset, const void* value, uint32_t size);
+	/// <summary>
+	/// Uploads the dirty ranges of the backing data to OpenGL, and clears them
+	/// </summary>
+	void _UploadDirty();
 };
 
 /// <summary>
@@ -77,10 +105,13 @@ public:
 
 	/// <summary>
 	/// Gets the data structure that this uniform buffer is
-	/// using for storage
+	/// using for storage. Since we can't tell what gets modified
+	/// through the reference, this marks the whole buffer as dirty,
+	/// prefer Set and SetElement for data that changes often
 	/// </summary>
 	/// <returns>A reference to the underlying data for this buffer</returns>
 	Structure& GetData() {
+		MarkAllDirty();
 		return *reinterpret_cast<Structure*>(_rawData);
 	}
 	/// <summary>
@@ -99,14 +130,49 @@ public:
 	/// <param name="data">The new data to store in the UBO</param>
 	void SetData(const Structure& data) {
 		*((Structure*)_rawData) = data;
+		MarkAllDirty();
 		Update();
 	}
 
+	/// <summary>
+	/// Sets a single field of the structure, only marking it as dirty
+	/// if the value has changed
+	/// </summary>
+	/// <example>ubo->Set(&FrameLevelUniforms::u_Time, time);</example>
+	/// <param name="member">A pointer to the member to set</param>
+	/// <param name="value">The new value for the member, converted to the member's type</param>
+	template <typename Field, typename Value>
+	void Set(Field Structure::* member, const Value& value) {
+		Field& field = reinterpret_cast<Structure*>(_rawData)->*member;
+		const Field converted = static_cast<Field>(value);
+		_Write(_OffsetOf(&field), &converted, sizeof(Field));
+	}
+	/// <summary>
+	/// Sets a single element of an array within the structure, only marking
+	/// it as dirty if the value has changed
+	/// </summary>
+	/// <param name="member">A pointer to the array member to set an element of</param>
+	/// <param name="index">The index of the element to set</param>
+	/// <param name="value">The new value for the element, converted to the element's type</param>
+	template <typename Field, size_t Count, typename Value>
+	void SetElement(Field (Structure::* member)[Count], size_t index, const Value& value) {
+		LOG_ASSERT(index < Count, "Index {} is out of bounds for an array of {} elements", index, Count);
+		Field& field = (reinterpret_cast<Structure*>(_rawData)->*member)[index];
+		const Field converted = static_cast<Field>(value);
+		_Write(_OffsetOf(&field), &converted, sizeof(Field));
+	}
+
 	/// <summary>
 	/// Notifies OpenGL that the data has been updated and requires
-	/// a resync with the GL side buffer
+	/// a resync with the GL side buffer, only the ranges that have
+	/// changed since the last update are uploaded
 	/// </summary>
 	void Update() {
-		glNamedBufferSubData(_rendererId, 0, sizeof(Structure), _rawData);
+		_UploadDirty();
+	}
+
+private:
+	uint32_t _OffsetOf(const void* field) const {
+		return static_cast<uint32_t>(reinterpret_cast<const uint8_t*>(field) - _rawData);
 	}
 };
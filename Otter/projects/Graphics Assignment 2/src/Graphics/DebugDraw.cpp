@@ -1,4 +1,5 @@
 #include "Graphics/DebugDraw.h"
+#include "Graphics/GlState.h"
 
 DebugDrawer::DebugDrawer() :
 	_colorStack(std::stack<glm::vec3>()),
@@ -7,12 +8,12 @@ DebugDrawer::DebugDrawer() :
 	_lineOffset(0),
 	_triangleOffset(0)
 {
-	_linesVBO = VertexBuffer::Create(BufferUsage::DynamicDraw);
+	_linesVBO = VertexBuffer::Create(BufferUsage::Streaming);
 	_linesVBO->LoadData<VertexPosCol>(nullptr, LINE_BATCH_SIZE * 2);
 	_linesVAO = VertexArrayObject::Create();
 	_linesVAO->AddVertexBuffer(_linesVBO, VertexPosCol::V_DECL);
 
-	_trisVBO = VertexBuffer::Create(BufferUsage::DynamicDraw);
+	_trisVBO = VertexBuffer::Create(BufferUsage::Streaming);
 	_trisVBO->LoadData<VertexPosCol>(nullptr, TRI_BATCH_SIZE * 3);
 	_trisVAO = VertexArrayObject::Create();
 	_trisVAO->AddVertexBuffer(_trisVBO, VertexPosCol::V_DECL);
@@ -80,7 +81,7 @@ void DebugDrawer::FlushLines()
 		_linesVAO->Unbind();
 		_lineOffset = 0;
 		if (restorePoint != 0) {
-			glBindVertexArray(restorePoint);
+			GlState::BindVertexArray(restorePoint);
 		}
 	}
 }
@@ -123,7 +124,7 @@ void DebugDrawer::FlushTris()
 		_trisVAO->Unbind();
 		_triangleOffset = 0;
 		if (restorePoint != 0) {
-			glBindVertexArray(restorePoint);
+			GlState::BindVertexArray(restorePoint);
 		}
 	}
 }
@@ -0,0 +1,107 @@
+#include "DepthPyramid.h"
+#include <algorithm>
+
+// We pick the level where the rectangle covers at most this many texels across
+const uint32_t MAX_TEST_TEXELS = 4;
+
+DepthPyramid::DepthPyramid() :
+	_viewProjection(glm::mat4(1.0f)),
+	_cameraPosition(glm::vec3(0.0f)),
+	_levels(std::vector<Level>()),
+	_levelCount(0)
+{ }
+
+void DepthPyramid::Build(const glm::mat4& viewProjection, const glm::vec3& cameraPosition, const float* depth, uint32_t width, uint32_t height) {
+	_viewProjection = viewProjection;
+	_cameraPosition = cameraPosition;
+	_levelCount = 0;
+	if (width == 0 || height == 0) {
+		return;
+	}
+
+	// Make room for every level up front, so that growing the list doesn't move a level we're reading from
+	int levelCount = 1;
+	for (uint32_t size = glm::max(width, height); size > 1; size = (size + 1) / 2) {
+		levelCount++;
+	}
+	if (static_cast<int>(_levels.size()) < levelCount) {
+		_levels.resize(levelCount);
+	}
+
+	auto nextLevel = [&](uint32_t levelWidth, uint32_t levelHeight) -> Level& {
+		Level& level = _levels[_levelCount++];
+		level.Width = levelWidth;
+		level.Height = levelHeight;
+		level.Depth.resize(levelWidth * levelHeight);
+		return level;
+	};
+
+	Level& top = nextLevel(width, height);
+	std::copy(depth, depth + width * height, top.Depth.begin());
+
+	// Each texel takes the furthest of the 2x2 texels below it. Sizes are rounded up, and the last
+	// row and column of an odd sized level only have one texel to read on that axis
+	while (width > 1 || height > 1) {
+		const Level& source = _levels[_levelCount - 1];
+		uint32_t nextWidth = (width + 1) / 2;
+		uint32_t nextHeight = (height + 1) / 2;
+		Level& dest = nextLevel(nextWidth, nextHeight);
+
+		for (uint32_t y = 0; y < nextHeight; y++) {
+			const float* row0 = &source.Depth[(y * 2) * width];
+			const float* row1 = &source.Depth[glm::min(y * 2 + 1, height - 1) * width];
+			for (uint32_t x = 0; x < nextWidth; x++) {
+				uint32_t x0 = x * 2;
+				uint32_t x1 = glm::min(x0 + 1, width - 1);
+				dest.Depth[y * nextWidth + x] = glm::max(glm::max(row0[x0], row0[x1]), glm::max(row1[x0], row1[x1]));
+			}
+		}
+
+		width = nextWidth;
+		height = nextHeight;
+	}
+}
+
+void DepthPyramid::Clear() {
+	_levelCount = 0;
+}
+
+bool DepthPyramid::TestRect(const ScreenRect& rect) const {
+	if (_levelCount == 0) {
+		return true;
+	}
+	if (rect.IsEmpty()) {
+		return false;
+	}
+	glm::uvec2 minPixel = glm::uvec2(rect.Min);
+	glm::uvec2 maxPixel = glm::uvec2(rect.Max);
+
+	// Texel x of a level covers pixels x << level to ((x + 1) << level) - 1 of the top level
+	int level = 0;
+	while (level + 1 < _levelCount &&
+		((maxPixel.x >> level) - (minPixel.x >> level) >= MAX_TEST_TEXELS ||
+		 (maxPixel.y >> level) - (minPixel.y >> level) >= MAX_TEST_TEXELS)) {
+		level++;
+	}
+
+	const Level& source = _levels[level];
+	for (uint32_t y = minPixel.y >> level; y <= (maxPixel.y >> level); y++) {
+		for (uint32_t x = minPixel.x >> level; x <= (maxPixel.x >> level); x++) {
+			if (source.Depth[y * source.Width + x] > rect.NearestDepth) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+bool DepthPyramid::IsVisible(const BoundingBox& box, float margin) const {
+	if (_levelCount == 0) {
+		return true;
+	}
+	BoundingBox grown = { box.Min - glm::vec3(margin), box.Max + glm::vec3(margin) };
+
+	// Anything in front of the near plane could cover the whole screen
+	ScreenRect rect;
+	return !grown.ProjectToPixels(_viewProjection, glm::ivec2(_levels[0].Width, _levels[0].Height), rect) || TestRect(rect);
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <GLM/glm.hpp>
+
+#include "Utils/Macros.h"
+#include "Utils/Frustum.h"
+
+/// <summary>
+/// A CPU side hierarchical depth buffer, where each level stores the furthest depth of the 2x2
+/// texels below it. This lets us test a box against a handful of texels from whichever level
+/// it covers, rather than against every pixel that it covers
+///
+/// The depth is expected to come from an earlier frame, so boxes are tested with the view projection
+/// that the depth was rendered with, and are not reprojected into the current view. This bounds how
+/// wrong the results can be:
+///   - Turning the camera without moving it never changes what hides what, so it never causes popping
+///   - Moving the camera shows objects from a new angle, so callers grow each box by how far the camera
+///     has moved since the depth was rendered (see IsVisible). This covers an object peeking past an
+///     occluder's edge by up to that distance, but not one revealed by a larger change in parallax
+///   - Objects and occluders that move on their own are not accounted for. An object that comes out from
+///     behind an occluder, or is uncovered by one moving away, pops in once the depth catches up, which
+///     is the readback latency (usually 1-3 frames, see HiZBuffer::GetLatency)
+/// This does not touch OpenGL, and is covered by DepthPyramidTests
+/// </summary>
+class DepthPyramid final {
+public:
+	MAKE_PTRS(DepthPyramid);
+	NO_COPY(DepthPyramid);
+	NO_MOVE(DepthPyramid);
+
+	DepthPyramid();
+	~DepthPyramid() = default;
+
+	/// <summary>
+	/// Replaces the contents of the pyramid, and builds the coarser levels from it
+	/// </summary>
+	/// <param name="viewProjection">The view projection matrix that the depth was rendered with</param>
+	/// <param name="cameraPosition">The world position of the camera that the depth was rendered with</param>
+	/// <param name="depth">The depth buffer, stored row by row from the bottom of the screen, with depths from 0 (near) to 1 (far)</param>
+	/// <param name="width">The width of the depth buffer in pixels</param>
+	/// <param name="height">The height of the depth buffer in pixels</param>
+	void Build(const glm::mat4& viewProjection, const glm::vec3& cameraPosition, const float* depth, uint32_t width, uint32_t height);
+	/// <summary>
+	/// Removes all the levels, after this all tests will pass until Build is called again
+	/// </summary>
+	void Clear();
+
+	/// <summary>
+	/// Returns true if the pyramid has been built
+	/// </summary>
+	bool HasData() const { return _levelCount > 0; }
+
+	/// <summary>
+	/// Tests a range of pixels on the top level against the pyramid
+	/// </summary>
+	/// <param name="rect">The pixels to test, and the closest depth of the object inside them</param>
+	/// <returns>True if any part of the rectangle may be visible</returns>
+	bool TestRect(const ScreenRect& rect) const;
+	/// <summary>
+	/// Tests a world space bounding box against the pyramid, using the view projection that the pyramid
+	/// was built with. Boxes that cross the near plane are always visible
+	/// </summary>
+	/// <param name="box">The box to test, in world space</param>
+	/// <param name="margin">How far to grow the box on every side before testing it, callers should pass
+	/// the distance the camera has moved since the pyramid's depth was rendered (see GetCameraDistance)</param>
+	/// <returns>True if any part of the box may be visible</returns>
+	bool IsVisible(const BoundingBox& box, float margin = 0.0f) const;
+	/// <summary>
+	/// Gets how far a camera is from the one that the pyramid was built with
+	/// </summary>
+	/// <param name="cameraPosition">The current camera's world position</param>
+	float GetCameraDistance(const glm::vec3& cameraPosition) const { return glm::distance(cameraPosition, _cameraPosition); }
+
+	/// <summary>
+	/// Gets the view projection matrix that the pyramid was built with
+	/// </summary>
+	const glm::mat4& GetViewProjection() const { return _viewProjection; }
+	int GetLevelCount() const { return _levelCount; }
+	/// <summary>
+	/// Gets the size of a level in texels, level 0 is the depth buffer that was passed to Build
+	/// </summary>
+	glm::uvec2 GetLevelSize(int level) const { return glm::uvec2(_levels[level].Width, _levels[level].Height); }
+	/// <summary>
+	/// Gets the depths of a level, stored row by row from the bottom of the screen
+	/// </summary>
+	const std::vector<float>& GetLevel(int level) const { return _levels[level].Depth; }
+
+private:
+	struct Level {
+		uint32_t           Width;
+		uint32_t           Height;
+		std::vector<float> Depth;
+	};
+
+	glm::mat4          _viewProjection;
+	glm::vec3          _cameraPosition;
+	std::vector<Level> _levels;
+	// The number of levels that hold data, _levels is not shrunk so we can re-use it's memory
+	int                _levelCount;
+};
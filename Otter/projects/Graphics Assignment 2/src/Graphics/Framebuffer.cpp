@@ -1,6 +1,7 @@
 #include "Graphics/Framebuffer.h"
 
 #include "Graphics/RenderBuffer.h"
+#include "Graphics/GlState.h"
 #include "Utils/JsonGlmHelpers.h"
 
 
@@ -21,10 +22,16 @@ Framebuffer::Framebuffer(const FramebufferDescriptor& description) :
 	for (const auto& kvp : _description.RenderTargets) {
 		_AddAttachment(kvp.first, kvp.second);
 	}
+
+	// Depth only buffers don't draw to any color buffers
+	if (_drawBuffers.empty()) {
+		glNamedFramebufferDrawBuffer(_rendererId, GL_NONE);
+	}
 }
 
 Framebuffer::~Framebuffer() {
 	LOG_INFO("Deleting frame buffer with ID: {}", _rendererId);
+	GlState::OnFramebufferDeleted(_rendererId);
 	glDeleteFramebuffers(1, &_rendererId);
 }
 
@@ -181,24 +188,23 @@ bool Framebuffer::BindAttachment(RenderTargetAttachment attachment, int slot) co
 
 void Framebuffer::Bind(FramebufferBinding bindMode /*= FramebufferBinding::Draw*/) const {
 	_currentBinding = bindMode;
-	// Make sure that we're drawing to all the color buffers
-	glNamedFramebufferDrawBuffers(_rendererId, _drawBuffers.size(), reinterpret_cast<const GLenum*>(_drawBuffers.data()));
-	glBindFramebuffer(*bindMode, _rendererId);
+	// The draw buffers are set up as attachments are added, so we only need to bind
+	GlState::BindFramebuffer(*bindMode, _rendererId);
 }
 
 void Framebuffer::Unbind() {
 	// Only handle if we've been bound
 	if (_currentBinding != FramebufferBinding::None) {
 		// Unbind the framebuffer and clear our binding
-		glBindFramebuffer(*_currentBinding, 0);
+		GlState::BindFramebuffer(*_currentBinding, 0);
 		_currentBinding = FramebufferBinding::None;
 	}
 }
 
 void Framebuffer::Blit(const Sptr& source, const Sptr& dest, BufferFlags flags /*= BufferFlags::All*/, MagFilter filter /*= MagFilter::Linear*/) {
 	// Bind this buffer as the read, and the unsampled as the write
-	glBindFramebuffer(GL_READ_FRAMEBUFFER, source ? source->GetHandle() : 0);
-	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, dest ? dest->GetHandle() : 0);
+	GlState::BindFramebuffer(GL_READ_FRAMEBUFFER, source ? source->GetHandle() : 0);
+	GlState::BindFramebuffer(GL_DRAW_FRAMEBUFFER, dest ? dest->GetHandle() : 0);
 
 	// Figure out bounds of the framebuffers
 	glm::ivec4 srcBounds; 
@@ -224,8 +230,8 @@ void Framebuffer::Blit(const Sptr& source, const Sptr& dest, BufferFlags flags /
 	Blit(srcBounds, dstBounds, flags, filter);
 
 	// Unbind both buffers
-	glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
-	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	GlState::BindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+	GlState::BindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
 }
 
 void Framebuffer::Blit(const glm::ivec4& srcBounds, const glm::ivec4& dstBounds, BufferFlags flags /*= BufferFlags::All*/, MagFilter filter /*= MagFilter::Linear*/) {
@@ -43,6 +43,8 @@ ENUM(InternalFormat, GLint,
 	R8           = GL_R8,
 	R16          = GL_R16,
 	RG8          = GL_RG8,
+	RG16         = GL_RG16,
+	R32F         = GL_R32F,
 	RGB8         = GL_RGB8,
 	SRGB         = GL_SRGB8,
 	RGB10        = GL_RGB10,
@@ -750,7 +752,9 @@ ENUM(BlendEquation, uint32_t,
 ENUM(BufferType, GLenum,
 	Vertex  = GL_ARRAY_BUFFER,
 	Index   = GL_ELEMENT_ARRAY_BUFFER,
-	Uniform = GL_UNIFORM_BUFFER
+	Uniform = GL_UNIFORM_BUFFER,
+	ShaderStorage = GL_SHADER_STORAGE_BUFFER,
+	PixelPack = GL_PIXEL_PACK_BUFFER
 )
 
 /// <summary>
@@ -762,8 +766,14 @@ ENUM(BufferType, GLenum,
 /// Draw: Content will be modified by our application and used by OpenGL
 /// Read: Content will be filled with content by OpenGL to be read by our application
 /// Copy: Content will be filled by OpenGL and used by other OpenGL commands (not optimized for application access)
+///
+/// The last two are not usage hints, and give the buffer immutable storage with glNamedBufferStorage instead:
+/// Immutable: Storage is only re-created when data larger than it is loaded, updates go through glNamedBufferSubData
+/// Streaming: Storage is persistently mapped and split into a region per frame in flight, every write is
+///            appended to this frame's region, so data can be written every frame without syncing with the GPU
 /// </summary>
 /// <see>https://www.khronos.org/registry/OpenGL-Refpages/gl4/html/glBufferData.xhtml</see>
+/// <see>https://www.khronos.org/registry/OpenGL-Refpages/gl4/html/glBufferStorage.xhtml</see>
 ENUM(BufferUsage, GLenum,
 	StreamDraw = GL_STREAM_DRAW,
 	StreamRead = GL_STREAM_READ,
@@ -776,6 +786,9 @@ ENUM(BufferUsage, GLenum,
 	DynamicDraw = GL_DYNAMIC_DRAW,
 	DynamicRead = GL_DYNAMIC_READ,
 	DynamicCopy = GL_DYNAMIC_COPY,
+
+	Immutable = 0x10000,
+	Streaming = 0x10001,
 )
 
 /// <summary>
@@ -865,7 +878,10 @@ ENUM(RenderTargetType, uint32_t,
 	 ColorRgb10   = GL_RGB10,
 	 ColorRgb8    = GL_RGB8,
 	 ColorRG8     = GL_RG8,
+	 ColorRG16    = GL_RG16,
+	 ColorRG16F   = GL_RG16F,
 	 ColorRed8    = GL_R8,
+	 ColorR32F    = GL_R32F,
 	 ColorRgb16F  = GL_RGB16F,
 	 ColorRgba16F = GL_RGBA16F,
 	 DepthStencil = GL_DEPTH24_STENCIL8,
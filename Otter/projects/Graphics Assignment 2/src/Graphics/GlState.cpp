@@ -0,0 +1,409 @@
+#include "GlState.h"
+#include "Logging.h"
+
+// Marks state that we don't know, so that the next call for it always goes through
+const GLuint GL_STATE_UNKNOWN = 0xFFFFFFFF;
+
+// The capabilities that are tracked, anything else is always passed on to OpenGL
+const GLenum GL_STATE_CAPABILITIES[] = {
+	GL_BLEND,
+	GL_DEPTH_TEST,
+	GL_CULL_FACE,
+	GL_SCISSOR_TEST,
+	GL_STENCIL_TEST,
+	GL_RASTERIZER_DISCARD
+};
+const int GL_STATE_CAPABILITY_COUNT = sizeof(GL_STATE_CAPABILITIES) / sizeof(GLenum);
+
+namespace {
+	// A buffer bound to an indexed binding point, a size of 0 means the whole buffer is bound,
+	// which is also what OpenGL reports for glBindBufferBase
+	struct BufferBinding {
+		GLuint     Buffer;
+		GLintptr   Offset;
+		GLsizeiptr Size;
+
+		bool operator ==(const BufferBinding& other) const {
+			return Buffer == other.Buffer && Offset == other.Offset && Size == other.Size;
+		}
+		bool operator !=(const BufferBinding& other) const {
+			return !(*this == other);
+		}
+	};
+
+	const BufferBinding UNKNOWN_BINDING = { GL_STATE_UNKNOWN, 0, 0 };
+
+	struct CachedState {
+		GLuint        Program;
+		GLuint        VertexArray;
+		GLuint        Textures[GlState::MAX_TEXTURE_UNITS];
+		BufferBinding UniformBuffers[GlState::MAX_BUFFER_BINDINGS];
+		BufferBinding StorageBuffers[GlState::MAX_BUFFER_BINDINGS];
+		GLuint        DrawFramebuffer;
+		GLuint        ReadFramebuffer;
+		// 0 or 1 for disabled or enabled, or GL_STATE_UNKNOWN
+		GLuint        Capabilities[GL_STATE_CAPABILITY_COUNT];
+		GLenum        BlendSrcRgb;
+		GLenum        BlendDstRgb;
+		GLenum        BlendSrcAlpha;
+		GLenum        BlendDstAlpha;
+		GLenum        BlendEquationRgb;
+		GLenum        BlendEquationAlpha;
+		GLenum        DepthFunc;
+		GLuint        DepthMask;
+		GLenum        CullFace;
+	};
+
+	CachedState GetUnknownState() {
+		CachedState result;
+		result.Program = GL_STATE_UNKNOWN;
+		result.VertexArray = GL_STATE_UNKNOWN;
+		for (int ix = 0; ix < GlState::MAX_TEXTURE_UNITS; ix++) {
+			result.Textures[ix] = GL_STATE_UNKNOWN;
+		}
+		for (int ix = 0; ix < GlState::MAX_BUFFER_BINDINGS; ix++) {
+			result.UniformBuffers[ix] = UNKNOWN_BINDING;
+			result.StorageBuffers[ix] = UNKNOWN_BINDING;
+		}
+		result.DrawFramebuffer = GL_STATE_UNKNOWN;
+		result.ReadFramebuffer = GL_STATE_UNKNOWN;
+		for (int ix = 0; ix < GL_STATE_CAPABILITY_COUNT; ix++) {
+			result.Capabilities[ix] = GL_STATE_UNKNOWN;
+		}
+		result.BlendSrcRgb = GL_STATE_UNKNOWN;
+		result.BlendDstRgb = GL_STATE_UNKNOWN;
+		result.BlendSrcAlpha = GL_STATE_UNKNOWN;
+		result.BlendDstAlpha = GL_STATE_UNKNOWN;
+		result.BlendEquationRgb = GL_STATE_UNKNOWN;
+		result.BlendEquationAlpha = GL_STATE_UNKNOWN;
+		result.DepthFunc = GL_STATE_UNKNOWN;
+		result.DepthMask = GL_STATE_UNKNOWN;
+		result.CullFace = GL_STATE_UNKNOWN;
+		return result;
+	}
+
+	CachedState    Cache = GetUnknownState();
+	GlState::Stats CacheStats = { 0, 0, 0 };
+	#ifdef _DEBUG
+	bool ValidationEnabled = true;
+	#else
+	bool ValidationEnabled = false;
+	#endif
+
+	// Updates a piece of cached state, returning true if the call needs to go through to OpenGL
+	template <typename T>
+	bool Update(T& cached, const T& value) {
+		if (cached == value) {
+			CacheStats.Skipped++;
+			return false;
+		}
+		cached = value;
+		CacheStats.Issued++;
+		return true;
+	}
+
+	int GetCapabilityIndex(GLenum capability) {
+		for (int ix = 0; ix < GL_STATE_CAPABILITY_COUNT; ix++) {
+			if (GL_STATE_CAPABILITIES[ix] == capability) {
+				return ix;
+			}
+		}
+		return -1;
+	}
+
+	BufferBinding* GetBufferBinding(GLenum target, uint32_t index) {
+		if (index >= GlState::MAX_BUFFER_BINDINGS) {
+			return nullptr;
+		}
+		switch (target) {
+			case GL_UNIFORM_BUFFER:        return &Cache.UniformBuffers[index];
+			case GL_SHADER_STORAGE_BUFFER: return &Cache.StorageBuffers[index];
+			default:                       return nullptr;
+		}
+	}
+
+	// Compares a cached value against the one read back from OpenGL, forgetting it if they don't match
+	template <typename T>
+	void Check(const char* name, T& cached, T actual, bool& result) {
+		if (cached == static_cast<T>(GL_STATE_UNKNOWN) || cached == actual) {
+			return;
+		}
+		LOG_WARN("GL state cache is out of date, {} is {} but the cache has {}", name, actual, cached);
+		cached = static_cast<T>(GL_STATE_UNKNOWN);
+		CacheStats.Mismatches++;
+		result = false;
+	}
+
+	GLuint GetInteger(GLenum name) {
+		GLint result = 0;
+		glGetIntegerv(name, &result);
+		return static_cast<GLuint>(result);
+	}
+
+	void CheckBuffers(const char* name, GLenum binding, GLenum start, GLenum size, BufferBinding* cached, bool& result) {
+		for (int ix = 0; ix < GlState::MAX_BUFFER_BINDINGS; ix++) {
+			if (cached[ix].Buffer == GL_STATE_UNKNOWN) {
+				continue;
+			}
+			GLint buffer = 0;
+			GLint64 offset = 0, length = 0;
+			glGetIntegeri_v(binding, ix, &buffer);
+			glGetInteger64i_v(start, ix, &offset);
+			glGetInteger64i_v(size, ix, &length);
+			BufferBinding actual = { static_cast<GLuint>(buffer), static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(length) };
+			if (actual != cached[ix]) {
+				LOG_WARN("GL state cache is out of date, {} binding {} is {} but the cache has {}", name, ix, actual.Buffer, cached[ix].Buffer);
+				cached[ix] = UNKNOWN_BINDING;
+				CacheStats.Mismatches++;
+				result = false;
+			}
+		}
+	}
+}
+
+void GlState::UseProgram(GLuint program) {
+	if (Update(Cache.Program, program)) {
+		glUseProgram(program);
+	}
+}
+
+void GlState::BindVertexArray(GLuint vao) {
+	if (Update(Cache.VertexArray, vao)) {
+		glBindVertexArray(vao);
+	}
+}
+
+void GlState::BindTextureUnit(uint32_t unit, GLuint texture) {
+	if (unit >= MAX_TEXTURE_UNITS) {
+		CacheStats.Issued++;
+		glBindTextureUnit(unit, texture);
+	} else if (Update(Cache.Textures[unit], texture)) {
+		glBindTextureUnit(unit, texture);
+	}
+}
+
+void GlState::BindBufferBase(GLenum target, uint32_t index, GLuint buffer) {
+	BufferBinding* cached = GetBufferBinding(target, index);
+	if (cached == nullptr) {
+		CacheStats.Issued++;
+		glBindBufferBase(target, index, buffer);
+	} else if (Update(*cached, BufferBinding{ buffer, 0, 0 })) {
+		glBindBufferBase(target, index, buffer);
+	}
+}
+
+void GlState::BindBufferRange(GLenum target, uint32_t index, GLuint buffer, GLintptr offset, GLsizeiptr size) {
+	BufferBinding* cached = GetBufferBinding(target, index);
+	if (cached == nullptr) {
+		CacheStats.Issued++;
+		glBindBufferRange(target, index, buffer, offset, size);
+	} else if (Update(*cached, BufferBinding{ buffer, offset, size })) {
+		glBindBufferRange(target, index, buffer, offset, size);
+	}
+}
+
+void GlState::BindFramebuffer(GLenum target, GLuint framebuffer) {
+	switch (target) {
+		case GL_DRAW_FRAMEBUFFER:
+			if (Update(Cache.DrawFramebuffer, framebuffer)) {
+				glBindFramebuffer(target, framebuffer);
+			}
+			break;
+		case GL_READ_FRAMEBUFFER:
+			if (Update(Cache.ReadFramebuffer, framebuffer)) {
+				glBindFramebuffer(target, framebuffer);
+			}
+			break;
+		default:
+			// Binding both only counts as skipped if neither would change
+			if (Cache.DrawFramebuffer == framebuffer && Cache.ReadFramebuffer == framebuffer) {
+				CacheStats.Skipped++;
+			} else {
+				Cache.DrawFramebuffer = framebuffer;
+				Cache.ReadFramebuffer = framebuffer;
+				CacheStats.Issued++;
+				glBindFramebuffer(target, framebuffer);
+			}
+			break;
+	}
+}
+
+void GlState::SetEnabled(GLenum capability, bool enabled) {
+	int index = GetCapabilityIndex(capability);
+	if (index < 0) {
+		CacheStats.Issued++;
+	} else if (!Update(Cache.Capabilities[index], enabled ? 1u : 0u)) {
+		return;
+	}
+
+	if (enabled) {
+		glEnable(capability);
+	} else {
+		glDisable(capability);
+	}
+}
+
+void GlState::BlendFunc(GLenum src, GLenum dst) {
+	BlendFuncSeparate(src, dst, src, dst);
+}
+
+void GlState::BlendFuncSeparate(GLenum srcRgb, GLenum dstRgb, GLenum srcAlpha, GLenum dstAlpha) {
+	if (Cache.BlendSrcRgb == srcRgb && Cache.BlendDstRgb == dstRgb && Cache.BlendSrcAlpha == srcAlpha && Cache.BlendDstAlpha == dstAlpha) {
+		CacheStats.Skipped++;
+		return;
+	}
+	Cache.BlendSrcRgb = srcRgb;
+	Cache.BlendDstRgb = dstRgb;
+	Cache.BlendSrcAlpha = srcAlpha;
+	Cache.BlendDstAlpha = dstAlpha;
+	CacheStats.Issued++;
+	glBlendFuncSeparate(srcRgb, dstRgb, srcAlpha, dstAlpha);
+}
+
+void GlState::BlendEquationSeparate(GLenum rgb, GLenum alpha) {
+	if (Cache.BlendEquationRgb == rgb && Cache.BlendEquationAlpha == alpha) {
+		CacheStats.Skipped++;
+		return;
+	}
+	Cache.BlendEquationRgb = rgb;
+	Cache.BlendEquationAlpha = alpha;
+	CacheStats.Issued++;
+	glBlendEquationSeparate(rgb, alpha);
+}
+
+void GlState::DepthFunc(GLenum func) {
+	if (Update(Cache.DepthFunc, func)) {
+		glDepthFunc(func);
+	}
+}
+
+void GlState::DepthMask(bool enabled) {
+	if (Update(Cache.DepthMask, enabled ? 1u : 0u)) {
+		glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+	}
+}
+
+void GlState::CullFace(GLenum face) {
+	if (Update(Cache.CullFace, face)) {
+		glCullFace(face);
+	}
+}
+
+void GlState::OnProgramDeleted(GLuint program) {
+	// Deleting the program in use is deferred until another one is used, so we can't know what is bound
+	if (Cache.Program == program) {
+		Cache.Program = GL_STATE_UNKNOWN;
+	}
+}
+
+void GlState::OnVertexArrayDeleted(GLuint vao) {
+	if (Cache.VertexArray == vao) {
+		Cache.VertexArray = 0;
+	}
+}
+
+void GlState::OnTextureDeleted(GLuint texture) {
+	for (int ix = 0; ix < MAX_TEXTURE_UNITS; ix++) {
+		if (Cache.Textures[ix] == texture) {
+			Cache.Textures[ix] = 0;
+		}
+	}
+}
+
+void GlState::OnBufferDeleted(GLuint buffer) {
+	for (int ix = 0; ix < MAX_BUFFER_BINDINGS; ix++) {
+		if (Cache.UniformBuffers[ix].Buffer == buffer) {
+			Cache.UniformBuffers[ix] = { 0, 0, 0 };
+		}
+		if (Cache.StorageBuffers[ix].Buffer == buffer) {
+			Cache.StorageBuffers[ix] = { 0, 0, 0 };
+		}
+	}
+}
+
+void GlState::OnFramebufferDeleted(GLuint framebuffer) {
+	if (Cache.DrawFramebuffer == framebuffer) {
+		Cache.DrawFramebuffer = 0;
+	}
+	if (Cache.ReadFramebuffer == framebuffer) {
+		Cache.ReadFramebuffer = 0;
+	}
+}
+
+void GlState::Invalidate() {
+	Cache = GetUnknownState();
+}
+
+bool GlState::Validate() {
+	bool result = true;
+
+	Check("the program", Cache.Program, GetInteger(GL_CURRENT_PROGRAM), result);
+	Check("the vertex array", Cache.VertexArray, GetInteger(GL_VERTEX_ARRAY_BINDING), result);
+	Check("the draw framebuffer", Cache.DrawFramebuffer, GetInteger(GL_DRAW_FRAMEBUFFER_BINDING), result);
+	Check("the read framebuffer", Cache.ReadFramebuffer, GetInteger(GL_READ_FRAMEBUFFER_BINDING), result);
+
+	// Texture bindings can only be read back per target through the active unit, a unit matches if the
+	// texture is bound to any of it's targets, or if they are all empty when nothing should be bound
+	const GLenum textureBindings[] = {
+		GL_TEXTURE_BINDING_1D, GL_TEXTURE_BINDING_2D, GL_TEXTURE_BINDING_3D,
+		GL_TEXTURE_BINDING_CUBE_MAP, GL_TEXTURE_BINDING_2D_ARRAY
+	};
+	GLuint activeTexture = GetInteger(GL_ACTIVE_TEXTURE);
+	for (int unit = 0; unit < MAX_TEXTURE_UNITS; unit++) {
+		GLuint cached = Cache.Textures[unit];
+		if (cached == GL_STATE_UNKNOWN) {
+			continue;
+		}
+		glActiveTexture(GL_TEXTURE0 + unit);
+		bool found = false;
+		bool empty = true;
+		for (GLenum binding : textureBindings) {
+			GLuint texture = GetInteger(binding);
+			found |= texture == cached;
+			empty &= texture == 0;
+		}
+		if (cached == 0 ? !empty : !found) {
+			LOG_WARN("GL state cache is out of date, texture unit {} does not have {} bound", unit, cached);
+			Cache.Textures[unit] = GL_STATE_UNKNOWN;
+			CacheStats.Mismatches++;
+			result = false;
+		}
+	}
+	glActiveTexture(activeTexture);
+
+	CheckBuffers("uniform buffer", GL_UNIFORM_BUFFER_BINDING, GL_UNIFORM_BUFFER_START, GL_UNIFORM_BUFFER_SIZE, Cache.UniformBuffers, result);
+	CheckBuffers("shader storage buffer", GL_SHADER_STORAGE_BUFFER_BINDING, GL_SHADER_STORAGE_BUFFER_START, GL_SHADER_STORAGE_BUFFER_SIZE, Cache.StorageBuffers, result);
+
+	for (int ix = 0; ix < GL_STATE_CAPABILITY_COUNT; ix++) {
+		Check("a capability", Cache.Capabilities[ix], glIsEnabled(GL_STATE_CAPABILITIES[ix]) ? 1u : 0u, result);
+	}
+	Check("the blend source RGB", Cache.BlendSrcRgb, GetInteger(GL_BLEND_SRC_RGB), result);
+	Check("the blend destination RGB", Cache.BlendDstRgb, GetInteger(GL_BLEND_DST_RGB), result);
+	Check("the blend source alpha", Cache.BlendSrcAlpha, GetInteger(GL_BLEND_SRC_ALPHA), result);
+	Check("the blend destination alpha", Cache.BlendDstAlpha, GetInteger(GL_BLEND_DST_ALPHA), result);
+	Check("the blend equation RGB", Cache.BlendEquationRgb, GetInteger(GL_BLEND_EQUATION_RGB), result);
+	Check("the blend equation alpha", Cache.BlendEquationAlpha, GetInteger(GL_BLEND_EQUATION_ALPHA), result);
+	Check("the depth function", Cache.DepthFunc, GetInteger(GL_DEPTH_FUNC), result);
+	GLboolean depthMask = GL_TRUE;
+	glGetBooleanv(GL_DEPTH_WRITEMASK, &depthMask);
+	Check("the depth mask", Cache.DepthMask, depthMask ? 1u : 0u, result);
+	Check("the cull face", Cache.CullFace, GetInteger(GL_CULL_FACE_MODE), result);
+
+	return result;
+}
+
+void GlState::SetValidationEnabled(bool value) {
+	ValidationEnabled = value;
+}
+
+bool GlState::IsValidationEnabled() {
+	return ValidationEnabled;
+}
+
+const GlState::Stats& GlState::GetStats() {
+	return CacheStats;
+}
+
+void GlState::ResetStats() {
+	CacheStats = { 0, 0, 0 };
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include <cstdint>
+#include <glad/glad.h>
+
+/// <summary>
+/// Remembers the OpenGL state that has been set through it, so that binds and enables which would not
+/// change anything are skipped before they reach the driver. Programs, VAOs, textures, indexed uniform
+/// and storage buffers, framebuffers, and the blend, depth and cull state are tracked
+///
+/// Any state that is changed without going through here will leave the cache out of date. Code that
+/// hands the context to something else (ex: ImGui's backend) should call Invalidate afterwards, and
+/// objects that are deleted should let the cache know, since OpenGL unbinds them and may hand their
+/// names out again. Validate compares the cache against glGet, to catch anything that was missed
+/// </summary>
+class GlState final {
+public:
+	/// <summary>
+	/// Counts of the state changes that went through the cache
+	/// </summary>
+	struct Stats {
+		// The calls that were passed on to OpenGL
+		uint32_t Issued;
+		// The calls that were skipped, since they would not have changed anything
+		uint32_t Skipped;
+		// The number of times that Validate found the cache did not match OpenGL
+		uint32_t Mismatches;
+	};
+
+	/// <summary>
+	/// The number of texture units and indexed buffer bindings that are tracked, anything past these
+	/// is always passed on to OpenGL
+	/// </summary>
+	static const int MAX_TEXTURE_UNITS   = 32;
+	static const int MAX_BUFFER_BINDINGS = 16;
+
+	static void UseProgram(GLuint program);
+	static void BindVertexArray(GLuint vao);
+	static void BindTextureUnit(uint32_t unit, GLuint texture);
+	/// <summary>
+	/// Binds a buffer to an indexed binding point, only uniform and shader storage buffers are tracked
+	/// </summary>
+	static void BindBufferBase(GLenum target, uint32_t index, GLuint buffer);
+	static void BindBufferRange(GLenum target, uint32_t index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+	/// <summary>
+	/// Binds a framebuffer, GL_FRAMEBUFFER sets both the draw and read bindings
+	/// </summary>
+	static void BindFramebuffer(GLenum target, GLuint framebuffer);
+
+	/// <summary>
+	/// Enables or disables a capability, blending, depth testing, culling, scissor testing, stencil testing
+	/// and rasterizer discard are tracked
+	/// </summary>
+	static void SetEnabled(GLenum capability, bool enabled);
+	static void Enable(GLenum capability) { SetEnabled(capability, true); }
+	static void Disable(GLenum capability) { SetEnabled(capability, false); }
+	static void BlendFunc(GLenum src, GLenum dst);
+	static void BlendFuncSeparate(GLenum srcRgb, GLenum dstRgb, GLenum srcAlpha, GLenum dstAlpha);
+	static void BlendEquationSeparate(GLenum rgb, GLenum alpha);
+	static void DepthFunc(GLenum func);
+	static void DepthMask(bool enabled);
+	static void CullFace(GLenum face);
+
+	/// <summary>
+	/// Lets the cache know that an object was deleted, OpenGL unbinds deleted objects from the current
+	/// context, and may re-use their names for new objects
+	/// </summary>
+	static void OnProgramDeleted(GLuint program);
+	static void OnVertexArrayDeleted(GLuint vao);
+	static void OnTextureDeleted(GLuint texture);
+	static void OnBufferDeleted(GLuint buffer);
+	static void OnFramebufferDeleted(GLuint framebuffer);
+
+	/// <summary>
+	/// Forgets all of the cached state, the next call for each piece of state will always go through
+	/// </summary>
+	static void Invalidate();
+	/// <summary>
+	/// Reads the tracked state back with glGet, and logs anything that does not match the cache. Mismatched
+	/// state is forgotten so that the next call fixes it. This stalls the pipeline, so it should only be
+	/// used for debugging
+	/// </summary>
+	/// <returns>True if the cache matched OpenGL</returns>
+	static bool Validate();
+	/// <summary>
+	/// Sets whether the renderer validates the cache once per frame, this is on by default in debug builds
+	/// </summary>
+	static void SetValidationEnabled(bool value);
+	static bool IsValidationEnabled();
+
+	static const Stats& GetStats();
+	static void ResetStats();
+
+private:
+	GlState() = delete;
+};
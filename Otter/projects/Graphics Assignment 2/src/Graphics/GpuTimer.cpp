@@ -0,0 +1,65 @@
+#include "GpuTimer.h"
+#include "Logging.h"
+
+GpuTimer::GpuTimer() :
+	_next(0),
+	_active(-1),
+	_hasNewResult(false),
+	_milliseconds(0.0f)
+{
+	for (int ix = 0; ix < RING_SIZE; ix++) {
+		glGenQueries(2, _ring[ix].Queries);
+		_ring[ix].Pending = false;
+	}
+}
+
+GpuTimer::~GpuTimer() {
+	for (int ix = 0; ix < RING_SIZE; ix++) {
+		glDeleteQueries(2, _ring[ix].Queries);
+	}
+}
+
+void GpuTimer::Begin() {
+	LOG_ASSERT(_active < 0, "GpuTimer::Begin called twice without calling End!");
+	_hasNewResult = false;
+
+	// Measurements finish in the order they were started, so walk from the oldest until we find one
+	// that is still in flight, and keep the newest one that has finished
+	for (int step = 0; step < RING_SIZE; step++) {
+		Slot& slot = _ring[(_next + step) % RING_SIZE];
+		if (!slot.Pending) {
+			continue;
+		}
+
+		// The end query is issued last, so once it is available both of them are
+		GLint available = GL_FALSE;
+		glGetQueryObjectiv(slot.Queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (available == GL_FALSE) {
+			break;
+		}
+
+		GLuint64 start = 0, end = 0;
+		glGetQueryObjectui64v(slot.Queries[0], GL_QUERY_RESULT, &start);
+		glGetQueryObjectui64v(slot.Queries[1], GL_QUERY_RESULT, &end);
+		slot.Pending = false;
+		_milliseconds = static_cast<float>(end - start) / 1000000.0f;
+		_hasNewResult = true;
+	}
+
+	// If the GPU is still working on the oldest measurement we skip this frame rather than waiting on it
+	if (_ring[_next].Pending) {
+		return;
+	}
+	_active = _next;
+	glQueryCounter(_ring[_active].Queries[0], GL_TIMESTAMP);
+}
+
+void GpuTimer::End() {
+	if (_active < 0) {
+		return;
+	}
+	glQueryCounter(_ring[_active].Queries[1], GL_TIMESTAMP);
+	_ring[_active].Pending = true;
+	_next = (_next + 1) % RING_SIZE;
+	_active = -1;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <cstdint>
+#include <glad/glad.h>
+
+#include "Utils/Macros.h"
+
+/// <summary>
+/// Measures how long the GPU spends on a span of commands, using a pair of timestamp queries
+///
+/// Reading a query straight after issuing it would stall until the GPU catches up, so the queries
+/// are kept in a ring, and each frame only the results that are already available are read. This
+/// means the time reported is a few frames old
+/// </summary>
+class GpuTimer final {
+public:
+	MAKE_PTRS(GpuTimer);
+	NO_COPY(GpuTimer);
+	NO_MOVE(GpuTimer);
+
+	/// <summary>
+	/// The number of measurements that can be waiting on the GPU at once
+	/// </summary>
+	static const int RING_SIZE = 4;
+
+	GpuTimer();
+	~GpuTimer();
+
+	/// <summary>
+	/// Starts timing, collecting any earlier measurements that have finished. If every slot in the
+	/// ring is still waiting on the GPU, this measurement is skipped
+	/// </summary>
+	void Begin();
+	/// <summary>
+	/// Stops timing, must be called after Begin
+	/// </summary>
+	void End();
+
+	/// <summary>
+	/// Returns true if a new measurement was collected by the last call to Begin
+	/// </summary>
+	bool HasNewResult() const { return _hasNewResult; }
+	/// <summary>
+	/// Gets the most recent measurement in milliseconds
+	/// </summary>
+	float GetMilliseconds() const { return _milliseconds; }
+
+private:
+	struct Slot {
+		GLuint Queries[2];
+		bool   Pending;
+	};
+
+	Slot  _ring[RING_SIZE];
+	// The ring slot that the next measurement will use, which is always the oldest
+	int   _next;
+	// The slot being measured between Begin and End, or -1 if this frame was skipped
+	int   _active;
+	bool  _hasNewResult;
+	float _milliseconds;
+};
@@ -298,8 +298,8 @@ void GuiBatcher::__StaticInit()
 
 		__fontShader->Link();
 
-		__vbo = VertexBuffer::Create(BufferUsage::DynamicDraw);
-		__ibo = IndexBuffer::Create(BufferUsage::DynamicDraw, IndexType::UInt);
+		__vbo = VertexBuffer::Create(BufferUsage::Streaming);
+		__ibo = IndexBuffer::Create(BufferUsage::Streaming, IndexType::UInt);
 
 		__vao = VertexArrayObject::Create();
 		__vao->AddVertexBuffer(__vbo, VertexPosColTex::V_DECL);
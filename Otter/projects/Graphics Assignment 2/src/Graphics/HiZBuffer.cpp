@@ -0,0 +1,156 @@
+#include "HiZBuffer.h"
+#include "Logging.h"
+#include "GlState.h"
+
+HiZBuffer::HiZBuffer(const VertexArrayObject::Sptr& fullscreenQuad) :
+	_fullscreenQuad(fullscreenQuad),
+	_downsampleShader(nullptr),
+	_levels(std::vector<Framebuffer::Sptr>()),
+	_sourceSize(glm::uvec2(0)),
+	_nextReadback(0),
+	_frame(0),
+	_latency(0),
+	_pyramid(std::make_shared<DepthPyramid>())
+{
+	_downsampleShader = ShaderProgram::Create();
+	_downsampleShader->LoadShaderPartFromFile("shaders/vertex_shaders/fullscreen_quad.glsl", ShaderPartType::Vertex);
+	_downsampleShader->LoadShaderPartFromFile("shaders/fragment_shaders/hiz_downsample.glsl", ShaderPartType::Fragment);
+	_downsampleShader->Link();
+
+	for (int ix = 0; ix < RING_SIZE; ix++) {
+		_ring[ix].Buffer = PixelPackBuffer::Create(BufferUsage::StreamRead);
+		_ring[ix].Fence = nullptr;
+		_ring[ix].ViewProjection = glm::mat4(1.0f);
+		_ring[ix].CameraPosition = glm::vec3(0.0f);
+		_ring[ix].Size = glm::uvec2(0);
+		_ring[ix].Frame = 0;
+	}
+}
+
+HiZBuffer::~HiZBuffer() {
+	for (int ix = 0; ix < RING_SIZE; ix++) {
+		if (_ring[ix].Fence != nullptr) {
+			glDeleteSync(_ring[ix].Fence);
+			_ring[ix].Fence = nullptr;
+		}
+	}
+}
+
+void HiZBuffer::Update(const Texture2D::Sptr& depth, const glm::mat4& viewProjection, const glm::vec3& cameraPosition, const glm::uvec2& region) {
+	LOG_ASSERT(depth != nullptr, "Hi-Z buffer needs a depth texture to build from!");
+	_frame++;
+
+	_CollectReadbacks();
+
+	glm::uvec2 sourceSize = glm::uvec2(depth->GetWidth(), depth->GetHeight());
+	if (sourceSize != _sourceSize) {
+		_ResizeLevels(sourceSize);
+	}
+
+	// Build each level from the one before it, starting from the depth texture. The levels are sized for the
+	// whole depth texture, so when the scene only covers part of it the first level is stretched over that part
+	glm::uvec2 sourceRegion = glm::clamp(region, glm::uvec2(1), sourceSize);
+	GlState::Disable(GL_DEPTH_TEST);
+	GlState::Disable(GL_BLEND);
+	_downsampleShader->Bind();
+	_downsampleShader->SetUniform("u_SourceScale", glm::vec2(sourceRegion) / glm::vec2(sourceSize));
+	_downsampleShader->SetUniform("u_SourceMax", glm::ivec2(sourceRegion) - 1);
+	depth->Bind(SOURCE_SLOT);
+	for (size_t ix = 0; ix < _levels.size(); ix++) {
+		if (ix > 0) {
+			_levels[ix - 1]->BindAttachment(RenderTargetAttachment::Color0, SOURCE_SLOT);
+			_downsampleShader->SetUniform("u_SourceScale", glm::vec2(1.0f));
+			_downsampleShader->SetUniform("u_SourceMax", glm::ivec2(_levels[ix - 1]->GetWidth(), _levels[ix - 1]->GetHeight()) - 1);
+		}
+		_levels[ix]->Bind();
+		glViewport(0, 0, _levels[ix]->GetWidth(), _levels[ix]->GetHeight());
+		_fullscreenQuad->Draw();
+	}
+	_levels.back()->Unbind();
+	GlState::Enable(GL_DEPTH_TEST);
+
+	// If the GPU is still working on the oldest readback, we skip this frame rather than waiting on it
+	Readback& readback = _ring[_nextReadback];
+	if (readback.Fence != nullptr) {
+		return;
+	}
+
+	const Framebuffer::Sptr& last = _levels.back();
+	readback.Size = glm::uvec2(last->GetWidth(), last->GetHeight());
+	readback.ViewProjection = viewProjection;
+	readback.CameraPosition = cameraPosition;
+	readback.Frame = _frame;
+
+	uint32_t texelCount = readback.Size.x * readback.Size.y;
+	if (readback.Buffer->GetElementCount() != texelCount) {
+		readback.Buffer->LoadData<float>(nullptr, texelCount);
+	}
+
+	// With a pixel pack buffer bound, the read goes into the buffer and returns straight away
+	readback.Buffer->Bind();
+	glGetTextureImage(last->GetTextureAttachment(RenderTargetAttachment::Color0)->GetHandle(), 0, GL_RED, GL_FLOAT, texelCount * sizeof(float), nullptr);
+	PixelPackBuffer::UnBind();
+	readback.Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+	_nextReadback = (_nextReadback + 1) % RING_SIZE;
+}
+
+void HiZBuffer::Reset() {
+	for (int ix = 0; ix < RING_SIZE; ix++) {
+		if (_ring[ix].Fence != nullptr) {
+			glDeleteSync(_ring[ix].Fence);
+			_ring[ix].Fence = nullptr;
+		}
+	}
+	_pyramid->Clear();
+	_latency = 0;
+}
+
+void HiZBuffer::_ResizeLevels(const glm::uvec2& sourceSize) {
+	_sourceSize = sourceSize;
+	_levels.clear();
+
+	// Sizes are rounded up, so that the last row and column of an odd sized level are never dropped
+	glm::uvec2 size = sourceSize;
+	do {
+		size = glm::max((size + 1u) / 2u, glm::uvec2(1));
+
+		FramebufferDescriptor desc;
+		desc.Width  = size.x;
+		desc.Height = size.y;
+		desc.RenderTargets[RenderTargetAttachment::Color0] = RenderTargetDescriptor(RenderTargetType::ColorR32F);
+		_levels.push_back(std::make_shared<Framebuffer>(desc));
+	} while (size.x > READBACK_WIDTH && (size.x > 1 || size.y > 1));
+}
+
+void HiZBuffer::_CollectReadbacks() {
+	// Readbacks finish in the order they were started, so walk from the oldest until we find one
+	// that is still in flight, and keep the newest one that has finished
+	int newest = -1;
+	for (int step = 0; step < RING_SIZE; step++) {
+		int ix = (_nextReadback + step) % RING_SIZE;
+		Readback& readback = _ring[ix];
+		if (readback.Fence == nullptr) {
+			continue;
+		}
+
+		GLenum status = glClientWaitSync(readback.Fence, 0, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+			break;
+		}
+		glDeleteSync(readback.Fence);
+		readback.Fence = nullptr;
+		newest = ix;
+	}
+	if (newest < 0) {
+		return;
+	}
+
+	Readback& readback = _ring[newest];
+	const float* data = static_cast<const float*>(readback.Buffer->Map(BufferMapMode::Read));
+	if (data != nullptr) {
+		_pyramid->Build(readback.ViewProjection, readback.CameraPosition, data, readback.Size.x, readback.Size.y);
+		_latency = static_cast<uint32_t>(_frame - readback.Frame);
+	}
+	readback.Buffer->Unmap();
+}
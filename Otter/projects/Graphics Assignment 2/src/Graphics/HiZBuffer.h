@@ -0,0 +1,105 @@
+#pragma once
+#include <vector>
+#include <GLM/glm.hpp>
+
+#include "Graphics/Framebuffer.h"
+#include "Graphics/ShaderProgram.h"
+#include "Graphics/VertexArrayObject.h"
+#include "Graphics/DepthPyramid.h"
+#include "Graphics/Buffers/PixelPackBuffer.h"
+#include "Utils/Macros.h"
+
+/// <summary>
+/// Builds a hierarchical Z (Hi-Z) pyramid from the scene's depth buffer on the GPU, where each level
+/// holds the furthest depth of the 2x2 texels below it, and reads the smallest level back to the CPU
+/// so that the next frames can skip objects that were hidden behind the scene
+///
+/// Reading a texture straight back would stall until the GPU catches up, so each readback is copied
+/// into one of a ring of pixel pack buffers and fenced, and is only mapped once the fence has passed.
+/// The results are a few frames old, so boxes are tested with the camera that the depth was rendered
+/// with. Objects that were hidden on that frame but have since come into view will show up late
+/// </summary>
+class HiZBuffer final {
+public:
+	MAKE_PTRS(HiZBuffer);
+	NO_COPY(HiZBuffer);
+	NO_MOVE(HiZBuffer);
+
+	/// <summary>
+	/// Levels are built until they are no wider than this, and the last level is read back
+	/// </summary>
+	static const uint32_t READBACK_WIDTH = 256;
+	/// <summary>
+	/// The number of readbacks that can be waiting on the GPU at once
+	/// </summary>
+	static const int RING_SIZE = 3;
+	/// <summary>
+	/// The texture slot that the source of each downsample pass is bound to
+	/// </summary>
+	static const int SOURCE_SLOT = 4;
+
+	/// <summary>
+	/// Creates a new Hi-Z buffer
+	/// </summary>
+	/// <param name="fullscreenQuad">The mesh to draw each downsample pass with</param>
+	HiZBuffer(const VertexArrayObject::Sptr& fullscreenQuad);
+	~HiZBuffer();
+
+	/// <summary>
+	/// Collects any readbacks that have finished, then builds the pyramid from the given depth
+	/// texture and starts reading it back. Note that this changes the bound framebuffer and viewport
+	/// </summary>
+	/// <param name="depth">The scene's depth texture</param>
+	/// <param name="viewProjection">The view projection matrix that the depth was rendered with</param>
+	/// <param name="cameraPosition">The world position of the camera that the depth was rendered with</param>
+	/// <param name="region">The size of the region in the bottom left of the depth texture that the scene was rendered into</param>
+	void Update(const Texture2D::Sptr& depth, const glm::mat4& viewProjection, const glm::vec3& cameraPosition, const glm::uvec2& region);
+	/// <summary>
+	/// Throws away the readback results and any readbacks that are in flight, should be called
+	/// when the results are no longer valid, such as when culling is turned back on after a break
+	/// </summary>
+	void Reset();
+
+	/// <summary>
+	/// Gets the most recent readback, along with the camera it was rendered with
+	/// </summary>
+	const DepthPyramid::Sptr& GetPyramid() const { return _pyramid; }
+	/// <summary>
+	/// Gets the number of frames between the most recent readback being rendered and it being collected
+	/// </summary>
+	uint32_t GetLatency() const { return _latency; }
+
+	int GetLevelCount() const { return static_cast<int>(_levels.size()); }
+	/// <summary>
+	/// Gets a level of the GPU side pyramid, level 0 is half the size of the depth texture. The levels
+	/// always cover the whole screen, even if the scene was only rendered into part of the depth texture
+	/// </summary>
+	const Framebuffer::Sptr& GetLevel(int level) const { return _levels[level]; }
+
+private:
+	struct Readback {
+		PixelPackBuffer::Sptr Buffer;
+		GLsync                Fence;
+		glm::mat4             ViewProjection;
+		glm::vec3             CameraPosition;
+		glm::uvec2            Size;
+		uint64_t              Frame;
+	};
+
+	VertexArrayObject::Sptr        _fullscreenQuad;
+	ShaderProgram::Sptr            _downsampleShader;
+	std::vector<Framebuffer::Sptr> _levels;
+	glm::uvec2                     _sourceSize;
+
+	Readback                       _ring[RING_SIZE];
+	// The ring slot that the next readback will use, which is always the oldest
+	int                            _nextReadback;
+	uint64_t                       _frame;
+	uint32_t                       _latency;
+	DepthPyramid::Sptr             _pyramid;
+
+	// Re-creates the levels of the pyramid for a new depth texture size
+	void _ResizeLevels(const glm::uvec2& sourceSize);
+	// Maps the newest readback that the GPU has finished with, and builds the CPU pyramid from it
+	void _CollectReadbacks();
+};
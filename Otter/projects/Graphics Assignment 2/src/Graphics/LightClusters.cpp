@@ -0,0 +1,202 @@
+#include "LightClusters.h"
+#include <cfloat>
+
+#include "Utils/Simd.h"
+
+// Rows of clusters are tested 4 at a time
+static_assert(LightClusters::TILES_X % 4 == 0, "Tiles across must be a multiple of 4");
+
+LightClusters::LightClusters() :
+	_projection(glm::mat4(0.0f)),
+	_nearPlane(0.0f),
+	_farPlane(0.0f),
+	_sliceScale(0.0f),
+	_sliceBias(0.0f),
+	_minX(CLUSTER_COUNT, 0.0f), _minY(CLUSTER_COUNT, 0.0f), _minZ(CLUSTER_COUNT, 0.0f),
+	_maxX(CLUSTER_COUNT, 0.0f), _maxY(CLUSTER_COUNT, 0.0f), _maxZ(CLUSTER_COUNT, 0.0f),
+	_clusters(CLUSTER_COUNT, Cluster{ 0, 0 }),
+	_lightIndices(std::vector<uint32_t>()),
+	_refs(std::vector<LightRef>())
+{ }
+
+void LightClusters::SetProjection(const glm::mat4& projection, float nearPlane, float farPlane) {
+	if (projection == _projection && nearPlane == _nearPlane && farPlane == _farPlane) {
+		return;
+	}
+	_projection = projection;
+	_nearPlane = glm::max(nearPlane, 0.0001f);
+	_farPlane = glm::max(farPlane, _nearPlane * 1.0001f);
+
+	float logRatio = glm::log(_farPlane / _nearPlane);
+	_sliceScale = SLICES / logRatio;
+	_sliceBias = -(SLICES * glm::log(_nearPlane)) / logRatio;
+
+	// Each tile is a ray through each of it's corners, we find the ray by un-projecting the corner onto
+	// the near and far planes, which works for both perspective and orthographic projections
+	glm::mat4 inverseProjection = glm::inverse(projection);
+	auto unproject = [&](float x, float y, float z) {
+		glm::vec4 result = inverseProjection * glm::vec4(x, y, z, 1.0f);
+		return glm::vec3(result) / result.w;
+	};
+
+	for (uint32_t y = 0; y < TILES_Y; y++) {
+		for (uint32_t x = 0; x < TILES_X; x++) {
+			glm::vec3 rayStart[4], rayEnd[4];
+			for (int corner = 0; corner < 4; corner++) {
+				float ndcX = ((x + (corner & 1)) / static_cast<float>(TILES_X)) * 2.0f - 1.0f;
+				float ndcY = ((y + (corner >> 1)) / static_cast<float>(TILES_Y)) * 2.0f - 1.0f;
+				rayStart[corner] = unproject(ndcX, ndcY, -1.0f);
+				rayEnd[corner]   = unproject(ndcX, ndcY, 1.0f);
+			}
+
+			for (uint32_t slice = 0; slice < SLICES; slice++) {
+				float depths[2] = {
+					_nearPlane * glm::pow(_farPlane / _nearPlane, slice / static_cast<float>(SLICES)),
+					_nearPlane * glm::pow(_farPlane / _nearPlane, (slice + 1) / static_cast<float>(SLICES))
+				};
+
+				glm::vec3 min = glm::vec3(FLT_MAX), max = glm::vec3(-FLT_MAX);
+				for (int corner = 0; corner < 4; corner++) {
+					glm::vec3 ray = rayEnd[corner] - rayStart[corner];
+					for (float depth : depths) {
+						// Find where the ray crosses the plane at z = -depth
+						glm::vec3 point = rayStart[corner] + ray * ((-depth - rayStart[corner].z) / ray.z);
+						min = glm::min(min, point);
+						max = glm::max(max, point);
+					}
+				}
+
+				uint32_t index = GetClusterIndex(x, y, slice);
+				_minX[index] = min.x; _minY[index] = min.y; _minZ[index] = min.z;
+				_maxX[index] = max.x; _maxY[index] = max.y; _maxZ[index] = max.z;
+			}
+		}
+	}
+}
+
+uint32_t LightClusters::GetSlice(float depth) const {
+	float slice = glm::log(glm::max(depth, _nearPlane)) * _sliceScale + _sliceBias;
+	return static_cast<uint32_t>(glm::clamp(slice, 0.0f, static_cast<float>(SLICES - 1)));
+}
+
+void LightClusters::GetClusterBounds(uint32_t index, glm::vec3& outMin, glm::vec3& outMax) const {
+	outMin = glm::vec3(_minX[index], _minY[index], _minZ[index]);
+	outMax = glm::vec3(_maxX[index], _maxY[index], _maxZ[index]);
+}
+
+void LightClusters::Build(const glm::vec4* lights, uint32_t count) {
+	_refs.clear();
+
+	for (uint32_t lightIx = 0; lightIx < count; lightIx++) {
+		glm::vec3 center = glm::vec3(lights[lightIx]);
+		float radius = lights[lightIx].w;
+
+		// The camera looks down -Z, so depth is the negated Z coordinate
+		float nearDepth = -center.z - radius;
+		float farDepth  = -center.z + radius;
+		if (farDepth < _nearPlane || nearDepth > _farPlane || radius <= 0.0f) {
+			continue;
+		}
+
+		glm::uvec2 tileMin, tileMax;
+		if (!_GetTileRange(center, radius, tileMin, tileMax)) {
+			continue;
+		}
+		uint32_t sliceMin = GetSlice(nearDepth);
+		uint32_t sliceMax = GetSlice(farDepth);
+
+		// The tile and slice ranges are a conservative box around the light, test the light against
+		// each cluster in that box to throw away the corners that the sphere doesn't reach
+		for (uint32_t slice = sliceMin; slice <= sliceMax; slice++) {
+			for (uint32_t y = tileMin.y; y <= tileMax.y; y++) {
+				uint32_t row = GetClusterIndex(0, y, slice);
+				for (uint32_t x = tileMin.x & ~3u; x <= tileMax.x; x += 4) {
+					uint32_t mask = _TestSphere4(row + x, center, radius);
+					for (uint32_t lane = 0; lane < 4; lane++) {
+						uint32_t tile = x + lane;
+						if ((mask & (1 << lane)) && tile >= tileMin.x && tile <= tileMax.x) {
+							_refs.push_back({ row + tile, lightIx });
+						}
+					}
+				}
+			}
+		}
+	}
+
+	// Counting sort the references by cluster, which keeps the lights in each cluster in order
+	for (Cluster& cluster : _clusters) {
+		cluster.Count = 0;
+	}
+	for (const LightRef& ref : _refs) {
+		_clusters[ref.Cluster].Count++;
+	}
+	uint32_t offset = 0;
+	for (Cluster& cluster : _clusters) {
+		cluster.Offset = offset;
+		offset += cluster.Count;
+		// We re-use count as the write cursor below, and it will end up back where it started
+		cluster.Count = 0;
+	}
+	_lightIndices.resize(_refs.size());
+	for (const LightRef& ref : _refs) {
+		Cluster& cluster = _clusters[ref.Cluster];
+		_lightIndices[cluster.Offset + cluster.Count++] = ref.Light;
+	}
+}
+
+bool LightClusters::_GetTileRange(const glm::vec3& center, float radius, glm::uvec2& outMin, glm::uvec2& outMax) const {
+	outMin = glm::uvec2(0);
+	outMax = glm::uvec2(TILES_X - 1, TILES_Y - 1);
+
+	// Project the corners of the box around the sphere to find the region of the screen that it covers
+	glm::vec2 minNdc = glm::vec2(FLT_MAX), maxNdc = glm::vec2(-FLT_MAX);
+	for (int ix = 0; ix < 8; ix++) {
+		glm::vec3 corner = center + glm::vec3((ix & 1) ? radius : -radius, (ix & 2) ? radius : -radius, (ix & 4) ? radius : -radius);
+		glm::vec4 clip = _projection * glm::vec4(corner, 1.0f);
+		// If the light crosses the camera's plane we can't project it, so it may cover any tile
+		if (clip.w <= 0.0001f) {
+			return true;
+		}
+		glm::vec2 ndc = glm::vec2(clip) / clip.w;
+		minNdc = glm::min(minNdc, ndc);
+		maxNdc = glm::max(maxNdc, ndc);
+	}
+	if (maxNdc.x < -1.0f || maxNdc.y < -1.0f || minNdc.x > 1.0f || minNdc.y > 1.0f) {
+		return false;
+	}
+
+	glm::vec2 tiles = glm::vec2(TILES_X, TILES_Y);
+	glm::vec2 minTile = glm::clamp((minNdc * 0.5f + 0.5f) * tiles, glm::vec2(0.0f), tiles - 1.0f);
+	glm::vec2 maxTile = glm::clamp((maxNdc * 0.5f + 0.5f) * tiles, glm::vec2(0.0f), tiles - 1.0f);
+	outMin = glm::uvec2(minTile);
+	outMax = glm::uvec2(maxTile);
+	return true;
+}
+
+uint32_t LightClusters::_TestSphere4(uint32_t index, const glm::vec3& center, float radius) const {
+	#if SIMD_USE_SSE
+	// The distance from the sphere to the box on each axis is max(min - c, c - max, 0), and the
+	// sphere touches the box if the squared length of those distances is less than radius squared
+	__m128 zero = _mm_setzero_ps();
+	__m128 cx = _mm_set1_ps(center.x);
+	__m128 cy = _mm_set1_ps(center.y);
+	__m128 cz = _mm_set1_ps(center.z);
+	__m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&_minX[index]), cx), _mm_sub_ps(cx, _mm_loadu_ps(&_maxX[index]))), zero);
+	__m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&_minY[index]), cy), _mm_sub_ps(cy, _mm_loadu_ps(&_maxY[index]))), zero);
+	__m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&_minZ[index]), cz), _mm_sub_ps(cz, _mm_loadu_ps(&_maxZ[index]))), zero);
+	__m128 distSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+	return static_cast<uint32_t>(_mm_movemask_ps(_mm_cmple_ps(distSq, _mm_set1_ps(radius * radius))));
+	#else
+	uint32_t result = 0;
+	for (uint32_t lane = 0; lane < 4; lane++) {
+		uint32_t ix = index + lane;
+		glm::vec3 distance = glm::max(glm::max(
+			glm::vec3(_minX[ix], _minY[ix], _minZ[ix]) - center,
+			center - glm::vec3(_maxX[ix], _maxY[ix], _maxZ[ix])), glm::vec3(0.0f));
+		if (glm::dot(distance, distance) <= radius * radius) {
+			result |= 1 << lane;
+		}
+	}
+	return result;
+	#endif
+}
@@ -0,0 +1,120 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <GLM/glm.hpp>
+
+#include "Utils/Macros.h"
+
+/// <summary>
+/// Bins point lights into clusters (froxels), which split the camera's view into a grid of screen tiles,
+/// and further split each tile into slices by depth. This lets the lighting shader only consider the lights
+/// that can reach the cluster a pixel is in, instead of every light in the scene
+///
+/// Depth slices are spaced exponentially, so clusters stay roughly cube shaped as they get further
+/// from the camera. Binning is done on the CPU without touching OpenGL (LightClustersTests checks it against
+/// a brute force search). The results are a list of light indices, and an (offset, count) pair into that list for each cluster
+/// </summary>
+class LightClusters final {
+public:
+	MAKE_PTRS(LightClusters);
+	NO_COPY(LightClusters);
+	NO_MOVE(LightClusters);
+
+	/// <summary>
+	/// The number of screen tiles across and down, and the number of depth slices
+	/// </summary>
+	static const uint32_t TILES_X = 16;
+	static const uint32_t TILES_Y = 9;
+	static const uint32_t SLICES  = 24;
+	static const uint32_t CLUSTER_COUNT = TILES_X * TILES_Y * SLICES;
+
+	/// <summary>
+	/// The range of the light index list that belongs to a single cluster, matches
+	/// the uvec2 layout used by light_accumulation.glsl
+	/// </summary>
+	struct Cluster {
+		uint32_t Offset;
+		uint32_t Count;
+	};
+
+	LightClusters();
+	~LightClusters() = default;
+
+	/// <summary>
+	/// Sets the camera projection that the clusters are built from, the bounds of the clusters are only
+	/// re-calculated when the projection changes
+	/// </summary>
+	/// <param name="projection">The camera's projection matrix</param>
+	/// <param name="nearPlane">The camera's near clip plane</param>
+	/// <param name="farPlane">The camera's far clip plane</param>
+	void SetProjection(const glm::mat4& projection, float nearPlane, float farPlane);
+
+	/// <summary>
+	/// Bins lights into the clusters, replacing the results of the last call
+	/// </summary>
+	/// <param name="lights">The lights' bounding spheres in view space, with the center in xyz and the radius in w</param>
+	/// <param name="count">The number of lights</param>
+	void Build(const glm::vec4* lights, uint32_t count);
+
+	/// <summary>
+	/// Gets the index of a cluster in the cluster list
+	/// </summary>
+	static uint32_t GetClusterIndex(uint32_t x, uint32_t y, uint32_t slice) {
+		return (slice * TILES_Y + y) * TILES_X + x;
+	}
+	/// <summary>
+	/// Gets the depth slice that a view depth falls into
+	/// </summary>
+	/// <param name="depth">The distance along the camera's forward axis</param>
+	uint32_t GetSlice(float depth) const;
+
+	/// <summary>
+	/// Gets the scale and bias that map log(depth) to a slice index, so that shaders can find the
+	/// slice a pixel is in with a single multiply-add, as floor(log(depth) * scale + bias)
+	/// </summary>
+	glm::vec2 GetSliceParams() const { return glm::vec2(_sliceScale, _sliceBias); }
+
+	/// <summary>
+	/// Gets the light list range for each cluster, see GetClusterIndex
+	/// </summary>
+	const std::vector<Cluster>& GetClusters() const { return _clusters; }
+	/// <summary>
+	/// Gets the indices of the lights that touch each cluster, sorted by cluster
+	/// </summary>
+	const std::vector<uint32_t>& GetLightIndices() const { return _lightIndices; }
+
+	/// <summary>
+	/// Gets the view space bounding box of a cluster
+	/// </summary>
+	/// <param name="index">The index of the cluster, see GetClusterIndex</param>
+	/// <param name="outMin">Receives the minimum corner of the cluster's bounds</param>
+	/// <param name="outMax">Receives the maximum corner of the cluster's bounds</param>
+	void GetClusterBounds(uint32_t index, glm::vec3& outMin, glm::vec3& outMax) const;
+
+private:
+	struct LightRef {
+		uint32_t Cluster;
+		uint32_t Light;
+	};
+
+	glm::mat4 _projection;
+	float     _nearPlane;
+	float     _farPlane;
+	float     _sliceScale;
+	float     _sliceBias;
+
+	// View space cluster bounds, stored as separate arrays so that 4 clusters next to each other on
+	// the X axis can be tested against a light at once
+	std::vector<float> _minX, _minY, _minZ;
+	std::vector<float> _maxX, _maxY, _maxZ;
+
+	std::vector<Cluster>  _clusters;
+	std::vector<uint32_t> _lightIndices;
+	// Every cluster that each light touches, these are sorted into _lightIndices
+	std::vector<LightRef> _refs;
+
+	// Finds the range of screen tiles that a light's bounding sphere covers, returns false if it is off screen
+	bool _GetTileRange(const glm::vec3& center, float radius, glm::uvec2& outMin, glm::uvec2& outMax) const;
+	// Tests a sphere against the 4 clusters starting at the given index, returning a bit mask of the clusters that it touches
+	uint32_t _TestSphere4(uint32_t index, const glm::vec3& center, float radius) const;
+};
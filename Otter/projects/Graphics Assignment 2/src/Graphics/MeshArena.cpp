@@ -0,0 +1,294 @@
+#include "MeshArena.h"
+#include <algorithm>
+#include <GLM/glm.hpp>
+
+#include "Graphics/Buffers/VertexBuffer.h"
+#include "Graphics/Buffers/IndexBuffer.h"
+#include "Logging.h"
+
+std::vector<MeshArena::Sptr> MeshArena::_arenas = std::vector<MeshArena::Sptr>();
+
+// Returns true if two vertex layouts will read vertex data in the exact same way
+static bool LayoutsMatch(const VertexArrayObject::VertexDeclaration& a, const VertexArrayObject::VertexDeclaration& b) {
+	if (a.size() != b.size()) {
+		return false;
+	}
+	for (size_t ix = 0; ix < a.size(); ix++) {
+		if (a[ix].Slot != b[ix].Slot || a[ix].Size != b[ix].Size || a[ix].Type != b[ix].Type ||
+			a[ix].Normalized != b[ix].Normalized || a[ix].Stride != b[ix].Stride || a[ix].Offset != b[ix].Offset) {
+			return false;
+		}
+	}
+	return true;
+}
+
+MeshArena::Block::Block(const MeshArena::Sptr& arena, bool isIndex, uint32_t offset, uint32_t count) :
+	_arena(arena),
+	_isIndex(isIndex),
+	_offset(offset),
+	_count(count)
+{ }
+
+MeshArena::Block::~Block() {
+	MeshArena::Sptr arena = _arena.lock();
+	if (arena != nullptr) {
+		arena->_Release(this);
+	}
+}
+
+MeshArena::MeshArena(const VertexArrayObject::VertexDeclaration& vDecl) :
+	_vDecl(vDecl),
+	_vao(nullptr),
+	_instanceBuffer(nullptr),
+	_instanceAttributes(VertexArrayObject::VertexDeclaration()),
+	_vertices(Heap()),
+	_indices(Heap())
+{
+	LOG_ASSERT(!vDecl.empty(), "Mesh arenas require a vertex layout!");
+
+	_vertices.Buffer = nullptr;
+	_vertices.ElementSize = vDecl[0].Stride;
+	_vertices.Capacity = 0;
+	_vertices.Used = 0;
+	_vertices.IsIndex = false;
+
+	_indices.Buffer = nullptr;
+	_indices.ElementSize = sizeof(uint32_t);
+	_indices.Capacity = 0;
+	_indices.Used = 0;
+	_indices.IsIndex = true;
+}
+
+MeshArena::~MeshArena() = default;
+
+MeshArena::Sptr MeshArena::Get(const VertexArrayObject::VertexDeclaration& vDecl) {
+	for (const auto& arena : _arenas) {
+		if (LayoutsMatch(arena->_vDecl, vDecl)) {
+			return arena;
+		}
+	}
+	MeshArena::Sptr result = std::make_shared<MeshArena>(vDecl);
+	_arenas.push_back(result);
+	return result;
+}
+
+const std::vector<MeshArena::Sptr>& MeshArena::GetArenas() {
+	return _arenas;
+}
+
+void MeshArena::DefragmentAll(float maxFragmentation) {
+	for (const auto& arena : _arenas) {
+		if (arena->GetFragmentation() > maxFragmentation) {
+			arena->Defragment();
+		}
+	}
+}
+
+void MeshArena::ReleaseAll() {
+	_arenas.clear();
+}
+
+MeshArena::Block::Sptr MeshArena::AllocateVertices(const void* data, uint32_t count) {
+	return _AllocateBlock(_vertices, data, count);
+}
+
+MeshArena::Block::Sptr MeshArena::AllocateIndices(const uint32_t* data, uint32_t count) {
+	return _AllocateBlock(_indices, data, count);
+}
+
+void MeshArena::Defragment() {
+	uint32_t vertexGaps = _GetGapCount(_vertices);
+	uint32_t indexGaps  = _GetGapCount(_indices);
+	if (vertexGaps > 0) {
+		_Repack(_vertices, _vertices.Capacity);
+	}
+	if (indexGaps > 0) {
+		_Repack(_indices, _indices.Capacity);
+	}
+	if (vertexGaps > 0 || indexGaps > 0) {
+		LOG_TRACE("Defragmented mesh arena, recovered {} vertices and {} indices", vertexGaps, indexGaps);
+	}
+}
+
+float MeshArena::GetFragmentation() const {
+	float vertexFrag = _vertices.Capacity > 0 ? _GetGapCount(_vertices) / static_cast<float>(_vertices.Capacity) : 0.0f;
+	float indexFrag  = _indices.Capacity > 0 ? _GetGapCount(_indices) / static_cast<float>(_indices.Capacity) : 0.0f;
+	return glm::max(vertexFrag, indexFrag);
+}
+
+void MeshArena::Bind() {
+	if (_vao != nullptr) {
+		_vao->Bind();
+	}
+}
+
+void MeshArena::Draw(const Block& vertices, const Block& indices, DrawMode mode) {
+	glDrawElementsBaseVertex((GLenum)mode, indices._count, (GLenum)IndexType::UInt,
+							 (void*)(static_cast<size_t>(indices._offset) * sizeof(uint32_t)), static_cast<GLint>(vertices._offset));
+}
+
+void MeshArena::DrawInstanced(const Block& vertices, const Block& indices, uint32_t instanceCount, uint32_t baseInstance, DrawMode mode) {
+	glDrawElementsInstancedBaseVertexBaseInstance((GLenum)mode, indices._count, (GLenum)IndexType::UInt,
+		(void*)(static_cast<size_t>(indices._offset) * sizeof(uint32_t)), instanceCount, static_cast<GLint>(vertices._offset), baseInstance);
+}
+
+void MeshArena::SetInstanceBuffer(const VertexBuffer::Sptr& buffer, const VertexArrayObject::VertexDeclaration& attributes) {
+	_instanceBuffer = buffer;
+	_instanceAttributes = attributes;
+	_RebuildVao();
+}
+
+MeshArena::Block::Sptr MeshArena::_AllocateBlock(Heap& heap, const void* data, uint32_t count) {
+	if (count == 0) {
+		return nullptr;
+	}
+
+	uint32_t offset = 0;
+	if (!_TryAllocate(heap, count, offset)) {
+		// If there's enough free space but it's split up, packing the heap is enough, otherwise we need
+		// to grow the buffer (which packs it as well)
+		if (heap.Capacity - heap.Used >= count) {
+			_Repack(heap, heap.Capacity);
+		} else {
+			uint32_t capacity = heap.IsIndex ? INITIAL_INDEX_CAPACITY : INITIAL_VERTEX_CAPACITY;
+			capacity = glm::max(capacity, heap.Capacity * 2);
+			_Repack(heap, glm::max(capacity, heap.Used + count));
+		}
+		bool success = _TryAllocate(heap, count, offset);
+		LOG_ASSERT(success, "Failed to allocate from mesh arena after resizing!");
+	}
+
+	glNamedBufferSubData(heap.Buffer->GetHandle(), static_cast<GLintptr>(offset) * heap.ElementSize, static_cast<GLsizeiptr>(count) * heap.ElementSize, data);
+
+	Block::Sptr result = std::make_shared<Block>(shared_from_this(), heap.IsIndex, offset, count);
+	heap.Blocks.push_back(result.get());
+	return result;
+}
+
+void MeshArena::_Release(Block* block) {
+	Heap& heap = block->_isIndex ? _indices : _vertices;
+	auto it = std::find(heap.Blocks.begin(), heap.Blocks.end(), block);
+	if (it != heap.Blocks.end()) {
+		*it = heap.Blocks.back();
+		heap.Blocks.pop_back();
+		_Free(heap, block->_offset, block->_count);
+	}
+}
+
+bool MeshArena::_TryAllocate(Heap& heap, uint32_t count, uint32_t& offset) {
+	for (auto it = heap.FreeList.begin(); it != heap.FreeList.end(); it++) {
+		if (it->Count >= count) {
+			offset = it->Offset;
+			it->Offset += count;
+			it->Count  -= count;
+			if (it->Count == 0) {
+				heap.FreeList.erase(it);
+			}
+			heap.Used += count;
+			return true;
+		}
+	}
+	return false;
+}
+
+void MeshArena::_Free(Heap& heap, uint32_t offset, uint32_t count) {
+	auto it = std::lower_bound(heap.FreeList.begin(), heap.FreeList.end(), offset, [](const Range& range, uint32_t value) {
+		return range.Offset < value;
+	});
+	it = heap.FreeList.insert(it, { offset, count });
+
+	// Merge with the range after us
+	auto next = it + 1;
+	if (next != heap.FreeList.end() && it->Offset + it->Count == next->Offset) {
+		it->Count += next->Count;
+		it = heap.FreeList.erase(next) - 1;
+	}
+	// Merge with the range before us
+	if (it != heap.FreeList.begin()) {
+		auto prev = it - 1;
+		if (prev->Offset + prev->Count == it->Offset) {
+			prev->Count += it->Count;
+			heap.FreeList.erase(it);
+		}
+	}
+
+	heap.Used -= count;
+}
+
+uint32_t MeshArena::_GetGapCount(const Heap& heap) {
+	uint32_t free = heap.Capacity - heap.Used;
+	// The range at the end of the heap is not a gap, since new blocks can be placed there
+	if (!heap.FreeList.empty()) {
+		const Range& last = heap.FreeList.back();
+		if (last.Offset + last.Count == heap.Capacity) {
+			free -= last.Count;
+		}
+	}
+	return free;
+}
+
+void MeshArena::_Repack(Heap& heap, uint32_t capacity) {
+	IBuffer::Sptr buffer = nullptr;
+	if (heap.IsIndex) {
+		IndexBuffer::Sptr ibo = IndexBuffer::Create(BufferUsage::StaticDraw);
+		ibo->LoadData(nullptr, heap.ElementSize, capacity, IndexType::UInt);
+		buffer = ibo;
+	} else {
+		VertexBuffer::Sptr vbo = VertexBuffer::Create(BufferUsage::StaticDraw);
+		vbo->LoadData(nullptr, heap.ElementSize, capacity);
+		buffer = vbo;
+	}
+
+	// Walk the blocks in order, so that blocks that were already next to each other can be moved
+	// with a single copy
+	std::sort(heap.Blocks.begin(), heap.Blocks.end(), [](const Block* a, const Block* b) {
+		return a->_offset < b->_offset;
+	});
+	uint32_t cursor = 0;
+	uint32_t runSource = 0, runDest = 0, runCount = 0;
+	for (Block* block : heap.Blocks) {
+		if (runCount > 0 && runSource + runCount != block->_offset) {
+			glCopyNamedBufferSubData(heap.Buffer->GetHandle(), buffer->GetHandle(),
+				static_cast<GLintptr>(runSource) * heap.ElementSize, static_cast<GLintptr>(runDest) * heap.ElementSize, static_cast<GLsizeiptr>(runCount) * heap.ElementSize);
+			runCount = 0;
+		}
+		if (runCount == 0) {
+			runSource = block->_offset;
+			runDest = cursor;
+		}
+		runCount += block->_count;
+		block->_offset = cursor;
+		cursor += block->_count;
+	}
+	if (runCount > 0) {
+		glCopyNamedBufferSubData(heap.Buffer->GetHandle(), buffer->GetHandle(),
+			static_cast<GLintptr>(runSource) * heap.ElementSize, static_cast<GLintptr>(runDest) * heap.ElementSize, static_cast<GLsizeiptr>(runCount) * heap.ElementSize);
+	}
+
+	heap.FreeList.clear();
+	if (capacity > cursor) {
+		heap.FreeList.push_back({ cursor, capacity - cursor });
+	}
+	heap.Buffer = buffer;
+	heap.Capacity = capacity;
+	heap.Used = cursor;
+
+	_RebuildVao();
+}
+
+void MeshArena::_RebuildVao() {
+	_vao = nullptr;
+	if (_vertices.Buffer == nullptr) {
+		return;
+	}
+	_vao = VertexArrayObject::Create();
+	_vao->AddVertexBuffer(std::static_pointer_cast<VertexBuffer>(_vertices.Buffer), _vDecl);
+	if (_indices.Buffer != nullptr) {
+		_vao->SetIndexBuffer(std::static_pointer_cast<IndexBuffer>(_indices.Buffer));
+	}
+	if (_instanceBuffer != nullptr) {
+		_vao->AddVertexBuffer(_instanceBuffer, _instanceAttributes, true);
+	}
+	_vao->SetVDecl(_vDecl);
+	_vao->SetDebugName("Mesh Arena");
+}
@@ -0,0 +1,218 @@
+#pragma once
+#include <vector>
+#include <memory>
+
+#include "Graphics/VertexArrayObject.h"
+#include "Utils/Macros.h"
+
+/// <summary>
+/// A mesh arena packs the vertices and indices of many static meshes that share a vertex layout into
+/// a single large vertex buffer and index buffer, which are wrapped by a single VAO. Meshes sub-allocate
+/// ranges from the arena and are drawn with glDrawElementsBaseVertex, so consecutive draws from the
+/// same arena do not need to switch VAOs
+///
+/// Indices are stored relative to the start of the mesh's vertex range, so vertex and index ranges
+/// can be moved independently when the arena grows or is defragmented
+/// </summary>
+class MeshArena final : public std::enable_shared_from_this<MeshArena>
+{
+public:
+	DEFINE_RESOURCE(MeshArena);
+
+	/// <summary>
+	/// The number of vertices we allocate space for when an arena is first used
+	/// </summary>
+	static const uint32_t INITIAL_VERTEX_CAPACITY = 1 << 16;
+	/// <summary>
+	/// The number of indices we allocate space for when an arena is first used
+	/// </summary>
+	static const uint32_t INITIAL_INDEX_CAPACITY = 1 << 18;
+
+	/// <summary>
+	/// A range of vertices or indices that has been allocated from an arena. The range is returned to
+	/// the arena when the block is destroyed. Note that the offset of a block will change when the
+	/// arena grows or is defragmented, so it should be read at draw time rather than cached
+	/// </summary>
+	class Block final {
+	public:
+		MAKE_PTRS(Block);
+		NO_MOVE(Block);
+		NO_COPY(Block);
+
+		Block(const MeshArena::Sptr& arena, bool isIndex, uint32_t offset, uint32_t count);
+		~Block();
+
+		/// <summary>
+		/// Gets the arena that this block was allocated from, or nullptr if the arena has been released
+		/// </summary>
+		MeshArena::Sptr GetArena() const { return _arena.lock(); }
+		/// <summary>
+		/// Gets the offset of the first element in this block, in elements
+		/// </summary>
+		uint32_t GetOffset() const { return _offset; }
+		/// <summary>
+		/// Gets the number of elements in this block
+		/// </summary>
+		uint32_t GetCount() const { return _count; }
+		/// <summary>
+		/// Returns true if this block is a range of indices, false if it is a range of vertices
+		/// </summary>
+		bool IsIndexBlock() const { return _isIndex; }
+
+	private:
+		friend class MeshArena;
+
+		MeshArena::Wptr _arena;
+		bool            _isIndex;
+		uint32_t        _offset;
+		uint32_t        _count;
+	};
+
+	/// <summary>
+	/// Creates a new empty arena for the given vertex layout, note that the arenas should normally
+	/// be retrieved via MeshArena::Get so that meshes with the same layout share an arena
+	/// </summary>
+	/// <param name="vDecl">The vertex layout of the meshes in this arena</param>
+	MeshArena(const VertexArrayObject::VertexDeclaration& vDecl);
+	~MeshArena();
+
+	/// <summary>
+	/// Gets the arena for the given vertex layout, creating it if it does not exist yet
+	/// </summary>
+	/// <param name="vDecl">The vertex layout to get the arena for</param>
+	static MeshArena::Sptr Get(const VertexArrayObject::VertexDeclaration& vDecl);
+	/// <summary>
+	/// Gets all the arenas that have been created
+	/// </summary>
+	static const std::vector<MeshArena::Sptr>& GetArenas();
+	/// <summary>
+	/// Defragments all arenas where gaps between allocations make up more than the given fraction
+	/// of the arena. This is cheap to call every frame, as it only does work when an arena needs it
+	/// </summary>
+	/// <param name="maxFragmentation">The fraction of the arena that may be lost to gaps before it is compacted</param>
+	static void DefragmentAll(float maxFragmentation = 0.25f);
+	/// <summary>
+	/// Releases all arenas and their OpenGL buffers. Any blocks that are still alive will no longer
+	/// be drawable, so this should only be called when shutting down
+	/// </summary>
+	static void ReleaseAll();
+
+	/// <summary>
+	/// Allocates a range of vertices from this arena and uploads the data into it
+	/// </summary>
+	/// <param name="data">The vertex data to upload, must match the arena's vertex layout</param>
+	/// <param name="count">The number of vertices in data</param>
+	/// <returns>The block of vertices that was allocated</returns>
+	Block::Sptr AllocateVertices(const void* data, uint32_t count);
+	/// <summary>
+	/// Allocates a range of indices from this arena and uploads the data into it. Indices should
+	/// be relative to the start of the vertex block they will be drawn with
+	/// </summary>
+	/// <param name="data">The indices to upload</param>
+	/// <param name="count">The number of indices in data</param>
+	/// <returns>The block of indices that was allocated</returns>
+	Block::Sptr AllocateIndices(const uint32_t* data, uint32_t count);
+
+	/// <summary>
+	/// Packs all the allocated blocks to the start of the arena, removing any gaps left behind
+	/// by meshes that have been released
+	/// </summary>
+	void Defragment();
+	/// <summary>
+	/// Gets the fraction of this arena that is lost to gaps between allocated blocks, this is the
+	/// space that would be recovered by calling Defragment
+	/// </summary>
+	float GetFragmentation() const;
+
+	/// <summary>
+	/// Binds the arena's VAO as the source of data for draw operations
+	/// </summary>
+	void Bind();
+	/// <summary>
+	/// Draws a range of indices from this arena, note that the arena must already be bound
+	/// </summary>
+	/// <param name="vertices">The block of vertices that the indices refer to</param>
+	/// <param name="indices">The block of indices to draw</param>
+	/// <param name="mode">The primitive mode for rendering the mesh</param>
+	void Draw(const Block& vertices, const Block& indices, DrawMode mode = DrawMode::TriangleList);
+	/// <summary>
+	/// Draws multiple instances of a range of indices from this arena, note that the arena must
+	/// already be bound
+	/// </summary>
+	/// <param name="vertices">The block of vertices that the indices refer to</param>
+	/// <param name="indices">The block of indices to draw</param>
+	/// <param name="instanceCount">The number of instances to draw</param>
+	/// <param name="baseInstance">The index of the first instance to read from the instance buffer</param>
+	/// <param name="mode">The primitive mode for rendering the mesh</param>
+	void DrawInstanced(const Block& vertices, const Block& indices, uint32_t instanceCount, uint32_t baseInstance, DrawMode mode = DrawMode::TriangleList);
+
+	/// <summary>
+	/// Attaches a buffer of per-instance attributes to the arena's VAO. The buffer stays attached
+	/// when the arena is resized or defragmented. Note that this may replace the VAO, so the arena
+	/// should be bound after calling this
+	/// </summary>
+	/// <param name="buffer">The buffer containing one element per instance</param>
+	/// <param name="attributes">The instanced attributes stored in the buffer</param>
+	void SetInstanceBuffer(const VertexBuffer::Sptr& buffer, const VertexArrayObject::VertexDeclaration& attributes);
+	/// <summary>
+	/// Gets the buffer of per-instance attributes attached to this arena, may be nullptr
+	/// </summary>
+	const VertexBuffer::Sptr& GetInstanceBuffer() const { return _instanceBuffer; }
+
+	/// <summary>
+	/// Gets the vertex layout of the meshes in this arena
+	/// </summary>
+	const VertexArrayObject::VertexDeclaration& GetVDecl() const { return _vDecl; }
+	/// <summary>
+	/// Gets the VAO that wraps around this arena's buffers, may be nullptr if nothing has been allocated
+	/// </summary>
+	const VertexArrayObject::Sptr& GetVao() const { return _vao; }
+
+	uint32_t GetVertexCapacity() const { return _vertices.Capacity; }
+	uint32_t GetVertexCount() const { return _vertices.Used; }
+	uint32_t GetIndexCapacity() const { return _indices.Capacity; }
+	uint32_t GetIndexCount() const { return _indices.Used; }
+
+private:
+	// A contiguous range of free elements within a heap
+	struct Range {
+		uint32_t Offset;
+		uint32_t Count;
+	};
+
+	// One of the two buffers that make up the arena, along with the book keeping for the allocator
+	struct Heap {
+		IBuffer::Sptr       Buffer;
+		uint32_t            ElementSize;
+		uint32_t            Capacity;
+		uint32_t            Used;
+		// Free ranges, sorted by offset. Neighbouring ranges are always merged
+		std::vector<Range>  FreeList;
+		// All blocks that are currently allocated from this heap
+		std::vector<Block*> Blocks;
+		bool                IsIndex;
+	};
+
+	VertexArrayObject::VertexDeclaration _vDecl;
+	VertexArrayObject::Sptr _vao;
+	VertexBuffer::Sptr _instanceBuffer;
+	VertexArrayObject::VertexDeclaration _instanceAttributes;
+	Heap _vertices;
+	Heap _indices;
+
+	static std::vector<MeshArena::Sptr> _arenas;
+
+	Block::Sptr _AllocateBlock(Heap& heap, const void* data, uint32_t count);
+	void _Release(Block* block);
+
+	// First fit search of the free list, returns false if no range is large enough
+	static bool _TryAllocate(Heap& heap, uint32_t count, uint32_t& offset);
+	// Returns a range to the free list, merging it with it's neighbours
+	static void _Free(Heap& heap, uint32_t offset, uint32_t count);
+	// Returns the number of free elements in the heap that are not part of the range at the end of the heap
+	static uint32_t _GetGapCount(const Heap& heap);
+	// Copies all blocks into a new buffer with the given capacity, packed to the start of the buffer
+	void _Repack(Heap& heap, uint32_t capacity);
+	// Re-creates the VAO after one of our buffers has been replaced
+	void _RebuildVao();
+};
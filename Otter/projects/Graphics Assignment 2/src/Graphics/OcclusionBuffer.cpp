@@ -0,0 +1,282 @@
+#include "OcclusionBuffer.h"
+#include <algorithm>
+
+#include "Logging.h"
+#include "Utils/Simd.h"
+
+// Rows are rasterized and tested 4 pixels at a time
+static_assert(OcclusionBuffer::TILE_WIDTH % 4 == 0, "Tile width must be a multiple of 4");
+
+// The number of binned triangles each thread should have before it's worth waking up another one
+const size_t OCCLUSION_MIN_TRIS_PER_THREAD = 256;
+
+OcclusionBuffer::OcclusionBuffer(uint32_t width, uint32_t height) :
+	_width(width),
+	_height(height),
+	_tilesX(width / TILE_WIDTH),
+	_tilesY(height / TILE_HEIGHT),
+	_viewProjection(glm::mat4(1.0f)),
+	_depth(width * height, 1.0f),
+	_triangles(std::vector<Triangle>()),
+	_bins((width / TILE_WIDTH) * (height / TILE_HEIGHT)),
+	_useSimd(SIMD_USE_SSE != 0)
+{
+	LOG_ASSERT(width > 0 && height > 0 && width % TILE_WIDTH == 0 && height % TILE_HEIGHT == 0,
+		"Occlusion buffer size must be a non-zero multiple of the tile size!");
+}
+
+void OcclusionBuffer::Begin(const glm::mat4& viewProjection) {
+	_viewProjection = viewProjection;
+	std::fill(_depth.begin(), _depth.end(), 1.0f);
+	_triangles.clear();
+	for (auto& bin : _bins) {
+		bin.clear();
+	}
+}
+
+void OcclusionBuffer::AddOccluder(const glm::mat4& transform, const glm::vec3* vertices, const uint32_t* indices, size_t indexCount) {
+	glm::mat4 mvp = _viewProjection * transform;
+	for (size_t ix = 0; ix + 2 < indexCount; ix += 3) {
+		glm::vec4 clip[3] = {
+			mvp * glm::vec4(vertices[indices[ix + 0]], 1.0f),
+			mvp * glm::vec4(vertices[indices[ix + 1]], 1.0f),
+			mvp * glm::vec4(vertices[indices[ix + 2]], 1.0f)
+		};
+
+		// Skip triangles that are entirely outside one of the side planes, there's no need
+		// to clip against them since the rasterizer only visits pixels on screen
+		bool outside = false;
+		for (int axis = 0; axis < 2 && !outside; axis++) {
+			outside =
+				(clip[0][axis] >  clip[0].w && clip[1][axis] >  clip[1].w && clip[2][axis] >  clip[2].w) ||
+				(clip[0][axis] < -clip[0].w && clip[1][axis] < -clip[1].w && clip[2][axis] < -clip[2].w);
+		}
+		if (!outside) {
+			_AddClipped(clip);
+		}
+	}
+}
+
+void OcclusionBuffer::_AddClipped(const glm::vec4* clip) {
+	// Clip against the near plane (z >= -w), which leaves us with up to 4 vertices
+	glm::vec4 polygon[4];
+	int count = 0;
+	for (int ix = 0; ix < 3; ix++) {
+		const glm::vec4& current = clip[ix];
+		const glm::vec4& next = clip[(ix + 1) % 3];
+		float currentDist = current.z + current.w;
+		float nextDist = next.z + next.w;
+
+		if (currentDist >= 0.0f) {
+			polygon[count++] = current;
+		}
+		if ((currentDist >= 0.0f) != (nextDist >= 0.0f)) {
+			polygon[count++] = glm::mix(current, next, currentDist / (currentDist - nextDist));
+		}
+	}
+	if (count < 3) {
+		return;
+	}
+
+	// Project to pixels, with depth remapped from [-1, 1] to [0, 1]
+	glm::vec3 screen[4];
+	glm::vec2 size = glm::vec2(_width, _height);
+	for (int ix = 0; ix < count; ix++) {
+		glm::vec3 ndc = glm::vec3(polygon[ix]) / polygon[ix].w;
+		screen[ix] = glm::vec3((glm::vec2(ndc) * 0.5f + 0.5f) * size, ndc.z * 0.5f + 0.5f);
+	}
+
+	_AddTriangle(screen[0], screen[1], screen[2]);
+	if (count == 4) {
+		_AddTriangle(screen[0], screen[2], screen[3]);
+	}
+}
+
+void OcclusionBuffer::_AddTriangle(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c) {
+	float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+	if (glm::abs(area) < 1e-6f) {
+		return;
+	}
+
+	// Find the pixels whose centers could be inside the triangle
+	glm::vec2 minPos = glm::min(glm::vec2(a), glm::min(glm::vec2(b), glm::vec2(c)));
+	glm::vec2 maxPos = glm::max(glm::vec2(a), glm::max(glm::vec2(b), glm::vec2(c)));
+	glm::vec2 minPixel = glm::max(glm::ceil(minPos - 0.5f), glm::vec2(0.0f));
+	glm::vec2 maxPixel = glm::min(glm::floor(maxPos - 0.5f), glm::vec2(_width - 1, _height - 1));
+	if (minPixel.x > maxPixel.x || minPixel.y > maxPixel.y) {
+		return;
+	}
+
+	Triangle result;
+	result.Min = glm::ivec2(minPixel);
+	result.Max = glm::ivec2(maxPixel);
+
+	// Each edge is opposite a vertex, and we flip them for clockwise triangles so that the
+	// inside is always positive, since occluders are drawn from both sides
+	const glm::vec3* verts[3] = { &a, &b, &c };
+	float sign = area > 0.0f ? 1.0f : -1.0f;
+	for (int ix = 0; ix < 3; ix++) {
+		const glm::vec3& from = *verts[(ix + 1) % 3];
+		const glm::vec3& to = *verts[(ix + 2) % 3];
+		result.EdgeA[ix] = (from.y - to.y) * sign;
+		result.EdgeB[ix] = (to.x - from.x) * sign;
+		result.EdgeC[ix] = (from.x * to.y - from.y * to.x) * sign;
+	}
+
+	// The edge functions divided by the area are the barycentric coordinates, so we can build
+	// the depth plane out of them
+	area *= sign;
+	result.DepthPlane = glm::vec3(0.0f);
+	for (int ix = 0; ix < 3; ix++) {
+		result.DepthPlane += glm::vec3(result.EdgeA[ix], result.EdgeB[ix], result.EdgeC[ix]) * (verts[ix]->z / area);
+	}
+	// We only sample the plane at pixel centers, so push it back by the most it can change between
+	// the center and the corner of a pixel, but never past the furthest vertex
+	result.DepthPlane.z += 0.5f * (glm::abs(result.DepthPlane.x) + glm::abs(result.DepthPlane.y));
+	result.MaxDepth = glm::max(a.z, glm::max(b.z, c.z));
+
+	uint32_t index = static_cast<uint32_t>(_triangles.size());
+	_triangles.push_back(result);
+
+	for (int y = result.Min.y / TILE_HEIGHT; y <= result.Max.y / static_cast<int>(TILE_HEIGHT); y++) {
+		for (int x = result.Min.x / TILE_WIDTH; x <= result.Max.x / static_cast<int>(TILE_WIDTH); x++) {
+			_bins[y * _tilesX + x].push_back(index);
+		}
+	}
+}
+
+void OcclusionBuffer::Rasterize(WorkerPool& pool) {
+	size_t work = 0;
+	for (const auto& bin : _bins) {
+		work += bin.size();
+	}
+	if (work == 0) {
+		return;
+	}
+
+	// Only go wide if there's enough triangles to make up for waking up the workers
+	size_t threadCount = glm::clamp<size_t>(work / OCCLUSION_MIN_TRIS_PER_THREAD, 1, glm::min(pool.GetThreadCount(), _bins.size()));
+
+	// Tiles are handed out in turn rather than in blocks, since occluders tend to bunch up on
+	// one part of the screen. Tiles never share pixels, so no locking is needed
+	pool.Run(threadCount, [&](size_t thread) {
+		for (size_t tile = thread; tile < _bins.size(); tile += threadCount) {
+			_RasterizeTile(static_cast<uint32_t>(tile));
+		}
+	});
+}
+
+void OcclusionBuffer::_RasterizeTile(uint32_t tile) {
+	const int tileX = static_cast<int>((tile % _tilesX) * TILE_WIDTH);
+	const int tileY = static_cast<int>((tile / _tilesX) * TILE_HEIGHT);
+
+	for (uint32_t triIx : _bins[tile]) {
+		const Triangle& tri = _triangles[triIx];
+
+		// Start on a multiple of 4 so that every group of pixels stays inside the tile
+		int minX = glm::max(tri.Min.x, tileX) & ~3;
+		int maxX = glm::min(tri.Max.x, tileX + static_cast<int>(TILE_WIDTH) - 1);
+		int minY = glm::max(tri.Min.y, tileY);
+		int maxY = glm::min(tri.Max.y, tileY + static_cast<int>(TILE_HEIGHT) - 1);
+
+		// Both paths evaluate the edges and depth as A * x + (B * y + C), so that they round the same way
+		#if SIMD_USE_SSE
+		if (_useSimd) {
+			const __m128 laneOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+			const __m128 zero = _mm_setzero_ps();
+			const __m128 maxDepth = _mm_set1_ps(tri.MaxDepth);
+			__m128 edgeA[3];
+			for (int ix = 0; ix < 3; ix++) {
+				edgeA[ix] = _mm_set1_ps(tri.EdgeA[ix]);
+			}
+			__m128 depthA = _mm_set1_ps(tri.DepthPlane.x);
+
+			for (int y = minY; y <= maxY; y++) {
+				float pixelY = y + 0.5f;
+				__m128 edgeRow[3];
+				for (int ix = 0; ix < 3; ix++) {
+					edgeRow[ix] = _mm_set1_ps(tri.EdgeB[ix] * pixelY + tri.EdgeC[ix]);
+				}
+				__m128 depthRow = _mm_set1_ps(tri.DepthPlane.y * pixelY + tri.DepthPlane.z);
+				float* row = &_depth[y * _width];
+
+				for (int x = minX; x <= maxX; x += 4) {
+					__m128 pixelX = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), laneOffsets);
+					__m128 inside =                   _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA[0], pixelX), edgeRow[0]), zero);
+					inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA[1], pixelX), edgeRow[1]), zero));
+					inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA[2], pixelX), edgeRow[2]), zero));
+					if (_mm_movemask_ps(inside) == 0) {
+						continue;
+					}
+
+					__m128 depth = _mm_min_ps(_mm_add_ps(_mm_mul_ps(depthA, pixelX), depthRow), maxDepth);
+					__m128 current = _mm_loadu_ps(row + x);
+					__m128 closest = _mm_min_ps(current, depth);
+					_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, closest), _mm_andnot_ps(inside, current)));
+				}
+			}
+			continue;
+		}
+		#endif
+
+		for (int y = minY; y <= maxY; y++) {
+			float pixelY = y + 0.5f;
+			float edgeRow[3];
+			for (int ix = 0; ix < 3; ix++) {
+				edgeRow[ix] = tri.EdgeB[ix] * pixelY + tri.EdgeC[ix];
+			}
+			float depthRow = tri.DepthPlane.y * pixelY + tri.DepthPlane.z;
+			float* row = &_depth[y * _width];
+
+			for (int x = minX; x <= maxX; x++) {
+				float pixelX = x + 0.5f;
+				bool inside = true;
+				for (int ix = 0; ix < 3 && inside; ix++) {
+					inside = tri.EdgeA[ix] * pixelX + edgeRow[ix] >= 0.0f;
+				}
+				if (inside) {
+					float depth = glm::min(tri.DepthPlane.x * pixelX + depthRow, tri.MaxDepth);
+					row[x] = glm::min(row[x], depth);
+				}
+			}
+		}
+	}
+}
+
+bool OcclusionBuffer::TestRect(const ScreenRect& rect) const {
+	if (rect.IsEmpty()) {
+		return false;
+	}
+
+	// The rectangle is widened out to multiples of 4 pixels, which can only make it more visible
+	#if SIMD_USE_SSE
+	if (_useSimd) {
+		__m128 nearest = _mm_set1_ps(rect.NearestDepth);
+		for (int y = rect.Min.y; y <= rect.Max.y; y++) {
+			const float* row = &_depth[y * _width];
+			for (int x = rect.Min.x & ~3; x <= rect.Max.x; x += 4) {
+				if (_mm_movemask_ps(_mm_cmpgt_ps(_mm_loadu_ps(row + x), nearest)) != 0) {
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+	#endif
+
+	for (int y = rect.Min.y; y <= rect.Max.y; y++) {
+		const float* row = &_depth[y * _width];
+		for (int x = rect.Min.x & ~3; x <= (rect.Max.x | 3); x++) {
+			if (row[x] > rect.NearestDepth) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+bool OcclusionBuffer::IsVisible(const BoundingBox& box) const {
+	// Anything in front of the near plane could cover the whole screen
+	ScreenRect rect;
+	return !box.ProjectToPixels(_viewProjection, glm::ivec2(_width, _height), rect) || TestRect(rect);
+}
@@ -0,0 +1,126 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <GLM/glm.hpp>
+
+#include "Utils/Macros.h"
+#include "Utils/Frustum.h"
+#include "Utils/WorkerPool.h"
+#include "Utils/Simd.h"
+
+/// <summary>
+/// A small software depth buffer for occlusion culling. A handful of large, simplified occluders
+/// are rasterized into it on the CPU, and then the screen space bounds of everything else can be
+/// tested against it before we spend any time submitting draws for it
+///
+/// The buffer is split into tiles, and triangles are binned into the tiles they touch so that
+/// tiles can be rasterized on separate threads. Each tile is rasterized 4 pixels at a time with SSE
+/// where it's available. Occluder depths are pushed back by the most they can change across a pixel
+/// so the buffer never claims to be closer than the occluders really are. It does not touch OpenGL,
+/// and OcclusionBufferTests checks it against reference depth images without a window
+/// </summary>
+class OcclusionBuffer final {
+public:
+	MAKE_PTRS(OcclusionBuffer);
+	NO_COPY(OcclusionBuffer);
+	NO_MOVE(OcclusionBuffer);
+
+	/// <summary>
+	/// The size of the tiles that triangles are binned into, the buffer size must be a multiple of these
+	/// </summary>
+	static const uint32_t TILE_WIDTH  = 32;
+	static const uint32_t TILE_HEIGHT = 16;
+
+	/// <summary>
+	/// Creates a new occlusion buffer
+	/// </summary>
+	/// <param name="width">The width of the buffer in pixels, must be a multiple of TILE_WIDTH</param>
+	/// <param name="height">The height of the buffer in pixels, must be a multiple of TILE_HEIGHT</param>
+	OcclusionBuffer(uint32_t width = 256, uint32_t height = 128);
+	~OcclusionBuffer() = default;
+
+	/// <summary>
+	/// Clears the buffer and removes all occluders, ready for a new frame
+	/// </summary>
+	/// <param name="viewProjection">The camera's view projection matrix</param>
+	void Begin(const glm::mat4& viewProjection);
+
+	/// <summary>
+	/// Adds an occluder's triangles to the buffer. Triangles are clipped and binned straight away,
+	/// but are not rasterized until Rasterize is called
+	/// </summary>
+	/// <param name="transform">The occluder's world transform</param>
+	/// <param name="vertices">The occluder's vertex positions in object space</param>
+	/// <param name="indices">The occluder's triangle list</param>
+	/// <param name="indexCount">The number of indices in the triangle list</param>
+	void AddOccluder(const glm::mat4& transform, const glm::vec3* vertices, const uint32_t* indices, size_t indexCount);
+
+	/// <summary>
+	/// Rasterizes all of the occluders that have been added since Begin, splitting the tiles
+	/// between the pool's threads when there is enough work to go around
+	/// </summary>
+	/// <param name="pool">The worker pool to split the tiles across</param>
+	void Rasterize(WorkerPool& pool);
+
+	/// <summary>
+	/// Tests a range of pixels against the buffer
+	/// </summary>
+	/// <param name="rect">The pixels to test, and the closest depth of the object inside them</param>
+	/// <returns>True if any part of the rectangle may be visible</returns>
+	bool TestRect(const ScreenRect& rect) const;
+	/// <summary>
+	/// Tests a world space bounding box against the buffer, boxes that cross the near plane are always visible
+	/// </summary>
+	/// <param name="box">The box to test, in world space</param>
+	/// <returns>True if any part of the box may be visible</returns>
+	bool IsVisible(const BoundingBox& box) const;
+
+	/// <summary>
+	/// Selects between the SSE and scalar paths for rasterizing and testing. SSE is used by default
+	/// wherever it's available, turning it off is only useful for checking the two paths against each other
+	/// </summary>
+	void SetUseSimd(bool useSimd) { _useSimd = useSimd && SIMD_USE_SSE; }
+
+	uint32_t GetWidth() const { return _width; }
+	uint32_t GetHeight() const { return _height; }
+	/// <summary>
+	/// Gets the number of triangles that survived clipping since the last call to Begin
+	/// </summary>
+	uint32_t GetTriangleCount() const { return static_cast<uint32_t>(_triangles.size()); }
+	/// <summary>
+	/// Gets the depth buffer, stored row by row from the bottom of the screen, with depths from 0 (near) to 1 (far)
+	/// </summary>
+	const std::vector<float>& GetDepth() const { return _depth; }
+
+private:
+	// A triangle set up for rasterizing, where the edge functions are A*x + B*y + C and are positive
+	// inside the triangle, and the depth is a plane over the screen that is clamped to the furthest vertex
+	struct Triangle {
+		float EdgeA[3];
+		float EdgeB[3];
+		float EdgeC[3];
+		glm::vec3 DepthPlane;
+		float MaxDepth;
+		glm::ivec2 Min;
+		glm::ivec2 Max;
+	};
+
+	uint32_t  _width;
+	uint32_t  _height;
+	uint32_t  _tilesX;
+	uint32_t  _tilesY;
+	glm::mat4 _viewProjection;
+
+	std::vector<float>    _depth;
+	std::vector<Triangle> _triangles;
+	// The triangles that touch each tile, by index into _triangles
+	std::vector<std::vector<uint32_t>> _bins;
+	bool                  _useSimd;
+
+	// Clips a triangle against the near plane, and adds the pieces that are left
+	void _AddClipped(const glm::vec4* clip);
+	// Sets up a triangle from it's screen space positions and depths, and bins it
+	void _AddTriangle(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c);
+	// Rasterizes all of the triangles binned to a single tile
+	void _RasterizeTile(uint32_t tile);
+};
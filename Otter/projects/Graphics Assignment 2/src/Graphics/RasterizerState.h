@@ -2,6 +2,7 @@
 #include <EnumToString.h>
 #include "glad/glad.h"
 #include "Graphics/GlEnums.h"
+#include "Graphics/GlState.h"
 
 /**
  * Represents the state of the OpenGL blend function 
@@ -41,12 +42,12 @@ struct BlendState {
 	 */
 	inline void Apply() {
 		if (BlendEnabled) {
-			glEnable(GL_BLEND);
-			glBlendFuncSeparate(*SrcRgb, *DstRgb, *SrcAlpha, *DstAlpha);
-			glBlendEquationSeparate(*RgbBlendFunc, *AlphaBlendFunc);
+			GlState::Enable(GL_BLEND);
+			GlState::BlendFuncSeparate(*SrcRgb, *DstRgb, *SrcAlpha, *DstAlpha);
+			GlState::BlendEquationSeparate(*RgbBlendFunc, *AlphaBlendFunc);
 		}
 		else  {
-			glDisable(GL_BLEND);
+			GlState::Disable(GL_BLEND);
 		}
 	}
 };
@@ -92,10 +93,10 @@ struct RasterizerState {
 		glPolygonMode(GL_FRONT, *FrontFaceFill);
 		glPolygonMode(GL_BACK, *BackFaceFill);
 		if (CullMode != CullMode::None) {
-			glEnable(GL_CULL_FACE);
-			glCullFace(*CullMode);
+			GlState::Enable(GL_CULL_FACE);
+			GlState::CullFace(*CullMode);
 		} else {
-			glDisable(GL_CULL_FACE);
+			GlState::Disable(GL_CULL_FACE);
 		}
 	}
 };
\ No newline at end of file
@@ -0,0 +1,229 @@
+#include "RenderGraph.h"
+#include "Logging.h"
+
+#include <algorithm>
+
+RenderGraph::RenderGraph() :
+	_resources(std::vector<Resource>()),
+	_passes(std::vector<Pass>()),
+	_order(std::vector<PassId>()),
+	_physical(std::vector<TextureDesc>()),
+	_physicalLastUse(std::vector<uint32_t>()),
+	_unreferenced(std::vector<ResourceId>())
+{ }
+
+void RenderGraph::Clear() {
+	_resources.clear();
+	_passes.clear();
+	_order.clear();
+	_physical.clear();
+	_physicalLastUse.clear();
+}
+
+RenderGraph::ResourceId RenderGraph::CreateTexture(const std::string& name, const TextureDesc& desc) {
+	Resource resource;
+	resource.Name     = name;
+	resource.Desc     = desc;
+	resource.Imported = false;
+	resource.RefCount = 0;
+	resource.FirstUse = INVALID;
+	resource.LastUse  = INVALID;
+	resource.Physical = INVALID;
+	_resources.push_back(resource);
+	return static_cast<ResourceId>(_resources.size() - 1);
+}
+
+RenderGraph::ResourceId RenderGraph::ImportTexture(const std::string& name, const TextureDesc& desc) {
+	ResourceId result = CreateTexture(name, desc);
+	_resources[result].Imported = true;
+	return result;
+}
+
+RenderGraph::PassId RenderGraph::AddPass(const std::string& name, const ExecuteFunc& execute) {
+	Pass pass;
+	pass.Name       = name;
+	pass.Execute    = execute;
+	pass.SideEffect = false;
+	pass.RefCount   = 0;
+	pass.Culled     = false;
+	_passes.push_back(pass);
+	return static_cast<PassId>(_passes.size() - 1);
+}
+
+void RenderGraph::Read(PassId pass, ResourceId resource) {
+	LOG_ASSERT(pass < _passes.size() && resource < _resources.size(), "Invalid pass or resource!");
+	std::vector<ResourceId>& reads = _passes[pass].Reads;
+	if (std::find(reads.begin(), reads.end(), resource) == reads.end()) {
+		reads.push_back(resource);
+	}
+}
+
+void RenderGraph::Write(PassId pass, ResourceId resource) {
+	LOG_ASSERT(pass < _passes.size() && resource < _resources.size(), "Invalid pass or resource!");
+	std::vector<ResourceId>& writes = _passes[pass].Writes;
+	if (std::find(writes.begin(), writes.end(), resource) == writes.end()) {
+		writes.push_back(resource);
+		_resources[resource].Writers.push_back(pass);
+	}
+}
+
+void RenderGraph::SetSideEffect(PassId pass, bool value) {
+	LOG_ASSERT(pass < _passes.size(), "Invalid pass!");
+	_passes[pass].SideEffect = value;
+}
+
+bool RenderGraph::Compile() {
+	// Passes run in the order they were added, so a transient texture has to be written by the pass
+	// reading it or by one before it, otherwise the pass would read whatever was left in the memory
+	for (PassId passIx = 0; passIx < _passes.size(); passIx++) {
+		for (ResourceId resourceIx : _passes[passIx].Reads) {
+			const Resource& resource = _resources[resourceIx];
+			if (!resource.Imported && (resource.Writers.empty() || resource.Writers.front() > passIx)) {
+				LOG_ERROR("Render graph pass \"{}\" reads \"{}\" before it has been written", _passes[passIx].Name, resource.Name);
+				return false;
+			}
+		}
+	}
+
+	_Cull();
+
+	_order.clear();
+	for (PassId passIx = 0; passIx < _passes.size(); passIx++) {
+		if (!_passes[passIx].Culled) {
+			_order.push_back(passIx);
+		}
+	}
+
+	_ComputeLifetimes();
+	_AssignPhysical();
+	return true;
+}
+
+void RenderGraph::Execute() const {
+	for (PassId passIx : _order) {
+		if (_passes[passIx].Execute) {
+			_passes[passIx].Execute();
+		}
+	}
+}
+
+bool RenderGraph::_Writes(const Pass& pass, ResourceId resource) {
+	return std::find(pass.Writes.begin(), pass.Writes.end(), resource) != pass.Writes.end();
+}
+
+void RenderGraph::_Cull() {
+	// Count how many passes use each resource, and how many resources each pass writes. Reads from a
+	// texture the pass also writes don't count, otherwise a pass's scratch textures would keep it alive
+	for (Resource& resource : _resources) {
+		resource.RefCount = 0;
+	}
+	for (Pass& pass : _passes) {
+		pass.RefCount = static_cast<uint32_t>(pass.Writes.size());
+		pass.Culled = false;
+		for (ResourceId resourceIx : pass.Reads) {
+			if (!_Writes(pass, resourceIx)) {
+				_resources[resourceIx].RefCount++;
+			}
+		}
+	}
+
+	// Releases a culled pass's reads, queuing up any resource that nothing is reading anymore
+	auto cullPass = [&](Pass& pass) {
+		pass.Culled = true;
+		for (ResourceId resourceIx : pass.Reads) {
+			if (_Writes(pass, resourceIx)) {
+				continue;
+			}
+			Resource& resource = _resources[resourceIx];
+			if (--resource.RefCount == 0 && !resource.Imported) {
+				_unreferenced.push_back(resourceIx);
+			}
+		}
+	};
+
+	_unreferenced.clear();
+	for (ResourceId resourceIx = 0; resourceIx < _resources.size(); resourceIx++) {
+		if (_resources[resourceIx].RefCount == 0 && !_resources[resourceIx].Imported) {
+			_unreferenced.push_back(resourceIx);
+		}
+	}
+	for (Pass& pass : _passes) {
+		if (pass.RefCount == 0 && !pass.SideEffect) {
+			cullPass(pass);
+		}
+	}
+
+	// Anything written only to resources that nobody reads is culled, which can leave the resources it
+	// was reading unused in turn
+	while (!_unreferenced.empty()) {
+		ResourceId resourceIx = _unreferenced.back();
+		_unreferenced.pop_back();
+
+		for (PassId writerIx : _resources[resourceIx].Writers) {
+			Pass& writer = _passes[writerIx];
+			if (writer.Culled) {
+				continue;
+			}
+			if (--writer.RefCount == 0 && !writer.SideEffect) {
+				cullPass(writer);
+			}
+		}
+	}
+}
+
+void RenderGraph::_ComputeLifetimes() {
+	for (Resource& resource : _resources) {
+		resource.FirstUse = INVALID;
+		resource.LastUse  = INVALID;
+	}
+
+	for (uint32_t position = 0; position < _order.size(); position++) {
+		const Pass& pass = _passes[_order[position]];
+		auto use = [&](ResourceId resourceIx) {
+			Resource& resource = _resources[resourceIx];
+			if (resource.FirstUse == INVALID) {
+				resource.FirstUse = position;
+			}
+			resource.LastUse = position;
+		};
+		for (ResourceId resourceIx : pass.Reads) {
+			use(resourceIx);
+		}
+		for (ResourceId resourceIx : pass.Writes) {
+			use(resourceIx);
+		}
+	}
+}
+
+void RenderGraph::_AssignPhysical() {
+	_physical.clear();
+	_physicalLastUse.clear();
+	for (Resource& resource : _resources) {
+		resource.Physical = INVALID;
+	}
+
+	// Walk the passes in order, giving each texture the first matching physical texture that is no
+	// longer in use when the texture is first written, or a new one if they are all busy
+	for (uint32_t position = 0; position < _order.size(); position++) {
+		const Pass& pass = _passes[_order[position]];
+		for (ResourceId resourceIx : pass.Writes) {
+			Resource& resource = _resources[resourceIx];
+			if (resource.Imported || resource.FirstUse != position || resource.Physical != INVALID) {
+				continue;
+			}
+
+			for (uint32_t physicalIx = 0; physicalIx < _physical.size(); physicalIx++) {
+				if (_physicalLastUse[physicalIx] < position && _physical[physicalIx] == resource.Desc) {
+					resource.Physical = physicalIx;
+					break;
+				}
+			}
+			if (resource.Physical == INVALID) {
+				resource.Physical = static_cast<uint32_t>(_physical.size());
+				_physical.push_back(resource.Desc);
+				_physicalLastUse.push_back(0);
+			}
+			_physicalLastUse[resource.Physical] = resource.LastUse;
+		}
+	}
+}
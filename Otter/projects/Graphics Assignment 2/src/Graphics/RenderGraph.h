@@ -0,0 +1,171 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <functional>
+
+#include "Utils/Macros.h"
+#include "Graphics/GlEnums.h"
+
+/// <summary>
+/// A render graph collects the passes for a frame along with the textures that each pass reads and
+/// writes, rather than having each pass own it's render targets for the life of the application
+///
+/// Compiling the graph culls any pass whose results are never used, and works out the first and last
+/// pass that uses each transient texture. Transient textures whose lifetimes don't overlap are given
+/// the same physical texture, so that a chain of passes only needs as many textures as are alive at
+/// once. Imported textures are owned outside of the graph, and are never culled or aliased
+///
+/// The graph only deals in descriptions and indices, so culling and aliasing are checked by RenderGraphTests
+/// without a GL context. See RenderTargetPool for creating the physical textures
+/// </summary>
+class RenderGraph final {
+public:
+	MAKE_PTRS(RenderGraph);
+
+	typedef uint32_t ResourceId;
+	typedef uint32_t PassId;
+	typedef std::function<void()> ExecuteFunc;
+
+	static constexpr uint32_t INVALID = ~0u;
+
+	/// <summary>
+	/// Describes a texture in the graph, textures can only share memory if their descriptions match
+	/// </summary>
+	struct TextureDesc {
+		uint32_t         Width;
+		uint32_t         Height;
+		RenderTargetType Format;
+
+		TextureDesc() : Width(0), Height(0), Format(RenderTargetType::ColorRgba8) {}
+		TextureDesc(uint32_t width, uint32_t height, RenderTargetType format) : Width(width), Height(height), Format(format) {}
+
+		bool operator ==(const TextureDesc& other) const { return Width == other.Width && Height == other.Height && Format == other.Format; }
+		bool operator !=(const TextureDesc& other) const { return !(*this == other); }
+	};
+
+	RenderGraph();
+	~RenderGraph() = default;
+
+	/// <summary>
+	/// Removes all passes and resources, while keeping the underlying memory
+	/// </summary>
+	void Clear();
+
+	/// <summary>
+	/// Adds a transient texture, which only exists while the passes that use it are running
+	/// </summary>
+	/// <param name="name">The name of the texture, for debugging</param>
+	/// <param name="desc">The size and format of the texture</param>
+	ResourceId CreateTexture(const std::string& name, const TextureDesc& desc);
+	/// <summary>
+	/// Adds a texture that is owned outside of the graph. Imported textures are assumed to be used after
+	/// the graph has run, so passes that write to them are never culled
+	/// </summary>
+	/// <param name="name">The name of the texture, for debugging</param>
+	/// <param name="desc">The size and format of the texture</param>
+	ResourceId ImportTexture(const std::string& name, const TextureDesc& desc);
+
+	/// <summary>
+	/// Adds a pass to the end of the graph. Passes run in the order they are added, so a pass must be
+	/// added after the passes that write the textures it reads
+	/// </summary>
+	/// <param name="name">The name of the pass, for debugging</param>
+	/// <param name="execute">The function to call when the pass runs</param>
+	PassId AddPass(const std::string& name, const ExecuteFunc& execute);
+	/// <summary>
+	/// Declares that a pass reads from a texture
+	/// </summary>
+	void Read(PassId pass, ResourceId resource);
+	/// <summary>
+	/// Declares that a pass writes to a texture. A pass may read and write the same texture, for
+	/// instance for scratch textures that are only used within the pass
+	/// </summary>
+	void Write(PassId pass, ResourceId resource);
+	/// <summary>
+	/// Marks a pass as having effects outside of the graph, such as drawing to the screen, so that
+	/// it is never culled
+	/// </summary>
+	void SetSideEffect(PassId pass, bool value = true);
+
+	/// <summary>
+	/// Culls unused passes, and assigns physical textures to the transient textures that are left
+	/// </summary>
+	/// <returns>True if the graph is valid, false if a pass reads a transient texture that nothing has written to</returns>
+	bool Compile();
+	/// <summary>
+	/// Runs the passes that survived compiling, in the order they were added
+	/// </summary>
+	void Execute() const;
+
+	size_t GetPassCount() const { return _passes.size(); }
+	size_t GetResourceCount() const { return _resources.size(); }
+	const std::string& GetPassName(PassId pass) const { return _passes[pass].Name; }
+	const std::string& GetResourceName(ResourceId resource) const { return _resources[resource].Name; }
+	const TextureDesc& GetDesc(ResourceId resource) const { return _resources[resource].Desc; }
+	bool IsImported(ResourceId resource) const { return _resources[resource].Imported; }
+
+	/// <summary>
+	/// Returns true if the pass was culled by the last call to Compile
+	/// </summary>
+	bool IsCulled(PassId pass) const { return _passes[pass].Culled; }
+	/// <summary>
+	/// Gets the passes that survived compiling, in the order they will run
+	/// </summary>
+	const std::vector<PassId>& GetExecutionOrder() const { return _order; }
+	/// <summary>
+	/// Gets the physical texture that a transient texture was assigned, or INVALID for imported
+	/// textures and textures that are only used by culled passes
+	/// </summary>
+	uint32_t GetPhysicalIndex(ResourceId resource) const { return _resources[resource].Physical; }
+	/// <summary>
+	/// Gets the first and last position in the execution order that uses a texture, or INVALID if no
+	/// pass that survived compiling uses it
+	/// </summary>
+	uint32_t GetFirstUse(ResourceId resource) const { return _resources[resource].FirstUse; }
+	uint32_t GetLastUse(ResourceId resource) const { return _resources[resource].LastUse; }
+	/// <summary>
+	/// Gets the descriptions of the physical textures that are needed to run the graph
+	/// </summary>
+	const std::vector<TextureDesc>& GetPhysicalTextures() const { return _physical; }
+
+private:
+	struct Resource {
+		std::string Name;
+		TextureDesc Desc;
+		bool        Imported;
+		// The passes that write to this resource
+		std::vector<PassId> Writers;
+		// The number of passes that read this resource, not counting passes that also write it
+		uint32_t    RefCount;
+		// The range of positions in _order that this resource is used over
+		uint32_t    FirstUse;
+		uint32_t    LastUse;
+		uint32_t    Physical;
+	};
+	struct Pass {
+		std::string Name;
+		ExecuteFunc Execute;
+		std::vector<ResourceId> Reads;
+		std::vector<ResourceId> Writes;
+		bool        SideEffect;
+		// The number of resources this pass writes that are still in use
+		uint32_t    RefCount;
+		bool        Culled;
+	};
+
+	std::vector<Resource>    _resources;
+	std::vector<Pass>        _passes;
+	std::vector<PassId>      _order;
+	std::vector<TextureDesc> _physical;
+	// The position in _order after which each physical texture is free again
+	std::vector<uint32_t>    _physicalLastUse;
+	// Scratch space for compiling
+	std::vector<ResourceId>  _unreferenced;
+
+	// Returns true if the pass writes to the resource
+	static bool _Writes(const Pass& pass, ResourceId resource);
+	void _Cull();
+	void _ComputeLifetimes();
+	void _AssignPhysical();
+};
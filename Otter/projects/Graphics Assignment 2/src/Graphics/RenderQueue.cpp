@@ -0,0 +1,88 @@
+#include "RenderQueue.h"
+#include <algorithm>
+#include <cmath>
+
+// Below this many draws, a comparison sort beats the fixed cost of the radix sort's histograms
+const size_t RADIX_SORT_THRESHOLD = 64;
+
+RenderQueue::RenderQueue() :
+	_entries(std::vector<Entry>()),
+	_scratch(std::vector<Entry>())
+{ }
+
+uint64_t RenderQueue::MakeKey(uint32_t pass, uint32_t layer, uint32_t shader, uint32_t material, uint32_t mesh, uint32_t depth) {
+	return
+		(static_cast<uint64_t>(pass     & 0xF)    << 60) |
+		(static_cast<uint64_t>(layer    & 0xF)    << 56) |
+		(static_cast<uint64_t>(shader   & 0x3FF)  << 46) |
+		(static_cast<uint64_t>(material & 0x3FFF) << 32) |
+		(static_cast<uint64_t>(mesh     & 0xFFFF) << 16) |
+		(static_cast<uint64_t>(depth    & 0xFFFF));
+}
+
+uint32_t RenderQueue::QuantizeDepth(float distance, bool invert) {
+	static const float scale = 1.0f / std::log2(1.0f + MAX_SORT_DEPTH);
+	float t = std::log2(1.0f + std::max(distance, 0.0f)) * scale;
+	uint32_t result = static_cast<uint32_t>(std::min(t, 1.0f) * 65535.0f);
+	return invert ? 65535 - result : result;
+}
+
+void RenderQueue::Clear() {
+	_entries.clear();
+}
+
+void RenderQueue::Push(uint64_t key, uint32_t index) {
+	_entries.push_back({ key, index });
+}
+
+void RenderQueue::Sort() {
+	size_t count = _entries.size();
+	if (count < RADIX_SORT_THRESHOLD) {
+		std::stable_sort(_entries.begin(), _entries.end(), [](const Entry& a, const Entry& b) {
+			return a.Key < b.Key;
+		});
+		return;
+	}
+
+	// Find which bits are not the same across all keys, any byte that is identical in every key
+	// would not change the order, so we can skip that pass entirely. In practice this skips the
+	// pass and layer bytes, and usually the shader byte as well
+	uint64_t anyBits = 0, allBits = ~0ull;
+	for (const Entry& entry : _entries) {
+		anyBits |= entry.Key;
+		allBits &= entry.Key;
+	}
+	uint64_t changingBits = anyBits ^ allBits;
+
+	_scratch.resize(count);
+	Entry* source = _entries.data();
+	Entry* dest   = _scratch.data();
+
+	// Least significant digit radix sort, one byte at a time. Each pass is stable, so the
+	// result is ordered by the full key
+	for (int shift = 0; shift < 64; shift += 8) {
+		if (((changingBits >> shift) & 0xFF) == 0) {
+			continue;
+		}
+
+		uint32_t offsets[256] = { 0 };
+		for (size_t ix = 0; ix < count; ix++) {
+			offsets[(source[ix].Key >> shift) & 0xFF]++;
+		}
+		uint32_t total = 0;
+		for (int bucket = 0; bucket < 256; bucket++) {
+			uint32_t bucketCount = offsets[bucket];
+			offsets[bucket] = total;
+			total += bucketCount;
+		}
+		for (size_t ix = 0; ix < count; ix++) {
+			dest[offsets[(source[ix].Key >> shift) & 0xFF]++] = source[ix];
+		}
+		std::swap(source, dest);
+	}
+
+	// If we did an odd number of passes, the sorted result is in the scratch buffer
+	if (source != _entries.data()) {
+		_entries.swap(_scratch);
+	}
+}
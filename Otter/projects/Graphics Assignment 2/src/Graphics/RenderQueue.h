@@ -0,0 +1,92 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+#include "Utils/Macros.h"
+
+/// <summary>
+/// A render queue collects draws along with a 64 bit sort key, and sorts them so that draws
+/// sharing state end up next to each other. The queue only stores indices, the draw data
+/// itself is owned by whoever is filling the queue
+///
+/// Keys are laid out from most to least significant as:
+///		pass (4 bits), layer (4 bits), shader (10 bits), material (14 bits), mesh (16 bits), depth (16 bits)
+/// so that the most expensive state changes are the ones that happen least often. Fields that
+/// overflow their bits are wrapped, which only makes the sort less effective, never incorrect
+/// </summary>
+class RenderQueue final {
+public:
+	MAKE_PTRS(RenderQueue);
+
+	/// <summary>
+	/// The maximum view depth that is used when quantizing depths, anything further away will
+	/// be put in the last depth bucket
+	/// </summary>
+	static constexpr float MAX_SORT_DEPTH = 1000.0f;
+
+	/// <summary>
+	/// A single draw within the queue
+	/// </summary>
+	struct Entry {
+		/// <summary>
+		/// The sort key for the draw, see RenderQueue::MakeKey
+		/// </summary>
+		uint64_t Key;
+		/// <summary>
+		/// The index of the draw in the caller's draw list
+		/// </summary>
+		uint32_t Index;
+	};
+
+	RenderQueue();
+	~RenderQueue() = default;
+
+	/// <summary>
+	/// Builds a sort key from it's components. The shader, material and mesh IDs should be
+	/// small, densely packed IDs rather than pointers or OpenGL handles
+	/// </summary>
+	/// <param name="pass">The render pass that the draw belongs to</param>
+	/// <param name="layer">The layer within the pass</param>
+	/// <param name="shader">The ID of the shader that the draw uses</param>
+	/// <param name="material">The ID of the material that the draw uses</param>
+	/// <param name="mesh">The ID of the mesh that the draw uses</param>
+	/// <param name="depth">The quantized depth of the draw, see QuantizeDepth</param>
+	static uint64_t MakeKey(uint32_t pass, uint32_t layer, uint32_t shader, uint32_t material, uint32_t mesh, uint32_t depth);
+	/// <summary>
+	/// Gets the render pass that was packed into a sort key
+	/// </summary>
+	static uint32_t GetPass(uint64_t key) { return static_cast<uint32_t>(key >> 60); }
+	/// <summary>
+	/// Converts a view space distance to a 16 bit depth bucket. Buckets are spaced logarithmically,
+	/// so nearby objects get much finer buckets than distant ones
+	/// </summary>
+	/// <param name="distance">The distance along the camera's forward axis</param>
+	/// <param name="invert">True to sort back to front instead of front to back</param>
+	static uint32_t QuantizeDepth(float distance, bool invert = false);
+
+	/// <summary>
+	/// Removes all the draws from the queue, while keeping the underlying memory
+	/// </summary>
+	void Clear();
+	/// <summary>
+	/// Adds a draw to the end of the queue
+	/// </summary>
+	/// <param name="key">The sort key for the draw</param>
+	/// <param name="index">The index of the draw in the caller's draw list</param>
+	void Push(uint64_t key, uint32_t index);
+	/// <summary>
+	/// Sorts the queue by key, draws with the same key will stay in the order they were pushed
+	/// </summary>
+	void Sort();
+
+	/// <summary>
+	/// Gets the draws in the queue, will be in key order after a call to Sort
+	/// </summary>
+	const std::vector<Entry>& GetEntries() const { return _entries; }
+	size_t Size() const { return _entries.size(); }
+
+private:
+	std::vector<Entry> _entries;
+	// Second buffer for the radix sort to ping-pong with
+	std::vector<Entry> _scratch;
+};
@@ -0,0 +1,48 @@
+#include "RenderTargetPool.h"
+#include "Logging.h"
+
+RenderTargetPool::RenderTargetPool() :
+	_targets(std::vector<Framebuffer::Sptr>()),
+	_targetDescs(std::vector<RenderGraph::TextureDesc>()),
+	_resources(std::vector<Framebuffer::Sptr>())
+{ }
+
+void RenderTargetPool::Realize(const RenderGraph& graph) {
+	const std::vector<RenderGraph::TextureDesc>& physical = graph.GetPhysicalTextures();
+
+	// Take framebuffers over from the last frame where we can, anything left over is freed
+	std::vector<Framebuffer::Sptr> targets;
+	targets.reserve(physical.size());
+	for (const RenderGraph::TextureDesc& desc : physical) {
+		Framebuffer::Sptr target = nullptr;
+		for (size_t ix = 0; ix < _targets.size(); ix++) {
+			if (_targets[ix] != nullptr && _targetDescs[ix] == desc) {
+				target = _targets[ix];
+				_targets[ix] = nullptr;
+				break;
+			}
+		}
+
+		if (target == nullptr) {
+			FramebufferDescriptor fboDesc = FramebufferDescriptor();
+			fboDesc.Width  = desc.Width;
+			fboDesc.Height = desc.Height;
+			fboDesc.RenderTargets[RenderTargetAttachment::Color0] = RenderTargetDescriptor(desc.Format);
+			target = std::make_shared<Framebuffer>(fboDesc);
+		}
+		targets.push_back(target);
+	}
+	_targets = std::move(targets);
+	_targetDescs = physical;
+
+	_resources.resize(graph.GetResourceCount());
+	for (RenderGraph::ResourceId resource = 0; resource < _resources.size(); resource++) {
+		uint32_t physicalIx = graph.GetPhysicalIndex(resource);
+		_resources[resource] = physicalIx != RenderGraph::INVALID ? _targets[physicalIx] : nullptr;
+	}
+}
+
+void RenderTargetPool::Import(RenderGraph::ResourceId resource, const Framebuffer::Sptr& framebuffer) {
+	LOG_ASSERT(resource < _resources.size(), "Resource has not been realized, call Realize before importing!");
+	_resources[resource] = framebuffer;
+}
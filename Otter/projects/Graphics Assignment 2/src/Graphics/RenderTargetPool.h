@@ -0,0 +1,48 @@
+#pragma once
+#include <vector>
+
+#include "Graphics/Framebuffer.h"
+#include "Graphics/RenderGraph.h"
+#include "Utils/Macros.h"
+
+/// <summary>
+/// Creates the framebuffers for the physical textures of a compiled render graph, and maps the graph's
+/// textures to them. Framebuffers are kept between frames, and re-used whenever the next frame's graph
+/// asks for the same size and format, so a graph that doesn't change never re-allocates
+/// </summary>
+class RenderTargetPool final {
+public:
+	MAKE_PTRS(RenderTargetPool);
+	NO_COPY(RenderTargetPool);
+	NO_MOVE(RenderTargetPool);
+
+	RenderTargetPool();
+	~RenderTargetPool() = default;
+
+	/// <summary>
+	/// Makes sure there is a framebuffer for each of the graph's physical textures, and frees any that
+	/// the graph no longer needs. Imported textures need to be set with Import after this is called
+	/// </summary>
+	/// <param name="graph">The graph to create the framebuffers for, must be compiled</param>
+	void Realize(const RenderGraph& graph);
+	/// <summary>
+	/// Sets the framebuffer for a texture that was imported into the graph
+	/// </summary>
+	void Import(RenderGraph::ResourceId resource, const Framebuffer::Sptr& framebuffer);
+
+	/// <summary>
+	/// Gets the framebuffer for a texture in the graph that was last realized, or nullptr if it was culled
+	/// </summary>
+	const Framebuffer::Sptr& Get(RenderGraph::ResourceId resource) const { return _resources[resource]; }
+	/// <summary>
+	/// Gets the number of framebuffers that the pool is holding on to
+	/// </summary>
+	int GetTargetCount() const { return static_cast<int>(_targets.size()); }
+
+private:
+	// The pooled framebuffers, and the descriptions they were created with
+	std::vector<Framebuffer::Sptr>        _targets;
+	std::vector<RenderGraph::TextureDesc> _targetDescs;
+	// The framebuffer for each texture in the graph
+	std::vector<Framebuffer::Sptr>        _resources;
+};
@@ -0,0 +1,69 @@
+#include "ResolutionController.h"
+#include <GLM/glm.hpp>
+
+// How much of each new measurement is blended into the running average
+const float RESOLUTION_TIME_SMOOTHING = 0.25f;
+
+ResolutionController::ResolutionController() :
+	_budget(12.0f),
+	_minScale(0.5f),
+	_maxScale(1.0f),
+	_kp(0.3f),
+	_ki(0.05f),
+	_kd(0.02f),
+	_smoothedTime(0.0f),
+	_integral(0.0f),
+	_lastError(0.0f),
+	_hasHistory(false),
+	_scale(1.0f)
+{ }
+
+void ResolutionController::SetBudget(float milliseconds) {
+	_budget = glm::max(milliseconds, 0.1f);
+}
+
+void ResolutionController::SetScaleRange(float minScale, float maxScale) {
+	_maxScale = glm::clamp(maxScale, 0.1f, 1.0f);
+	_minScale = glm::clamp(minScale, 0.1f, _maxScale);
+	_scale = glm::clamp(_scale, _minScale, _maxScale);
+}
+
+void ResolutionController::SetGains(float proportional, float integral, float derivative) {
+	_kp = proportional;
+	_ki = integral;
+	_kd = derivative;
+}
+
+float ResolutionController::Update(float gpuMilliseconds) {
+	if (gpuMilliseconds <= 0.0f) {
+		return _scale;
+	}
+
+	_smoothedTime = _hasHistory ? glm::mix(_smoothedTime, gpuMilliseconds, RESOLUTION_TIME_SMOOTHING) : gpuMilliseconds;
+
+	// Positive when there is time to spare, negative when we are over budget
+	float error = (_budget - _smoothedTime) / _budget;
+	float derivative = _hasHistory ? error - _lastError : 0.0f;
+	_lastError = error;
+	_hasHistory = true;
+
+	// The controller rests at the maximum scale, and the integral pulls it down for as long as we are over budget.
+	// The integral is kept within the range that the scale can actually move over, otherwise it would keep
+	// growing while the scale is pinned at a limit, and take just as long to unwind once the error changes sign
+	_integral += error;
+	if (_ki > 0.0f) {
+		_integral = glm::clamp(_integral, (_minScale - _maxScale) / _ki, 0.0f);
+	}
+	float output = _maxScale + _kp * error + _ki * _integral + _kd * derivative;
+
+	_scale = glm::clamp(output, _minScale, _maxScale);
+	return _scale;
+}
+
+void ResolutionController::Reset() {
+	_smoothedTime = 0.0f;
+	_integral = 0.0f;
+	_lastError = 0.0f;
+	_hasHistory = false;
+	_scale = _maxScale;
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include "Utils/Macros.h"
+
+/// <summary>
+/// Picks the fraction of the window that the scene is rendered at, so that the GPU stays within a
+/// time budget. A PID controller works on the difference between the budget and the measured GPU
+/// time, as a fraction of the budget, and the scale is clamped between a minimum and maximum
+///
+/// The controller only sees numbers and never touches OpenGL. ResolutionControllerTests runs it against a
+/// GPU whose time goes with the pixel count, to check that it settles on the budget and recovers quickly
+/// after being pinned at the minimum. See GpuTimer for measuring the GPU time
+/// </summary>
+class ResolutionController final {
+public:
+	MAKE_PTRS(ResolutionController);
+
+	ResolutionController();
+	~ResolutionController() = default;
+
+	/// <summary>
+	/// Sets the GPU time that the controller aims for, in milliseconds
+	/// </summary>
+	void SetBudget(float milliseconds);
+	float GetBudget() const { return _budget; }
+
+	/// <summary>
+	/// Sets the range that the scale is kept in, the scale is applied to both width and height
+	/// </summary>
+	void SetScaleRange(float minScale, float maxScale);
+	float GetMinScale() const { return _minScale; }
+	float GetMaxScale() const { return _maxScale; }
+
+	/// <summary>
+	/// Sets the proportional, integral and derivative gains. Each is applied to the error as a fraction of
+	/// the budget, so a proportional gain of 0.5 drops the scale by 0.5 when the GPU takes twice the budget
+	/// </summary>
+	void SetGains(float proportional, float integral, float derivative);
+	float GetProportionalGain() const { return _kp; }
+	float GetIntegralGain() const { return _ki; }
+	float GetDerivativeGain() const { return _kd; }
+
+	/// <summary>
+	/// Feeds in a new GPU time measurement, and updates the scale
+	/// </summary>
+	/// <param name="gpuMilliseconds">The time the GPU took to render a frame</param>
+	/// <returns>The new scale</returns>
+	float Update(float gpuMilliseconds);
+	/// <summary>
+	/// Throws away the controller's history, and goes back to the maximum scale
+	/// </summary>
+	void Reset();
+
+	/// <summary>
+	/// Gets the scale that the scene should be rendered at
+	/// </summary>
+	float GetScale() const { return _scale; }
+	/// <summary>
+	/// Gets the measured GPU time after smoothing, in milliseconds
+	/// </summary>
+	float GetSmoothedTime() const { return _smoothedTime; }
+
+private:
+	float _budget;
+	float _minScale;
+	float _maxScale;
+	float _kp;
+	float _ki;
+	float _kd;
+
+	// GPU times are noisy from frame to frame, so the controller works on a running average
+	float _smoothedTime;
+	float _integral;
+	float _lastError;
+	bool  _hasHistory;
+	float _scale;
+};
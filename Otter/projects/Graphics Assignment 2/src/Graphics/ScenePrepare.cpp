@@ -0,0 +1,62 @@
+#include "ScenePrepare.h"
+#include "Graphics/RenderQueue.h"
+
+size_t ScenePrepare::Prepare(WorkerPool& pool, const std::vector<Draw>& draws, const uint32_t* visible, size_t visibleCount,
+	size_t minPerThread, const Settings& settings, std::vector<Buffer>& buffers)
+{
+	if (buffers.size() < pool.GetThreadCount()) {
+		buffers.resize(pool.GetThreadCount());
+	}
+	return pool.RunRanges(visibleCount, minPerThread, [&](size_t thread, size_t begin, size_t end) {
+		PrepareRange(draws, visible, begin, end, settings, buffers[thread]);
+	});
+}
+
+void ScenePrepare::PrepareRange(const std::vector<Draw>& draws, const uint32_t* visible, size_t begin, size_t end,
+	const Settings& settings, Buffer& buffer)
+{
+	buffer.Draws.clear();
+	buffer.Culled = 0;
+	buffer.OcclusionCulled = 0;
+	buffer.HiZCulled = 0;
+
+	// Orthographic projections don't shrink with distance
+	bool isOrtho = settings.Projection[3][3] == 1.0f;
+
+	for (size_t visibleIx = begin; visibleIx < end; visibleIx++) {
+		uint32_t drawIx = visible[visibleIx];
+		const Draw& draw = draws[drawIx];
+		if (!settings.ViewFrustum.Intersects(draw.Box)) {
+			buffer.Culled++;
+			continue;
+		}
+		if (settings.Occlusion != nullptr && !draw.IsOccluder && !settings.Occlusion->IsVisible(draw.Box)) {
+			buffer.OcclusionCulled++;
+			continue;
+		}
+		if (settings.HiZ != nullptr && !settings.HiZ->IsVisible(draw.Box, settings.HiZMargin)) {
+			buffer.HiZCulled++;
+			continue;
+		}
+
+		glm::vec3 viewPos = settings.View * glm::vec4(draw.Sphere.Center, 1.0f);
+
+		// Pick the level of detail based on how big the object's bounding sphere is on screen
+		int lod = -1;
+		if (settings.SelectLod && draw.HasLods) {
+			lod = 0;
+			if (settings.LodPixelError > 0.0f) {
+				// For perspective we keep full detail if the camera is inside of the bounds
+				float radius = draw.Sphere.Radius;
+				float distance = isOrtho ? 1.0f : -viewPos.z;
+				if (isOrtho || distance > radius) {
+					float screenDiameter = radius * settings.Projection[1][1] * settings.ScreenSize.y / distance;
+					lod = settings.SelectLod(drawIx, screenDiameter);
+				}
+			}
+		}
+
+		// Within a batch we draw front to back, so that early depth testing can reject hidden pixels
+		buffer.Draws.push_back({ drawIx, RenderQueue::QuantizeDepth(-viewPos.z), lod });
+	}
+}
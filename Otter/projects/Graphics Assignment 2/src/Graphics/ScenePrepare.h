@@ -0,0 +1,130 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <GLM/glm.hpp>
+
+#include "Utils/Frustum.h"
+#include "Utils/WorkerPool.h"
+#include "Graphics/OcclusionBuffer.h"
+#include "Graphics/DepthPyramid.h"
+
+/// <summary>
+/// The part of preparing a view that runs across the worker threads. The objects that passed the
+/// sphere test are culled against their boxes, the occlusion buffer and the Hi-Z pyramid, given a
+/// level of detail, and have their view depth quantized for the sort key
+///
+/// This works on a plain copy of each object's bounds that RenderLayer gathers from it's render
+/// components, so that the same code runs on the scene and in the tests without a GL context
+/// </summary>
+class ScenePrepare
+{
+public:
+	/// <summary>
+	/// The parts of an object in the draw list that preparing it looks at
+	/// </summary>
+	struct Draw {
+		BoundingBox    Box;
+		BoundingSphere Sphere;
+		/// <summary>
+		/// Occluders are never occlusion culled, since they are in the occlusion buffer themselves
+		/// </summary>
+		bool           IsOccluder;
+		/// <summary>
+		/// True if the object's mesh has more than one level of detail to pick from
+		/// </summary>
+		bool           HasLods;
+		/// <summary>
+		/// The object's world transform this frame and last frame. Preparing doesn't use these, they are
+		/// carried along so that the instance data can be packed on the worker threads from the copies
+		/// </summary>
+		glm::mat4      Transform;
+		glm::mat4      PrevTransform;
+	};
+
+	/// <summary>
+	/// A draw that survived culling
+	/// </summary>
+	struct PreparedDraw {
+		/// <summary>
+		/// The index of the object in the draw list
+		/// </summary>
+		uint32_t DrawIndex;
+		/// <summary>
+		/// The quantized view depth, see RenderQueue::QuantizeDepth
+		/// </summary>
+		uint32_t Depth;
+		/// <summary>
+		/// The level of detail the object should switch to, or -1 to keep it's current one
+		/// </summary>
+		int      Lod;
+	};
+
+	/// <summary>
+	/// Each thread writes the draws it keeps and it's culling stats into it's own buffer, so that no
+	/// locking is needed
+	/// </summary>
+	struct Buffer {
+		std::vector<PreparedDraw> Draws;
+		uint32_t Culled;
+		uint32_t OcclusionCulled;
+		uint32_t HiZCulled;
+	};
+
+	/// <summary>
+	/// Picks the level of detail for an object in the draw list, given the diameter of it's bounding
+	/// sphere on screen in pixels
+	/// </summary>
+	typedef std::function<int(uint32_t drawIndex, float screenDiameter)> LodSelector;
+
+	/// <summary>
+	/// Describes the view that is being prepared
+	/// </summary>
+	struct Settings {
+		glm::mat4             View;
+		glm::mat4             Projection;
+		glm::ivec2            ScreenSize;
+		Frustum               ViewFrustum;
+		/// <summary>
+		/// The occlusion buffer to test against, or nullptr to skip software occlusion culling
+		/// </summary>
+		const OcclusionBuffer* Occlusion;
+		/// <summary>
+		/// The Hi-Z pyramid to test against, or nullptr to skip Hi-Z culling
+		/// </summary>
+		const DepthPyramid*   HiZ;
+		/// <summary>
+		/// How much to grow boxes by before testing them against the Hi-Z pyramid, see DepthPyramid::IsVisible
+		/// </summary>
+		float                 HiZMargin;
+		/// <summary>
+		/// Objects with levels of detail use their most detailed level when this is 0 or less
+		/// </summary>
+		float                 LodPixelError;
+		/// <summary>
+		/// Picks the level of detail for objects with more than one, leave empty to keep their current levels
+		/// </summary>
+		LodSelector           SelectLod;
+	};
+
+	/// <summary>
+	/// Prepares the draws in the visible list across the pool. Each thread takes a contiguous range of
+	/// the list, so reading the buffers in thread order gives the survivors in the order they were listed
+	/// </summary>
+	/// <param name="pool">The pool to run on</param>
+	/// <param name="draws">The draw list</param>
+	/// <param name="visible">Indices into the draw list of the objects to prepare</param>
+	/// <param name="visibleCount">The number of indices in visible</param>
+	/// <param name="minPerThread">The fewest draws that are worth handing to a thread</param>
+	/// <param name="settings">The view being prepared</param>
+	/// <param name="buffers">One buffer per thread in the pool, these are cleared before they are written</param>
+	/// <returns>The number of buffers that were written</returns>
+	static size_t Prepare(WorkerPool& pool, const std::vector<Draw>& draws, const uint32_t* visible, size_t visibleCount,
+		size_t minPerThread, const Settings& settings, std::vector<Buffer>& buffers);
+
+	/// <summary>
+	/// Prepares a range of the visible list into a single buffer, this is what each thread runs in Prepare
+	/// </summary>
+	static void PrepareRange(const std::vector<Draw>& draws, const uint32_t* visible, size_t begin, size_t end,
+		const Settings& settings, Buffer& buffer);
+};
@@ -1,5 +1,6 @@
 #include "ShaderProgram.h"
 #include "Logging.h"
+#include "GlState.h"
 #include <fstream>
 #include <sstream>
 #include <filesystem>
@@ -27,6 +28,7 @@ ShaderProgram::ShaderProgram(const std::unordered_map<ShaderPartType, std::strin
 
 ShaderProgram::~ShaderProgram() {
 	if (_rendererId != 0) {
+		GlState::OnProgramDeleted(_rendererId);
 		glDeleteProgram(_rendererId);
 		_rendererId = 0;
 	}
@@ -103,6 +105,19 @@ bool ShaderProgram::LoadShaderPartFromFile(const char* path, ShaderPartType type
 	}
 }
 
+bool ShaderProgram::LoadShaderPartFrom(const ShaderProgram& other, ShaderPartType type) {
+	auto it = other._fileSourceMap.find(type);
+	if (it == other._fileSourceMap.end()) {
+		return false;
+	}
+	// File sources are re-read so that includes are resolved relative to the original file
+	if (it->second.IsFilePath) {
+		return LoadShaderPartFromFile(it->second.Source.c_str(), type);
+	} else {
+		return LoadShaderPart(it->second.Source.c_str(), type);
+	}
+}
+
 bool ShaderProgram::Link() {
 
 	LOG_TRACE("Starting shader link:");
@@ -162,13 +177,13 @@ bool ShaderProgram::Link() {
 }
 
 void ShaderProgram::Bind() {
-	// Simply calls glUseProgram with our shader handle
-	glUseProgram(_rendererId);
+	// Uses our shader handle, the state cache skips this if we're already in use
+	GlState::UseProgram(_rendererId);
 }
 
 void ShaderProgram::Unbind() {
 	// We unbind a shader program by using the default program (0)
-	glUseProgram(0);
+	GlState::UseProgram(0);
 }
 
 void ShaderProgram::SetUniformMatrix(int location, const glm::mat3* value, int count, bool transposed) {
@@ -83,6 +83,14 @@ public:
 	/// <param name="type">The stage to load (GL_VERTEX_SHADER or GL_FRAGMENT_SHADER)</param>
 	/// <returns>True if the shader is loaded, false if there was an issue</returns>
 	bool LoadShaderPartFromFile(const char* path, ShaderPartType type);
+	/// <summary>
+	/// Loads a single shader stage from the same source that another shader object loaded it's stage from,
+	/// used to build variants of a shader that swap out some of it's stages
+	/// </summary>
+	/// <param name="other">The shader to copy the stage from</param>
+	/// <param name="type">The stage to copy</param>
+	/// <returns>True if the shader is loaded, false if the other shader does not have the stage or there was an issue</returns>
+	bool LoadShaderPartFrom(const ShaderProgram& other, ShaderPartType type);
 
 	/// <summary>
 	/// Registers a list of varying outputs to capture for transform feedback, must be called before Link
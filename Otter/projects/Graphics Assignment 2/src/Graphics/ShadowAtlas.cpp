@@ -0,0 +1,12 @@
+#include "ShadowAtlas.h"
+
+ShadowAtlas::ShadowAtlas(uint32_t size) :
+	_layout(size),
+	_framebuffer(nullptr)
+{
+	FramebufferDescriptor desc;
+	desc.Width  = size;
+	desc.Height = size;
+	desc.RenderTargets[RenderTargetAttachment::Depth] = RenderTargetDescriptor(RenderTargetType::Depth32, true, true);
+	_framebuffer = std::make_shared<Framebuffer>(desc);
+}
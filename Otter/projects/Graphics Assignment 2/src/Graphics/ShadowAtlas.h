@@ -0,0 +1,72 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <GLM/glm.hpp>
+
+#include "Graphics/Framebuffer.h"
+#include "Graphics/ShadowAtlasLayout.h"
+#include "Utils/Macros.h"
+
+/// <summary>
+/// A shadow atlas packs the shadow maps for many lights into a single depth texture, so that
+/// all the shadows can be read in a single pass without re-binding textures
+///
+/// Space is handed out by a ShadowAtlasLayout, where each tile is a power of two and is split into
+/// four when a smaller tile is needed. The atlas is expected to be cleared and filled each frame,
+/// from the largest tiles to the smallest, which keeps the quadtree tightly packed
+/// </summary>
+class ShadowAtlas final {
+public:
+	MAKE_PTRS(ShadowAtlas);
+	NO_COPY(ShadowAtlas);
+	NO_MOVE(ShadowAtlas);
+
+	/// <summary>
+	/// The smallest tile that will be handed out by the atlas, in pixels
+	/// </summary>
+	static const uint32_t MIN_TILE_SIZE = ShadowAtlasLayout::MIN_TILE_SIZE;
+
+	/// <summary>
+	/// Creates a new shadow atlas
+	/// </summary>
+	/// <param name="size">The width and height of the atlas in pixels, must be a power of two</param>
+	ShadowAtlas(uint32_t size);
+	~ShadowAtlas() = default;
+
+	/// <summary>
+	/// Frees all the tiles in the atlas, note that this does not clear the depth texture
+	/// </summary>
+	void Clear() { _layout.Clear(); }
+	/// <summary>
+	/// Allocates a square tile from the atlas
+	/// </summary>
+	/// <param name="size">The size of the tile in pixels, this will be rounded up to a power of two</param>
+	/// <param name="outRect">Receives the tile as (x, y, width, height) in pixels</param>
+	/// <returns>True if a tile was allocated, false if there was no space left for a tile of that size</returns>
+	bool Allocate(uint32_t size, glm::ivec4& outRect) { return _layout.Allocate(size, outRect); }
+
+	/// <summary>
+	/// Rounds a resolution up to the nearest tile size that the atlas can allocate
+	/// </summary>
+	/// <param name="size">The resolution to round, in pixels</param>
+	uint32_t GetTileSize(uint32_t size) const { return _layout.GetTileSize(size); }
+	/// <summary>
+	/// Rounds a resolution down to the largest tile size that fits inside of it, use this for upper
+	/// limits such as a light's buffer resolution
+	/// </summary>
+	/// <param name="size">The resolution to round, in pixels</param>
+	uint32_t GetLargestTileSize(uint32_t size) const { return _layout.GetLargestTileSize(size); }
+
+	/// <summary>
+	/// Gets the width and height of the atlas in pixels
+	/// </summary>
+	uint32_t GetSize() const { return _layout.GetSize(); }
+	/// <summary>
+	/// Gets the framebuffer that contains the atlas' depth texture
+	/// </summary>
+	const Framebuffer::Sptr& GetFramebuffer() const { return _framebuffer; }
+
+private:
+	ShadowAtlasLayout _layout;
+	Framebuffer::Sptr _framebuffer;
+};
@@ -0,0 +1,68 @@
+#include "ShadowAtlasLayout.h"
+#include "Logging.h"
+
+ShadowAtlasLayout::ShadowAtlasLayout(uint32_t size) :
+	_size(size),
+	_nodes(std::vector<Node>())
+{
+	LOG_ASSERT(size >= MIN_TILE_SIZE && (size & (size - 1)) == 0, "Shadow atlas size must be a power of two!");
+	Clear();
+}
+
+void ShadowAtlasLayout::Clear() {
+	_nodes.clear();
+	_nodes.push_back({ 0, 0, _size, NodeState::Free, 0 });
+}
+
+bool ShadowAtlasLayout::Allocate(uint32_t size, glm::ivec4& outRect) {
+	return _Allocate(0, GetTileSize(size), outRect);
+}
+
+uint32_t ShadowAtlasLayout::GetTileSize(uint32_t size) const {
+	uint32_t result = MIN_TILE_SIZE;
+	while (result < size && result < _size) {
+		result <<= 1;
+	}
+	return result;
+}
+
+uint32_t ShadowAtlasLayout::GetLargestTileSize(uint32_t size) const {
+	uint32_t result = MIN_TILE_SIZE;
+	while ((result << 1) <= size && result < _size) {
+		result <<= 1;
+	}
+	return result;
+}
+
+bool ShadowAtlasLayout::_Allocate(uint32_t nodeIx, uint32_t size, glm::ivec4& outRect) {
+	// Copy the node, since splitting it will add to the node list
+	Node node = _nodes[nodeIx];
+	if (node.Size < size || node.State == NodeState::Used) {
+		return false;
+	}
+
+	if (node.State == NodeState::Free) {
+		if (node.Size == size) {
+			_nodes[nodeIx].State = NodeState::Used;
+			outRect = glm::ivec4(node.X, node.Y, size, size);
+			return true;
+		}
+
+		// Split the node into 4 quadrants
+		uint32_t half = node.Size / 2;
+		node.FirstChild = static_cast<uint32_t>(_nodes.size());
+		_nodes[nodeIx].State = NodeState::Split;
+		_nodes[nodeIx].FirstChild = node.FirstChild;
+		_nodes.push_back({ node.X,        node.Y,        half, NodeState::Free, 0 });
+		_nodes.push_back({ node.X + half, node.Y,        half, NodeState::Free, 0 });
+		_nodes.push_back({ node.X,        node.Y + half, half, NodeState::Free, 0 });
+		_nodes.push_back({ node.X + half, node.Y + half, half, NodeState::Free, 0 });
+	}
+
+	for (uint32_t ix = 0; ix < 4; ix++) {
+		if (_Allocate(node.FirstChild + ix, size, outRect)) {
+			return true;
+		}
+	}
+	return false;
+}
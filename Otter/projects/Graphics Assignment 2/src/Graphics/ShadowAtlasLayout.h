@@ -0,0 +1,76 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <GLM/glm.hpp>
+
+/// <summary>
+/// Hands out square tiles from a square area using a quadtree, where each tile is a power of two and
+/// is split into four when a smaller tile is needed. This is the packing used by ShadowAtlas, kept
+/// apart from the atlas' depth texture so that it doesn't need a GL context
+///
+/// The layout is expected to be cleared and filled each frame, from the largest tiles to the smallest,
+/// which keeps the quadtree tightly packed
+/// </summary>
+class ShadowAtlasLayout final {
+public:
+	/// <summary>
+	/// The smallest tile that will be handed out, in pixels
+	/// </summary>
+	inline static const uint32_t MIN_TILE_SIZE = 64;
+
+	/// <summary>
+	/// Creates a new, empty layout
+	/// </summary>
+	/// <param name="size">The width and height of the area in pixels, must be a power of two</param>
+	ShadowAtlasLayout(uint32_t size);
+	~ShadowAtlasLayout() = default;
+
+	/// <summary>
+	/// Frees all the tiles in the layout
+	/// </summary>
+	void Clear();
+	/// <summary>
+	/// Allocates a square tile
+	/// </summary>
+	/// <param name="size">The size of the tile in pixels, this will be rounded up to a power of two</param>
+	/// <param name="outRect">Receives the tile as (x, y, width, height) in pixels</param>
+	/// <returns>True if a tile was allocated, false if there was no space left for a tile of that size</returns>
+	bool Allocate(uint32_t size, glm::ivec4& outRect);
+
+	/// <summary>
+	/// Rounds a resolution up to the nearest tile size that can be allocated
+	/// </summary>
+	/// <param name="size">The resolution to round, in pixels</param>
+	uint32_t GetTileSize(uint32_t size) const;
+	/// <summary>
+	/// Rounds a resolution down to the largest tile size that fits inside of it, so that a tile never
+	/// has more texels than the resolution it was asked for. Sizes below MIN_TILE_SIZE give MIN_TILE_SIZE
+	/// </summary>
+	/// <param name="size">The resolution to round, in pixels</param>
+	uint32_t GetLargestTileSize(uint32_t size) const;
+
+	/// <summary>
+	/// Gets the width and height of the area in pixels
+	/// </summary>
+	uint32_t GetSize() const { return _size; }
+
+private:
+	enum class NodeState {
+		Free,
+		Split,
+		Used
+	};
+
+	struct Node {
+		uint32_t  X, Y;
+		uint32_t  Size;
+		NodeState State;
+		// The index of the first of the node's 4 children, only valid once the node is split
+		uint32_t  FirstChild;
+	};
+
+	uint32_t          _size;
+	std::vector<Node> _nodes;
+
+	bool _Allocate(uint32_t nodeIx, uint32_t size, glm::ivec4& outRect);
+};
@@ -0,0 +1,80 @@
+#include "ShadowCascades.h"
+#include <GLM/gtc/matrix_transform.hpp>
+
+// Converts a view depth to a normalized device depth using the camera's projection
+static float ViewDepthToNdc(const glm::mat4& projection, float depth) {
+	glm::vec4 clip = projection * glm::vec4(0.0f, 0.0f, -depth, 1.0f);
+	return clip.z / clip.w;
+}
+
+void ShadowCascades::CalculateSplits(float nearPlane, float farPlane, int count, float lambda, float* outSplits) {
+	count = glm::clamp(count, 1, MAX_CASCADES);
+	lambda = glm::clamp(lambda, 0.0f, 1.0f);
+	nearPlane = glm::max(nearPlane, 0.0001f);
+
+	outSplits[0] = nearPlane;
+	for (int ix = 1; ix < count; ix++) {
+		float t = ix / static_cast<float>(count);
+		float logSplit = nearPlane * glm::pow(farPlane / nearPlane, t);
+		float uniformSplit = nearPlane + (farPlane - nearPlane) * t;
+		outSplits[ix] = glm::mix(uniformSplit, logSplit, lambda);
+	}
+	outSplits[count] = farPlane;
+}
+
+void ShadowCascades::GetSliceCorners(const glm::mat4& inverseViewProjection, const glm::mat4& cameraProjection, float nearDepth, float farDepth, glm::vec3* outCorners) {
+	float ndcDepths[2] = { ViewDepthToNdc(cameraProjection, nearDepth), ViewDepthToNdc(cameraProjection, farDepth) };
+	for (int ix = 0; ix < 8; ix++) {
+		glm::vec4 corner = inverseViewProjection * glm::vec4((ix & 1) ? 1.0f : -1.0f, (ix & 2) ? 1.0f : -1.0f, ndcDepths[ix >> 2], 1.0f);
+		outCorners[ix] = glm::vec3(corner) / corner.w;
+	}
+}
+
+ShadowCascades::Cascade ShadowCascades::FitCascade(
+	const glm::mat4& cameraView, const glm::mat4& cameraProjection,
+	float nearDepth, float farDepth,
+	const glm::mat3& lightRotation, uint32_t resolution, float casterDistance)
+{
+	// Fit the sphere in the camera's view space, where the slice is the same no matter where the camera
+	// is or how it's rotated, so the projection only ever moves and never scales
+	glm::vec3 corners[8];
+	GetSliceCorners(glm::inverse(cameraProjection), cameraProjection, nearDepth, farDepth, corners);
+
+	glm::vec3 viewCenter = glm::vec3(0.0f);
+	for (const glm::vec3& corner : corners) {
+		viewCenter += corner;
+	}
+	viewCenter /= 8.0f;
+	float radius = 0.0f;
+	for (const glm::vec3& corner : corners) {
+		radius = glm::max(radius, glm::length(corner - viewCenter));
+	}
+	// Round the radius up so that the size of the texels is a tidy number
+	radius = glm::ceil(radius * 16.0f) / 16.0f;
+	glm::vec3 center = glm::vec3(glm::inverse(cameraView) * glm::vec4(viewCenter, 1.0f));
+
+	Cascade result;
+	result.Center = center;
+	result.Radius = radius;
+	// The view only rotates into the light's space, so that snapping below is relative to a fixed grid
+	result.View = glm::mat4(glm::transpose(lightRotation));
+
+	// Snap the center of the projection to whole texels, so that the shadow map is always sampled
+	// at the same world space positions
+	glm::vec3 lightCenter = glm::mat3(result.View) * center;
+	float texelSize = (radius * 2.0f) / glm::max(resolution, 1u);
+	lightCenter.x = glm::floor(lightCenter.x / texelSize) * texelSize;
+	lightCenter.y = glm::floor(lightCenter.y / texelSize) * texelSize;
+	// The depth range is snapped the same way, otherwise the near and far planes would follow every
+	// small camera move and the projection would never stay the same between frames
+	lightCenter.z = glm::floor(lightCenter.z / texelSize) * texelSize;
+
+	// The light looks down it's -Z axis, so the slice covers distances of -center.z +/- radius. Snapping
+	// moved the center up to a texel away from the light, so the near plane is pulled back by a texel
+	result.Projection = glm::ortho(
+		lightCenter.x - radius, lightCenter.x + radius,
+		lightCenter.y - radius, lightCenter.y + radius,
+		-lightCenter.z - radius - casterDistance - texelSize, -lightCenter.z + radius);
+
+	return result;
+}
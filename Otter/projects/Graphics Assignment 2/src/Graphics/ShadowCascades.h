@@ -0,0 +1,79 @@
+#pragma once
+#include <cstdint>
+#include <GLM/glm.hpp>
+
+/// <summary>
+/// Helpers for splitting a camera's view into cascades for directional shadow maps, and for
+/// fitting a stable orthographic shadow projection around each cascade
+///
+/// Cascades are fit to a bounding sphere around their slice of the camera's frustum, so the size
+/// of the projection does not change as the camera rotates, and the projection is snapped to whole
+/// shadow map texels so that shadow edges do not shimmer as the camera moves
+/// </summary>
+class ShadowCascades
+{
+public:
+	/// <summary>
+	/// The maximum number of cascades that a directional light can use
+	/// </summary>
+	static const int MAX_CASCADES = 4;
+
+	/// <summary>
+	/// A single cascade's shadow projection
+	/// </summary>
+	struct Cascade {
+		/// <summary>
+		/// The light's view matrix, this only contains the light's rotation
+		/// </summary>
+		glm::mat4 View;
+		/// <summary>
+		/// The orthographic projection around the cascade, in the light's view space
+		/// </summary>
+		glm::mat4 Projection;
+		/// <summary>
+		/// The bounding sphere of the cascade's slice of the camera frustum, in world space
+		/// </summary>
+		glm::vec3 Center;
+		float     Radius;
+	};
+
+	/// <summary>
+	/// Calculates the view depths at which to split the camera's frustum into cascades, using the
+	/// practical split scheme, which blends between logarithmic and uniform splits
+	/// </summary>
+	/// <param name="nearPlane">The view depth that the first cascade starts at</param>
+	/// <param name="farPlane">The view depth that the last cascade ends at</param>
+	/// <param name="count">The number of cascades, between 1 and MAX_CASCADES</param>
+	/// <param name="lambda">The blend between uniform (0) and logarithmic (1) splits</param>
+	/// <param name="outSplits">Receives count + 1 view depths, where cascade i covers outSplits[i] to outSplits[i + 1]</param>
+	static void CalculateSplits(float nearPlane, float farPlane, int count, float lambda, float* outSplits);
+
+	/// <summary>
+	/// Fits a texel snapped orthographic projection around a slice of the camera's frustum
+	/// </summary>
+	/// <param name="cameraView">The camera's view matrix</param>
+	/// <param name="cameraProjection">The camera's projection matrix</param>
+	/// <param name="nearDepth">The view depth that the slice starts at</param>
+	/// <param name="farDepth">The view depth that the slice ends at</param>
+	/// <param name="lightRotation">The light's rotation, the light shines along it's -Z axis</param>
+	/// <param name="resolution">The resolution of the cascade's shadow map in pixels</param>
+	/// <param name="casterDistance">How far towards the light the projection extends past the slice, to catch casters outside of the view</param>
+	static Cascade FitCascade(
+		const glm::mat4& cameraView, const glm::mat4& cameraProjection,
+		float nearDepth, float farDepth,
+		const glm::mat3& lightRotation, uint32_t resolution, float casterDistance);
+
+	/// <summary>
+	/// Gets the world space corners of a slice of the camera's frustum
+	/// </summary>
+	/// <param name="inverseViewProjection">The inverse of the camera's view projection matrix</param>
+	/// <param name="cameraProjection">The camera's projection matrix</param>
+	/// <param name="nearDepth">The view depth that the slice starts at</param>
+	/// <param name="farDepth">The view depth that the slice ends at</param>
+	/// <param name="outCorners">Receives the 8 corners of the slice, near corners first</param>
+	static void GetSliceCorners(const glm::mat4& inverseViewProjection, const glm::mat4& cameraProjection, float nearDepth, float farDepth, glm::vec3* outCorners);
+
+protected:
+	ShadowCascades() = default;
+	~ShadowCascades() = default;
+};
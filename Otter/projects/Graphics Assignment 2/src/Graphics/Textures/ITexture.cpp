@@ -1,4 +1,5 @@
 #include "ITexture.h"
+#include "Graphics/GlState.h"
 
 ITexture::Limits ITexture::__limits = ITexture::Limits();
 bool ITexture::__isStaticInit = false;
@@ -13,7 +14,8 @@ ITexture::ITexture(TextureType type) :
 
 void ITexture::_Recreate()
 {
-	if (_rendererId == 0) {
+	if (_rendererId != 0) {
+		GlState::OnTextureDeleted(_rendererId);
 		glDeleteTextures(1, &_rendererId);
 	}
 	glCreateTextures((GLenum)_type, 1, &_rendererId);
@@ -21,6 +23,7 @@ void ITexture::_Recreate()
 
 ITexture::~ITexture() {
 	if (glIsTexture(_rendererId)) {
+		GlState::OnTextureDeleted(_rendererId);
 		glDeleteTextures(1, &_rendererId);
 		_rendererId = 0;
 	}
@@ -29,12 +32,12 @@ ITexture::~ITexture() {
 void ITexture::Bind(int slot) {
 	if (_rendererId != 0) {
 		// Instead of glActiveTexture + glBindTexture, we can one line it now :D
-		glBindTextureUnit(slot, _rendererId); 
+		GlState::BindTextureUnit(slot, _rendererId);
 	}
 }
 
 void ITexture::Unbind(int slot) {
-	glBindTextureUnit(slot, 0);
+	GlState::BindTextureUnit(slot, 0);
 }
 
 void ITexture::Clear(const glm::vec4& color) {
@@ -4,6 +4,7 @@
 #include "GLM/glm.hpp"
 #include "Utils/JsonGlmHelpers.h"
 #include "Utils/Base64.h"
+#include "Graphics/GlState.h"
 
 /// <summary>
 /// Get the number of mipmap levels required for a texture of the given size
@@ -202,6 +203,7 @@ void Texture2D::_LoadDataFromFile() {
 void Texture2D::_SetTextureParams() {
 	// If we have a multisampled texture, and the current type is 2D, change it to 2D multisampled
 	if (_description.MultisampleCount > 1 && _type == TextureType::_2D) {
+		GlState::OnTextureDeleted(_rendererId);
 		glDeleteTextures(1, &_rendererId);
 		_type = TextureType::_2DMultisample;
 		glCreateTextures(*_type, 1, &_rendererId);
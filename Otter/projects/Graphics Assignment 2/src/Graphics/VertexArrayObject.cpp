@@ -2,13 +2,15 @@
 #include "Buffers/IndexBuffer.h"
 #include "Buffers/VertexBuffer.h"
 #include "Logging.h"
+#include "GlState.h"
 
 VertexArrayObject::VertexArrayObject() :
 	_indexBuffer(nullptr),
-	_handle(0),
+	_vertexBuffers(std::vector<VertexBufferBinding*>()),
 	_vertexCount(0),
 	_elementCount(0),
-	_vertexBuffers(std::vector<VertexBufferBinding*>())
+	_handle(0),
+	_indexHandle(0)
 {
 	glCreateVertexArrays(1, &_handle);
 }
@@ -16,6 +18,7 @@ VertexArrayObject::VertexArrayObject() :
 VertexArrayObject::~VertexArrayObject()
 {
 	if (_handle != 0) {
+		GlState::OnVertexArrayDeleted(_handle);
 		glDeleteVertexArrays(1, &_handle);
 		_handle = 0;
 	}
@@ -27,10 +30,12 @@ void VertexArrayObject::SetIndexBuffer(const IndexBuffer::Sptr& ibo) {
 	Bind();
 	if (_indexBuffer != nullptr) {
 		_indexBuffer->Bind();
+		_indexHandle = _indexBuffer->GetHandle();
 		_elementCount = _indexBuffer->GetElementCount();
 	}
 	else {
 		IndexBuffer::Unbind();
+		_indexHandle = 0;
 		_elementCount = _vertexCount;
 	}
 	Unbind();
@@ -43,7 +48,7 @@ VertexArrayObject::VertexBufferBinding* VertexArrayObject::AddVertexBuffer(const
 			_elementCount = _vertexCount;
 		}
 	} 
-	else if (buffer->GetElementCount() != _vertexCount) {
+	else if (!instanced && buffer->GetElementCount() != _vertexCount) {
 		LOG_WARN("Buffer element count does not match vertex count of this VAO!!!");
 	}
 
@@ -53,20 +58,26 @@ VertexArrayObject::VertexBufferBinding* VertexArrayObject::AddVertexBuffer(const
 	binding->Instanced = instanced;
 	_vertexBuffers.push_back(binding);
 
+	GlState::BindVertexArray(_handle);
+	_BindAttributes(binding);
+	Unbind();
 
-	Bind();
-	buffer->Bind();
-	for (const BufferAttribute& attrib : attributes) {
+	return binding;
+}
+
+void VertexArrayObject::_BindAttributes(VertexBufferBinding* binding) {
+	uint32_t offset = binding->Buffer->GetDataOffset();
+	binding->Buffer->Bind();
+	for (const BufferAttribute& attrib : binding->Attributes) {
 		glEnableVertexArrayAttrib(_handle, attrib.Slot);
 		glVertexAttribPointer(attrib.Slot, attrib.Size, (GLenum)attrib.Type, attrib.Normalized, attrib.Stride,
-							  (void*)attrib.Offset);
+							  (void*)(static_cast<size_t>(attrib.Offset) + offset));
 
 		// Here is where we select whether the attribute is instanced or not
-		glVertexAttribDivisor(attrib.Slot, instanced ? 1 : 0);
+		glVertexAttribDivisor(attrib.Slot, binding->Instanced ? 1 : 0);
 	}
-	Unbind();
-
-	return binding;
+	binding->BoundHandle = binding->Buffer->GetHandle();
+	binding->BoundOffset = offset;
 }
 
 void VertexArrayObject::ReplaceVertexBuffer(VertexBufferBinding* binding, const VertexBuffer::Sptr& buffer)
@@ -85,16 +96,8 @@ void VertexArrayObject::ReplaceVertexBuffer(VertexBufferBinding* binding, const
 		binding->Buffer = buffer;
 
 		// Re-bind the buffer and attributes
-		Bind();
-		buffer->Bind();
-		for (const BufferAttribute& attrib : binding->Attributes) {
-			glEnableVertexArrayAttrib(_handle, attrib.Slot);
-			glVertexAttribPointer(attrib.Slot, attrib.Size, (GLenum)attrib.Type, attrib.Normalized, attrib.Stride,
-				(void*)attrib.Offset);
-
-			// Here is where we select whether the attribute is instanced or not
-			glVertexAttribDivisor(attrib.Slot, binding->Instanced ? 1 : 0);
-		}
+		GlState::BindVertexArray(_handle);
+		_BindAttributes(binding);
 		Unbind();
 	}
 
@@ -108,7 +111,7 @@ void VertexArrayObject::Draw(DrawMode mode) {
 		glDrawArrays((GLenum)mode, 0, elements);
 	} else {
 		uint32_t elements = _elementCount == 0 ? _indexBuffer->GetElementCount() : _elementCount;
-		glDrawElements((GLenum)mode, elements, (GLenum)_indexBuffer->GetElementType(), nullptr);
+		glDrawElements((GLenum)mode, elements, (GLenum)_indexBuffer->GetElementType(), (void*)static_cast<size_t>(_indexBuffer->GetDataOffset()));
 	}
 	Unbind();
 }
@@ -122,18 +125,30 @@ void VertexArrayObject::DrawInstanced(uint32_t instanceCount, DrawMode mode /*=
 	}
 	else {
 		uint32_t elements = _elementCount == 0 ? _indexBuffer->GetElementCount() : _elementCount;
-		glDrawElementsInstanced((GLenum)mode, elements, (GLenum)_indexBuffer->GetElementType(), nullptr, instanceCount);
+		glDrawElementsInstanced((GLenum)mode, elements, (GLenum)_indexBuffer->GetElementType(), (void*)static_cast<size_t>(_indexBuffer->GetDataOffset()), instanceCount);
 	}
 	Unbind();
 	
 }
 
 void VertexArrayObject::Bind() {
-	glBindVertexArray(_handle);
+	GlState::BindVertexArray(_handle);
+
+	// Streaming buffers move their data every time they're written to, and buffers with immutable storage
+	// are re-created when they grow, so our attributes may be pointing at old data
+	for (VertexBufferBinding* binding : _vertexBuffers) {
+		if (binding->Buffer->GetHandle() != binding->BoundHandle || binding->Buffer->GetDataOffset() != binding->BoundOffset) {
+			_BindAttributes(binding);
+		}
+	}
+	if (_indexBuffer != nullptr && _indexBuffer->GetHandle() != _indexHandle) {
+		_indexBuffer->Bind();
+		_indexHandle = _indexBuffer->GetHandle();
+	}
 }
 
 void VertexArrayObject::Unbind() {
-	glBindVertexArray(0);
+	GlState::BindVertexArray(0);
 }
 
 void VertexArrayObject::SetVDecl(const VertexDeclaration& vDecl) {
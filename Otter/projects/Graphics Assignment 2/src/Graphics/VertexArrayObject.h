@@ -75,6 +75,10 @@ public:
 		VertexBuffer::Sptr Buffer;
 		std::vector<BufferAttribute> Attributes;
 		bool Instanced;
+		// The buffer handle and data offset that the attributes were last pointed at, buffers with
+		// immutable or streaming storage may be re-created or move their data around
+		GLuint   BoundHandle = 0;
+		uint32_t BoundOffset = 0;
 	};
 	
 public:
@@ -135,7 +139,8 @@ public:
 	void DrawInstanced(uint32_t instanceCount, DrawMode mode = DrawMode::TriangleList);
 
 	/// <summary>
-	/// Binds this VAO as the source of data for draw operations
+	/// Binds this VAO as the source of data for draw operations, re-pointing the attributes at any
+	/// buffers that have been re-created or written to a new offset since the last bind
 	/// </summary>
 	void Bind();
 	/// <summary>
@@ -167,6 +172,13 @@ protected:
 
 	// The underlying OpenGL handle that this class is wrapping around
 	GLuint _handle;
+	// The handle of the index buffer that is bound to the VAO
+	GLuint _indexHandle;
+
+	/// <summary>
+	/// Points the binding's attributes at it's buffer, the VAO must already be bound
+	/// </summary>
+	void _BindAttributes(VertexBufferBinding* binding);
 
 	// Inherited via IGraphicsResource
 	virtual GlResourceType GetResourceClass() const override;
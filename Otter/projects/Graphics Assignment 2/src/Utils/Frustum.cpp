@@ -0,0 +1,169 @@
+#include "Utils/Frustum.h"
+#include <cfloat>
+
+#include "Utils/Simd.h"
+
+ScreenRect ScreenRect::FromNdc(const glm::vec2& minNdc, const glm::vec2& maxNdc, float nearestDepth, const glm::ivec2& size) {
+	ScreenRect result;
+	result.NearestDepth = nearestDepth;
+	if (maxNdc.x < -1.0f || maxNdc.y < -1.0f || minNdc.x > 1.0f || minNdc.y > 1.0f) {
+		result.Min = glm::ivec2(0);
+		result.Max = glm::ivec2(-1);
+		return result;
+	}
+
+	glm::vec2 pixels = glm::vec2(size);
+	result.Min = glm::ivec2(glm::clamp((minNdc * 0.5f + 0.5f) * pixels, glm::vec2(0.0f), pixels - 1.0f));
+	result.Max = glm::ivec2(glm::clamp((maxNdc * 0.5f + 0.5f) * pixels, glm::vec2(0.0f), pixels - 1.0f));
+	return result;
+}
+
+BoundingBox BoundingBox::Transformed(const glm::mat4& transform) const {
+	// Transform the center as usual, and project the extents onto the new axes (Arvo's method)
+	glm::vec3 center = transform * glm::vec4(GetCenter(), 1.0f);
+	glm::vec3 extents = GetExtents();
+	glm::vec3 newExtents =
+		glm::abs(glm::vec3(transform[0])) * extents.x +
+		glm::abs(glm::vec3(transform[1])) * extents.y +
+		glm::abs(glm::vec3(transform[2])) * extents.z;
+	return { center - newExtents, center + newExtents };
+}
+
+bool BoundingBox::Project(const glm::mat4& viewProjection, glm::vec2& outMinNdc, glm::vec2& outMaxNdc, float& outNearestDepth) const {
+	outMinNdc = glm::vec2(FLT_MAX);
+	outMaxNdc = glm::vec2(-FLT_MAX);
+	float nearest = FLT_MAX;
+
+	for (int corner = 0; corner < 8; corner++) {
+		glm::vec3 point = glm::vec3(
+			(corner & 1) ? Max.x : Min.x,
+			(corner & 2) ? Max.y : Min.y,
+			(corner & 4) ? Max.z : Min.z);
+		glm::vec4 clip = viewProjection * glm::vec4(point, 1.0f);
+
+		// Corners in front of the near plane can't be projected
+		if (clip.w <= 1e-5f || clip.z < -clip.w) {
+			return false;
+		}
+		glm::vec3 ndc = glm::vec3(clip) / clip.w;
+		outMinNdc = glm::min(outMinNdc, glm::vec2(ndc));
+		outMaxNdc = glm::max(outMaxNdc, glm::vec2(ndc));
+		nearest = glm::min(nearest, ndc.z);
+	}
+
+	outNearestDepth = nearest * 0.5f + 0.5f;
+	return true;
+}
+
+bool BoundingBox::ProjectToPixels(const glm::mat4& viewProjection, const glm::ivec2& size, ScreenRect& outRect) const {
+	glm::vec2 minNdc, maxNdc;
+	float nearest;
+	if (!Project(viewProjection, minNdc, maxNdc, nearest)) {
+		return false;
+	}
+	outRect = ScreenRect::FromNdc(minNdc, maxNdc, nearest, size);
+	return true;
+}
+
+BoundingSphere BoundingSphere::Transformed(const glm::mat4& transform) const {
+	float scaleSq = glm::max(
+		glm::dot(glm::vec3(transform[0]), glm::vec3(transform[0])), glm::max(
+		glm::dot(glm::vec3(transform[1]), glm::vec3(transform[1])),
+		glm::dot(glm::vec3(transform[2]), glm::vec3(transform[2]))));
+	return { glm::vec3(transform * glm::vec4(Center, 1.0f)), Radius * glm::sqrt(scaleSq) };
+}
+
+Frustum Frustum::FromViewProjection(const glm::mat4& viewProjection) {
+	// GLM matrices are column major, so we need to pull out the rows ourselves
+	glm::vec4 rows[4];
+	for (int ix = 0; ix < 4; ix++) {
+		rows[ix] = glm::vec4(viewProjection[0][ix], viewProjection[1][ix], viewProjection[2][ix], viewProjection[3][ix]);
+	}
+
+	Frustum result;
+	result.Planes[0] = rows[3] + rows[0];
+	result.Planes[1] = rows[3] - rows[0];
+	result.Planes[2] = rows[3] + rows[1];
+	result.Planes[3] = rows[3] - rows[1];
+	result.Planes[4] = rows[3] + rows[2];
+	result.Planes[5] = rows[3] - rows[2];
+	for (glm::vec4& plane : result.Planes) {
+		plane /= glm::length(glm::vec3(plane));
+	}
+	return result;
+}
+
+bool Frustum::Intersects(const BoundingSphere& sphere) const {
+	for (const glm::vec4& plane : Planes) {
+		if (glm::dot(glm::vec3(plane), sphere.Center) + plane.w < -sphere.Radius) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool Frustum::Intersects(const BoundingBox& box) const {
+	for (const glm::vec4& plane : Planes) {
+		// Test the corner of the box that is furthest along the plane's normal
+		glm::vec3 corner = glm::vec3(
+			plane.x >= 0.0f ? box.Max.x : box.Min.x,
+			plane.y >= 0.0f ? box.Max.y : box.Min.y,
+			plane.z >= 0.0f ? box.Max.z : box.Min.z);
+		if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f) {
+			return false;
+		}
+	}
+	return true;
+}
+
+uint32_t Frustum::CullSpheres(const glm::vec4* spheres, uint32_t count, uint32_t* outVisible) const {
+	uint32_t result = 0;
+	uint32_t ix = 0;
+
+	#if SIMD_USE_SSE
+	// Splat each plane across a register once, so the loop only has to load the spheres
+	__m128 planeX[6], planeY[6], planeZ[6], planeW[6];
+	for (int plane = 0; plane < 6; plane++) {
+		planeX[plane] = _mm_set1_ps(Planes[plane].x);
+		planeY[plane] = _mm_set1_ps(Planes[plane].y);
+		planeZ[plane] = _mm_set1_ps(Planes[plane].z);
+		planeW[plane] = _mm_set1_ps(Planes[plane].w);
+	}
+
+	// Test 4 spheres at a time, with each SSE lane holding a different sphere
+	for (; ix + 4 <= count; ix += 4) {
+		__m128 x = _mm_loadu_ps(&spheres[ix + 0].x);
+		__m128 y = _mm_loadu_ps(&spheres[ix + 1].x);
+		__m128 z = _mm_loadu_ps(&spheres[ix + 2].x);
+		__m128 r = _mm_loadu_ps(&spheres[ix + 3].x);
+		_MM_TRANSPOSE4_PS(x, y, z, r);
+
+		// A sphere is visible if it is not entirely behind any of the planes. The distance is summed in the
+		// same order as Intersects, so that spheres sitting right on a plane get the same answer
+		__m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), r);
+		__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+		for (int plane = 0; plane < 6; plane++) {
+			__m128 distance = _mm_add_ps(
+				_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, planeX[plane]), _mm_mul_ps(y, planeY[plane])), _mm_mul_ps(z, planeZ[plane])),
+				planeW[plane]);
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negRadius));
+		}
+
+		int mask = _mm_movemask_ps(inside);
+		for (int lane = 0; lane < 4; lane++) {
+			if (mask & (1 << lane)) {
+				outVisible[result++] = ix + lane;
+			}
+		}
+	}
+	#endif
+
+	// Scalar path for the remaining spheres (or everything if we don't have SSE)
+	for (; ix < count; ix++) {
+		if (Intersects(BoundingSphere{ glm::vec3(spheres[ix]), spheres[ix].w })) {
+			outVisible[result++] = ix;
+		}
+	}
+
+	return result;
+}
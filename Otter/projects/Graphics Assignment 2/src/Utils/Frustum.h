@@ -0,0 +1,119 @@
+#pragma once
+#include <cstdint>
+#include <GLM/glm.hpp>
+
+/// <summary>
+/// A range of pixels on a depth buffer that an object covers, along with the object's closest depth.
+/// Both corners are inclusive
+/// </summary>
+struct ScreenRect {
+	glm::ivec2 Min;
+	glm::ivec2 Max;
+	float      NearestDepth;
+
+	/// <summary>
+	/// Returns true if the rectangle does not cover any pixels, which happens when it is entirely off screen
+	/// </summary>
+	bool IsEmpty() const { return Max.x < Min.x || Max.y < Min.y; }
+
+	/// <summary>
+	/// Converts a rectangle in normalized device coordinates to the pixels it covers on a buffer,
+	/// clamped to the edges of the buffer
+	/// </summary>
+	/// <param name="minNdc">The bottom left corner of the rectangle, in normalized device coordinates</param>
+	/// <param name="maxNdc">The top right corner of the rectangle, in normalized device coordinates</param>
+	/// <param name="nearestDepth">The closest depth of the object inside the rectangle, from 0 (near) to 1 (far)</param>
+	/// <param name="size">The size of the buffer in pixels</param>
+	static ScreenRect FromNdc(const glm::vec2& minNdc, const glm::vec2& maxNdc, float nearestDepth, const glm::ivec2& size);
+};
+
+/// <summary>
+/// An axis aligned bounding box, stored as it's minimum and maximum corners
+/// </summary>
+struct BoundingBox {
+	glm::vec3 Min;
+	glm::vec3 Max;
+
+	glm::vec3 GetCenter() const { return (Min + Max) * 0.5f; }
+	glm::vec3 GetExtents() const { return (Max - Min) * 0.5f; }
+
+	/// <summary>
+	/// Gets the axis aligned box that contains this box after it has been transformed
+	/// </summary>
+	/// <param name="transform">The affine transform to apply to the box</param>
+	BoundingBox Transformed(const glm::mat4& transform) const;
+
+	/// <summary>
+	/// Projects this box onto the screen, giving the rectangle that it covers and it's closest depth
+	/// </summary>
+	/// <param name="viewProjection">The camera's view projection matrix</param>
+	/// <param name="outMinNdc">Receives the bottom left corner of the rectangle, in normalized device coordinates</param>
+	/// <param name="outMaxNdc">Receives the top right corner of the rectangle, in normalized device coordinates</param>
+	/// <param name="outNearestDepth">Receives the closest depth of the box, from 0 (near) to 1 (far)</param>
+	/// <returns>False if part of the box is in front of the near plane, in which case the rectangle is not valid</returns>
+	bool Project(const glm::mat4& viewProjection, glm::vec2& outMinNdc, glm::vec2& outMaxNdc, float& outNearestDepth) const;
+	/// <summary>
+	/// Projects this box onto a buffer, giving the pixels that it covers and it's closest depth
+	/// </summary>
+	/// <param name="viewProjection">The camera's view projection matrix</param>
+	/// <param name="size">The size of the buffer in pixels</param>
+	/// <param name="outRect">Receives the pixels covered by the box, which will be empty if the box is off screen</param>
+	/// <returns>False if part of the box is in front of the near plane, in which case the rectangle is not valid</returns>
+	bool ProjectToPixels(const glm::mat4& viewProjection, const glm::ivec2& size, ScreenRect& outRect) const;
+};
+
+/// <summary>
+/// A bounding sphere, stored as it's center and radius
+/// </summary>
+struct BoundingSphere {
+	glm::vec3 Center;
+	float     Radius;
+
+	/// <summary>
+	/// Gets the sphere that contains this sphere after it has been transformed. Non-uniform
+	/// scales will grow the sphere by the largest scaling factor
+	/// </summary>
+	/// <param name="transform">The affine transform to apply to the sphere</param>
+	BoundingSphere Transformed(const glm::mat4& transform) const;
+};
+
+/// <summary>
+/// The 6 planes that bound the volume a camera can see. Plane normals point into the
+/// frustum, and are normalized so that the plane equation gives the distance to the plane
+/// </summary>
+struct Frustum {
+	/// <summary>
+	/// The planes of the frustum, in the order left, right, bottom, top, near, far
+	/// Each plane is stored as (normal, distance) so that dot(normal, point) + distance
+	/// is positive for points inside of the frustum
+	/// </summary>
+	glm::vec4 Planes[6];
+
+	/// <summary>
+	/// Extracts the planes of a frustum from a view projection matrix (Gribb-Hartmann), the
+	/// resulting planes will be in the space that the matrix transforms from
+	/// </summary>
+	/// <param name="viewProjection">The combined view and projection matrix</param>
+	static Frustum FromViewProjection(const glm::mat4& viewProjection);
+
+	/// <summary>
+	/// Returns true if the sphere is at least partially inside of the frustum. This is conservative,
+	/// and may return true for spheres near the corners of the frustum that are outside of it
+	/// </summary>
+	bool Intersects(const BoundingSphere& sphere) const;
+	/// <summary>
+	/// Returns true if the box is at least partially inside of the frustum. This is conservative,
+	/// and may return true for boxes near the corners of the frustum that are outside of it
+	/// </summary>
+	bool Intersects(const BoundingBox& box) const;
+
+	/// <summary>
+	/// Tests a batch of spheres against the frustum, 4 at a time where SSE is available,
+	/// and writes out the indices of the spheres that are at least partially inside of it
+	/// </summary>
+	/// <param name="spheres">The spheres to test, stored as (center, radius)</param>
+	/// <param name="count">The number of spheres to test</param>
+	/// <param name="outVisible">Receives the indices of the visible spheres, must have room for count indices</param>
+	/// <returns>The number of indices written to outVisible</returns>
+	uint32_t CullSpheres(const glm::vec4* spheres, uint32_t count, uint32_t* outVisible) const;
+};
@@ -11,6 +11,7 @@
 #include "imgui_internal.h"
 
 #include <Logging.h>
+#include "Graphics/GlState.h"
 
 #include <GLM/glm.hpp>
 #include "StringUtils.h"
@@ -232,6 +233,10 @@ void ImGuiHelper::EndFrame() {
 		{ (R + L) / (L - R),  (T + B) / (B - T),  0.0f,   1.0f },
 	};
 	glProgramUniformMatrix4fv(_linearDepthShader->GetHandle(), 0, 1, GL_FALSE, &ortho_projection[0][0]);
+
+	// ImGui's backend sets up it's own state without the cache, so forget what the cache knows before any
+	// of our draw callbacks go through it
+	GlState::Invalidate();
 	ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 
 	// If we have multiple viewports enabled (can drag into a new window)
@@ -242,5 +247,8 @@ void ImGuiHelper::EndFrame() {
 		// Restore our gl context
 		glfwMakeContextCurrent(_window);
 	}
+
+	// ImGui's backend and our draw callbacks change state behind the state cache's back
+	GlState::Invalidate();
 }
 
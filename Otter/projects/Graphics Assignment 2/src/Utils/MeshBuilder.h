@@ -70,6 +70,16 @@ public:
 		_indices.push_back(index);
 	}
 
+	/// <summary>
+	/// Adds a range of indices to the index buffer
+	/// </summary>
+	/// <param name="data">The array of indices to append to the buffer</param>
+	/// <param name="count">The number of indices in data</param>
+	void AddIndexRange(const uint32_t* data, size_t count) {
+		_indices.reserve(_indices.size() + count);
+		std::copy(data, data + count, std::back_inserter(_indices));
+	}
+
 	/// <summary>
 	/// Adds a triangle between the three indices
 	/// </summary>
@@ -1,5 +1,11 @@
 #include "Utils/MeshFactory.h"
 
+#include <cstring>
+#include <cfloat>
+#include <algorithm>
+
+#include "Utils/WorkerPool.h"
+
 MeshBuilderParam MeshBuilderParam::CreateCube(const glm::vec3& pos, const glm::vec3& scale, const glm::vec3& eulerDeg /*= glm::vec3(0.0f)*/, const glm::vec4& col /*= glm::vec4(1.0f)*/) {
 	MeshBuilderParam result;
 	result.Type = MeshBuilderType::Cube;
@@ -78,4 +84,695 @@ nlohmann::json MeshBuilderParam::ToJson() const {
 		result["params"][key] = value;
 	}
 	return result;
-}
\ No newline at end of file
+}
+
+namespace {
+	// We won't split the tangent calculation across threads unless each thread gets at least this many triangles
+	const size_t TBN_MIN_TRIS_PER_THREAD = 16384;
+
+	/// <summary>
+	/// Per vertex sums of the tangents and bitangents from the fast mode
+	/// </summary>
+	struct TangentAccumulator {
+		glm::vec3 A;
+		glm::vec3 B;
+	};
+
+	struct TbnJob {
+		uint8_t*              Vertices;
+		size_t                Stride;
+		size_t                VertexCount;
+		const uint32_t*       Indices;
+		size_t                TriangleCount;
+		const VertexParamMap* Map;
+	};
+
+	inline glm::vec3 ReadVec3(const uint8_t* vertex, uint32_t offset) {
+		glm::vec3 result;
+		memcpy(&result, vertex + offset, sizeof(glm::vec3));
+		return result;
+	}
+
+	inline glm::vec2 ReadVec2(const uint8_t* vertex, uint32_t offset) {
+		glm::vec2 result;
+		memcpy(&result, vertex + offset, sizeof(glm::vec2));
+		return result;
+	}
+
+	inline void WriteVec3(uint8_t* vertex, uint32_t offset, const glm::vec3& value) {
+		if (offset != (uint32_t)-1) {
+			memcpy(vertex + offset, &value, sizeof(glm::vec3));
+		}
+	}
+
+	inline void Accumulate(TangentAccumulator& acc, const glm::vec3& tangent, const glm::vec3& bitangent) {
+		acc.A += tangent;
+		acc.B += bitangent;
+	}
+
+	// Standard UV derivative tangents, weighted by the size of the triangle
+	void AccumulateFast(const TbnJob& job, size_t triBegin, size_t triEnd, TangentAccumulator* acc) {
+		const VertexParamMap& map = *job.Map;
+		for (size_t tri = triBegin; tri < triEnd; tri++) {
+			const uint32_t* ix = job.Indices + tri * 3;
+			const uint8_t* v0 = job.Vertices + ix[0] * job.Stride;
+			const uint8_t* v1 = job.Vertices + ix[1] * job.Stride;
+			const uint8_t* v2 = job.Vertices + ix[2] * job.Stride;
+
+			glm::vec3 p0 = ReadVec3(v0, map.PositionOffset);
+			glm::vec3 deltaP1 = ReadVec3(v1, map.PositionOffset) - p0;
+			glm::vec3 deltaP2 = ReadVec3(v2, map.PositionOffset) - p0;
+
+			glm::vec2 uv0 = ReadVec2(v0, map.TextureOffset);
+			glm::vec2 deltaT1 = ReadVec2(v1, map.TextureOffset) - uv0;
+			glm::vec2 deltaT2 = ReadVec2(v2, map.TextureOffset) - uv0;
+
+			// https://learnopengl.com/Advanced-Lighting/Normal-Mapping
+			float det = deltaT1.x * deltaT2.y - deltaT1.y * deltaT2.x;
+			if (glm::abs(det) <= 1e-12f) {
+				continue;
+			}
+			float r = 1.0f / det;
+			glm::vec3 tangent = (deltaP1 * deltaT2.y - deltaP2 * deltaT1.y) * r;
+			glm::vec3 bitangent = (deltaP2 * deltaT1.x - deltaP1 * deltaT2.x) * r;
+
+			for (int corner = 0; corner < 3; corner++) {
+				Accumulate(acc[ix[corner]], tangent, bitangent);
+			}
+		}
+	}
+
+	// Any tangent that's perpendicular to the normal, for vertices that got no usable triangles
+	glm::vec3 AnyTangent(const glm::vec3& normal) {
+		glm::vec3 axis = glm::abs(normal.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+		return glm::normalize(axis - normal * glm::dot(normal, axis));
+	}
+
+	// Reduces the per-thread sums and writes the final orthonormal basis for a range of vertices
+	void ResolveTangents(const TbnJob& job, TangentAccumulator* const* accumulators, size_t accumulatorCount, size_t begin, size_t end) {
+		const VertexParamMap& map = *job.Map;
+		const bool hasNormals = map.NormalOffset != (uint32_t)-1;
+
+		for (size_t ix = begin; ix < end; ix++) {
+			TangentAccumulator sum = accumulators[0][ix];
+			for (size_t thread = 1; thread < accumulatorCount; thread++) {
+				sum.A += accumulators[thread][ix].A;
+				sum.B += accumulators[thread][ix].B;
+			}
+
+			uint8_t* vertex = job.Vertices + ix * job.Stride;
+			glm::vec3 normal = hasNormals ? ReadVec3(vertex, map.NormalOffset) : glm::vec3(0.0f);
+			float normalLength = glm::length(normal);
+			glm::vec3 tangent, bitangent;
+
+			if (normalLength > 0.0f) {
+				normal /= normalLength;
+				// Gram-Schmidt orthogonalize, and keep the handedness of the UVs
+				glm::vec3 t = sum.A - normal * glm::dot(normal, sum.A);
+				tangent = glm::length(t) > 0.0f ? glm::normalize(t) : AnyTangent(normal);
+				float handedness = glm::dot(glm::cross(normal, sum.A), sum.B) < 0.0f ? -1.0f : 1.0f;
+				bitangent = glm::cross(normal, tangent) * handedness;
+			} else {
+				tangent = glm::length(sum.A) > 0.0f ? glm::normalize(sum.A) : glm::vec3(1.0f, 0.0f, 0.0f);
+				bitangent = glm::length(sum.B) > 0.0f ? glm::normalize(sum.B) : glm::vec3(0.0f, 1.0f, 0.0f);
+			}
+
+			WriteVec3(vertex, map.TangentOffset, tangent);
+			WriteVec3(vertex, map.BiTangentOffset, bitangent);
+		}
+	}
+
+	// MikkTSpace, see http://www.mikktspace.com/ and the reference implementation in mikktspace.c. The steps
+	// and names below follow the reference, so that the two can be compared side by side. Our meshes are
+	// always triangulated, so the reference's handling of quads is left out
+
+	// We won't split the per triangle and per group work across threads unless each thread gets at least this many
+	const size_t MIKK_MIN_TRIS_PER_THREAD   = 16384;
+	const size_t MIKK_MIN_GROUPS_PER_THREAD = 16384;
+
+	const uint32_t MIKK_NONE = (uint32_t)-1;
+
+	// The UVs of the triangle are not mirrored
+	const uint8_t MIKK_ORIENT_PRESERVING = 0x01;
+	// The UVs of the triangle have no area, so it takes the tangent space of whichever group reaches it first
+	const uint8_t MIKK_GROUP_WITH_ANY    = 0x02;
+	// Two of the triangle's corners are in the same place
+	const uint8_t MIKK_DEGENERATE        = 0x04;
+
+	struct MikkTriangle {
+		// The direction of increasing U and V across the triangle, flipped when the UVs are mirrored
+		glm::vec3 Os;
+		glm::vec3 Ot;
+		// The triangle across the edge from corner i to corner i + 1, or MIKK_NONE
+		uint32_t  Neighbours[3];
+		// The group that each corner was put into, or MIKK_NONE
+		uint32_t  Groups[3];
+		uint8_t   Flags;
+	};
+
+	// The triangles around a vertex that are connected to each other and have the same UV winding
+	struct MikkGroup {
+		uint32_t Vertex;
+		bool     OrientPreserving;
+		uint32_t FaceOffset;
+		uint32_t FaceCount;
+	};
+
+	struct MikkCorner {
+		glm::vec3 Tangent;
+		bool      OrientPreserving;
+	};
+
+	struct MikkEdge {
+		uint32_t Low;
+		uint32_t High;
+		uint32_t Face;
+		uint32_t Edge;
+	};
+
+	// Vertices are welded by value, so that corners that only share a position, normal and UV (and not an
+	// index) still share a tangent space
+	struct MikkWeldKey {
+		float Values[8];
+		bool operator ==(const MikkWeldKey& other) const {
+			return memcmp(Values, other.Values, sizeof(Values)) == 0;
+		}
+		uint64_t Hash() const {
+			// FNV-1a over the bits of each value
+			uint64_t hash = 0xCBF29CE484222325ull;
+			for (float value : Values) {
+				uint32_t bits;
+				memcpy(&bits, &value, sizeof(uint32_t));
+				hash = (hash ^ bits) * 0x100000001B3ull;
+			}
+			return hash;
+		}
+	};
+
+	inline bool NotZero(float value) {
+		return glm::abs(value) > FLT_MIN;
+	}
+
+	inline bool NotZero(const glm::vec3& value) {
+		return NotZero(value.x) || NotZero(value.y) || NotZero(value.z);
+	}
+
+	// Normalizes the vector if it has a length, otherwise leaves it as it is
+	inline glm::vec3 SafeNormalize(const glm::vec3& value) {
+		return NotZero(value) ? value * (1.0f / glm::length(value)) : value;
+	}
+
+	// Projects the vector onto the plane of the normal, and normalizes the result
+	inline glm::vec3 ProjectOnto(const glm::vec3& normal, const glm::vec3& value) {
+		return SafeNormalize(value - normal * glm::dot(normal, value));
+	}
+
+	// Compares positions by value, so -0 and 0 are the same place
+	inline bool SamePosition(const glm::vec3& a, const glm::vec3& b) {
+		return a.x == b.x && a.y == b.y && a.z == b.z;
+	}
+
+	// Finds the corner of the triangle that uses the given welded vertex, or -1
+	inline int FindCorner(const uint32_t* corners, uint32_t vertex) {
+		return corners[0] == vertex ? 0 : corners[1] == vertex ? 1 : corners[2] == vertex ? 2 : -1;
+	}
+
+	struct MikkJob {
+		uint8_t*              Vertices;
+		size_t                Stride;
+		size_t                VertexCount;
+		size_t                TriangleCount;
+		const VertexParamMap* Map;
+		// The welded vertex for each corner of each triangle
+		std::vector<uint32_t> Corners;
+		std::vector<MikkTriangle> Triangles;
+		std::vector<MikkGroup> Groups;
+		// The triangles in each group, indexed by MikkGroup::FaceOffset
+		std::vector<uint32_t> GroupFaces;
+		// The final tangent space for each corner of each triangle
+		std::vector<MikkCorner> Tangents;
+
+		glm::vec3 Position(uint32_t vertex) const {
+			return ReadVec3(Vertices + vertex * Stride, Map->PositionOffset);
+		}
+		glm::vec3 Normal(uint32_t vertex) const {
+			return ReadVec3(Vertices + vertex * Stride, Map->NormalOffset);
+		}
+		glm::vec2 TexCoord(uint32_t vertex) const {
+			return ReadVec2(Vertices + vertex * Stride, Map->TextureOffset);
+		}
+	};
+
+	// Gives each vertex the index of the first vertex with the same position, normal and UV
+	void MikkWeld(MikkJob& job, const uint32_t* indices) {
+		// An open addressed table that's at least twice the vertex count, so that probes stay short
+		size_t tableSize = 1;
+		while (tableSize < job.VertexCount * 2) {
+			tableSize <<= 1;
+		}
+		std::vector<uint32_t> table(tableSize, MIKK_NONE);
+		std::vector<MikkWeldKey> keys(job.VertexCount);
+		std::vector<uint32_t> welded(job.VertexCount);
+
+		for (uint32_t ix = 0; ix < job.VertexCount; ix++) {
+			glm::vec3 position = job.Position(ix);
+			glm::vec3 normal = job.Normal(ix);
+			glm::vec2 uv = job.TexCoord(ix);
+			MikkWeldKey& key = keys[ix];
+			key = { { position.x, position.y, position.z, normal.x, normal.y, normal.z, uv.x, uv.y } };
+			for (float& value : key.Values) {
+				value = value == 0.0f ? 0.0f : value;
+			}
+
+			size_t slot = static_cast<size_t>(key.Hash()) & (tableSize - 1);
+			while (table[slot] != MIKK_NONE && !(keys[table[slot]] == key)) {
+				slot = (slot + 1) & (tableSize - 1);
+			}
+			if (table[slot] == MIKK_NONE) {
+				table[slot] = ix;
+			}
+			welded[ix] = table[slot];
+		}
+
+		job.Corners.resize(job.TriangleCount * 3);
+		for (size_t ix = 0; ix < job.Corners.size(); ix++) {
+			job.Corners[ix] = welded[indices[ix]];
+		}
+	}
+
+	// Works out the direction of U and V across each triangle, and which triangles are degenerate (InitTriInfo)
+	void MikkInitTriangles(MikkJob& job, size_t begin, size_t end) {
+		for (size_t tri = begin; tri < end; tri++) {
+			MikkTriangle& info = job.Triangles[tri];
+			const uint32_t* corners = job.Corners.data() + tri * 3;
+			info.Os = glm::vec3(0.0f);
+			info.Ot = glm::vec3(0.0f);
+			info.Flags = MIKK_GROUP_WITH_ANY;
+			for (int corner = 0; corner < 3; corner++) {
+				info.Neighbours[corner] = MIKK_NONE;
+				info.Groups[corner] = MIKK_NONE;
+			}
+
+			glm::vec3 p0 = job.Position(corners[0]);
+			glm::vec3 p1 = job.Position(corners[1]);
+			glm::vec3 p2 = job.Position(corners[2]);
+			if (SamePosition(p0, p1) || SamePosition(p0, p2) || SamePosition(p1, p2)) {
+				info.Flags |= MIKK_DEGENERATE;
+				continue;
+			}
+
+			glm::vec2 t0 = job.TexCoord(corners[0]);
+			glm::vec2 t21 = job.TexCoord(corners[1]) - t0;
+			glm::vec2 t31 = job.TexCoord(corners[2]) - t0;
+			glm::vec3 d1 = p1 - p0;
+			glm::vec3 d2 = p2 - p0;
+
+			float signedArea = t21.x * t31.y - t21.y * t31.x;
+			glm::vec3 os = t31.y * d1 - t21.y * d2;
+			glm::vec3 ot = -t31.x * d1 + t21.x * d2;
+			if (signedArea > 0.0f) {
+				info.Flags |= MIKK_ORIENT_PRESERVING;
+			}
+
+			if (NotZero(signedArea)) {
+				float absArea = glm::abs(signedArea);
+				float lengthOs = glm::length(os);
+				float lengthOt = glm::length(ot);
+				float sign = signedArea > 0.0f ? 1.0f : -1.0f;
+				if (NotZero(lengthOs)) {
+					info.Os = os * (sign / lengthOs);
+				}
+				if (NotZero(lengthOt)) {
+					info.Ot = ot * (sign / lengthOt);
+				}
+				// Triangles where the UVs are stretched to nothing in one direction also take any group
+				if (NotZero(lengthOs / absArea) && NotZero(lengthOt / absArea)) {
+					info.Flags &= ~MIKK_GROUP_WITH_ANY;
+				}
+			}
+		}
+	}
+
+	// Finds the triangle across each edge. Edges are only paired with an edge going the other way, and where
+	// more than two triangles share an edge they are paired up in order (BuildNeighborsFast)
+	void MikkBuildNeighbours(MikkJob& job) {
+		// Sort the edges by (Low, High, Face). The edges are bucketed by their low vertex first, which keeps
+		// them in face order, so each of the small buckets only has to be stable sorted by it's high vertex
+		std::vector<uint32_t> bucketStarts(job.VertexCount + 1, 0);
+		for (uint32_t tri = 0; tri < job.TriangleCount; tri++) {
+			if ((job.Triangles[tri].Flags & MIKK_DEGENERATE) == 0) {
+				for (uint32_t edge = 0; edge < 3; edge++) {
+					bucketStarts[glm::min(job.Corners[tri * 3 + edge], job.Corners[tri * 3 + (edge + 1) % 3]) + 1]++;
+				}
+			}
+		}
+		for (size_t ix = 1; ix < bucketStarts.size(); ix++) {
+			bucketStarts[ix] += bucketStarts[ix - 1];
+		}
+		std::vector<MikkEdge> edges(bucketStarts.back());
+		std::vector<uint32_t> bucketEnds(bucketStarts.begin(), bucketStarts.end() - 1);
+		for (uint32_t tri = 0; tri < job.TriangleCount; tri++) {
+			if (job.Triangles[tri].Flags & MIKK_DEGENERATE) {
+				continue;
+			}
+			for (uint32_t edge = 0; edge < 3; edge++) {
+				uint32_t a = job.Corners[tri * 3 + edge];
+				uint32_t b = job.Corners[tri * 3 + (edge + 1) % 3];
+				uint32_t low = glm::min(a, b);
+				edges[bucketEnds[low]++] = { low, glm::max(a, b), tri, edge };
+			}
+		}
+		for (size_t ix = 0; ix < job.VertexCount; ix++) {
+			std::stable_sort(edges.begin() + bucketStarts[ix], edges.begin() + bucketStarts[ix + 1], [](const MikkEdge& a, const MikkEdge& b) {
+				return a.High < b.High;
+			});
+		}
+
+		for (size_t ix = 0; ix < edges.size(); ix++) {
+			const MikkEdge& edgeA = edges[ix];
+			MikkTriangle& triA = job.Triangles[edgeA.Face];
+			if (triA.Neighbours[edgeA.Edge] != MIKK_NONE) {
+				continue;
+			}
+			uint32_t startA = job.Corners[edgeA.Face * 3 + edgeA.Edge];
+			uint32_t endA = job.Corners[edgeA.Face * 3 + (edgeA.Edge + 1) % 3];
+
+			for (size_t other = ix + 1; other < edges.size() && edges[other].Low == edgeA.Low && edges[other].High == edgeA.High; other++) {
+				const MikkEdge& edgeB = edges[other];
+				MikkTriangle& triB = job.Triangles[edgeB.Face];
+				uint32_t startB = job.Corners[edgeB.Face * 3 + edgeB.Edge];
+				uint32_t endB = job.Corners[edgeB.Face * 3 + (edgeB.Edge + 1) % 3];
+				if (startB == endA && endB == startA && triB.Neighbours[edgeB.Edge] == MIKK_NONE) {
+					triA.Neighbours[edgeA.Edge] = edgeB.Face;
+					triB.Neighbours[edgeB.Edge] = edgeA.Face;
+					break;
+				}
+			}
+		}
+	}
+
+	// Groups the corners around each vertex, by walking from triangle to triangle across the edges that meet at
+	// the vertex, for as long as the UV winding stays the same (Build4RuleGroups and AssignRecur). The reference
+	// does this recursively, we keep our own stack so that big fans can't overflow the real one
+	void MikkBuildGroups(MikkJob& job) {
+		job.Groups.clear();
+		job.GroupFaces.resize(job.TriangleCount * 3);
+		uint32_t offset = 0;
+		std::vector<uint32_t> stack;
+
+		for (uint32_t tri = 0; tri < job.TriangleCount; tri++) {
+			MikkTriangle& info = job.Triangles[tri];
+			if (info.Flags & (MIKK_DEGENERATE | MIKK_GROUP_WITH_ANY)) {
+				continue;
+			}
+			for (int corner = 0; corner < 3; corner++) {
+				if (info.Groups[corner] != MIKK_NONE) {
+					continue;
+				}
+				uint32_t groupIx = static_cast<uint32_t>(job.Groups.size());
+				job.Groups.push_back({ job.Corners[tri * 3 + corner], (info.Flags & MIKK_ORIENT_PRESERVING) != 0, offset, 0 });
+				MikkGroup& group = job.Groups.back();
+				info.Groups[corner] = groupIx;
+				job.GroupFaces[offset + group.FaceCount++] = tri;
+
+				// Pushed right then left, so that the left side is walked first like in the reference
+				stack.clear();
+				stack.push_back(info.Neighbours[corner > 0 ? corner - 1 : 2]);
+				stack.push_back(info.Neighbours[corner]);
+				while (!stack.empty()) {
+					uint32_t next = stack.back();
+					stack.pop_back();
+					if (next == MIKK_NONE) {
+						continue;
+					}
+
+					MikkTriangle& nextInfo = job.Triangles[next];
+					int nextCorner = FindCorner(job.Corners.data() + next * 3, group.Vertex);
+					if (nextCorner < 0 || nextInfo.Groups[nextCorner] != MIKK_NONE) {
+						continue;
+					}
+					// The first group to reach a triangle without a tangent of it's own decides it's winding
+					if ((nextInfo.Flags & MIKK_GROUP_WITH_ANY) &&
+						nextInfo.Groups[0] == MIKK_NONE && nextInfo.Groups[1] == MIKK_NONE && nextInfo.Groups[2] == MIKK_NONE) {
+						nextInfo.Flags = (nextInfo.Flags & ~MIKK_ORIENT_PRESERVING) | (group.OrientPreserving ? MIKK_ORIENT_PRESERVING : 0);
+					}
+					if (((nextInfo.Flags & MIKK_ORIENT_PRESERVING) != 0) != group.OrientPreserving) {
+						continue;
+					}
+
+					nextInfo.Groups[nextCorner] = groupIx;
+					job.GroupFaces[offset + group.FaceCount++] = next;
+					stack.push_back(nextInfo.Neighbours[nextCorner > 0 ? nextCorner - 1 : 2]);
+					stack.push_back(nextInfo.Neighbours[nextCorner]);
+				}
+				offset += group.FaceCount;
+			}
+		}
+	}
+
+	// Averages the tangents of the triangles in a sub group, weighted by the angle of their corner at the
+	// vertex (EvalTspace)
+	glm::vec3 MikkEvalTangent(const MikkJob& job, const uint32_t* faces, size_t faceCount, uint32_t vertex) {
+		glm::vec3 result = glm::vec3(0.0f);
+		glm::vec3 normal = job.Normal(vertex);
+		for (size_t ix = 0; ix < faceCount; ix++) {
+			uint32_t tri = faces[ix];
+			const MikkTriangle& info = job.Triangles[tri];
+			if (info.Flags & MIKK_GROUP_WITH_ANY) {
+				continue;
+			}
+			const uint32_t* corners = job.Corners.data() + tri * 3;
+			int corner = FindCorner(corners, vertex);
+
+			glm::vec3 os = ProjectOnto(normal, info.Os);
+			glm::vec3 p0 = job.Position(corners[corner > 0 ? corner - 1 : 2]);
+			glm::vec3 p1 = job.Position(corners[corner]);
+			glm::vec3 p2 = job.Position(corners[corner < 2 ? corner + 1 : 0]);
+			glm::vec3 v1 = ProjectOnto(normal, p0 - p1);
+			glm::vec3 v2 = ProjectOnto(normal, p2 - p1);
+			float angle = glm::acos(glm::clamp(glm::dot(v1, v2), -1.0f, 1.0f));
+
+			result += os * angle;
+		}
+		return SafeNormalize(result);
+	}
+
+	// Splits each group into sub groups of triangles whose tangents don't point in opposite directions, and
+	// writes the tangent of each corner's sub group (GenerateTSpaces). The reference's default angular
+	// threshold of 180 degrees is used, so only tangents that are exactly opposite get split
+	void MikkGenerateTangents(MikkJob& job, size_t begin, size_t end) {
+		const float thresholdCos = -1.0f;
+		struct SubGroup {
+			size_t    MemberOffset;
+			size_t    MemberCount;
+			glm::vec3 Tangent;
+		};
+		std::vector<uint32_t> members;
+		std::vector<uint32_t> subGroupMembers;
+		std::vector<SubGroup> subGroups;
+		// Every triangle in a group is projected onto the same normal, so we only need to do it once each
+		std::vector<glm::vec3> projectedOs;
+		std::vector<glm::vec3> projectedOt;
+
+		for (size_t groupIx = begin; groupIx < end; groupIx++) {
+			const MikkGroup& group = job.Groups[groupIx];
+			const uint32_t* faces = job.GroupFaces.data() + group.FaceOffset;
+			glm::vec3 normal = job.Normal(group.Vertex);
+			subGroupMembers.clear();
+			subGroups.clear();
+			projectedOs.resize(group.FaceCount);
+			projectedOt.resize(group.FaceCount);
+			for (uint32_t faceIx = 0; faceIx < group.FaceCount; faceIx++) {
+				projectedOs[faceIx] = ProjectOnto(normal, job.Triangles[faces[faceIx]].Os);
+				projectedOt[faceIx] = ProjectOnto(normal, job.Triangles[faces[faceIx]].Ot);
+			}
+
+			for (uint32_t faceIx = 0; faceIx < group.FaceCount; faceIx++) {
+				uint32_t tri = faces[faceIx];
+				const MikkTriangle& info = job.Triangles[tri];
+
+				members.clear();
+				for (uint32_t otherIx = 0; otherIx < group.FaceCount; otherIx++) {
+					uint32_t other = faces[otherIx];
+					bool any = ((info.Flags | job.Triangles[other].Flags) & MIKK_GROUP_WITH_ANY) != 0;
+					float cosS = glm::dot(projectedOs[faceIx], projectedOs[otherIx]);
+					float cosT = glm::dot(projectedOt[faceIx], projectedOt[otherIx]);
+					if (any || other == tri || (cosS > thresholdCos && cosT > thresholdCos)) {
+						members.push_back(other);
+					}
+				}
+				std::sort(members.begin(), members.end());
+
+				// Triangles that end up with the same members share the same tangent
+				size_t subGroupIx = 0;
+				for (; subGroupIx < subGroups.size(); subGroupIx++) {
+					const SubGroup& subGroup = subGroups[subGroupIx];
+					if (subGroup.MemberCount == members.size() &&
+						std::equal(members.begin(), members.end(), subGroupMembers.begin() + subGroup.MemberOffset)) {
+						break;
+					}
+				}
+				if (subGroupIx == subGroups.size()) {
+					subGroups.push_back({ subGroupMembers.size(), members.size(), MikkEvalTangent(job, members.data(), members.size(), group.Vertex) });
+					subGroupMembers.insert(subGroupMembers.end(), members.begin(), members.end());
+				}
+
+				int corner = FindCorner(job.Corners.data() + tri * 3, group.Vertex);
+				job.Tangents[tri * 3 + corner] = { subGroups[subGroupIx].Tangent, group.OrientPreserving };
+			}
+		}
+	}
+
+	// Corners of degenerate triangles copy the tangent space of the first good corner that uses the same
+	// vertex (DegenEpilogue)
+	void MikkDegenerateCorners(MikkJob& job) {
+		bool anyDegenerate = false;
+		for (uint32_t tri = 0; tri < job.TriangleCount && !anyDegenerate; tri++) {
+			anyDegenerate = (job.Triangles[tri].Flags & MIKK_DEGENERATE) != 0;
+		}
+		if (!anyDegenerate) {
+			return;
+		}
+
+		std::vector<uint32_t> firstCorner(job.VertexCount, MIKK_NONE);
+		for (uint32_t tri = 0; tri < job.TriangleCount; tri++) {
+			if ((job.Triangles[tri].Flags & MIKK_DEGENERATE) == 0) {
+				for (uint32_t corner = 0; corner < 3; corner++) {
+					uint32_t& first = firstCorner[job.Corners[tri * 3 + corner]];
+					first = first == MIKK_NONE ? tri * 3 + corner : first;
+				}
+			}
+		}
+		for (uint32_t tri = 0; tri < job.TriangleCount; tri++) {
+			if (job.Triangles[tri].Flags & MIKK_DEGENERATE) {
+				for (uint32_t corner = 0; corner < 3; corner++) {
+					uint32_t first = firstCorner[job.Corners[tri * 3 + corner]];
+					if (first != MIKK_NONE) {
+						job.Tangents[tri * 3 + corner] = job.Tangents[first];
+					}
+				}
+			}
+		}
+	}
+}
+
+void MeshFactory::_CalculateTBN(uint8_t* vertices, size_t stride, size_t vertexCount, const uint32_t* indices, size_t indexCount, const VertexParamMap& vMap, WorkerPool* pool)
+{
+	TbnJob job;
+	job.Vertices      = vertices;
+	job.Stride        = stride;
+	job.VertexCount   = vertexCount;
+	job.Indices       = indices;
+	job.TriangleCount = indexCount / 3;
+	job.Map           = &vMap;
+
+	// Only go wide if the mesh is big enough to make up for waking up the workers
+	WorkerPool::Sptr shared = pool == nullptr ? WorkerPool::GetShared() : nullptr;
+	WorkerPool& workers = pool == nullptr ? *shared : *pool;
+	size_t threadCount = glm::clamp<size_t>(job.TriangleCount / TBN_MIN_TRIS_PER_THREAD, 1, workers.GetThreadCount());
+
+	// Each thread gets its own accumulators so that we don't need any atomics or locks
+	std::vector<std::vector<TangentAccumulator>> accumulators(threadCount);
+	std::vector<TangentAccumulator*> accumulatorPtrs(threadCount);
+	for (size_t ix = 0; ix < threadCount; ix++) {
+		accumulators[ix].resize(vertexCount, TangentAccumulator{ glm::vec3(0.0f), glm::vec3(0.0f) });
+		accumulatorPtrs[ix] = accumulators[ix].data();
+	}
+
+	auto accumulate = [&](size_t thread) {
+		size_t begin = (job.TriangleCount * thread) / threadCount;
+		size_t end = (job.TriangleCount * (thread + 1)) / threadCount;
+		AccumulateFast(job, begin, end, accumulatorPtrs[thread]);
+	};
+	auto resolve = [&](size_t thread) {
+		size_t begin = (vertexCount * thread) / threadCount;
+		size_t end = (vertexCount * (thread + 1)) / threadCount;
+		ResolveTangents(job, accumulatorPtrs.data(), threadCount, begin, end);
+	};
+
+	// The pool only runs one job at a time, so meshes being loaded on other threads (or the renderer) wait their turn
+	workers.Run(threadCount, accumulate);
+	workers.Run(threadCount, resolve);
+}
+
+void MeshFactory::_CalculateMikkTSpace(uint8_t* vertices, size_t stride, size_t vertexCount, uint32_t* indices, size_t indexCount, const VertexParamMap& vMap, WorkerPool* pool, std::vector<TangentSplit>& outSplits)
+{
+	outSplits.clear();
+
+	MikkJob job;
+	job.Vertices      = vertices;
+	job.Stride        = stride;
+	job.VertexCount   = vertexCount;
+	job.TriangleCount = indexCount / 3;
+	job.Map           = &vMap;
+
+	WorkerPool::Sptr shared = pool == nullptr ? WorkerPool::GetShared() : nullptr;
+	WorkerPool& workers = pool == nullptr ? *shared : *pool;
+
+	MikkWeld(job, indices);
+
+	job.Triangles.resize(job.TriangleCount);
+	workers.RunRanges(job.TriangleCount, MIKK_MIN_TRIS_PER_THREAD, [&](size_t, size_t begin, size_t end) {
+		MikkInitTriangles(job, begin, end);
+	});
+
+	MikkBuildNeighbours(job);
+	MikkBuildGroups(job);
+
+	// Corners that never made it into a group keep the reference's default tangent space
+	job.Tangents.assign(job.TriangleCount * 3, MikkCorner{ glm::vec3(1.0f, 0.0f, 0.0f), false });
+	// Each corner is in at most one group, so the groups can be done in any order
+	workers.RunRanges(job.Groups.size(), MIKK_MIN_GROUPS_PER_THREAD, [&](size_t, size_t begin, size_t end) {
+		MikkGenerateTangents(job, begin, end);
+	});
+	MikkDegenerateCorners(job);
+
+	// Every corner now has a tangent space, but the corners that share a vertex may not agree on it. The
+	// first tangent space a vertex is used with is written to the vertex itself, and any others get a copy
+	// of the vertex that the mesh builder adds on to the end
+	struct Variant {
+		MikkCorner Space;
+		uint32_t   Vertex;
+		uint32_t   Next;
+	};
+	std::vector<uint32_t> firstVariant(vertexCount, MIKK_NONE);
+	std::vector<Variant> variants;
+	variants.reserve(vertexCount);
+
+	for (size_t cornerIx = 0; cornerIx < job.TriangleCount * 3; cornerIx++) {
+		uint32_t source = indices[cornerIx];
+		const MikkCorner& space = job.Tangents[cornerIx];
+
+		uint32_t* link = &firstVariant[source];
+		while (*link != MIKK_NONE) {
+			const Variant& variant = variants[*link];
+			if (variant.Space.OrientPreserving == space.OrientPreserving &&
+				memcmp(&variant.Space.Tangent, &space.Tangent, sizeof(glm::vec3)) == 0) {
+				break;
+			}
+			link = &variants[*link].Next;
+		}
+		if (*link != MIKK_NONE) {
+			indices[cornerIx] = variants[*link].Vertex;
+			continue;
+		}
+
+		// Our vertices don't have a w on the tangent, so the sign goes into the direction of the bitangent
+		glm::vec3 normal = glm::normalize(job.Normal(source));
+		glm::vec3 tangent = NotZero(space.Tangent) ? space.Tangent : AnyTangent(normal);
+		glm::vec3 bitangent = glm::cross(normal, tangent) * (space.OrientPreserving ? 1.0f : -1.0f);
+
+		uint32_t target = source;
+		if (link != &firstVariant[source]) {
+			target = static_cast<uint32_t>(vertexCount + outSplits.size());
+			outSplits.push_back({ source, tangent, bitangent });
+		} else {
+			uint8_t* vertex = vertices + source * stride;
+			WriteVec3(vertex, vMap.TangentOffset, tangent);
+			WriteVec3(vertex, vMap.BiTangentOffset, bitangent);
+		}
+		*link = static_cast<uint32_t>(variants.size());
+		variants.push_back({ space, target, MIKK_NONE });
+		indices[cornerIx] = target;
+	}
+}
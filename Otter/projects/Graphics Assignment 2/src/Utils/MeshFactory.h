@@ -3,6 +3,8 @@
 #include <GLM/gtc/matrix_transform.hpp>
 #include "MeshBuilder.h"
 #include "Graphics/VertexTypes.h"
+#include "Graphics/VertexParamMap.h"
+#include "Utils/WorkerPool.h"
 #include <json.hpp>
 
 #include <EnumToString.h>
@@ -19,6 +21,22 @@ ENUM(MeshBuilderType, int,
 	 FaceInvert = 5
 );
 
+/// <summary>
+/// Selects how MeshFactory::CalculateTBN generates tangents and bitangents
+/// 
+/// Fast       accumulates the UV derivatives of each triangle and orthonormalizes them per vertex
+/// MikkTSpace generates the same tangent space as the MikkTSpace reference implementation (mikktspace.c),
+///            which is what most baking tools expect normal maps to be in. Vertices where the triangles
+///            around them don't agree on a tangent space, like at UV seams or where mirrored UVs meet,
+///            are split, so this can add vertices to the mesh. Our vertices have no w on the tangent, so
+///            the handedness sign is kept in the direction of the bitangent, which is always
+///            sign * cross(normal, tangent). This mode needs vertex normals
+/// </summary>
+ENUM(TangentMode, int,
+	 Fast       = 0,
+	 MikkTSpace = 1
+);
+
 /// <summary>
 /// Allows storing configuration parameters for mesh factory calls
 /// </summary>
@@ -149,17 +167,34 @@ public:
 	static void InvertFaces(MeshBuilder<Vertex>& mesh);
 
 	/// <summary>
-	/// Calculates the tangents and bitangents from the normal and UV coords
+	/// Calculates the tangents and bitangents from the normal and UV coords. Large meshes are split
+	/// across multiple threads. In MikkTSpace mode vertices may be added to the end of the mesh, and
+	/// the indices changed to use them, see TangentMode
 	/// </summary>
 	/// <typeparam name="Vertex">The type of vertex the mesh consists of</typeparam>
 	/// <param name="mesh">The mesh to manipulate</param>
+	/// <param name="mode">The rules to use when generating the tangent space</param>
+	/// <param name="pool">The pool to split large meshes across, or nullptr to use WorkerPool::GetShared()</param>
 	template <typename Vertex>
-	static void CalculateTBN(MeshBuilder<Vertex>& mesh);
+	static void CalculateTBN(MeshBuilder<Vertex>& mesh, TangentMode mode = TangentMode::Fast, WorkerPool* pool = nullptr);
 
 protected:	
 	MeshFactory() = default;
 	~MeshFactory() = default;
 
+	// A copy of a vertex that MikkTSpace needs, because the triangles using the vertex don't agree on it's tangent space
+	struct TangentSplit {
+		uint32_t  Source;
+		glm::vec3 Tangent;
+		glm::vec3 BiTangent;
+	};
+
+	// Non-templated implementation of CalculateTBN's fast mode, which works on raw vertex data using the param map
+	static void _CalculateTBN(uint8_t* vertices, size_t stride, size_t vertexCount, const uint32_t* indices, size_t indexCount, const VertexParamMap& vMap, WorkerPool* pool);
+	// Non-templated implementation of CalculateTBN's MikkTSpace mode. The indices are pointed at the copies
+	// in outSplits, which the caller needs to add to the end of the vertex list in order
+	static void _CalculateMikkTSpace(uint8_t* vertices, size_t stride, size_t vertexCount, uint32_t* indices, size_t indexCount, const VertexParamMap& vMap, WorkerPool* pool, std::vector<TangentSplit>& outSplits);
+
 	inline static const glm::mat4 MAT4_IDENTITY = glm::mat4(1.0f);
 };
 
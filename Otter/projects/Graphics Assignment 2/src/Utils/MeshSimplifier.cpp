@@ -0,0 +1,386 @@
+#include "Utils/MeshSimplifier.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <cstring>
+#include <cfloat>
+
+namespace {
+	/// <summary>
+	/// A symmetric 4x4 error quadric, along with the total area that contributed to it
+	/// so that we can turn the error back into a squared distance
+	/// </summary>
+	struct Quadric {
+		double A00 = 0, A11 = 0, A22 = 0, A01 = 0, A02 = 0, A12 = 0;
+		double B0 = 0, B1 = 0, B2 = 0;
+		double C = 0;
+		double Weight = 0;
+
+		void AddPlane(const glm::vec3& n, float d, float weight) {
+			A00 += weight * n.x * n.x; A11 += weight * n.y * n.y; A22 += weight * n.z * n.z;
+			A01 += weight * n.x * n.y; A02 += weight * n.x * n.z; A12 += weight * n.y * n.z;
+			B0  += weight * n.x * d;   B1  += weight * n.y * d;   B2  += weight * n.z * d;
+			C   += weight * d * d;
+			Weight += weight;
+		}
+
+		void Add(const Quadric& other) {
+			A00 += other.A00; A11 += other.A11; A22 += other.A22;
+			A01 += other.A01; A02 += other.A02; A12 += other.A12;
+			B0 += other.B0; B1 += other.B1; B2 += other.B2;
+			C += other.C;
+			Weight += other.Weight;
+		}
+
+		// Returns the area weighted squared distance of p from all the planes in the quadric
+		double Evaluate(const glm::vec3& p) const {
+			double result =
+				A00 * p.x * p.x + A11 * p.y * p.y + A22 * p.z * p.z +
+				2.0 * (A01 * p.x * p.y + A02 * p.x * p.z + A12 * p.y * p.z) +
+				2.0 * (B0 * p.x + B1 * p.y + B2 * p.z) +
+				C;
+			return Weight > 0.0 ? std::abs(result) / Weight : 0.0;
+		}
+	};
+
+	struct Collapse {
+		uint32_t Source;
+		uint32_t Target;
+		float    Cost;
+	};
+
+	// Squared difference of the shading attributes of two vertices, roughly normalized to [0, 1]
+	float AttributeDistance(const VertexPosNormTexColTangents& a, const VertexPosNormTexColTangents& b) {
+		glm::vec3 dn = a.Normal - b.Normal;
+		glm::vec2 duv = a.UV - b.UV;
+		glm::vec4 dc = a.Color - b.Color;
+		return glm::dot(dn, dn) * 0.25f + glm::dot(duv, duv) + glm::dot(dc, dc) * 0.25f;
+	}
+
+	// Replaces -0 with 0. Positions are hashed and compared by their bits (GLM's vector == compares
+	// floats bitwise too), so without this seams that lie on an axis plane would never be welded
+	glm::vec3 WeldPosition(const glm::vec3& p) {
+		glm::vec3 result;
+		for (int ix = 0; ix < 3; ix++) {
+			result[ix] = p[ix] == 0.0f ? 0.0f : p[ix];
+		}
+		return result;
+	}
+
+	uint64_t PositionKey(const glm::vec3& p, uint64_t salt) {
+		uint32_t bits[3];
+		memcpy(bits, &p, sizeof(bits));
+		uint64_t hash = salt;
+		for (int ix = 0; ix < 3; ix++) {
+			hash = (hash ^ bits[ix]) * 0x100000001B3ull;
+		}
+		return hash;
+	}
+}
+
+float MeshSimplifier::Simplify(
+	const MeshBuilder<VertexPosNormTexColTangents>& mesh,
+	std::vector<uint32_t>& outIndices,
+	size_t targetIndexCount, float targetError, float attributeWeight)
+{
+	return Simplify(
+		mesh.GetVertexDataPtr(), mesh.GetVertexCount(),
+		mesh.GetIndexDataPtr(), mesh.GetIndexCount(),
+		outIndices, targetIndexCount, targetError, attributeWeight);
+}
+
+float MeshSimplifier::Simplify(
+	const VertexPosNormTexColTangents* vertices, size_t vertexCount,
+	const uint32_t* indices, size_t indexCount,
+	std::vector<uint32_t>& outIndices,
+	size_t targetIndexCount, float targetError, float attributeWeight)
+{
+	outIndices.assign(indices, indices + indexCount);
+	if (vertexCount == 0 || indexCount < 3 || targetIndexCount >= indexCount) {
+		return 0.0f;
+	}
+
+	// Normalize positions into the unit cube so that errors are relative to the mesh size
+	glm::vec3 minBound = vertices[0].Position;
+	glm::vec3 maxBound = vertices[0].Position;
+	for (size_t ix = 1; ix < vertexCount; ix++) {
+		minBound = glm::min(minBound, vertices[ix].Position);
+		maxBound = glm::max(maxBound, vertices[ix].Position);
+	}
+	glm::vec3 extents = maxBound - minBound;
+	float scale = glm::max(extents.x, glm::max(extents.y, extents.z));
+	scale = scale > 0.0f ? 1.0f / scale : 1.0f;
+
+	std::vector<glm::vec3> positions(vertexCount);
+	for (size_t ix = 0; ix < vertexCount; ix++) {
+		positions[ix] = (vertices[ix].Position - minBound) * scale;
+	}
+
+	// Vertices that only differ by their attributes (UV or normal seams) share a position vertex,
+	// all topology and error tracking is done on those
+	std::vector<uint32_t> remap(vertexCount);
+	{
+		std::unordered_map<uint64_t, uint32_t> lookup;
+		lookup.reserve(vertexCount);
+		for (uint32_t ix = 0; ix < vertexCount; ix++) {
+			glm::vec3 position = WeldPosition(vertices[ix].Position);
+			uint64_t key = PositionKey(position, 0xCBF29CE484222325ull);
+			// Resolve hash collisions by probing, positions must match exactly to be welded
+			while (true) {
+				auto it = lookup.find(key);
+				if (it == lookup.end()) {
+					lookup[key] = ix;
+					remap[ix] = ix;
+					break;
+				}
+				else if (WeldPosition(vertices[it->second].Position) == position) {
+					remap[ix] = it->second;
+					break;
+				}
+				key = PositionKey(position, key);
+			}
+		}
+	}
+
+	// Strip out any triangles that are already degenerate
+	std::vector<uint32_t>& tris = outIndices;
+	tris.clear();
+	for (size_t ix = 0; ix + 2 < indexCount; ix += 3) {
+		uint32_t a = indices[ix], b = indices[ix + 1], c = indices[ix + 2];
+		if (remap[a] != remap[b] && remap[b] != remap[c] && remap[a] != remap[c]) {
+			tris.push_back(a); tris.push_back(b); tris.push_back(c);
+		}
+	}
+
+	// Border locking, any edge that is not shared by exactly 2 triangles is either an open border
+	// or non-manifold, and we keep both of its vertices where they are
+	std::vector<bool> locked(vertexCount, false);
+	{
+		std::unordered_map<uint64_t, int> edgeCounts;
+		edgeCounts.reserve(tris.size());
+		for (size_t ix = 0; ix < tris.size(); ix += 3) {
+			for (int e = 0; e < 3; e++) {
+				uint32_t a = remap[tris[ix + e]];
+				uint32_t b = remap[tris[ix + (e + 1) % 3]];
+				uint64_t key = a < b ? ((uint64_t)a << 32) | b : ((uint64_t)b << 32) | a;
+				edgeCounts[key]++;
+			}
+		}
+		for (const auto& [key, count] : edgeCounts) {
+			if (count != 2) {
+				locked[key >> 32] = true;
+				locked[key & 0xFFFFFFFFull] = true;
+			}
+		}
+	}
+
+	// Accumulate the area weighted plane quadrics for every position vertex
+	std::vector<Quadric> quadrics(vertexCount);
+	for (size_t ix = 0; ix < tris.size(); ix += 3) {
+		const glm::vec3& p0 = positions[tris[ix]];
+		const glm::vec3& p1 = positions[tris[ix + 1]];
+		const glm::vec3& p2 = positions[tris[ix + 2]];
+		glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+		float area = glm::length(normal);
+		if (area <= 0.0f) {
+			continue;
+		}
+		normal /= area;
+		float d = -glm::dot(normal, p0);
+		for (int c = 0; c < 3; c++) {
+			quadrics[remap[tris[ix + c]]].AddPlane(normal, d, area * 0.5f);
+		}
+	}
+
+	const double errorLimit = (double)targetError * targetError;
+	double resultError = 0.0;
+
+	std::vector<uint32_t> adjacencyOffsets(vertexCount + 1);
+	std::vector<uint32_t> adjacency;
+	std::vector<Collapse> collapses;
+	std::vector<bool> collapseLocked(vertexCount);
+	std::vector<std::pair<uint32_t, uint32_t>> wedgeMap;
+
+	auto isDegenerate = [&](size_t tri) {
+		uint32_t a = remap[tris[tri * 3]], b = remap[tris[tri * 3 + 1]], c = remap[tris[tri * 3 + 2]];
+		return a == b || b == c || a == c;
+	};
+
+	// Determines which of the target's vertices each of the source's vertices would be replaced with,
+	// returns false if the collapse would need to invent new vertices (ex: crossing a UV seam)
+	auto buildWedgeMap = [&](uint32_t source, uint32_t target) {
+		wedgeMap.clear();
+		for (uint32_t ix = adjacencyOffsets[source]; ix < adjacencyOffsets[source + 1]; ix++) {
+			uint32_t tri = adjacency[ix];
+			if (isDegenerate(tri)) continue;
+			uint32_t sourceWedge = UINT32_MAX, targetWedge = UINT32_MAX;
+			for (int c = 0; c < 3; c++) {
+				uint32_t wedge = tris[tri * 3 + c];
+				if (remap[wedge] == source) sourceWedge = wedge;
+				else if (remap[wedge] == target) targetWedge = wedge;
+			}
+			auto it = std::find_if(wedgeMap.begin(), wedgeMap.end(), [&](const auto& p) { return p.first == sourceWedge; });
+			if (targetWedge == UINT32_MAX) {
+				// Only add the wedge so that we can ensure it gets mapped by some other triangle
+				if (it == wedgeMap.end()) wedgeMap.push_back({ sourceWedge, UINT32_MAX });
+			}
+			else if (it == wedgeMap.end()) {
+				wedgeMap.push_back({ sourceWedge, targetWedge });
+			}
+			else if (it->second == UINT32_MAX) {
+				it->second = targetWedge;
+			}
+			else if (it->second != targetWedge) {
+				return false;
+			}
+		}
+		for (const auto& pair : wedgeMap) {
+			if (pair.second == UINT32_MAX) return false;
+		}
+		return !wedgeMap.empty();
+	};
+
+	// Checks whether moving the source to the target will fold any triangles over
+	auto hasFlips = [&](uint32_t source, uint32_t target) {
+		const glm::vec3& newPos = positions[target];
+		for (uint32_t ix = adjacencyOffsets[source]; ix < adjacencyOffsets[source + 1]; ix++) {
+			uint32_t tri = adjacency[ix];
+			if (isDegenerate(tri)) continue;
+			glm::vec3 oldCorners[3], newCorners[3];
+			bool touchesTarget = false;
+			for (int c = 0; c < 3; c++) {
+				uint32_t pos = remap[tris[tri * 3 + c]];
+				touchesTarget |= pos == target;
+				oldCorners[c] = positions[pos];
+				newCorners[c] = pos == source ? newPos : oldCorners[c];
+			}
+			if (touchesTarget) continue;
+			glm::vec3 oldNormal = glm::cross(oldCorners[1] - oldCorners[0], oldCorners[2] - oldCorners[0]);
+			glm::vec3 newNormal = glm::cross(newCorners[1] - newCorners[0], newCorners[2] - newCorners[0]);
+			if (glm::dot(oldNormal, newNormal) <= 0.0f) {
+				return true;
+			}
+		}
+		return false;
+	};
+
+	auto collapseCost = [&](uint32_t source, uint32_t target) {
+		Quadric q = quadrics[source];
+		q.Add(quadrics[target]);
+		double cost = q.Evaluate(positions[target]);
+		if (attributeWeight > 0.0f) {
+			// Attribute changes matter more the further the vertex travels
+			glm::vec3 delta = positions[target] - positions[source];
+			float travel = glm::dot(delta, delta);
+			float attribs = 0.0f;
+			for (const auto& [from, to] : wedgeMap) {
+				attribs = glm::max(attribs, AttributeDistance(vertices[from], vertices[to]));
+			}
+			cost += (double)attribs * travel * attributeWeight;
+		}
+		return cost;
+	};
+
+	while (tris.size() > targetIndexCount) {
+		const size_t triCount = tris.size() / 3;
+
+		// Build the position vertex -> triangle adjacency
+		std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+		for (uint32_t wedge : tris) {
+			adjacencyOffsets[remap[wedge] + 1]++;
+		}
+		for (size_t ix = 1; ix <= vertexCount; ix++) {
+			adjacencyOffsets[ix] += adjacencyOffsets[ix - 1];
+		}
+		adjacency.resize(tris.size());
+		{
+			std::vector<uint32_t> cursor(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+			for (size_t ix = 0; ix < tris.size(); ix++) {
+				adjacency[cursor[remap[tris[ix]]]++] = static_cast<uint32_t>(ix / 3);
+			}
+		}
+
+		// Rank every edge, picking the cheapest valid direction to collapse it in
+		collapses.clear();
+		for (size_t ix = 0; ix < tris.size(); ix += 3) {
+			for (int e = 0; e < 3; e++) {
+				uint32_t a = remap[tris[ix + e]];
+				uint32_t b = remap[tris[ix + (e + 1) % 3]];
+				// Interior edges are seen from both of their triangles, only handle them once
+				if (a > b) continue;
+
+				Collapse best = { 0, 0, FLT_MAX };
+				if (!locked[a] && buildWedgeMap(a, b)) {
+					best = { a, b, (float)collapseCost(a, b) };
+				}
+				if (!locked[b] && buildWedgeMap(b, a)) {
+					float cost = (float)collapseCost(b, a);
+					if (cost < best.Cost) best = { b, a, cost };
+				}
+				if (best.Cost < FLT_MAX) {
+					collapses.push_back(best);
+				}
+			}
+		}
+		if (collapses.empty()) {
+			break;
+		}
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& l, const Collapse& r) { return l.Cost < r.Cost; });
+
+		// Greedily perform the cheapest collapses, each vertex can only take part in one collapse
+		// per pass so that the adjacency and quadrics we ranked against stay valid
+		std::fill(collapseLocked.begin(), collapseLocked.end(), false);
+		size_t trisToRemove = triCount - targetIndexCount / 3;
+		size_t trisRemoved = 0;
+		size_t collapseCount = 0;
+		for (const Collapse& collapse : collapses) {
+			if (collapse.Cost > errorLimit || trisRemoved >= trisToRemove) {
+				break;
+			}
+			if (collapseLocked[collapse.Source] || collapseLocked[collapse.Target]) {
+				continue;
+			}
+			if (!buildWedgeMap(collapse.Source, collapse.Target) || hasFlips(collapse.Source, collapse.Target)) {
+				continue;
+			}
+
+			// Redirect all the source's wedges onto the target
+			for (uint32_t ix = adjacencyOffsets[collapse.Source]; ix < adjacencyOffsets[collapse.Source + 1]; ix++) {
+				uint32_t tri = adjacency[ix];
+				if (isDegenerate(tri)) continue;
+				bool touchesTarget = false;
+				for (int c = 0; c < 3; c++) {
+					uint32_t& wedge = tris[tri * 3 + c];
+					touchesTarget |= remap[wedge] == collapse.Target;
+					if (remap[wedge] == collapse.Source) {
+						wedge = std::find_if(wedgeMap.begin(), wedgeMap.end(), [&](const auto& p) { return p.first == wedge; })->second;
+					}
+				}
+				trisRemoved += touchesTarget ? 1 : 0;
+			}
+
+			quadrics[collapse.Target].Add(quadrics[collapse.Source]);
+			resultError = glm::max(resultError, quadrics[collapse.Target].Evaluate(positions[collapse.Target]));
+			collapseLocked[collapse.Source] = true;
+			collapseLocked[collapse.Target] = true;
+			collapseCount++;
+		}
+
+		if (collapseCount == 0) {
+			break;
+		}
+
+		// Compact the triangle list, dropping everything that collapsed
+		size_t write = 0;
+		for (size_t ix = 0; ix < triCount; ix++) {
+			if (!isDegenerate(ix)) {
+				tris[write++] = tris[ix * 3];
+				tris[write++] = tris[ix * 3 + 1];
+				tris[write++] = tris[ix * 3 + 2];
+			}
+		}
+		tris.resize(write);
+	}
+
+	return static_cast<float>(sqrt(resultError));
+}
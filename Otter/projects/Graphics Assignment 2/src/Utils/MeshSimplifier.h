@@ -0,0 +1,54 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+#include "Utils/MeshBuilder.h"
+#include "Graphics/VertexTypes.h"
+
+/// <summary>
+/// Quadric error metric mesh simplifier, used to generate levels of detail at import time
+///
+/// Simplification works by repeatedly collapsing the cheapest edge onto one of its existing
+/// endpoints, so the output is only a new index list that can be used with the original
+/// vertex buffer. Vertices on open borders are locked in place, and vertices along UV or
+/// normal seams may only slide along the seam.
+/// </summary>
+class MeshSimplifier
+{
+public:
+	/// <summary>
+	/// Simplifies an indexed triangle list, writing the new triangles into outIndices
+	/// </summary>
+	/// <param name="vertices">The vertices that the indices refer to</param>
+	/// <param name="vertexCount">The number of vertices in the vertex array</param>
+	/// <param name="indices">The triangle list to simplify</param>
+	/// <param name="indexCount">The number of indices in the triangle list</param>
+	/// <param name="outIndices">The resulting triangle list, referring to the same vertices</param>
+	/// <param name="targetIndexCount">The number of indices we want to reduce the mesh to</param>
+	/// <param name="targetError">The maximum error allowed, relative to the largest extent of the mesh</param>
+	/// <param name="attributeWeight">How much normal, UV and color differences should count against a collapse</param>
+	/// <returns>The error of the resulting mesh, relative to the largest extent of the mesh</returns>
+	static float Simplify(
+		const VertexPosNormTexColTangents* vertices, size_t vertexCount,
+		const uint32_t* indices, size_t indexCount,
+		std::vector<uint32_t>& outIndices,
+		size_t targetIndexCount, float targetError = 0.01f, float attributeWeight = 1.0f);
+
+	/// <summary>
+	/// Simplifies the triangles from a mesh builder, writing the new triangles into outIndices
+	/// </summary>
+	/// <param name="mesh">The mesh to simplify, must be indexed</param>
+	/// <param name="outIndices">The resulting triangle list, referring to the mesh's vertices</param>
+	/// <param name="targetIndexCount">The number of indices we want to reduce the mesh to</param>
+	/// <param name="targetError">The maximum error allowed, relative to the largest extent of the mesh</param>
+	/// <param name="attributeWeight">How much normal, UV and color differences should count against a collapse</param>
+	/// <returns>The error of the resulting mesh, relative to the largest extent of the mesh</returns>
+	static float Simplify(
+		const MeshBuilder<VertexPosNormTexColTangents>& mesh,
+		std::vector<uint32_t>& outIndices,
+		size_t targetIndexCount, float targetError = 0.01f, float attributeWeight = 1.0f);
+
+protected:
+	MeshSimplifier() = default;
+	~MeshSimplifier() = default;
+};
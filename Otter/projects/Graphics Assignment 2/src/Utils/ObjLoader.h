@@ -16,7 +16,17 @@ class ObjLoader
 {
 public:
 	template <typename VertexType = VertexPosNormTexColTangents>
-	static VertexArrayObject::Sptr LoadFromFile(const std::string& filename, bool calcTangents = true);
+	static VertexArrayObject::Sptr LoadFromFile(const std::string& filename, bool calcTangents = true, TangentMode tangentMode = TangentMode::Fast);
+
+	/// <summary>
+	/// Loads the contents of an OBJ file into a mesh builder, without uploading anything to the GPU
+	/// </summary>
+	/// <param name="filename">The path to the OBJ file to load</param>
+	/// <param name="mesh">The mesh builder to append the vertices and indices to</param>
+	/// <param name="calcTangents">True if tangents and bitangents should be calculated</param>
+	/// <param name="tangentMode">The rules to use when calculating tangents</param>
+	template <typename VertexType = VertexPosNormTexColTangents>
+	static void LoadMeshData(const std::string& filename, MeshBuilder<VertexType>& mesh, bool calcTangents = true, TangentMode tangentMode = TangentMode::Fast);
 
 protected:
 	ObjLoader() = default;
@@ -25,7 +35,16 @@ protected:
 
 
 template <typename VertexType>
-VertexArrayObject::Sptr ObjLoader::LoadFromFile(const std::string& filename, bool calcTangents) {
+VertexArrayObject::Sptr ObjLoader::LoadFromFile(const std::string& filename, bool calcTangents, TangentMode tangentMode) {
+	MeshBuilder<VertexType> mesh = MeshBuilder<VertexType>();
+	LoadMeshData(filename, mesh, calcTangents, tangentMode);
+
+	// Move our data into a VAO and return it
+	return mesh.Bake();
+}
+
+template <typename VertexType>
+void ObjLoader::LoadMeshData(const std::string& filename, MeshBuilder<VertexType>& mesh, bool calcTangents, TangentMode tangentMode) {
 	// Open our file in binary mode
 	std::ifstream file;
 	file.open(filename, std::ios::binary);
@@ -52,10 +71,6 @@ VertexArrayObject::Sptr ObjLoader::LoadFromFile(const std::string& filename, boo
 	// has been added to the mesh already
 	std::unordered_map<uint64_t, uint32_t> vertexMap;
 
-	// We'll use the mesh builder since it supports easily adding
-	// vertices and indices
-	MeshBuilder<VertexType> mesh = MeshBuilder<VertexType>();
-
 	// Storage for temporary data
 	std::string line;
 	glm::vec3 vecData;
@@ -162,6 +177,9 @@ VertexArrayObject::Sptr ObjLoader::LoadFromFile(const std::string& filename, boo
 		}
 	}
 
+	// Indices are offset so that we can append to a mesh that already has data
+	uint32_t baseVertex = static_cast<uint32_t>(mesh.GetVertexCount());
+
 	mesh.ReserveVertexSpace(vertices.size());
 	for (const auto& vertexIndices : vertices) {
 		// Construct a new vertex using the indices for the vertex
@@ -176,17 +194,14 @@ VertexArrayObject::Sptr ObjLoader::LoadFromFile(const std::string& filename, boo
 	}
 	mesh.ReserveIndexSpace(indices.size());
 	for (uint32_t ix : indices) {
-		mesh.AddIndex(ix);
+		mesh.AddIndex(baseVertex + ix);
 	}
 
 	if (calcTangents) {
-		MeshFactory::CalculateTBN(mesh);
+		MeshFactory::CalculateTBN(mesh, tangentMode);
 	}
 
 	// Calculate and trace out how long it took us to load
 	float endTime = static_cast<float>(glfwGetTime());
 	LOG_TRACE("Loaded OBJ file \"{}\" in {} seconds ({} vertices, {} indices)", filename, endTime - startTime, mesh.GetVertexCount(), mesh.GetIndexCount());
-
-	// Move our data into a VAO and return it
-	return mesh.Bake();
 }
\ No newline at end of file
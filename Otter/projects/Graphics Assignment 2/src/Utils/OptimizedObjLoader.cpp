@@ -7,6 +7,7 @@
 #include <fstream>
 #include <iostream>
 #include <filesystem>
+#include <algorithm>
 
 #include "Utils/StringUtils.h"
 #include "GLFW/glfw3.h"
@@ -45,6 +46,59 @@ VertexArrayObject::Sptr OptimizedObjLoader::LoadFromFile(const std::string& file
 	}
 }
 
+bool OptimizedObjLoader::LoadMeshData(const std::string& filename, MeshBuilder<VertexPosNormTexColTangents>& mesh, TangentMode tangentMode) {
+	// Get the file extension and lowercase it
+	fs::path filePath = std::filesystem::path(filename);
+	std::string extension = filePath.extension().string();
+	StringTools::ToLower(extension);
+
+	bool loaded = false;
+	if (extension == ".obj") {
+		// Get the binary path, and convert the OBJ file if we haven't yet
+		fs::path binPath = filePath.replace_extension(binaryExtension);
+		if (!fs::exists(binPath)) {
+			ConvertToBinary(filename, binPath.string());
+		}
+		loaded = _LoadMeshDataFromBinFile(binPath.string(), mesh);
+	}
+	else if (extension == ".bin") {
+		loaded = _LoadMeshDataFromBinFile(filename, mesh);
+	}
+	else {
+		LOG_WARN("Cannot load model from \"{}\"", filename);
+		return false;
+	}
+
+	// The binary file only stores fast tangents
+	if (loaded && tangentMode != TangentMode::Fast) {
+		MeshFactory::CalculateTBN(mesh, tangentMode);
+	}
+	return loaded;
+}
+
+bool OptimizedObjLoader::LoadPositions(const std::string& filename, std::vector<glm::vec3>& positions) {
+	// Get the file extension and lowercase it
+	fs::path filePath = std::filesystem::path(filename);
+	std::string extension = filePath.extension().string();
+	StringTools::ToLower(extension);
+
+	if (extension == ".obj") {
+		// Get the binary path, and convert the OBJ file if we haven't yet
+		fs::path binPath = filePath.replace_extension(binaryExtension);
+		if (!fs::exists(binPath)) {
+			ConvertToBinary(filename, binPath.string());
+		}
+		return _LoadPositionsFromBinFile(binPath.string(), positions);
+	}
+	else if (extension == ".bin") {
+		return _LoadPositionsFromBinFile(filename, positions);
+	}
+	else {
+		LOG_WARN("Cannot load model from \"{}\"", filename);
+		return false;
+	}
+}
+
 void OptimizedObjLoader::ConvertToBinary(const std::string& inFile, const std::string& outFile) {
 	// Load in the input file
 	MeshBuilder<VertexPosNormTexColTangents>* mesh = _LoadFromObjFile(inFile);
@@ -326,3 +380,120 @@ VertexArrayObject::Sptr OptimizedObjLoader::_LoadFromBinFile(const std::string&
 
 	return nullptr;
 }
+
+bool OptimizedObjLoader::_LoadMeshDataFromBinFile(const std::string& filename, MeshBuilder<VertexPosNormTexColTangents>& mesh) {
+	// Open the input file
+	std::ifstream file(filename, std::ios::binary);
+	// If our file fails to open, we will throw an error
+	if (!file) { throw std::runtime_error("Failed to open file"); }
+
+	// Get the file size so we can avoid reading past the end
+	file.seekg(0, std::ios::end);
+	size_t size = file.tellg();
+	file.seekg(0, std::ios::beg);
+
+	// Read the header from the file
+	BinaryHeader header = BinaryHeader();
+	if (size >= sizeof(BinaryHeader)) {
+		file.read(reinterpret_cast<char*>(&header), sizeof(BinaryHeader));
+	} else {
+		LOG_ERROR("Not enough data in the file!");
+		return false;
+	}
+
+	// We can only copy straight into the mesh builder if the layout is the one we write in ConvertToBinary
+	if (header.Version != 0x01 || 
+		header.VertexStride != sizeof(VertexPosNormTexColTangents) ||
+		header.NumAttributes != VertexPosNormTexColTangents::V_DECL.size() ||
+		(header.NumIndices > 0 && header.IndicesType != IndexType::UInt)) {
+		return false;
+	}
+
+	size_t requiredBytes =
+		sizeof(BinaryHeader) +
+		(header.NumAttributes * sizeof(BufferAttribute)) +
+		(header.VertexStride * (size_t)header.NumVertices) +
+		(header.NumIndices * sizeof(uint32_t));
+	if (size < requiredBytes) {
+		LOG_ERROR("Not enough data in the file!");
+		return false;
+	}
+
+	// Skip over the vertex declaration, we already know it matches
+	file.seekg(header.NumAttributes * sizeof(BufferAttribute), std::ios::cur);
+
+	if (header.NumIndices > 0) {
+		std::vector<uint32_t> indices(header.NumIndices);
+		file.read(reinterpret_cast<char*>(indices.data()), header.NumIndices * sizeof(uint32_t));
+		mesh.AddIndexRange(indices.data(), indices.size());
+	}
+
+	std::vector<VertexPosNormTexColTangents> vertices(header.NumVertices);
+	file.read(reinterpret_cast<char*>(vertices.data()), header.NumVertices * (size_t)header.VertexStride);
+	mesh.AddVertexRange(vertices);
+
+	return true;
+}
+
+bool OptimizedObjLoader::_LoadPositionsFromBinFile(const std::string& filename, std::vector<glm::vec3>& positions) {
+	// Open the input file
+	std::ifstream file(filename, std::ios::binary);
+	// If our file fails to open, we will throw an error
+	if (!file) { throw std::runtime_error("Failed to open file"); }
+
+	// Get the file size so we can avoid reading past the end
+	file.seekg(0, std::ios::end);
+	size_t size = file.tellg();
+	file.seekg(0, std::ios::beg);
+
+	// Read the header from the file
+	BinaryHeader header = BinaryHeader();
+	if (size >= sizeof(BinaryHeader)) {
+		file.read(reinterpret_cast<char*>(&header), sizeof(BinaryHeader));
+	} else {
+		LOG_ERROR("Not enough data in the file!");
+		return false;
+	}
+
+	if (header.Version != 0x01) {
+		return false;
+	}
+
+	size_t requiredBytes =
+		sizeof(BinaryHeader) +
+		(header.NumAttributes * sizeof(BufferAttribute)) +
+		(header.VertexStride * (size_t)header.NumVertices) +
+		(header.NumIndices * GetIndexTypeSize(header.IndicesType));
+	if (size < requiredBytes) {
+		LOG_ERROR("Not enough data in the file!");
+		return false;
+	}
+
+	// Find the position attribute in the vertex declaration
+	std::vector<BufferAttribute> vertexDeclaration;
+	vertexDeclaration.resize(header.NumAttributes);
+	for (int ix = 0; ix < header.NumAttributes; ix++) {
+		file.read(reinterpret_cast<char*>(&vertexDeclaration[ix]), sizeof(BufferAttribute));
+	}
+	auto it = std::find_if(vertexDeclaration.begin(), vertexDeclaration.end(), [](const BufferAttribute& attrib) {
+		return attrib.Usage == AttribUsage::Position;
+	});
+	if (it == vertexDeclaration.end() || it->Type != AttributeType::Float || it->Size < 3 || 
+		it->Offset + sizeof(glm::vec3) > header.VertexStride) {
+		return false;
+	}
+	size_t positionOffset = it->Offset;
+
+	// Skip over the indices, the positions are all we need
+	file.seekg(header.NumIndices * GetIndexTypeSize(header.IndicesType), std::ios::cur);
+
+	std::vector<uint8_t> vertexStore(header.NumVertices * (size_t)header.VertexStride);
+	file.read(reinterpret_cast<char*>(vertexStore.data()), vertexStore.size());
+
+	positions.resize(header.NumVertices);
+	for (size_t ix = 0; ix < header.NumVertices; ix++) {
+		memcpy(&positions[ix], vertexStore.data() + ix * header.VertexStride + positionOffset, sizeof(glm::vec3));
+	}
+
+	return true;
+}
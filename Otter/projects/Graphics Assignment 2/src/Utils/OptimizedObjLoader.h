@@ -12,6 +12,7 @@
 #include "Graphics/VertexTypes.h"
 
 #include "Utils/MeshBuilder.h"
+#include "Utils/MeshFactory.h"
 
 /// <summary>
 /// An optimized OBJ loader that can convert an OBJ file to a binary representation
@@ -27,6 +28,24 @@ public:
 	/// <returns>A VAO loaded from disk</returns>
 	static VertexArrayObject::Sptr LoadFromFile(const std::string& filename);
 	/// <summary>
+	/// Loads the CPU side data for a mesh from an OBJ or binary file, converting the OBJ to a binary
+	/// file in the same way as LoadFromFile. This is what lets us run import steps (such as LOD generation)
+	/// on the mesh before it is sent to OpenGL
+	/// </summary>
+	/// <param name="filename">The path to the .obj or .bin file to load</param>
+	/// <param name="mesh">The mesh builder to load the vertices and indices into, must be empty</param>
+	/// <param name="tangentMode">The rules to use for the mesh's tangents. Binary files always store fast tangents, so other modes are recalculated after loading</param>
+	/// <returns>True if the data was loaded, false if the file's vertex layout does not match the mesh builder</returns>
+	static bool LoadMeshData(const std::string& filename, MeshBuilder<VertexPosNormTexColTangents>& mesh, TangentMode tangentMode = TangentMode::Fast);
+	/// <summary>
+	/// Loads only the vertex positions from an OBJ or binary file. This works for any vertex layout
+	/// with a float position, so meshes that LoadMeshData can't handle can still be used for physics
+	/// </summary>
+	/// <param name="filename">The path to the .obj or .bin file to load</param>
+	/// <param name="positions">The vector to store the object space positions in</param>
+	/// <returns>True if the positions were loaded, false if the file has no usable position attribute</returns>
+	static bool LoadPositions(const std::string& filename, std::vector<glm::vec3>& positions);
+	/// <summary>
 	/// Manually converts an OBJ file into a binary mesh file
 	/// </summary>
 	/// <param name="inFile">The path to OBJ file to convert</param>
@@ -66,6 +85,8 @@ protected:
 
 	static MeshBuilder<VertexPosNormTexColTangents>* _LoadFromObjFile(const std::string& filename);
 	static VertexArrayObject::Sptr _LoadFromBinFile(const std::string& filename);
+	static bool _LoadMeshDataFromBinFile(const std::string& filename, MeshBuilder<VertexPosNormTexColTangents>& mesh);
+	static bool _LoadPositionsFromBinFile(const std::string& filename, std::vector<glm::vec3>& positions);
 };
 
 template <typename VertexType>
@@ -0,0 +1,11 @@
+#pragma once
+
+// Defines SIMD_USE_SSE as 1 if we can use SSE2 intrinsics, and includes them if so. Code using
+// them should always keep a scalar path for when SIMD_USE_SSE is 0
+// MSVC always has SSE2 available on x64, GCC and Clang will tell us if it's enabled
+#if defined(_M_X64) || defined(__SSE2__)
+#define SIMD_USE_SSE 1
+#include <emmintrin.h>
+#else
+#define SIMD_USE_SSE 0
+#endif
@@ -0,0 +1,87 @@
+#include "Utils/WorkerPool.h"
+#include "Logging.h"
+
+WorkerPool::WorkerPool(size_t threadCount) :
+	_workers(std::vector<std::thread>()),
+	_task(nullptr),
+	_workerTasks(0),
+	_pending(0),
+	_generation(0),
+	_shutdown(false)
+{
+	threadCount = threadCount > 0 ? threadCount : 1;
+	_workers.reserve(threadCount - 1);
+	for (size_t ix = 0; ix + 1 < threadCount; ix++) {
+		_workers.emplace_back(&WorkerPool::_WorkerMain, this, ix);
+	}
+}
+
+WorkerPool::~WorkerPool() {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_shutdown = true;
+	}
+	_wake.notify_all();
+	for (std::thread& worker : _workers) {
+		worker.join();
+	}
+}
+
+WorkerPool::Sptr WorkerPool::GetShared() {
+	static WorkerPool::Sptr shared = std::make_shared<WorkerPool>(std::max(std::thread::hardware_concurrency(), 1u));
+	return shared;
+}
+
+void WorkerPool::Run(size_t taskCount, const std::function<void(size_t)>& task) {
+	LOG_ASSERT(taskCount <= GetThreadCount(), "Cannot run {} tasks on a pool of {} threads", taskCount, GetThreadCount());
+	if (taskCount == 0) {
+		return;
+	}
+	// Nothing to hand off, skip waking anyone up
+	if (taskCount == 1) {
+		task(0);
+		return;
+	}
+
+	std::lock_guard<std::mutex> runLock(_runMutex);
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_task = &task;
+		_workerTasks = taskCount - 1;
+		_pending = taskCount - 1;
+		_generation++;
+	}
+	_wake.notify_all();
+
+	task(taskCount - 1);
+
+	std::unique_lock<std::mutex> lock(_mutex);
+	_done.wait(lock, [this]() { return _pending == 0; });
+	_task = nullptr;
+}
+
+void WorkerPool::_WorkerMain(size_t index) {
+	uint64_t lastGeneration = 0;
+	std::unique_lock<std::mutex> lock(_mutex);
+	while (true) {
+		_wake.wait(lock, [&]() { return _shutdown || _generation != lastGeneration; });
+		if (_shutdown) {
+			return;
+		}
+		lastGeneration = _generation;
+
+		// Jobs with fewer tasks than we have workers leave the rest of us asleep
+		if (index >= _workerTasks) {
+			continue;
+		}
+
+		const std::function<void(size_t)>& task = *_task;
+		lock.unlock();
+		task(index);
+		lock.lock();
+
+		if (--_pending == 0) {
+			_done.notify_one();
+		}
+	}
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+#include <cstdint>
+
+#include "Utils/Macros.h"
+
+/// <summary>
+/// A fixed set of worker threads that are created once and kept asleep between jobs, so that
+/// splitting work that runs many times a frame doesn't pay for creating and joining threads each time
+///
+/// The thread that calls Run always takes one of the tasks itself, so a pool with a thread count of
+/// N only creates N - 1 workers. Run is not re-entrant, tasks must not call Run on the pool that is
+/// running them. Calls from different threads are allowed, but they take turns
+/// </summary>
+class WorkerPool final {
+public:
+	MAKE_PTRS(WorkerPool);
+	NO_COPY(WorkerPool);
+	NO_MOVE(WorkerPool);
+
+	/// <summary>
+	/// Creates a new worker pool, starting it's worker threads
+	/// </summary>
+	/// <param name="threadCount">The number of threads that can run tasks, including the calling thread</param>
+	WorkerPool(size_t threadCount);
+	/// <summary>
+	/// Wakes up and joins all of the worker threads
+	/// </summary>
+	~WorkerPool();
+
+	/// <summary>
+	/// Gets the pool that the engine shares between all of it's systems, created the first time it's
+	/// needed with one thread per hardware thread. Systems should use this rather than making their own
+	/// pools, so that the machine doesn't end up with more busy threads than it has cores
+	/// </summary>
+	static WorkerPool::Sptr GetShared();
+
+	/// <summary>
+	/// Runs task(index) for each index in [0, taskCount), each on a different thread, and waits for all
+	/// of them to finish. The last task is run on the calling thread
+	/// </summary>
+	/// <param name="taskCount">The number of tasks to run, at most GetThreadCount()</param>
+	/// <param name="task">The function to call for each task index</param>
+	void Run(size_t taskCount, const std::function<void(size_t)>& task);
+	/// <summary>
+	/// Splits count items into contiguous ranges, and calls work(thread, begin, end) for each range on one
+	/// of the pool's threads. Only goes wide when each thread gets at least minPerThread items, and the
+	/// calling thread takes the last range, so the ranges are in order of their thread index
+	/// </summary>
+	/// <param name="count">The number of items to split up</param>
+	/// <param name="minPerThread">The fewest items that are worth handing to another thread</param>
+	/// <param name="work">The function to call for each range</param>
+	/// <returns>The number of ranges the items were split into</returns>
+	template <typename Func>
+	size_t RunRanges(size_t count, size_t minPerThread, const Func& work) {
+		size_t threadCount = std::clamp<size_t>(count / std::max<size_t>(minPerThread, 1), 1, GetThreadCount());
+		Run(threadCount, [&](size_t thread) {
+			work(thread, (count * thread) / threadCount, (count * (thread + 1)) / threadCount);
+		});
+		return threadCount;
+	}
+
+	/// <summary>
+	/// Gets the number of tasks that can run at once, including the calling thread
+	/// </summary>
+	size_t GetThreadCount() const { return _workers.size() + 1; }
+
+private:
+	std::vector<std::thread>          _workers;
+	// Held for the whole of a call to Run, so that jobs from different threads don't overlap
+	std::mutex                        _runMutex;
+	std::mutex                        _mutex;
+	// Signalled when a new job is started, or when the pool is shutting down
+	std::condition_variable           _wake;
+	// Signalled when the last worker in a job has finished it's task
+	std::condition_variable           _done;
+	const std::function<void(size_t)>* _task;
+	// The number of tasks in the current job that are run by workers, and how many of them are still running
+	size_t                            _workerTasks;
+	size_t                            _pending;
+	// Incremented for each job, so that workers can tell a new job from a spurious wake up
+	uint64_t                          _generation;
+	bool                              _shutdown;
+
+	void _WorkerMain(size_t index);
+};
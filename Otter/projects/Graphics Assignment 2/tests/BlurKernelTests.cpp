@@ -0,0 +1,142 @@
+#include "Testing.h"
+#include "Graphics/BlurKernel.h"
+
+#include <random>
+#include <GLM/glm.hpp>
+
+namespace {
+	// Samples a row of texels with linear filtering and clamp to edge, the same as the GPU would
+	float SampleLinear(const std::vector<float>& texels, float position) {
+		float clamped = glm::clamp(position, 0.0f, static_cast<float>(texels.size() - 1));
+		int left = static_cast<int>(glm::floor(clamped));
+		int right = glm::min(left + 1, static_cast<int>(texels.size() - 1));
+		float t = clamped - left;
+		return texels[left] * (1.0f - t) + texels[right] * t;
+	}
+
+	float SampleNearest(const std::vector<float>& texels, int position) {
+		return texels[glm::clamp(position, 0, static_cast<int>(texels.size() - 1))];
+	}
+
+	// Checks that blurring a random row of texels with the taps gives the same result as a direct
+	// convolution with the weights
+	void CheckTapsMatchConvolution(const std::vector<float>& weights) {
+		std::vector<BlurKernel::Tap> taps;
+		BlurKernel::GetLinearTaps(weights, taps);
+
+		std::mt19937 random(42);
+		std::uniform_real_distribution<float> value(0.0f, 1.0f);
+		std::vector<float> texels(64);
+		for (float& texel : texels) {
+			texel = value(random);
+		}
+
+		const int center = static_cast<int>(weights.size()) / 2;
+		// Stay away from the edges, where clamping makes the bilinear taps read the wrong texels
+		for (int pixel = center + 1; pixel + center + 1 < static_cast<int>(texels.size()); pixel++) {
+			float expected = 0.0f;
+			for (int ix = 0; ix < static_cast<int>(weights.size()); ix++) {
+				expected += weights[ix] * SampleNearest(texels, pixel + ix - center);
+			}
+			float actual = 0.0f;
+			for (const BlurKernel::Tap& tap : taps) {
+				actual += tap.Weight * SampleLinear(texels, pixel + tap.Offset);
+			}
+			CHECK_NEAR(actual, expected, 1e-5f);
+		}
+	}
+}
+
+TEST_CASE(BlurKernel_GaussianIsNormalizedAndSymmetric) {
+	std::vector<float> weights;
+	BlurKernel::GetGaussianWeights(12, 4.0f, weights);
+
+	CHECK_EQ(weights.size(), 25u);
+	float total = 0.0f;
+	for (float weight : weights) {
+		total += weight;
+	}
+	CHECK_NEAR(total, 1.0f, 1e-5f);
+	for (size_t ix = 0; ix < weights.size() / 2; ix++) {
+		CHECK_NEAR(weights[ix], weights[weights.size() - 1 - ix], 1e-7f);
+		// The weights fall off away from the center
+		CHECK(weights[ix] < weights[ix + 1]);
+	}
+}
+
+TEST_CASE(BlurKernel_BoxIsUniform) {
+	std::vector<float> weights;
+	BlurKernel::GetBoxWeights(2, weights);
+
+	CHECK_EQ(weights.size(), 5u);
+	for (float weight : weights) {
+		CHECK_NEAR(weight, 0.2f, 1e-7f);
+	}
+}
+
+TEST_CASE(BlurKernel_LinearTapsMatchConvolution) {
+	std::vector<float> weights;
+	std::vector<BlurKernel::Tap> taps;
+
+	// A radius of 12 is the center plus 6 bilinear pairs on each side
+	BlurKernel::GetGaussianWeights(12, 4.0f, weights);
+	BlurKernel::GetLinearTaps(weights, taps);
+	CHECK_EQ(taps.size(), 13u);
+	CheckTapsMatchConvolution(weights);
+
+	// A 5x5 box is 3 taps a pass, 6 for both passes instead of the 25 for the full 2D kernel
+	BlurKernel::GetBoxWeights(2, weights);
+	BlurKernel::GetLinearTaps(weights, taps);
+	CHECK_EQ(taps.size() * 2, 6u);
+	CheckTapsMatchConvolution(weights);
+
+	// Even radii leave the outer texel without a partner
+	BlurKernel::GetGaussianWeights(3, 1.5f, weights);
+	CheckTapsMatchConvolution(weights);
+
+	// Weights of different signs can't share a bilinear tap, but still have to give the same result
+	CheckTapsMatchConvolution({ -0.25f, 0.5f, 1.0f, 0.5f, -0.25f });
+}
+
+TEST_CASE(BlurKernel_FactorizeSeparable) {
+	// The outer product of a gaussian with itself, the same as a 2D gaussian
+	std::vector<float> weights;
+	BlurKernel::GetGaussianWeights(2, 1.0f, weights);
+	std::vector<float> kernel(25);
+	for (int iy = 0; iy < 5; iy++) {
+		for (int ix = 0; ix < 5; ix++) {
+			kernel[iy * 5 + ix] = weights[iy] * weights[ix];
+		}
+	}
+
+	std::vector<float> row, column;
+	CHECK(BlurKernel::Factorize(kernel.data(), 5, row, column));
+	for (int iy = 0; iy < 5; iy++) {
+		for (int ix = 0; ix < 5; ix++) {
+			CHECK_NEAR(column[iy] * row[ix], kernel[iy * 5 + ix], 1e-6f);
+		}
+	}
+
+	std::vector<float> box(25, 1.0f / 25.0f);
+	CHECK(BlurKernel::Factorize(box.data(), 5, row, column));
+}
+
+TEST_CASE(BlurKernel_FactorizeRejectsNonSeparable) {
+	std::vector<float> row, column;
+
+	// A plus shape can't be written as a column times a row
+	const float plus[9] = {
+		0.0f, 1.0f, 0.0f,
+		1.0f, 1.0f, 1.0f,
+		0.0f, 1.0f, 0.0f
+	};
+	CHECK(!BlurKernel::Factorize(plus, 3, row, column));
+
+	// Neither can a laplacian
+	const float laplacian[9] = {
+		 0.0f, -1.0f,  0.0f,
+		-1.0f,  4.0f, -1.0f,
+		 0.0f, -1.0f,  0.0f
+	};
+	CHECK(!BlurKernel::Factorize(laplacian, 3, row, column));
+}
@@ -0,0 +1,131 @@
+#include "Testing.h"
+#include "Graphics/DepthPyramid.h"
+
+#include <random>
+#include <algorithm>
+#include <GLM/gtc/matrix_transform.hpp>
+
+namespace {
+	// A depth buffer that is near everywhere except for a single far pixel
+	std::vector<float> MakeHole(uint32_t width, uint32_t height, uint32_t holeX, uint32_t holeY) {
+		std::vector<float> depth(width * height, 0.2f);
+		depth[holeY * width + holeX] = 1.0f;
+		return depth;
+	}
+
+	ScreenRect MakeRect(int minX, int minY, int maxX, int maxY, float nearestDepth) {
+		ScreenRect rect;
+		rect.Min = glm::ivec2(minX, minY);
+		rect.Max = glm::ivec2(maxX, maxY);
+		rect.NearestDepth = nearestDepth;
+		return rect;
+	}
+}
+
+TEST_CASE(DepthPyramid_LevelsTakeTheFurthestDepth) {
+	// Odd sizes, so that the last row and column of some levels only have one texel to read
+	const uint32_t width = 13, height = 7;
+	std::mt19937 random(3);
+	std::uniform_real_distribution<float> value(0.0f, 1.0f);
+	std::vector<float> depth(width * height);
+	for (float& texel : depth) {
+		texel = value(random);
+	}
+
+	DepthPyramid pyramid;
+	pyramid.Build(glm::mat4(1.0f), glm::vec3(0.0f), depth.data(), width, height);
+
+	// 13x7, 7x4, 4x2, 2x1, 1x1
+	CHECK_EQ(pyramid.GetLevelCount(), 5);
+	CHECK(pyramid.GetLevel(0) == depth);
+	for (int level = 1; level < pyramid.GetLevelCount(); level++) {
+		glm::uvec2 sourceSize = pyramid.GetLevelSize(level - 1);
+		glm::uvec2 size = pyramid.GetLevelSize(level);
+		CHECK(size == (sourceSize + 1u) / 2u);
+
+		const std::vector<float>& source = pyramid.GetLevel(level - 1);
+		for (uint32_t y = 0; y < size.y; y++) {
+			for (uint32_t x = 0; x < size.x; x++) {
+				float expected = 0.0f;
+				for (uint32_t sy = y * 2; sy < glm::min(y * 2 + 2, sourceSize.y); sy++) {
+					for (uint32_t sx = x * 2; sx < glm::min(x * 2 + 2, sourceSize.x); sx++) {
+						expected = glm::max(expected, source[sy * sourceSize.x + sx]);
+					}
+				}
+				CHECK_EQ(pyramid.GetLevel(level)[y * size.x + x], expected);
+			}
+		}
+	}
+	CHECK_EQ(pyramid.GetLevel(pyramid.GetLevelCount() - 1)[0], *std::max_element(depth.begin(), depth.end()));
+}
+
+TEST_CASE(DepthPyramid_TestRectPicksLevelWithFourTexels) {
+	const uint32_t size = 64;
+	DepthPyramid pyramid;
+	// Pixels 18 to 29 are 12 pixels, which is 5 texels on level 1 and 3 texels on level 2. So the
+	// test should be done on level 2, where texel 4 covers pixels 16 to 19
+	const ScreenRect rect = MakeRect(18, 18, 29, 29, 0.5f);
+
+	// Nothing behind the rect is far enough away to see the object
+	std::vector<float> depth(size * size, 0.2f);
+	pyramid.Build(glm::mat4(1.0f), glm::vec3(0.0f), depth.data(), size, size);
+	CHECK(!pyramid.TestRect(rect));
+
+	// Pixel 16 shares a texel with the rect on level 2 but not on level 1, so this is only
+	// visible if level 2 or coarser was used
+	depth = MakeHole(size, size, 16, 20);
+	pyramid.Build(glm::mat4(1.0f), glm::vec3(0.0f), depth.data(), size, size);
+	CHECK(pyramid.TestRect(rect));
+
+	// Pixel 14 only shares a texel with the rect on level 5, so if this is visible a level coarser
+	// than 2 was used
+	depth = MakeHole(size, size, 14, 20);
+	pyramid.Build(glm::mat4(1.0f), glm::vec3(0.0f), depth.data(), size, size);
+	CHECK(!pyramid.TestRect(rect));
+
+	// Small rects are tested on the full resolution level, so even a neighbouring pixel doesn't count
+	const ScreenRect small = MakeRect(17, 20, 18, 21, 0.5f);
+	CHECK(!pyramid.TestRect(small));
+	depth = MakeHole(size, size, 18, 21);
+	pyramid.Build(glm::mat4(1.0f), glm::vec3(0.0f), depth.data(), size, size);
+	CHECK(pyramid.TestRect(small));
+}
+
+TEST_CASE(DepthPyramid_IsVisible) {
+	// An ortho camera looking down -Z, with an occluder at a distance of 5 covering the middle
+	// half of the screen
+	const uint32_t width = 64, height = 32;
+	glm::mat4 viewProjection = glm::ortho(-1.0f, 1.0f, -1.0f, 1.0f, 0.1f, 10.0f);
+	const float occluderDepth = (5.0f - 0.1f) / (10.0f - 0.1f);
+	std::vector<float> depth(width * height, 1.0f);
+	for (uint32_t y = height / 4; y < height * 3 / 4; y++) {
+		for (uint32_t x = width / 4; x < width * 3 / 4; x++) {
+			depth[y * width + x] = occluderDepth;
+		}
+	}
+
+	DepthPyramid pyramid;
+	CHECK(pyramid.IsVisible(BoundingBox{ glm::vec3(-0.1f, -0.1f, -7.0f), glm::vec3(0.1f, 0.1f, -6.0f) }));
+	pyramid.Build(viewProjection, glm::vec3(0.0f), depth.data(), width, height);
+
+	// Behind the occluder
+	CHECK(!pyramid.IsVisible(BoundingBox{ glm::vec3(-0.1f, -0.1f, -7.0f), glm::vec3(0.1f, 0.1f, -6.0f) }));
+	// In front of it
+	CHECK(pyramid.IsVisible(BoundingBox{ glm::vec3(-0.1f, -0.1f, -4.0f), glm::vec3(0.1f, 0.1f, -3.0f) }));
+	// Behind it, but poking out past it's edge
+	CHECK(pyramid.IsVisible(BoundingBox{ glm::vec3(0.3f, -0.1f, -7.0f), glm::vec3(0.7f, 0.1f, -6.0f) }));
+	// Crossing the near plane
+	CHECK(pyramid.IsVisible(BoundingBox{ glm::vec3(-0.1f, -0.1f, -1.0f), glm::vec3(0.1f, 0.1f, 1.0f) }));
+
+	// Just inside of the occluder's edge, it's hidden until the camera has moved far enough that the
+	// grown box reaches past the edge
+	BoundingBox nearEdge = { glm::vec3(0.3f, -0.1f, -7.0f), glm::vec3(0.4f, 0.1f, -6.0f) };
+	CHECK(!pyramid.IsVisible(nearEdge));
+	CHECK_NEAR(pyramid.GetCameraDistance(glm::vec3(0.0f, 0.0f, 0.05f)), 0.05f, 1e-6f);
+	CHECK(!pyramid.IsVisible(nearEdge, pyramid.GetCameraDistance(glm::vec3(0.0f, 0.0f, 0.05f))));
+	CHECK(pyramid.IsVisible(nearEdge, pyramid.GetCameraDistance(glm::vec3(0.2f, 0.0f, 0.0f))));
+
+	// Clearing the pyramid makes everything visible again
+	pyramid.Clear();
+	CHECK(pyramid.IsVisible(BoundingBox{ glm::vec3(-0.1f, -0.1f, -7.0f), glm::vec3(0.1f, 0.1f, -6.0f) }));
+}
@@ -0,0 +1,142 @@
+#include "Testing.h"
+#include "Graphics/Buffers/DirtyRanges.h"
+#include "Graphics/Buffers/UniformBuffer.h"
+
+#include <cstddef>
+
+namespace {
+	// Checks that the ranges are exactly the expected { offset, size } pairs
+	void CheckRanges(const std::vector<DirtyRanges::Range>& ranges, const std::vector<DirtyRanges::Range>& expected) {
+		CHECK_EQ(ranges.size(), expected.size());
+		for (size_t ix = 0; ix < ranges.size() && ix < expected.size(); ix++) {
+			CHECK_EQ(ranges[ix].Offset, expected[ix].Offset);
+			CHECK_EQ(ranges[ix].Size, expected[ix].Size);
+		}
+	}
+
+	// Stands in for OpenGL, so that uniform buffers can be tested without a context. Uploads are
+	// recorded so that the tests can see what would have been sent
+	std::vector<DirtyRanges::Range> Uploads;
+
+	void APIENTRY StubCreateBuffers(GLsizei n, GLuint* buffers) {
+		for (GLsizei ix = 0; ix < n; ix++) {
+			buffers[ix] = static_cast<GLuint>(ix + 1);
+		}
+	}
+	void APIENTRY StubDeleteBuffers(GLsizei, const GLuint*) { }
+	void APIENTRY StubNamedBufferData(GLuint, GLsizeiptr, const void*, GLenum) { }
+	void APIENTRY StubNamedBufferSubData(GLuint, GLintptr offset, GLsizeiptr size, const void*) {
+		Uploads.push_back({ static_cast<uint32_t>(offset), static_cast<uint32_t>(size) });
+	}
+
+	void StubBufferFunctions() {
+		glad_glCreateBuffers = StubCreateBuffers;
+		glad_glDeleteBuffers = StubDeleteBuffers;
+		glad_glNamedBufferData = StubNamedBufferData;
+		glad_glNamedBufferSubData = StubNamedBufferSubData;
+		Uploads.clear();
+	}
+
+	struct TestUniforms {
+		float    First;
+		float    Second;
+		uint8_t  Padding[200];
+		float    Far;
+		float    Array[4];
+	};
+}
+
+TEST_CASE(DirtyRanges_MergesAdjacentAndOverlapping) {
+	DirtyRanges ranges(0);
+	ranges.Add(0, 16);
+	ranges.Add(16, 16);
+	ranges.Add(24, 16);
+	// Entirely within the last range
+	ranges.Add(4, 4);
+	CheckRanges(ranges.Coalesce(), { { 0, 40 } });
+
+	// Empty ranges are ignored
+	ranges.Clear();
+	ranges.Add(8, 0);
+	CHECK(ranges.IsEmpty());
+	CheckRanges(ranges.Coalesce(), { });
+}
+
+TEST_CASE(DirtyRanges_MergesWithinGap) {
+	DirtyRanges ranges(64);
+	CHECK_EQ(ranges.GetMergeGap(), 64u);
+	ranges.Add(0, 16);
+	// A gap of exactly 64 bytes is merged, one more is not
+	ranges.Add(80, 16);
+	ranges.Add(161, 4);
+	CheckRanges(ranges.Coalesce(), { { 0, 96 }, { 161, 4 } });
+
+	// Without a gap, only touching ranges are merged
+	DirtyRanges exact(0);
+	exact.Add(0, 16);
+	exact.Add(17, 4);
+	CheckRanges(exact.Coalesce(), { { 0, 16 }, { 17, 4 } });
+}
+
+TEST_CASE(DirtyRanges_CoalescesOutOfOrder) {
+	DirtyRanges ranges(64);
+	ranges.Add(400, 8);
+	ranges.Add(0, 4);
+	ranges.Add(200, 16);
+	ranges.Add(40, 8);
+	// Overlaps the range at 200 from the front
+	ranges.Add(190, 20);
+	ranges.Add(1000, 4);
+	CheckRanges(ranges.Coalesce(), { { 0, 48 }, { 190, 26 }, { 400, 8 }, { 1000, 4 } });
+
+	// Coalescing again doesn't change anything
+	CheckRanges(ranges.Coalesce(), { { 0, 48 }, { 190, 26 }, { 400, 8 }, { 1000, 4 } });
+
+	ranges.Clear();
+	CHECK(ranges.IsEmpty());
+	ranges.Add(8, 8);
+	ranges.Add(0, 8);
+	CheckRanges(ranges.Coalesce(), { { 0, 16 } });
+}
+
+TEST_CASE(UniformBuffer_UploadsChangedFields) {
+	StubBufferFunctions();
+	UniformBuffer<TestUniforms> buffer;
+
+	// Fields next to each other go up in one upload, far apart fields in their own
+	buffer.Set(&TestUniforms::Far, 1.0f);
+	buffer.Set(&TestUniforms::First, 1.0f);
+	buffer.Set(&TestUniforms::Second, 1.0f);
+	buffer.Update();
+	CheckRanges(Uploads, { { offsetof(TestUniforms, First), 8 }, { offsetof(TestUniforms, Far), 4 } });
+
+	// Setting the same values again doesn't upload anything
+	Uploads.clear();
+	buffer.Set(&TestUniforms::Far, 1.0f);
+	buffer.SetElement(&TestUniforms::Array, 2, 0.0f);
+	buffer.Update();
+	CheckRanges(Uploads, { });
+
+	Uploads.clear();
+	buffer.SetElement(&TestUniforms::Array, 2, 3.0f);
+	buffer.Update();
+	CheckRanges(Uploads, { { offsetof(TestUniforms, Array) + 2 * sizeof(float), 4 } });
+}
+
+TEST_CASE(UniformBuffer_GetDataMarksAllDirty) {
+	StubBufferFunctions();
+	UniformBuffer<TestUniforms> buffer;
+
+	// We can't see what gets changed through the reference, so it all has to go up
+	buffer.Set(&TestUniforms::Far, 1.0f);
+	buffer.GetData().First = 2.0f;
+	buffer.Update();
+	CheckRanges(Uploads, { { 0, sizeof(TestUniforms) } });
+
+	// The const version doesn't change anything
+	Uploads.clear();
+	const UniformBuffer<TestUniforms>& constBuffer = buffer;
+	CHECK_EQ(constBuffer.GetData().First, 2.0f);
+	buffer.Update();
+	CheckRanges(Uploads, { });
+}
@@ -0,0 +1,95 @@
+#include "Testing.h"
+#include "Utils/Frustum.h"
+
+#include <random>
+#include <GLM/gtc/matrix_transform.hpp>
+
+namespace {
+	// Runs the batched test, and checks that it keeps exactly the spheres that the scalar test keeps
+	void CheckMatchesScalar(const Frustum& frustum, const std::vector<glm::vec4>& spheres) {
+		std::vector<uint32_t> expected;
+		for (uint32_t ix = 0; ix < spheres.size(); ix++) {
+			if (frustum.Intersects(BoundingSphere{ glm::vec3(spheres[ix]), spheres[ix].w })) {
+				expected.push_back(ix);
+			}
+		}
+
+		// Leave some slack past the end so that we can tell if it writes more than it reports
+		std::vector<uint32_t> visible(spheres.size() + 4, UINT32_MAX);
+		uint32_t count = frustum.CullSpheres(spheres.data(), static_cast<uint32_t>(spheres.size()), visible.data());
+
+		CHECK_EQ(count, expected.size());
+		for (uint32_t ix = 0; ix < count && ix < expected.size(); ix++) {
+			CHECK_EQ(visible[ix], expected[ix]);
+		}
+		for (size_t ix = count; ix < visible.size(); ix++) {
+			CHECK_EQ(visible[ix], UINT32_MAX);
+		}
+	}
+}
+
+TEST_CASE(Frustum_CullSpheresMatchesScalar) {
+	glm::mat4 view = glm::lookAt(glm::vec3(3.0f, 2.0f, 5.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 50.0f);
+	Frustum frustum = Frustum::FromViewProjection(projection * view);
+
+	std::mt19937 random(1234);
+	std::uniform_real_distribution<float> position(-40.0f, 40.0f);
+	std::uniform_real_distribution<float> radius(0.0f, 4.0f);
+
+	// Counts that aren't a multiple of 4 leave a tail for the scalar path
+	for (size_t count : { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 13, 64, 1001 }) {
+		std::vector<glm::vec4> spheres(count);
+		for (glm::vec4& sphere : spheres) {
+			sphere = glm::vec4(position(random), position(random), position(random), radius(random));
+		}
+		CheckMatchesScalar(frustum, spheres);
+	}
+}
+
+TEST_CASE(Frustum_CullSpheresOnPlanes) {
+	// An orthographic frustum has axis aligned planes, so the distances below are exact
+	Frustum frustum = Frustum::FromViewProjection(glm::ortho(-4.0f, 4.0f, -4.0f, 4.0f, 1.0f, 9.0f));
+
+	// For each plane, a point on it, and the direction pointing out of the frustum
+	const glm::vec3 onPlane[6] = {
+		{ -4.0f, 0.0f, -5.0f }, { 4.0f, 0.0f, -5.0f },
+		{ 0.0f, -4.0f, -5.0f }, { 0.0f, 4.0f, -5.0f },
+		{ 0.0f, 0.0f, -1.0f },  { 0.0f, 0.0f, -9.0f }
+	};
+	const glm::vec3 outward[6] = {
+		{ -1.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 0.0f },
+		{ 0.0f, -1.0f, 0.0f }, { 0.0f, 1.0f, 0.0f },
+		{ 0.0f, 0.0f, 1.0f },  { 0.0f, 0.0f, -1.0f }
+	};
+
+	std::vector<glm::vec4> spheres;
+	std::vector<bool> expected;
+	for (int plane = 0; plane < 6; plane++) {
+		// A point sitting on the plane, and a sphere just touching it from the outside, are both kept
+		spheres.push_back(glm::vec4(onPlane[plane], 0.0f));
+		expected.push_back(true);
+		spheres.push_back(glm::vec4(onPlane[plane] + outward[plane] * 0.5f, 0.5f));
+		expected.push_back(true);
+		// A sphere that is a bit further out is culled
+		spheres.push_back(glm::vec4(onPlane[plane] + outward[plane] * 0.75f, 0.5f));
+		expected.push_back(false);
+	}
+	// 18 spheres, so the last 2 go through the scalar path
+	CHECK_EQ(spheres.size() % 4, 2u);
+
+	std::vector<uint32_t> visible(spheres.size());
+	uint32_t count = frustum.CullSpheres(spheres.data(), static_cast<uint32_t>(spheres.size()), visible.data());
+	std::vector<bool> result(spheres.size(), false);
+	for (uint32_t ix = 0; ix < count; ix++) {
+		result[visible[ix]] = true;
+	}
+	for (size_t ix = 0; ix < spheres.size(); ix++) {
+		CHECK_EQ(result[ix], expected[ix]);
+	}
+
+	// Every offset into the list puts the spheres in different lanes, or in the tail
+	for (size_t offset = 0; offset < 4; offset++) {
+		CheckMatchesScalar(frustum, std::vector<glm::vec4>(spheres.begin() + offset, spheres.end()));
+	}
+}
@@ -0,0 +1,154 @@
+#include "Testing.h"
+#include "Graphics/LightClusters.h"
+
+#include <algorithm>
+#include <GLM/gtc/matrix_transform.hpp>
+
+namespace {
+	const float FOV = glm::radians(60.0f);
+	const float ASPECT = 16.0f / 9.0f;
+	const float NEAR_PLANE = 0.1f;
+	const float FAR_PLANE = 100.0f;
+
+	void SetupClusters(LightClusters& clusters) {
+		clusters.SetProjection(glm::perspective(FOV, ASPECT, NEAR_PLANE, FAR_PLANE), NEAR_PLANE, FAR_PLANE);
+	}
+
+	// Gets the view space point in the middle of a screen tile, at the given depth
+	glm::vec3 TileCenter(uint32_t x, uint32_t y, float depth) {
+		glm::vec2 ndc = (glm::vec2(x + 0.5f, y + 0.5f) / glm::vec2(LightClusters::TILES_X, LightClusters::TILES_Y)) * 2.0f - 1.0f;
+		float halfHeight = glm::tan(FOV * 0.5f) * depth;
+		return glm::vec3(ndc.x * halfHeight * ASPECT, ndc.y * halfHeight, -depth);
+	}
+
+	// The depth where a slice starts
+	float SliceStart(uint32_t slice) {
+		return NEAR_PLANE * glm::pow(FAR_PLANE / NEAR_PLANE, slice / static_cast<float>(LightClusters::SLICES));
+	}
+
+	// Gets the lights in a cluster from the (offset, count) list
+	std::vector<uint32_t> GetLights(const LightClusters& clusters, uint32_t index) {
+		const LightClusters::Cluster& cluster = clusters.GetClusters()[index];
+		const std::vector<uint32_t>& indices = clusters.GetLightIndices();
+		return std::vector<uint32_t>(indices.begin() + cluster.Offset, indices.begin() + cluster.Offset + cluster.Count);
+	}
+
+	// Gets all of the clusters that a light was binned into
+	std::vector<uint32_t> GetClustersWithLight(const LightClusters& clusters, uint32_t light) {
+		std::vector<uint32_t> result;
+		for (uint32_t ix = 0; ix < LightClusters::CLUSTER_COUNT; ix++) {
+			std::vector<uint32_t> lights = GetLights(clusters, ix);
+			if (std::find(lights.begin(), lights.end(), light) != lights.end()) {
+				result.push_back(ix);
+			}
+		}
+		return result;
+	}
+
+	// Checks that the clusters' ranges are packed back to back, in cluster order, and cover the whole index list
+	void CheckRangesPacked(const LightClusters& clusters) {
+		uint32_t offset = 0;
+		for (const LightClusters::Cluster& cluster : clusters.GetClusters()) {
+			CHECK_EQ(cluster.Offset, offset);
+			offset += cluster.Count;
+		}
+		CHECK_EQ(offset, clusters.GetLightIndices().size());
+	}
+}
+
+TEST_CASE(LightClusters_SmallLightInOneCluster) {
+	LightClusters clusters;
+	SetupClusters(clusters);
+
+	// Put a small light in the middle of a cluster, away from all of it's edges
+	const uint32_t slice = 12;
+	float depth = glm::sqrt(SliceStart(slice) * SliceStart(slice + 1));
+	glm::vec4 light = glm::vec4(TileCenter(5, 3, depth), 0.01f);
+	clusters.Build(&light, 1);
+
+	CheckRangesPacked(clusters);
+	CHECK_EQ(clusters.GetLightIndices().size(), 1u);
+	uint32_t expected = LightClusters::GetClusterIndex(5, 3, slice);
+	CHECK_EQ(clusters.GetClusters()[expected].Offset, 0u);
+	CHECK_EQ(clusters.GetClusters()[expected].Count, 1u);
+	CHECK_EQ(clusters.GetLightIndices()[0], 0u);
+}
+
+TEST_CASE(LightClusters_LightStraddlesSlices) {
+	LightClusters clusters;
+	SetupClusters(clusters);
+
+	// Centered exactly on the boundary between two slices, so it reaches into both of them
+	const uint32_t slice = 10;
+	float depth = SliceStart(slice);
+	float radius = (SliceStart(slice + 1) - SliceStart(slice)) * 0.1f;
+	glm::vec4 light = glm::vec4(TileCenter(9, 6, depth), radius);
+	clusters.Build(&light, 1);
+
+	CheckRangesPacked(clusters);
+	std::vector<uint32_t> touched = GetClustersWithLight(clusters, 0);
+	std::vector<uint32_t> expected = {
+		LightClusters::GetClusterIndex(9, 6, slice - 1),
+		LightClusters::GetClusterIndex(9, 6, slice)
+	};
+	CHECK(touched == expected);
+}
+
+TEST_CASE(LightClusters_ListsAreSortedByCluster) {
+	LightClusters clusters;
+	SetupClusters(clusters);
+
+	std::vector<glm::vec4> lights = {
+		// Two small lights sharing a cluster, and one in the slice behind them
+		glm::vec4(TileCenter(2, 2, 5.0f), 0.01f),
+		glm::vec4(TileCenter(14, 7, 5.0f), 0.01f),
+		glm::vec4(TileCenter(2, 2, 5.0f) + glm::vec3(0.001f, 0.0f, 0.0f), 0.01f),
+		glm::vec4(TileCenter(2, 2, 5.0f * glm::pow(FAR_PLANE / NEAR_PLANE, 1.0f / LightClusters::SLICES)), 0.01f),
+		// Behind the camera, and off to the side of the screen, these shouldn't be in any cluster
+		glm::vec4(0.0f, 0.0f, 5.0f, 1.0f),
+		glm::vec4(1000.0f, 0.0f, -5.0f, 1.0f),
+		// Beyond the far plane
+		glm::vec4(0.0f, 0.0f, -FAR_PLANE - 2.0f, 1.0f)
+	};
+	clusters.Build(lights.data(), static_cast<uint32_t>(lights.size()));
+
+	CheckRangesPacked(clusters);
+	uint32_t slice = clusters.GetSlice(5.0f);
+	std::vector<uint32_t> shared = GetLights(clusters, LightClusters::GetClusterIndex(2, 2, slice));
+	CHECK(shared == std::vector<uint32_t>({ 0, 2 }));
+	CHECK(GetLights(clusters, LightClusters::GetClusterIndex(14, 7, slice)) == std::vector<uint32_t>({ 1 }));
+	CHECK(GetLights(clusters, LightClusters::GetClusterIndex(2, 2, slice + 1)) == std::vector<uint32_t>({ 3 }));
+	CHECK_EQ(clusters.GetLightIndices().size(), 4u);
+}
+
+TEST_CASE(LightClusters_MatchesBruteForce) {
+	LightClusters clusters;
+	SetupClusters(clusters);
+
+	// Large lights that cover many clusters, including ones crossing the edges of the screen and the near plane
+	std::vector<glm::vec4> lights = {
+		glm::vec4(TileCenter(3, 4, 8.0f), 2.5f),
+		glm::vec4(TileCenter(15, 0, 20.0f), 6.0f),
+		glm::vec4(TileCenter(8, 4, 0.3f), 0.5f),
+		glm::vec4(TileCenter(0, 8, 60.0f), 15.0f)
+	};
+	clusters.Build(lights.data(), static_cast<uint32_t>(lights.size()));
+	CheckRangesPacked(clusters);
+
+	// Every cluster whose bounds touch a light must list it. The tile and slice search can only skip
+	// clusters that the sphere doesn't reach, so this should be exact
+	for (uint32_t light = 0; light < lights.size(); light++) {
+		std::vector<uint32_t> expected;
+		for (uint32_t ix = 0; ix < LightClusters::CLUSTER_COUNT; ix++) {
+			glm::vec3 min, max;
+			clusters.GetClusterBounds(ix, min, max);
+			glm::vec3 center = glm::vec3(lights[light]);
+			glm::vec3 distance = glm::max(glm::max(min - center, center - max), glm::vec3(0.0f));
+			if (glm::dot(distance, distance) <= lights[light].w * lights[light].w) {
+				expected.push_back(ix);
+			}
+		}
+		CHECK(!expected.empty());
+		CHECK(GetClustersWithLight(clusters, light) == expected);
+	}
+}
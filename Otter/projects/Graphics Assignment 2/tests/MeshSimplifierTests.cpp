@@ -0,0 +1,174 @@
+#include "Testing.h"
+#include "Utils/MeshSimplifier.h"
+
+#include <GLM/gtc/constants.hpp>
+
+namespace {
+	typedef VertexPosNormTexColTangents Vertex;
+
+	// A flat grid in the XZ plane, with open borders
+	void MakeGrid(int cells, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+		for (int z = 0; z <= cells; z++) {
+			for (int x = 0; x <= cells; x++) {
+				glm::vec2 uv = glm::vec2(x, z) / static_cast<float>(cells);
+				vertices.emplace_back(glm::vec3(uv.x, 0.0f, uv.y), glm::vec3(0.0f, 1.0f, 0.0f), uv, glm::vec4(1.0f));
+			}
+		}
+		for (int z = 0; z < cells; z++) {
+			for (int x = 0; x < cells; x++) {
+				uint32_t i0 = z * (cells + 1) + x;
+				uint32_t i1 = i0 + 1;
+				uint32_t i2 = i0 + cells + 1;
+				uint32_t i3 = i2 + 1;
+				indices.insert(indices.end(), { i0, i2, i1, i1, i2, i3 });
+			}
+		}
+	}
+
+	// A closed unit sphere with shared vertices along the seam, so that it has no borders or UV seams
+	void MakeSphere(int rings, int segments, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+		auto addVertex = [&](const glm::vec3& normal) {
+			vertices.emplace_back(normal, normal, glm::vec2(normal.x, normal.z) * 0.5f + 0.5f, glm::vec4(1.0f));
+		};
+		addVertex(glm::vec3(0.0f, 1.0f, 0.0f));
+		for (int ring = 1; ring < rings; ring++) {
+			float phi = glm::pi<float>() * ring / rings;
+			for (int segment = 0; segment < segments; segment++) {
+				float theta = glm::two_pi<float>() * segment / segments;
+				addVertex(glm::vec3(glm::sin(phi) * glm::cos(theta), glm::cos(phi), glm::sin(phi) * glm::sin(theta)));
+			}
+		}
+		addVertex(glm::vec3(0.0f, -1.0f, 0.0f));
+
+		const uint32_t bottom = static_cast<uint32_t>(vertices.size() - 1);
+		auto ringVertex = [&](int ring, int segment) {
+			return static_cast<uint32_t>(1 + (ring - 1) * segments + (segment % segments));
+		};
+		for (int segment = 0; segment < segments; segment++) {
+			indices.insert(indices.end(), { 0, ringVertex(1, segment + 1), ringVertex(1, segment) });
+			indices.insert(indices.end(), { bottom, ringVertex(rings - 1, segment), ringVertex(rings - 1, segment + 1) });
+		}
+		for (int ring = 1; ring + 1 < rings; ring++) {
+			for (int segment = 0; segment < segments; segment++) {
+				uint32_t i0 = ringVertex(ring, segment);
+				uint32_t i1 = ringVertex(ring, segment + 1);
+				uint32_t i2 = ringVertex(ring + 1, segment);
+				uint32_t i3 = ringVertex(ring + 1, segment + 1);
+				indices.insert(indices.end(), { i0, i1, i2, i1, i3, i2 });
+			}
+		}
+	}
+
+	// Checks that the output is a valid triangle list over the input's vertices
+	void CheckTriangles(const std::vector<uint32_t>& indices, size_t vertexCount) {
+		CHECK_EQ(indices.size() % 3, 0u);
+		for (uint32_t index : indices) {
+			CHECK(index < vertexCount);
+		}
+	}
+}
+
+TEST_CASE(MeshSimplifier_GridReachesTargetWithinError) {
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	MakeGrid(32, vertices, indices);
+
+	// The grid is flat, so it can be reduced all the way down to its locked border without any error
+	const size_t target = indices.size() / 4;
+	const float targetError = 0.01f;
+	std::vector<uint32_t> result;
+	float error = MeshSimplifier::Simplify(vertices.data(), vertices.size(), indices.data(), indices.size(), result, target, targetError);
+
+	CHECK(!result.empty());
+	CHECK_LE(result.size(), target);
+	CHECK_LE(error, targetError);
+	CheckTriangles(result, vertices.size());
+}
+
+TEST_CASE(MeshSimplifier_SphereReachesTargetWithinError) {
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	MakeSphere(24, 48, vertices, indices);
+
+	const size_t target = (indices.size() / 6) * 3;
+	const float targetError = 0.05f;
+	std::vector<uint32_t> result;
+	float error = MeshSimplifier::Simplify(vertices.data(), vertices.size(), indices.data(), indices.size(), result, target, targetError);
+
+	CHECK(!result.empty());
+	CHECK_LE(result.size(), target);
+	CHECK_LE(error, targetError);
+	CheckTriangles(result, vertices.size());
+}
+
+TEST_CASE(MeshSimplifier_StopsAtErrorLimit) {
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	MakeSphere(24, 48, vertices, indices);
+
+	// A sphere can't lose most of it's triangles without changing shape, so this should stop early
+	const size_t target = 30;
+	const float targetError = 0.005f;
+	std::vector<uint32_t> result;
+	float error = MeshSimplifier::Simplify(vertices.data(), vertices.size(), indices.data(), indices.size(), result, target, targetError);
+
+	CHECK(result.size() > target);
+	CHECK(result.size() < indices.size());
+	CHECK_LE(error, targetError);
+	CheckTriangles(result, vertices.size());
+}
+
+TEST_CASE(MeshSimplifier_WeldsSignedZero) {
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	MakeSphere(24, 48, vertices, indices);
+
+	// Cut a seam along the half plane z = 0, x > 0, the way an exporter writes out a UV seam. The triangles
+	// on the negative side of it use copies of the vertices on the seam, which either keep their 0 or have
+	// it written as -0
+	auto splitSeam = [&](float zero, std::vector<Vertex>& outVertices, std::vector<uint32_t>& outIndices) {
+		outVertices = vertices;
+		outIndices = indices;
+		std::vector<uint32_t> copies(vertices.size(), ~0u);
+		for (size_t ix = 0; ix < outIndices.size(); ix += 3) {
+			glm::vec3 center = (vertices[indices[ix]].Position + vertices[indices[ix + 1]].Position + vertices[indices[ix + 2]].Position) / 3.0f;
+			if (center.x <= 0.0f || center.z >= 0.0f) {
+				continue;
+			}
+			for (int c = 0; c < 3; c++) {
+				uint32_t index = indices[ix + c];
+				if (vertices[index].Position.z != 0.0f) {
+					continue;
+				}
+				if (copies[index] == ~0u) {
+					Vertex copy = vertices[index];
+					copy.Position.z = zero;
+					if (copy.Position.x == 0.0f) {
+						copy.Position.x = zero;
+					}
+					copies[index] = static_cast<uint32_t>(outVertices.size());
+					outVertices.push_back(copy);
+				}
+				outIndices[ix + c] = copies[index];
+			}
+		}
+	};
+	std::vector<Vertex> positiveVertices, negativeVertices;
+	std::vector<uint32_t> positiveIndices, negativeIndices;
+	splitSeam(0.0f, positiveVertices, positiveIndices);
+	splitSeam(-0.0f, negativeVertices, negativeIndices);
+	CHECK(negativeVertices.size() > vertices.size());
+
+	// Both seams are welded, so the -0 copies don't lock any vertices as borders and the sphere simplifies
+	// just as far either way
+	const size_t target = 30;
+	const float targetError = 0.05f;
+	std::vector<uint32_t> expected, result;
+	MeshSimplifier::Simplify(positiveVertices.data(), positiveVertices.size(), positiveIndices.data(), positiveIndices.size(), expected, target, targetError);
+	float error = MeshSimplifier::Simplify(negativeVertices.data(), negativeVertices.size(), negativeIndices.data(), negativeIndices.size(), result, target, targetError);
+
+	CHECK(expected.size() < indices.size() / 4);
+	CHECK_EQ(result.size(), expected.size());
+	CHECK_LE(error, targetError);
+	CheckTriangles(result, negativeVertices.size());
+}
@@ -0,0 +1,206 @@
+#include "Testing.h"
+#include "Graphics/OcclusionBuffer.h"
+
+#include <random>
+#include <GLM/gtc/matrix_transform.hpp>
+
+namespace {
+	const uint32_t WIDTH = 256;
+	const uint32_t HEIGHT = 128;
+
+	// A unit quad in the XY plane, centered on the origin
+	const glm::vec3 QUAD_VERTICES[4] = {
+		glm::vec3(-0.5f, -0.5f, 0.0f),
+		glm::vec3( 0.5f, -0.5f, 0.0f),
+		glm::vec3( 0.5f,  0.5f, 0.0f),
+		glm::vec3(-0.5f,  0.5f, 0.0f)
+	};
+	const uint32_t QUAD_INDICES[6] = { 0, 1, 2, 0, 2, 3 };
+
+	// An orthographic camera looking down -Z, covering [-1, 1] on X and Y, so that a quad facing it
+	// has the same depth everywhere and covers an exact range of pixels
+	glm::mat4 OrthoCamera() {
+		return glm::ortho(-1.0f, 1.0f, -1.0f, 1.0f, 0.1f, 10.0f);
+	}
+
+	// The [0, 1] depth of a point at the given distance from the ortho camera
+	float OrthoDepth(float distance) {
+		return (distance - 0.1f) / (10.0f - 0.1f);
+	}
+
+	BoundingBox MakeBox(const glm::vec3& min, const glm::vec3& max) {
+		return BoundingBox{ min, max };
+	}
+}
+
+TEST_CASE(OcclusionBuffer_QuadMatchesReferenceDepth) {
+	OcclusionBuffer buffer(WIDTH, HEIGHT);
+	WorkerPool pool(4);
+
+	buffer.Begin(OrthoCamera());
+	glm::mat4 transform = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -5.0f));
+	buffer.AddOccluder(transform, QUAD_VERTICES, QUAD_INDICES, 6);
+	buffer.Rasterize(pool);
+	CHECK_EQ(buffer.GetTriangleCount(), 2u);
+
+	// The quad covers the middle half of the screen on both axes. Pixel centers never land exactly
+	// on it's edges, so the reference is exact
+	const float depth = OrthoDepth(5.0f);
+	size_t mismatched = 0;
+	for (uint32_t y = 0; y < HEIGHT; y++) {
+		for (uint32_t x = 0; x < WIDTH; x++) {
+			bool inside = x >= WIDTH / 4 && x < WIDTH * 3 / 4 && y >= HEIGHT / 4 && y < HEIGHT * 3 / 4;
+			float expected = inside ? depth : 1.0f;
+			if (glm::abs(buffer.GetDepth()[y * WIDTH + x] - expected) > 1e-5f) {
+				mismatched++;
+			}
+		}
+	}
+	CHECK_EQ(mismatched, 0u);
+}
+
+TEST_CASE(OcclusionBuffer_TiltedQuadIsConservative) {
+	OcclusionBuffer buffer(WIDTH, HEIGHT);
+	WorkerPool pool(1);
+
+	// Tilt the quad away from the camera, so that it's depth changes across the screen
+	buffer.Begin(OrthoCamera());
+	glm::mat4 transform = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -5.0f));
+	transform = glm::rotate(transform, glm::radians(60.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	transform = glm::scale(transform, glm::vec3(2.0f));
+	buffer.AddOccluder(transform, QUAD_VERTICES, QUAD_INDICES, 6);
+	buffer.Rasterize(pool);
+
+	// Every covered pixel must be at or behind the quad's real depth anywhere inside the pixel, so half
+	// a pixel's change in depth behind the center. Nothing gets pushed past the quad's furthest corner
+	glm::mat3 rotation = glm::mat3(transform);
+	glm::vec3 normal = glm::normalize(rotation * glm::vec3(0.0f, 0.0f, 1.0f));
+	float depthPerPixel = glm::abs(normal.x / normal.z) * (2.0f / WIDTH) / (10.0f - 0.1f);
+	float furthest = 0.0f;
+	for (const glm::vec3& vertex : QUAD_VERTICES) {
+		furthest = glm::max(furthest, OrthoDepth(-(transform * glm::vec4(vertex, 1.0f)).z));
+	}
+	size_t covered = 0;
+	for (uint32_t y = 0; y < HEIGHT; y++) {
+		for (uint32_t x = 0; x < WIDTH; x++) {
+			float value = buffer.GetDepth()[y * WIDTH + x];
+			if (value >= 1.0f) {
+				continue;
+			}
+			covered++;
+			float worldX = ((x + 0.5f) / WIDTH) * 2.0f - 1.0f;
+			// Solve the quad's plane for the distance from the camera at the pixel center
+			float distance = 5.0f + (normal.x / normal.z) * worldX;
+			float center = OrthoDepth(distance);
+			CHECK(value >= glm::min(center + depthPerPixel * 0.5f, furthest) - 1e-5f);
+			CHECK(value <= center + depthPerPixel * 0.5f + 1e-5f);
+		}
+	}
+	CHECK(covered > 0);
+}
+
+TEST_CASE(OcclusionBuffer_ClipsAgainstNearPlane) {
+	OcclusionBuffer buffer(WIDTH, HEIGHT);
+	WorkerPool pool(1);
+	glm::mat4 projection = glm::perspective(glm::radians(60.0f), 2.0f, 0.1f, 100.0f);
+
+	// A floor below the camera that runs from behind it to far in front of it
+	buffer.Begin(projection);
+	glm::mat4 floor = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -1.0f, -20.0f));
+	floor = glm::rotate(floor, glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
+	floor = glm::scale(floor, glm::vec3(40.0f, 50.0f, 1.0f));
+	buffer.AddOccluder(floor, QUAD_VERTICES, QUAD_INDICES, 6);
+	buffer.Rasterize(pool);
+
+	// Clipping leaves a quad, which is split into two triangles
+	CHECK(buffer.GetTriangleCount() >= 2u);
+	size_t covered = 0;
+	for (uint32_t y = 0; y < HEIGHT; y++) {
+		for (uint32_t x = 0; x < WIDTH; x++) {
+			float value = buffer.GetDepth()[y * WIDTH + x];
+			CHECK(value >= 0.0f && value <= 1.0f);
+			// The floor is below the horizon, so it can't cover the top half of the screen
+			if (y >= HEIGHT / 2) {
+				CHECK_EQ(value, 1.0f);
+			}
+			covered += value < 1.0f ? 1 : 0;
+		}
+	}
+	// The near edge of the floor is cut off by the near plane, so the bottom row is covered right across
+	CHECK(covered > 0);
+	for (uint32_t x = 0; x < WIDTH; x++) {
+		CHECK(buffer.GetDepth()[x] < 1.0f);
+	}
+
+	// A quad that is entirely behind the camera adds nothing
+	buffer.Begin(projection);
+	glm::mat4 behind = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, 5.0f));
+	buffer.AddOccluder(behind, QUAD_VERTICES, QUAD_INDICES, 6);
+	buffer.Rasterize(pool);
+	CHECK_EQ(buffer.GetTriangleCount(), 0u);
+}
+
+TEST_CASE(OcclusionBuffer_IsVisible) {
+	OcclusionBuffer buffer(WIDTH, HEIGHT);
+	WorkerPool pool(1);
+
+	buffer.Begin(OrthoCamera());
+	glm::mat4 transform = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -5.0f));
+	buffer.AddOccluder(transform, QUAD_VERTICES, QUAD_INDICES, 6);
+	buffer.Rasterize(pool);
+
+	// Fully behind the occluder
+	CHECK(!buffer.IsVisible(MakeBox(glm::vec3(-0.2f, -0.2f, -7.0f), glm::vec3(0.2f, 0.2f, -6.0f))));
+	// Behind it, but poking out past one side
+	CHECK(buffer.IsVisible(MakeBox(glm::vec3(0.3f, -0.2f, -7.0f), glm::vec3(0.8f, 0.2f, -6.0f))));
+	// Behind it on screen, but partly in front of it in depth
+	CHECK(buffer.IsVisible(MakeBox(glm::vec3(-0.2f, -0.2f, -7.0f), glm::vec3(0.2f, 0.2f, -4.0f))));
+	// In front of the occluder
+	CHECK(buffer.IsVisible(MakeBox(glm::vec3(-0.2f, -0.2f, -4.0f), glm::vec3(0.2f, 0.2f, -3.0f))));
+	// Crossing the near plane
+	CHECK(buffer.IsVisible(MakeBox(glm::vec3(-0.2f, -0.2f, -1.0f), glm::vec3(0.2f, 0.2f, 1.0f))));
+	// Off to the side, with nothing in front of it
+	CHECK(buffer.IsVisible(MakeBox(glm::vec3(0.7f, 0.7f, -9.0f), glm::vec3(0.9f, 0.9f, -8.0f))));
+}
+
+TEST_CASE(OcclusionBuffer_SimdMatchesScalar) {
+	OcclusionBuffer simd(WIDTH, HEIGHT);
+	OcclusionBuffer scalar(WIDTH, HEIGHT);
+	scalar.SetUseSimd(false);
+	WorkerPool pool(4);
+
+	glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 3.0f, 8.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::mat4 viewProjection = glm::perspective(glm::radians(60.0f), 2.0f, 0.1f, 100.0f) * view;
+	simd.Begin(viewProjection);
+	scalar.Begin(viewProjection);
+
+	// Lots of randomly placed and rotated quads, enough to go wide across the pool
+	std::mt19937 random(7);
+	std::uniform_real_distribution<float> position(-6.0f, 6.0f);
+	std::uniform_real_distribution<float> angle(0.0f, glm::two_pi<float>());
+	std::uniform_real_distribution<float> scale(0.2f, 3.0f);
+	for (int ix = 0; ix < 400; ix++) {
+		glm::mat4 transform = glm::translate(glm::mat4(1.0f), glm::vec3(position(random), position(random), position(random)));
+		transform = glm::rotate(transform, angle(random), glm::normalize(glm::vec3(position(random), position(random), 1.0f)));
+		transform = glm::scale(transform, glm::vec3(scale(random), scale(random), 1.0f));
+		simd.AddOccluder(transform, QUAD_VERTICES, QUAD_INDICES, 6);
+		scalar.AddOccluder(transform, QUAD_VERTICES, QUAD_INDICES, 6);
+	}
+	simd.Rasterize(pool);
+	scalar.Rasterize(pool);
+
+	size_t mismatched = 0;
+	for (size_t ix = 0; ix < simd.GetDepth().size(); ix++) {
+		if (simd.GetDepth()[ix] != scalar.GetDepth()[ix]) {
+			mismatched++;
+		}
+	}
+	CHECK_EQ(mismatched, 0u);
+
+	// Both paths should agree on the visibility of random boxes too
+	for (int ix = 0; ix < 500; ix++) {
+		glm::vec3 min = glm::vec3(position(random), position(random), position(random));
+		BoundingBox box = MakeBox(min, min + glm::vec3(scale(random), scale(random), scale(random)) * 0.3f);
+		CHECK_EQ(simd.IsVisible(box), scalar.IsVisible(box));
+	}
+}
@@ -0,0 +1,164 @@
+#include "Testing.h"
+#include "Graphics/RenderGraph.h"
+
+namespace {
+	const RenderGraph::TextureDesc ColorDesc = RenderGraph::TextureDesc(64, 64, RenderTargetType::ColorRgba8);
+}
+
+TEST_CASE(RenderGraph_CullsUnreferencedPasses) {
+	RenderGraph graph;
+	RenderGraph::ResourceId backbuffer = graph.ImportTexture("Backbuffer", ColorDesc);
+	RenderGraph::ResourceId scene = graph.CreateTexture("Scene", ColorDesc);
+	RenderGraph::ResourceId unused = graph.CreateTexture("Unused", ColorDesc);
+	RenderGraph::ResourceId unusedInput = graph.CreateTexture("UnusedInput", ColorDesc);
+	RenderGraph::ResourceId scratch = graph.CreateTexture("Scratch", ColorDesc);
+
+	RenderGraph::PassId draw = graph.AddPass("Draw", nullptr);
+	graph.Write(draw, scene);
+	// Only feeds a pass that gets culled, so it should be culled along with it
+	RenderGraph::PassId feeder = graph.AddPass("Feeder", nullptr);
+	graph.Write(feeder, unusedInput);
+	// Nothing reads what this writes, and reading it's own scratch texture shouldn't keep it alive
+	RenderGraph::PassId dead = graph.AddPass("Dead", nullptr);
+	graph.Read(dead, unusedInput);
+	graph.Write(dead, scratch);
+	graph.Read(dead, scratch);
+	graph.Write(dead, unused);
+	RenderGraph::PassId present = graph.AddPass("Present", nullptr);
+	graph.Read(present, scene);
+	graph.Write(present, backbuffer);
+	// Has no outputs, but draws to the screen
+	RenderGraph::PassId overlay = graph.AddPass("Overlay", nullptr);
+	graph.SetSideEffect(overlay);
+
+	CHECK(graph.Compile());
+	CHECK(!graph.IsCulled(draw));
+	CHECK(graph.IsCulled(feeder));
+	CHECK(graph.IsCulled(dead));
+	CHECK(!graph.IsCulled(present));
+	CHECK(!graph.IsCulled(overlay));
+
+	const std::vector<RenderGraph::PassId>& order = graph.GetExecutionOrder();
+	CHECK_EQ(order.size(), 3);
+	if (order.size() == 3) {
+		CHECK_EQ(order[0], draw);
+		CHECK_EQ(order[1], present);
+		CHECK_EQ(order[2], overlay);
+	}
+
+	// Textures that are only used by culled passes never get memory
+	CHECK_EQ(graph.GetPhysicalIndex(unused), RenderGraph::INVALID);
+	CHECK_EQ(graph.GetPhysicalIndex(unusedInput), RenderGraph::INVALID);
+	CHECK_EQ(graph.GetPhysicalIndex(scratch), RenderGraph::INVALID);
+	CHECK_EQ(graph.GetPhysicalIndex(backbuffer), RenderGraph::INVALID);
+	CHECK(graph.GetPhysicalIndex(scene) != RenderGraph::INVALID);
+}
+
+TEST_CASE(RenderGraph_RejectsReadBeforeWrite) {
+	{
+		RenderGraph graph;
+		RenderGraph::ResourceId texture = graph.CreateTexture("Texture", ColorDesc);
+		RenderGraph::PassId reader = graph.AddPass("Reader", nullptr);
+		graph.Read(reader, texture);
+		graph.SetSideEffect(reader);
+		RenderGraph::PassId writer = graph.AddPass("Writer", nullptr);
+		graph.Write(writer, texture);
+		CHECK(!graph.Compile());
+	}
+	{
+		// Never written at all
+		RenderGraph graph;
+		RenderGraph::ResourceId texture = graph.CreateTexture("Texture", ColorDesc);
+		RenderGraph::PassId reader = graph.AddPass("Reader", nullptr);
+		graph.Read(reader, texture);
+		graph.SetSideEffect(reader);
+		CHECK(!graph.Compile());
+	}
+	{
+		// Imported textures are written outside of the graph, so they can be read first
+		RenderGraph graph;
+		RenderGraph::ResourceId texture = graph.ImportTexture("Texture", ColorDesc);
+		RenderGraph::PassId reader = graph.AddPass("Reader", nullptr);
+		graph.Read(reader, texture);
+		graph.SetSideEffect(reader);
+		CHECK(graph.Compile());
+	}
+}
+
+TEST_CASE(RenderGraph_ComputesLifetimes) {
+	RenderGraph graph;
+	RenderGraph::ResourceId output = graph.ImportTexture("Output", ColorDesc);
+	RenderGraph::ResourceId a = graph.CreateTexture("A", ColorDesc);
+	RenderGraph::ResourceId b = graph.CreateTexture("B", ColorDesc);
+	RenderGraph::ResourceId culled = graph.CreateTexture("Culled", ColorDesc);
+
+	RenderGraph::PassId writeA = graph.AddPass("WriteA", nullptr);
+	graph.Write(writeA, a);
+	// Culled, so it shouldn't take up a position in the order
+	RenderGraph::PassId writeCulled = graph.AddPass("WriteCulled", nullptr);
+	graph.Write(writeCulled, culled);
+	RenderGraph::PassId aToB = graph.AddPass("AToB", nullptr);
+	graph.Read(aToB, a);
+	graph.Write(aToB, b);
+	RenderGraph::PassId combine = graph.AddPass("Combine", nullptr);
+	graph.Read(combine, a);
+	graph.Read(combine, b);
+	graph.Write(combine, output);
+
+	CHECK(graph.Compile());
+	CHECK(graph.IsCulled(writeCulled));
+	CHECK_EQ(graph.GetFirstUse(a), 0);
+	CHECK_EQ(graph.GetLastUse(a), 2);
+	CHECK_EQ(graph.GetFirstUse(b), 1);
+	CHECK_EQ(graph.GetLastUse(b), 2);
+	CHECK_EQ(graph.GetFirstUse(output), 2);
+	CHECK_EQ(graph.GetLastUse(output), 2);
+	CHECK_EQ(graph.GetFirstUse(culled), RenderGraph::INVALID);
+	CHECK_EQ(graph.GetLastUse(culled), RenderGraph::INVALID);
+}
+
+TEST_CASE(RenderGraph_AliasesDisjointLifetimes) {
+	RenderGraph graph;
+	RenderGraph::ResourceId output = graph.ImportTexture("Output", ColorDesc);
+	RenderGraph::ResourceId a = graph.CreateTexture("A", ColorDesc);
+	RenderGraph::ResourceId b = graph.CreateTexture("B", ColorDesc);
+	RenderGraph::ResourceId c = graph.CreateTexture("C", ColorDesc);
+	RenderGraph::ResourceId small = graph.CreateTexture("Small", RenderGraph::TextureDesc(32, 32, RenderTargetType::ColorRgba8));
+
+	// A chain of A -> B -> C -> Small -> Output, where each texture is only alive for two passes
+	RenderGraph::PassId writeA = graph.AddPass("WriteA", nullptr);
+	graph.Write(writeA, a);
+	RenderGraph::PassId aToB = graph.AddPass("AToB", nullptr);
+	graph.Read(aToB, a);
+	graph.Write(aToB, b);
+	RenderGraph::PassId bToC = graph.AddPass("BToC", nullptr);
+	graph.Read(bToC, b);
+	graph.Write(bToC, c);
+	RenderGraph::PassId cToSmall = graph.AddPass("CToSmall", nullptr);
+	graph.Read(cToSmall, c);
+	graph.Write(cToSmall, small);
+	RenderGraph::PassId present = graph.AddPass("Present", nullptr);
+	graph.Read(present, small);
+	graph.Write(present, output);
+
+	CHECK(graph.Compile());
+
+	// A and B overlap in AToB, and B and C overlap in BToC, but A is done before C is written
+	CHECK(graph.GetPhysicalIndex(a) != graph.GetPhysicalIndex(b));
+	CHECK(graph.GetPhysicalIndex(b) != graph.GetPhysicalIndex(c));
+	CHECK_EQ(graph.GetPhysicalIndex(a), graph.GetPhysicalIndex(c));
+	// Small is free to reuse B's memory by lifetime, but doesn't match it's size
+	CHECK(graph.GetPhysicalIndex(small) != graph.GetPhysicalIndex(a));
+	CHECK(graph.GetPhysicalIndex(small) != graph.GetPhysicalIndex(b));
+	CHECK_EQ(graph.GetPhysicalIndex(output), RenderGraph::INVALID);
+
+	const std::vector<RenderGraph::TextureDesc>& physical = graph.GetPhysicalTextures();
+	CHECK_EQ(physical.size(), 3);
+	for (RenderGraph::ResourceId resource : { a, b, c, small }) {
+		uint32_t physicalIx = graph.GetPhysicalIndex(resource);
+		CHECK(physicalIx < physical.size());
+		if (physicalIx < physical.size()) {
+			CHECK(physical[physicalIx] == graph.GetDesc(resource));
+		}
+	}
+}
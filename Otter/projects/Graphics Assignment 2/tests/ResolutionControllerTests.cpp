@@ -0,0 +1,85 @@
+#include "Testing.h"
+#include "Graphics/ResolutionController.h"
+
+#include <GLM/glm.hpp>
+
+namespace {
+	// A stand in for the GPU, where the time taken is proportional to the number of pixels shaded, so
+	// it goes with the square of the scale
+	float GpuTime(float fullResolutionTime, float scale) {
+		return fullResolutionTime * scale * scale;
+	}
+
+	// Runs the controller against the model for a number of frames, and returns the final scale
+	float Run(ResolutionController& controller, float fullResolutionTime, int frames) {
+		for (int ix = 0; ix < frames; ix++) {
+			controller.Update(GpuTime(fullResolutionTime, controller.GetScale()));
+		}
+		return controller.GetScale();
+	}
+}
+
+TEST_CASE(ResolutionController_ConvergesToBudget) {
+	ResolutionController controller;
+	controller.SetBudget(12.0f);
+
+	// At full resolution this takes 20ms, so the scale that hits the budget is sqrt(12 / 20)
+	float scale = Run(controller, 20.0f, 600);
+	CHECK_NEAR(scale, glm::sqrt(12.0f / 20.0f), 0.01f);
+	CHECK_NEAR(GpuTime(20.0f, scale), 12.0f, 0.25f);
+
+	// And it should stay there, rather than oscillating around it
+	for (int ix = 0; ix < 60; ix++) {
+		controller.Update(GpuTime(20.0f, controller.GetScale()));
+		CHECK_NEAR(controller.GetScale(), scale, 0.005f);
+	}
+
+	// When the scene gets cheaper it should follow it back up
+	scale = Run(controller, 15.0f, 600);
+	CHECK_NEAR(scale, glm::sqrt(12.0f / 15.0f), 0.01f);
+}
+
+TEST_CASE(ResolutionController_ClampsToRange) {
+	ResolutionController controller;
+	controller.SetBudget(12.0f);
+	CHECK_EQ(controller.GetMinScale(), 0.5f);
+	CHECK_EQ(controller.GetMaxScale(), 1.0f);
+
+	// Even at the minimum scale this is 25ms, so the scale pins to the bottom of the range
+	for (int ix = 0; ix < 300; ix++) {
+		float scale = controller.Update(GpuTime(100.0f, controller.GetScale()));
+		CHECK(scale >= 0.5f && scale <= 1.0f);
+	}
+	CHECK_EQ(controller.GetScale(), 0.5f);
+
+	// A cheap scene never goes above full resolution
+	controller.Reset();
+	for (int ix = 0; ix < 300; ix++) {
+		float scale = controller.Update(GpuTime(2.0f, controller.GetScale()));
+		CHECK(scale >= 0.5f && scale <= 1.0f);
+	}
+	CHECK_EQ(controller.GetScale(), 1.0f);
+
+	// Measurements that didn't come back leave the scale alone
+	CHECK_EQ(controller.Update(0.0f), 1.0f);
+}
+
+TEST_CASE(ResolutionController_RecoversAfterLongOverBudget) {
+	ResolutionController controller;
+	controller.SetBudget(12.0f);
+
+	// A long stretch where even the minimum scale can't hit the budget, without anti-windup the
+	// integral would keep growing for all of it
+	Run(controller, 100.0f, 5000);
+	CHECK_EQ(controller.GetScale(), 0.5f);
+
+	// Once the scene gets cheap enough to run at full resolution, the scale should get back there in
+	// about the same time it took to drop to the minimum, not in another 5000 frames
+	int frames = 0;
+	while (controller.GetScale() < 1.0f && frames < 5000) {
+		controller.Update(GpuTime(6.0f, controller.GetScale()));
+		frames++;
+	}
+	CHECK_EQ(controller.GetScale(), 1.0f);
+	CHECK_LE(frames, 60);
+}
@@ -0,0 +1,136 @@
+#include "Testing.h"
+#include "Graphics/ScenePrepare.h"
+
+#include <GLM/gtc/matrix_transform.hpp>
+
+namespace {
+	// A unit quad in the XY plane, centered on the origin
+	const glm::vec3 QUAD_VERTICES[4] = {
+		glm::vec3(-0.5f, -0.5f, 0.0f),
+		glm::vec3( 0.5f, -0.5f, 0.0f),
+		glm::vec3( 0.5f,  0.5f, 0.0f),
+		glm::vec3(-0.5f,  0.5f, 0.0f)
+	};
+	const uint32_t QUAD_INDICES[6] = { 0, 1, 2, 0, 2, 3 };
+
+	// A camera at the origin looking down -Z
+	ScenePrepare::Settings MakeSettings() {
+		ScenePrepare::Settings settings;
+		settings.View = glm::mat4(1.0f);
+		settings.Projection = glm::perspective(glm::radians(60.0f), 2.0f, 0.1f, 100.0f);
+		settings.ScreenSize = glm::ivec2(256, 128);
+		settings.ViewFrustum = Frustum::FromViewProjection(settings.Projection);
+		settings.Occlusion = nullptr;
+		settings.HiZ = nullptr;
+		settings.HiZMargin = 0.0f;
+		settings.LodPixelError = 1.0f;
+		return settings;
+	}
+
+	ScenePrepare::Draw MakeDraw(const glm::vec3& center, float halfSize, bool isOccluder = false, bool hasLods = false) {
+		ScenePrepare::Draw draw;
+		draw.Box = BoundingBox{ center - glm::vec3(halfSize), center + glm::vec3(halfSize) };
+		draw.Sphere = BoundingSphere{ center, halfSize * glm::sqrt(3.0f) };
+		draw.IsOccluder = isOccluder;
+		draw.HasLods = hasLods;
+		return draw;
+	}
+
+	void PrepareAll(const std::vector<ScenePrepare::Draw>& draws, const ScenePrepare::Settings& settings, ScenePrepare::Buffer& buffer) {
+		std::vector<uint32_t> visible(draws.size());
+		for (uint32_t ix = 0; ix < visible.size(); ix++) {
+			visible[ix] = ix;
+		}
+		ScenePrepare::PrepareRange(draws, visible.data(), 0, visible.size(), settings, buffer);
+	}
+}
+
+TEST_CASE(ScenePrepare_CullsAndSortsByDepth) {
+	ScenePrepare::Settings settings = MakeSettings();
+	std::vector<ScenePrepare::Draw> draws = {
+		MakeDraw(glm::vec3(0.0f, 0.0f, -20.0f), 1.0f),
+		MakeDraw(glm::vec3(0.0f, 0.0f, -5.0f), 1.0f),
+		// Behind the camera
+		MakeDraw(glm::vec3(0.0f, 0.0f, 10.0f), 1.0f),
+		// Off to the side
+		MakeDraw(glm::vec3(100.0f, 0.0f, -5.0f), 1.0f)
+	};
+
+	ScenePrepare::Buffer buffer;
+	PrepareAll(draws, settings, buffer);
+	CHECK_EQ(buffer.Culled, 2u);
+	CHECK_EQ(buffer.OcclusionCulled, 0u);
+	CHECK_EQ(buffer.HiZCulled, 0u);
+	CHECK_EQ(buffer.Draws.size(), 2u);
+	// Survivors stay in list order, and the nearer one gets the smaller depth
+	CHECK_EQ(buffer.Draws[0].DrawIndex, 0u);
+	CHECK_EQ(buffer.Draws[1].DrawIndex, 1u);
+	CHECK(buffer.Draws[1].Depth < buffer.Draws[0].Depth);
+	// Without a selector the levels of detail are left alone
+	CHECK_EQ(buffer.Draws[0].Lod, -1);
+}
+
+TEST_CASE(ScenePrepare_OcclusionSkipsOccluders) {
+	ScenePrepare::Settings settings = MakeSettings();
+
+	// A big wall in front of everything, with a box hidden behind it
+	OcclusionBuffer occlusion(256, 128);
+	WorkerPool pool(1);
+	occlusion.Begin(settings.Projection);
+	glm::mat4 wall = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -5.0f)), glm::vec3(50.0f));
+	occlusion.AddOccluder(wall, QUAD_VERTICES, QUAD_INDICES, 6);
+	occlusion.Rasterize(pool);
+	settings.Occlusion = &occlusion;
+
+	std::vector<ScenePrepare::Draw> draws = {
+		MakeDraw(glm::vec3(0.0f, 0.0f, -20.0f), 1.0f),
+		// An occluder that is also behind the wall is still kept
+		MakeDraw(glm::vec3(0.0f, 0.0f, -20.0f), 1.0f, true),
+		MakeDraw(glm::vec3(0.0f, 0.0f, -3.0f), 0.5f)
+	};
+
+	ScenePrepare::Buffer buffer;
+	PrepareAll(draws, settings, buffer);
+	CHECK_EQ(buffer.OcclusionCulled, 1u);
+	CHECK_EQ(buffer.Draws.size(), 2u);
+	CHECK_EQ(buffer.Draws[0].DrawIndex, 1u);
+	CHECK_EQ(buffer.Draws[1].DrawIndex, 2u);
+}
+
+TEST_CASE(ScenePrepare_SelectsLods) {
+	ScenePrepare::Settings settings = MakeSettings();
+	std::vector<float> diameters(4, -1.0f);
+	settings.SelectLod = [&](uint32_t drawIndex, float screenDiameter) {
+		diameters[drawIndex] = screenDiameter;
+		return 2;
+	};
+
+	std::vector<ScenePrepare::Draw> draws = {
+		MakeDraw(glm::vec3(0.0f, 0.0f, -10.0f), 1.0f, false, true),
+		// The camera is inside of this one, so it keeps full detail
+		MakeDraw(glm::vec3(0.0f, 0.0f, -0.5f), 1.0f, false, true),
+		// Only one level, so there is nothing to pick
+		MakeDraw(glm::vec3(0.0f, 0.0f, -10.0f), 1.0f),
+		MakeDraw(glm::vec3(0.0f, 0.0f, -20.0f), 1.0f, false, true)
+	};
+
+	ScenePrepare::Buffer buffer;
+	PrepareAll(draws, settings, buffer);
+	CHECK_EQ(buffer.Draws.size(), 4u);
+	CHECK_EQ(buffer.Draws[0].Lod, 2);
+	CHECK_EQ(buffer.Draws[1].Lod, 0);
+	CHECK_EQ(buffer.Draws[2].Lod, -1);
+	CHECK_EQ(buffer.Draws[3].Lod, 2);
+	// The diameter on screen halves as the distance doubles
+	float expected = draws[0].Sphere.Radius * settings.Projection[1][1] * settings.ScreenSize.y / 10.0f;
+	CHECK_NEAR(diameters[0], expected, 1e-3f);
+	CHECK_NEAR(diameters[3], expected * 0.5f, 1e-3f);
+	CHECK_EQ(diameters[1], -1.0f);
+	CHECK_EQ(diameters[2], -1.0f);
+
+	// With no pixel error allowed everything uses the most detailed level
+	settings.LodPixelError = 0.0f;
+	PrepareAll(draws, settings, buffer);
+	CHECK_EQ(buffer.Draws[0].Lod, 0);
+	CHECK_EQ(buffer.Draws[3].Lod, 0);
+}
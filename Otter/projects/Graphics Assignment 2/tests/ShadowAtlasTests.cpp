@@ -0,0 +1,74 @@
+#include "Testing.h"
+#include "Graphics/ShadowAtlasLayout.h"
+
+namespace {
+	bool Overlaps(const glm::ivec4& a, const glm::ivec4& b) {
+		return a.x < b.x + b.z && b.x < a.x + a.z && a.y < b.y + b.w && b.y < a.y + a.w;
+	}
+
+	// Checks that the tiles are all inside of the layout, and that none of them share any texels
+	void CheckTilesDisjoint(const std::vector<glm::ivec4>& tiles, uint32_t size) {
+		for (size_t ix = 0; ix < tiles.size(); ix++) {
+			CHECK(tiles[ix].x >= 0 && tiles[ix].y >= 0);
+			CHECK_LE(static_cast<uint32_t>(tiles[ix].x + tiles[ix].z), size);
+			CHECK_LE(static_cast<uint32_t>(tiles[ix].y + tiles[ix].w), size);
+			for (size_t other = ix + 1; other < tiles.size(); other++) {
+				CHECK(!Overlaps(tiles[ix], tiles[other]));
+			}
+		}
+	}
+}
+
+TEST_CASE(ShadowAtlas_TileSizeRounding) {
+	ShadowAtlasLayout layout(4096);
+
+	CHECK_EQ(layout.GetTileSize(1), ShadowAtlasLayout::MIN_TILE_SIZE);
+	CHECK_EQ(layout.GetTileSize(1000), 1024u);
+	CHECK_EQ(layout.GetTileSize(1024), 1024u);
+	CHECK_EQ(layout.GetTileSize(10000), 4096u);
+
+	// Caps round down, so a 1000 or 1500 texel light never gets a 1024 or 2048 texel tile
+	CHECK_EQ(layout.GetLargestTileSize(1000), 512u);
+	CHECK_EQ(layout.GetLargestTileSize(1024), 1024u);
+	CHECK_EQ(layout.GetLargestTileSize(1500), 1024u);
+	CHECK_EQ(layout.GetLargestTileSize(10000), 4096u);
+	CHECK_EQ(layout.GetLargestTileSize(10), ShadowAtlasLayout::MIN_TILE_SIZE);
+}
+
+TEST_CASE(ShadowAtlas_PacksLargestFirst) {
+	ShadowAtlasLayout layout(1024);
+	std::vector<glm::ivec4> tiles;
+	glm::ivec4 rect;
+
+	// One 512 takes a quadrant, and three 256s take most of the next. The four 128s left in that
+	// quadrant and the 32 in the last two quadrants fill it exactly
+	std::vector<uint32_t> sizes = { 512, 256, 256, 256 };
+	sizes.insert(sizes.end(), 36, 128);
+	for (uint32_t size : sizes) {
+		CHECK(layout.Allocate(size, rect));
+		CHECK_EQ(static_cast<uint32_t>(rect.z), size);
+		CHECK_EQ(static_cast<uint32_t>(rect.w), size);
+		tiles.push_back(rect);
+	}
+	CheckTilesDisjoint(tiles, layout.GetSize());
+
+	// The layout is full, nothing else fits until it's cleared
+	CHECK(!layout.Allocate(ShadowAtlasLayout::MIN_TILE_SIZE, rect));
+	layout.Clear();
+	CHECK(layout.Allocate(1024, rect));
+	CHECK(rect == glm::ivec4(0, 0, 1024, 1024));
+}
+
+TEST_CASE(ShadowAtlas_RejectsTilesThatDontFit) {
+	ShadowAtlasLayout layout(1024);
+	glm::ivec4 rect;
+
+	CHECK(layout.Allocate(512, rect));
+	CHECK(layout.Allocate(512, rect));
+	CHECK(layout.Allocate(512, rect));
+	// Only one 512 quadrant is left, so a full size tile can't fit, but smaller ones still can
+	CHECK(!layout.Allocate(1024, rect));
+	CHECK(layout.Allocate(256, rect));
+	CHECK(layout.Allocate(256, rect));
+	CHECK(!layout.Allocate(512, rect));
+}
@@ -0,0 +1,83 @@
+#include "Testing.h"
+#include "Graphics/ShadowCascades.h"
+
+#include <GLM/gtc/matrix_transform.hpp>
+
+namespace {
+	// The bounds of an orthographic projection, recovered from it's matrix
+	struct OrthoBounds {
+		glm::vec3 Min;
+		glm::vec3 Max;
+	};
+
+	OrthoBounds GetBounds(const glm::mat4& projection) {
+		OrthoBounds result;
+		for (int axis = 0; axis < 3; axis++) {
+			float scale = projection[axis][axis];
+			float offset = projection[3][axis];
+			result.Min[axis] = (-1.0f - offset) / scale;
+			result.Max[axis] = (1.0f - offset) / scale;
+		}
+		return result;
+	}
+
+	// Gets how far a value is from the nearest multiple of step, in steps
+	float DistanceToGrid(float value, float step) {
+		float steps = value / step;
+		return glm::abs(steps - glm::round(steps));
+	}
+}
+
+TEST_CASE(ShadowCascades_SplitsCoverRange) {
+	float splits[ShadowCascades::MAX_CASCADES + 1];
+	for (float lambda : { 0.0f, 0.5f, 1.0f }) {
+		ShadowCascades::CalculateSplits(0.1f, 100.0f, ShadowCascades::MAX_CASCADES, lambda, splits);
+		CHECK_EQ(splits[0], 0.1f);
+		CHECK_EQ(splits[ShadowCascades::MAX_CASCADES], 100.0f);
+		for (int ix = 0; ix < ShadowCascades::MAX_CASCADES; ix++) {
+			CHECK(splits[ix] < splits[ix + 1]);
+		}
+	}
+}
+
+TEST_CASE(ShadowCascades_SubTexelMovesStayOnGrid) {
+	const uint32_t resolution = 1024;
+	const float casterDistance = 20.0f;
+	glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+	glm::mat3 lightRotation = glm::mat3(glm::rotate(glm::rotate(glm::mat4(1.0f), glm::radians(-50.0f), glm::vec3(1.0f, 0.0f, 0.0f)), glm::radians(30.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+	glm::vec3 forward = glm::normalize(glm::vec3(1.0f, -0.3f, -1.0f));
+
+	float splits[ShadowCascades::MAX_CASCADES + 1];
+	ShadowCascades::CalculateSplits(0.1f, 100.0f, ShadowCascades::MAX_CASCADES, 0.75f, splits);
+
+	for (int cascade = 0; cascade < ShadowCascades::MAX_CASCADES; cascade++) {
+		glm::vec3 start = glm::vec3(2.0f, 3.0f, -1.0f);
+		ShadowCascades::Cascade first = ShadowCascades::FitCascade(
+			glm::lookAt(start, start + forward, glm::vec3(0.0f, 1.0f, 0.0f)), projection,
+			splits[cascade], splits[cascade + 1], lightRotation, resolution, casterDistance);
+		float texelSize = (first.Radius * 2.0f) / resolution;
+		OrthoBounds firstBounds = GetBounds(first.Projection);
+
+		// Walk the camera along in steps of a fraction of a texel, so that some steps stay within a texel and
+		// some of them cross into the next one
+		for (int step = 1; step <= 16; step++) {
+			glm::vec3 position = start + glm::vec3(0.37f, 0.21f, -0.13f) * (texelSize * step / 4.0f);
+			ShadowCascades::Cascade moved = ShadowCascades::FitCascade(
+				glm::lookAt(position, position + forward, glm::vec3(0.0f, 1.0f, 0.0f)), projection,
+				splits[cascade], splits[cascade + 1], lightRotation, resolution, casterDistance);
+			OrthoBounds bounds = GetBounds(moved.Projection);
+
+			// Only translating the camera never changes the size of the cascade
+			CHECK_EQ(moved.Radius, first.Radius);
+			for (int axis = 0; axis < 3; axis++) {
+				CHECK_NEAR(bounds.Max[axis] - bounds.Min[axis], firstBounds.Max[axis] - firstBounds.Min[axis], texelSize * 1e-2f);
+			}
+
+			// The origin only ever moves in whole texels
+			for (int axis = 0; axis < 3; axis++) {
+				CHECK_LE(DistanceToGrid(bounds.Min[axis] - firstBounds.Min[axis], texelSize), 1e-2f);
+				CHECK_LE(glm::abs(bounds.Min[axis] - firstBounds.Min[axis]), texelSize * (step / 4.0f + 1.01f));
+			}
+		}
+	}
+}
@@ -0,0 +1,234 @@
+#include "Testing.h"
+#include "Utils/MeshFactory.h"
+
+#include <chrono>
+#include <cstdio>
+
+namespace {
+	typedef VertexPosNormTexColTangents Vertex;
+
+	// A bumpy grid, big enough that CalculateTBN splits it across threads. The right half of the grid has
+	// it's UVs mirrored, so that both UV windings get used, and the column down the middle is shared
+	// between the two halves
+	MeshBuilder<Vertex> MakeGrid(int cells) {
+		MeshBuilder<Vertex> mesh;
+		for (int z = 0; z <= cells; z++) {
+			for (int x = 0; x <= cells; x++) {
+				glm::vec2 cell = glm::vec2(x, z) / static_cast<float>(cells);
+				float height = glm::sin(cell.x * 17.0f) * glm::cos(cell.y * 13.0f) * 0.05f;
+				glm::vec3 normal = glm::normalize(glm::vec3(-glm::cos(cell.x * 17.0f) * 0.3f, 1.0f, glm::sin(cell.y * 13.0f) * 0.3f));
+				glm::vec2 uv = glm::vec2(cell.x <= 0.5f ? cell.x : 1.0f - cell.x, cell.y);
+				mesh.AddVertex(Vertex(glm::vec3(cell.x, height, cell.y), normal, uv, glm::vec4(1.0f)));
+			}
+		}
+		for (int z = 0; z < cells; z++) {
+			for (int x = 0; x < cells; x++) {
+				uint32_t i0 = z * (cells + 1) + x;
+				uint32_t i1 = i0 + 1;
+				uint32_t i2 = i0 + cells + 1;
+				uint32_t i3 = i2 + 1;
+				for (uint32_t index : { i0, i2, i1, i1, i2, i3 }) {
+					mesh.AddIndex(index);
+				}
+			}
+		}
+		return mesh;
+	}
+
+	// Checks that splitting the mesh across a pool gives the same tangents as doing it on one thread. The
+	// per thread sums are added in a different order, so they only have to match up to rounding
+	void CheckThreadedMatchesSerial(TangentMode mode) {
+		// 128 * 128 * 2 triangles is enough for two threads to each get more than the minimum
+		MeshBuilder<Vertex> serial = MakeGrid(128);
+		MeshBuilder<Vertex> threaded = MakeGrid(128);
+
+		WorkerPool singleThread(1);
+		WorkerPool fourThreads(4);
+		MeshFactory::CalculateTBN(serial, mode, &singleThread);
+		MeshFactory::CalculateTBN(threaded, mode, &fourThreads);
+
+		// Any vertices that were split have to be split the same way
+		CHECK_EQ(serial.GetVertexCount(), threaded.GetVertexCount());
+		CHECK_EQ(serial.GetIndexCount(), threaded.GetIndexCount());
+		size_t mismatchedIndices = 0;
+		for (size_t ix = 0; ix < serial.GetIndexCount(); ix++) {
+			mismatchedIndices += serial.GetIndexDataPtr()[ix] != threaded.GetIndexDataPtr()[ix] ? 1 : 0;
+		}
+		CHECK_EQ(mismatchedIndices, 0u);
+
+		const Vertex* expected = reinterpret_cast<const Vertex*>(serial.GetVertexDataPtr());
+		const Vertex* actual = reinterpret_cast<const Vertex*>(threaded.GetVertexDataPtr());
+		size_t mismatched = 0;
+		for (size_t ix = 0; ix < serial.GetVertexCount(); ix++) {
+			float tangentError = glm::length(expected[ix].Tangent - actual[ix].Tangent);
+			float bitangentError = glm::length(expected[ix].BiTangent - actual[ix].BiTangent);
+			if (tangentError > 1e-4f || bitangentError > 1e-4f) {
+				mismatched++;
+			}
+		}
+		CHECK_EQ(mismatched, 0u);
+
+		// Make sure that there was something to compare against
+		for (size_t ix = 0; ix < serial.GetVertexCount(); ix++) {
+			CHECK_NEAR(glm::length(expected[ix].Tangent), 1.0f, 1e-4f);
+		}
+	}
+
+	// The per vertex path that CalculateTBN used before it was split across threads, kept here so that
+	// the benchmark has something to compare against. It's copied as it was, including reading the first
+	// corner's bitangent for all three corners
+	void LegacyCalculateTBN(std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices) {
+		VertexParamMap vMap = VertexParamMap(Vertex::V_DECL);
+		for (size_t i = 0; i < vertices.size(); i++) {
+			vMap.SetTangent(vertices[i], glm::vec3(0.0f));
+			vMap.SetBiTangent(vertices[i], glm::vec3(0.0f));
+		}
+
+		for (size_t i = 0; i < indices.size(); i += 3) {
+			Vertex& v1 = vertices[indices[i + 0u]];
+			Vertex& v2 = vertices[indices[i + 1u]];
+			Vertex& v3 = vertices[indices[i + 2u]];
+
+			glm::vec3 pos[3] = { vMap.GetPosition(v1), vMap.GetPosition(v2), vMap.GetPosition(v3) };
+			glm::vec2 uvs[3] = { vMap.GetTexture(v1), vMap.GetTexture(v2), vMap.GetTexture(v3) };
+
+			glm::vec3 deltaP1 = pos[1] - pos[0];
+			glm::vec3 deltaP2 = pos[2] - pos[0];
+			glm::vec2 deltaT1 = uvs[1] - uvs[0];
+			glm::vec2 deltaT2 = uvs[2] - uvs[0];
+
+			float r = 1.0f / (deltaT1.x * deltaT2.y - deltaT1.y * deltaT2.x);
+			glm::vec3 tangent = glm::normalize((deltaP1 * deltaT2.y - deltaP2 * deltaT1.y) * r);
+			glm::vec3 bitangent = glm::normalize((deltaP2 * deltaT1.x - deltaP1 * deltaT2.x) * r);
+
+			vMap.SetTangent(v1, glm::normalize((vMap.GetTangent(v1) + tangent) / 2.0f));
+			vMap.SetTangent(v2, glm::normalize((vMap.GetTangent(v2) + tangent) / 2.0f));
+			vMap.SetTangent(v3, glm::normalize((vMap.GetTangent(v3) + tangent) / 2.0f));
+
+			vMap.SetBiTangent(v1, glm::normalize((vMap.GetBiTangent(v1) + bitangent) / 2.0f));
+			vMap.SetBiTangent(v2, glm::normalize((vMap.GetBiTangent(v1) + bitangent) / 2.0f));
+			vMap.SetBiTangent(v3, glm::normalize((vMap.GetBiTangent(v1) + bitangent) / 2.0f));
+		}
+	}
+
+	// Runs the function a few times on a fresh copy of the mesh, and returns the fastest run in milliseconds
+	template <typename Func>
+	double BestTime(const MeshBuilder<Vertex>& source, int runs, const Func& func) {
+		double best = 0.0;
+		for (int run = 0; run < runs; run++) {
+			MeshBuilder<Vertex> mesh = source;
+			auto start = std::chrono::high_resolution_clock::now();
+			func(mesh);
+			double time = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+			best = run == 0 ? time : glm::min(best, time);
+		}
+		return best;
+	}
+}
+
+TEST_CASE(Tangents_ThreadedMatchesSerialFast) {
+	CheckThreadedMatchesSerial(TangentMode::Fast);
+}
+
+TEST_CASE(Tangents_ThreadedMatchesSerialMikkTSpace) {
+	CheckThreadedMatchesSerial(TangentMode::MikkTSpace);
+}
+
+TEST_CASE(Tangents_MikkTSpaceSplitsMirroredSeam) {
+	MeshBuilder<Vertex> mesh = MakeGrid(16);
+	MeshFactory::CalculateTBN(mesh, TangentMode::MikkTSpace);
+
+	// The 17 vertices down the middle are used by both UV windings, so each of them gets a copy
+	CHECK_EQ(mesh.GetVertexCount(), 17u * 17u + 17u);
+
+	const Vertex* vertices = reinterpret_cast<const Vertex*>(mesh.GetVertexDataPtr());
+	for (size_t ix = 0; ix < mesh.GetVertexCount(); ix++) {
+		CHECK_NEAR(glm::dot(vertices[ix].Tangent, vertices[ix].Normal), 0.0f, 1e-4f);
+		CHECK_NEAR(glm::length(vertices[ix].Tangent), 1.0f, 1e-4f);
+		CHECK_NEAR(glm::length(vertices[ix].BiTangent), 1.0f, 1e-4f);
+	}
+	// The left half has regular UVs and the right half is mirrored, so the tangent follows U in both
+	// halves, and the bitangent's handedness flips between them
+	CHECK(vertices[1].Tangent.x > 0.0f);
+	CHECK(vertices[15].Tangent.x < 0.0f);
+	float leftSign = glm::dot(vertices[1].BiTangent, glm::cross(vertices[1].Normal, vertices[1].Tangent));
+	float rightSign = glm::dot(vertices[15].BiTangent, glm::cross(vertices[15].Normal, vertices[15].Tangent));
+	CHECK(leftSign * rightSign < 0.0f);
+
+	// After splitting, the corners of each triangle all agree on the handedness
+	size_t mixedTriangles = 0;
+	const uint32_t* indices = mesh.GetIndexDataPtr();
+	for (size_t ix = 0; ix < mesh.GetIndexCount(); ix += 3) {
+		float signs[3];
+		for (int corner = 0; corner < 3; corner++) {
+			const Vertex& vertex = vertices[indices[ix + corner]];
+			signs[corner] = glm::dot(vertex.BiTangent, glm::cross(vertex.Normal, vertex.Tangent));
+		}
+		mixedTriangles += (signs[0] * signs[1] < 0.0f || signs[0] * signs[2] < 0.0f) ? 1 : 0;
+	}
+	CHECK_EQ(mixedTriangles, 0u);
+}
+
+TEST_CASE(Tangents_MikkTSpaceWeldsByValue) {
+	// Two triangles that meet along an edge, without sharing any vertex indices. The UVs are skewed
+	// across the second triangle, so the two triangles have different tangents
+	const glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f);
+	MeshBuilder<Vertex> mesh;
+	mesh.AddVertex(Vertex(glm::vec3(0.0f, 0.0f, 0.0f), up, glm::vec2(0.0f, 0.0f), glm::vec4(1.0f)));
+	mesh.AddVertex(Vertex(glm::vec3(0.0f, 0.0f, 1.0f), up, glm::vec2(0.0f, 1.0f), glm::vec4(1.0f)));
+	mesh.AddVertex(Vertex(glm::vec3(1.0f, 0.0f, 0.0f), up, glm::vec2(1.0f, 0.0f), glm::vec4(1.0f)));
+	mesh.AddVertex(Vertex(glm::vec3(1.0f, 0.0f, 0.0f), up, glm::vec2(1.0f, 0.0f), glm::vec4(1.0f)));
+	mesh.AddVertex(Vertex(glm::vec3(0.0f, 0.0f, 1.0f), up, glm::vec2(0.0f, 1.0f), glm::vec4(1.0f)));
+	mesh.AddVertex(Vertex(glm::vec3(1.0f, 0.0f, 1.0f), up, glm::vec2(1.0f, 1.5f), glm::vec4(1.0f)));
+	for (uint32_t index = 0; index < 6; index++) {
+		mesh.AddIndex(index);
+	}
+	MeshFactory::CalculateTBN(mesh, TangentMode::MikkTSpace);
+	CHECK_EQ(mesh.GetVertexCount(), 6u);
+
+	const Vertex* vertices = reinterpret_cast<const Vertex*>(mesh.GetVertexDataPtr());
+	// The corner only the first triangle uses gets it's tangent unchanged
+	CHECK_NEAR(vertices[0].Tangent.x, 1.0f, 1e-5f);
+	// The copies along the shared edge are welded, so they get the same blend of both triangles
+	CHECK(vertices[1].Tangent == vertices[4].Tangent);
+	CHECK(vertices[2].Tangent == vertices[3].Tangent);
+	CHECK(vertices[1].Tangent.z < -1e-3f);
+	CHECK(vertices[1].Tangent.z > vertices[5].Tangent.z);
+}
+
+// Times the old per vertex path against both modes, on one thread and on the shared pool. Run it with
+// "Benchmark_CalculateTBN" as a filter, benchmarks are skipped otherwise
+TEST_CASE(Benchmark_CalculateTBN) {
+	const int runs = 3;
+	MeshBuilder<Vertex> source = MakeGrid(512);
+	std::vector<uint32_t> indices(source.GetIndexDataPtr(), source.GetIndexDataPtr() + source.GetIndexCount());
+
+	WorkerPool singleThread(1);
+	WorkerPool::Sptr shared = WorkerPool::GetShared();
+
+	double legacy = BestTime(source, runs, [&](MeshBuilder<Vertex>& mesh) {
+		std::vector<Vertex> vertices(mesh.GetVertexDataPtr(), mesh.GetVertexDataPtr() + mesh.GetVertexCount());
+		LegacyCalculateTBN(vertices, indices);
+	});
+	double fastSerial = BestTime(source, runs, [&](MeshBuilder<Vertex>& mesh) {
+		MeshFactory::CalculateTBN(mesh, TangentMode::Fast, &singleThread);
+	});
+	double fastPool = BestTime(source, runs, [&](MeshBuilder<Vertex>& mesh) {
+		MeshFactory::CalculateTBN(mesh, TangentMode::Fast, shared.get());
+	});
+	double mikkSerial = BestTime(source, runs, [&](MeshBuilder<Vertex>& mesh) {
+		MeshFactory::CalculateTBN(mesh, TangentMode::MikkTSpace, &singleThread);
+	});
+	double mikkPool = BestTime(source, runs, [&](MeshBuilder<Vertex>& mesh) {
+		MeshFactory::CalculateTBN(mesh, TangentMode::MikkTSpace, shared.get());
+	});
+
+	printf("  CalculateTBN on %zu vertices and %zu triangles, best of %d:\n", source.GetVertexCount(), source.GetTriangleCount(), runs);
+	printf("    %-32s %8.2f ms\n", "old per vertex path", legacy);
+	printf("    %-32s %8.2f ms\n", "Fast, 1 thread", fastSerial);
+	printf("    %-32s %8.2f ms\n", "Fast, shared pool", fastPool);
+	printf("    %-32s %8.2f ms\n", "MikkTSpace, 1 thread", mikkSerial);
+	printf("    %-32s %8.2f ms\n", "MikkTSpace, shared pool", mikkPool);
+	printf("    (the shared pool has %zu threads)\n", shared->GetThreadCount());
+	CHECK(legacy > 0.0 && fastSerial > 0.0 && mikkSerial > 0.0);
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <sstream>
+#include <cmath>
+
+/// <summary>
+/// A minimal test harness for the engine's headless code. Tests are registered with TEST_CASE, and
+/// run by the test project's main function. Checks log a failure and keep going, so that one broken
+/// test reports everything that is wrong with it
+/// </summary>
+namespace Testing {
+	typedef void(*TestFunc)();
+
+	struct TestCase {
+		const char* Name;
+		TestFunc    Func;
+	};
+
+	/// <summary>
+	/// Gets all of the tests that have been registered
+	/// </summary>
+	std::vector<TestCase>& GetTests();
+	/// <summary>
+	/// Records a failed check against the test that is currently running
+	/// </summary>
+	void ReportFailure(const char* file, int line, const std::string& message);
+
+	struct Registrar {
+		Registrar(const char* name, TestFunc func) {
+			GetTests().push_back({ name, func });
+		}
+	};
+
+	template <typename A, typename B>
+	std::string FormatComparison(const char* expression, const A& a, const B& b) {
+		std::stringstream stream;
+		stream << expression << " (" << a << " vs " << b << ")";
+		return stream.str();
+	}
+}
+
+#define TEST_CASE(name) \
+	static void name(); \
+	static ::Testing::Registrar name##_Registrar(#name, &name); \
+	static void name()
+
+#define CHECK(x) \
+	do { if (!(x)) { ::Testing::ReportFailure(__FILE__, __LINE__, #x); } } while (0)
+
+#define CHECK_EQ(a, b) \
+	do { if (!((a) == (b))) { ::Testing::ReportFailure(__FILE__, __LINE__, ::Testing::FormatComparison(#a " == " #b, (a), (b))); } } while (0)
+
+#define CHECK_LE(a, b) \
+	do { if (!((a) <= (b))) { ::Testing::ReportFailure(__FILE__, __LINE__, ::Testing::FormatComparison(#a " <= " #b, (a), (b))); } } while (0)
+
+#define CHECK_NEAR(a, b, epsilon) \
+	do { if (!(std::abs((a) - (b)) <= (epsilon))) { ::Testing::ReportFailure(__FILE__, __LINE__, ::Testing::FormatComparison(#a " ~= " #b, (a), (b))); } } while (0)
@@ -0,0 +1,134 @@
+#include "Testing.h"
+#include "Utils/WorkerPool.h"
+#include "Utils/Frustum.h"
+#include "Graphics/ScenePrepare.h"
+
+#include <atomic>
+#include <random>
+#include <GLM/gtc/matrix_transform.hpp>
+
+namespace {
+	// Runs a job of the given size, and checks that every index was run exactly once
+	void CheckRunsEachIndexOnce(WorkerPool& pool, size_t taskCount) {
+		std::atomic<uint32_t> counts[8];
+		for (std::atomic<uint32_t>& count : counts) {
+			count = 0;
+		}
+		pool.Run(taskCount, [&](size_t index) {
+			counts[index]++;
+		});
+		for (size_t ix = 0; ix < 8; ix++) {
+			CHECK_EQ(counts[ix].load(), ix < taskCount ? 1u : 0u);
+		}
+	}
+
+	// Prepares the draws the same way the render layer does, and reads the buffers back in thread order
+	std::vector<ScenePrepare::PreparedDraw> PrepareVisible(WorkerPool& pool, const ScenePrepare::Settings& settings, const std::vector<ScenePrepare::Draw>& draws, size_t minPerThread) {
+		std::vector<uint32_t> visible(draws.size());
+		for (uint32_t ix = 0; ix < visible.size(); ix++) {
+			visible[ix] = ix;
+		}
+		std::vector<ScenePrepare::Buffer> buffers;
+		size_t threadCount = ScenePrepare::Prepare(pool, draws, visible.data(), visible.size(), minPerThread, settings, buffers);
+
+		std::vector<ScenePrepare::PreparedDraw> result;
+		for (size_t thread = 0; thread < threadCount; thread++) {
+			result.insert(result.end(), buffers[thread].Draws.begin(), buffers[thread].Draws.end());
+		}
+		return result;
+	}
+}
+
+// Found by argument lookup from std::vector's comparison, so this can't go in the anonymous namespace
+static bool operator ==(const ScenePrepare::PreparedDraw& a, const ScenePrepare::PreparedDraw& b) {
+	return a.DrawIndex == b.DrawIndex && a.Depth == b.Depth && a.Lod == b.Lod;
+}
+
+TEST_CASE(WorkerPool_RunsEachIndexOnce) {
+	WorkerPool pool(4);
+	CHECK_EQ(pool.GetThreadCount(), 4);
+
+	// Mix up the job sizes over many generations, so that workers that sat out a small job have to pick
+	// up the next large one
+	for (int generation = 0; generation < 500; generation++) {
+		CheckRunsEachIndexOnce(pool, generation % 5);
+	}
+}
+
+TEST_CASE(WorkerPool_SingleThread) {
+	// A pool of one thread has no workers, and runs everything on the calling thread
+	WorkerPool pool(1);
+	CHECK_EQ(pool.GetThreadCount(), 1);
+	std::thread::id caller = std::this_thread::get_id();
+	for (int generation = 0; generation < 10; generation++) {
+		bool onCaller = false;
+		pool.Run(1, [&](size_t) { onCaller = std::this_thread::get_id() == caller; });
+		CHECK(onCaller);
+	}
+	CheckRunsEachIndexOnce(pool, 0);
+}
+
+TEST_CASE(WorkerPool_RunRangesCoversEachItemOnce) {
+	WorkerPool pool(4);
+	for (size_t count : { 0, 1, 3, 7, 8, 9, 31, 32, 33, 1000 }) {
+		for (size_t minPerThread : { 1, 8, 64 }) {
+			std::vector<uint32_t> hits(count, 0);
+			std::atomic<size_t> maxThread(0);
+			size_t threadCount = pool.RunRanges(count, minPerThread, [&](size_t thread, size_t begin, size_t end) {
+				size_t seen = maxThread.load();
+				while (thread > seen && !maxThread.compare_exchange_weak(seen, thread)) {}
+				for (size_t ix = begin; ix < end; ix++) {
+					hits[ix]++;
+				}
+			});
+
+			CHECK_LE(threadCount, pool.GetThreadCount());
+			CHECK(threadCount == 1 || count / threadCount >= minPerThread);
+			CHECK_EQ(maxThread.load() + 1, threadCount);
+			for (uint32_t hit : hits) {
+				CHECK_EQ(hit, 1u);
+			}
+		}
+	}
+}
+
+TEST_CASE(WorkerPool_PrepareMatchesSingleThreaded) {
+	ScenePrepare::Settings settings;
+	settings.View = glm::lookAt(glm::vec3(0.0f, 5.0f, 10.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	settings.Projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 60.0f);
+	settings.ScreenSize = glm::ivec2(1920, 1080);
+	settings.ViewFrustum = Frustum::FromViewProjection(settings.Projection * settings.View);
+	settings.Occlusion = nullptr;
+	settings.HiZ = nullptr;
+	settings.HiZMargin = 0.0f;
+	settings.LodPixelError = 1.0f;
+	// Coarser levels the smaller the object is on screen
+	settings.SelectLod = [](uint32_t, float screenDiameter) {
+		return screenDiameter > 200.0f ? 0 : screenDiameter > 50.0f ? 1 : 2;
+	};
+
+	std::mt19937 random(4321);
+	std::uniform_real_distribution<float> position(-50.0f, 50.0f);
+	std::uniform_real_distribution<float> size(0.1f, 3.0f);
+	std::vector<ScenePrepare::Draw> draws(5000);
+	for (ScenePrepare::Draw& draw : draws) {
+		glm::vec3 center = glm::vec3(position(random), position(random), position(random));
+		glm::vec3 extents = glm::vec3(size(random), size(random), size(random));
+		draw.Box = BoundingBox{ center - extents, center + extents };
+		draw.Sphere = BoundingSphere{ center, glm::length(extents) };
+		draw.IsOccluder = false;
+		draw.HasLods = (random() & 1) != 0;
+	}
+
+	WorkerPool single(1);
+	WorkerPool wide(4);
+	for (size_t count : { 0, 1, 5, 63, 64, 65, 257, 5000 }) {
+		std::vector<ScenePrepare::Draw> subset(draws.begin(), draws.begin() + count);
+		std::vector<ScenePrepare::PreparedDraw> expected = PrepareVisible(single, settings, subset, 16);
+		// Run it a few times so that each generation gets a chance to go wrong
+		for (int repeat = 0; repeat < 4; repeat++) {
+			CHECK(PrepareVisible(wide, settings, subset, 16) == expected);
+			CHECK(PrepareVisible(wide, settings, subset, 1) == expected);
+		}
+	}
+}
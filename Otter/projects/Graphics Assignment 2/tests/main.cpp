@@ -0,0 +1,50 @@
+#include "Testing.h"
+#include <cstdio>
+#include <string>
+#include "Logging.h"
+
+namespace Testing {
+	static size_t CurrentFailures = 0;
+
+	std::vector<TestCase>& GetTests() {
+		static std::vector<TestCase> tests;
+		return tests;
+	}
+
+	void ReportFailure(const char* file, int line, const std::string& message) {
+		printf("  %s(%d): check failed: %s\n", file, line, message.c_str());
+		CurrentFailures++;
+	}
+}
+
+int main(int argc, char** args) {
+	Logger::Init();
+
+	// Any arguments are treated as filters, only tests with one of them in their name are run. Benchmarks
+	// are slow, so they only run when a filter asks for them
+	size_t failed = 0;
+	size_t run = 0;
+	for (const Testing::TestCase& test : Testing::GetTests()) {
+		bool selected = argc <= 1 && std::string(test.Name).rfind("Benchmark_", 0) != 0;
+		for (int ix = 1; ix < argc && !selected; ix++) {
+			selected = std::string(test.Name).find(args[ix]) != std::string::npos;
+		}
+		if (!selected) {
+			continue;
+		}
+
+		Testing::CurrentFailures = 0;
+		test.Func();
+		run++;
+		if (Testing::CurrentFailures > 0) {
+			printf("[FAILED] %s\n", test.Name);
+			failed++;
+		} else {
+			printf("[PASSED] %s\n", test.Name);
+		}
+	}
+	printf("%zu of %zu tests passed\n", run - failed, run);
+
+	Logger::Uninitialize();
+	return failed > 0 ? 1 : 0;
+}